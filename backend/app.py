@@ -2,7 +2,7 @@ import hmac
 import hashlib
 import time
 import struct
-import csv  
+from audit_log import AuditLog
 from datetime import datetime, timezone
 
 try:
@@ -85,9 +85,8 @@ def main():
         print("Failed to read RTC. Check wiring.")
         return
 
-    # Open the CSV file in append mode ('a')
-    with open(CSV_FILENAME, mode='a', newline='', encoding='utf-8') as file:
-        writer = csv.writer(file)
+    # Open the CSV log; rows are group-committed with a Merkle tree over them
+    with AuditLog(CSV_FILENAME) as writer:
         
         # Write the header row to the CSV
         writer.writerow(["SYS UTC (INTERNET)", "RTC TIME", "TOTP CODE", "ELAPSED (s)"])
@@ -115,12 +114,9 @@ def main():
                     # 1. Print to the console
                     print(f"{system_utc_now:<20} | {rtc_str:<10} | {totp_code:06d}    | {elapsed_seconds:<15}")
                     
-                    # 2. Write to the CSV file
+                    # 2. Write to the CSV log (committed in batches by the audit log writer)
                     writer.writerow([system_utc_now, rtc_str, f"{totp_code:06d}", elapsed_seconds])
                     
-                    # 3. Flush the file buffer so data is saved immediately
-                    file.flush()
-                    
                     last_processed_time = current_timestamp
                 
                 time.sleep(0.05)
@@ -0,0 +1,116 @@
+import collections
+import csv
+import io
+import os
+import subprocess
+import threading
+
+# --- CONFIG ---
+# Native writer built with: pio run -e native_auditlog (see src/audit_log.cpp)
+AUDIT_LOG_BIN = os.environ.get(
+    'AUDIT_LOG_BIN',
+    os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                 '..', '.pio', 'build', 'native_auditlog', 'program'))
+AUDIT_LOG_BATCH = int(os.environ.get('AUDIT_LOG_BATCH', '64'))          # rows per commit
+AUDIT_LOG_INTERVAL_MS = int(os.environ.get('AUDIT_LOG_INTERVAL_MS', '1000'))
+AUDIT_LOG_SYNC = os.environ.get('AUDIT_LOG_SYNC', '0') == '1'           # fsync each commit
+AUDIT_LOG_KEY_FILE = os.environ.get('AUDIT_LOG_KEY_FILE')               # MAC key for checkpoints
+
+
+class AuditLog:
+    """
+    Append-only CSV log with a Merkle tree over its rows.
+
+    Rows are queued here and handed to the native writer a batch at a time
+    (AUDIT_LOG_BATCH rows, or whatever is queued when AUDIT_LOG_INTERVAL_MS
+    has passed).  The writer commits each batch to the CSV file plus
+    <file>.tree and <file>.sth, so the loggers no longer flush per row and
+    the log can be checked with "program verify <file>".  Without the
+    native writer it falls back to a plain CSV file flushed per row.
+    """
+
+    def __init__(self, path):
+        self.path = path
+        self.proc = None
+        self.flusher = None
+
+        if os.path.exists(AUDIT_LOG_BIN):
+            # Batches are formed here, so the writer commits what each
+            # flush delivers (--interval 0) instead of waiting again.
+            args = [AUDIT_LOG_BIN, 'append',
+                    '--batch', str(AUDIT_LOG_BATCH),
+                    '--interval', '0']
+            if AUDIT_LOG_SYNC:
+                args.append('--sync')
+            if AUDIT_LOG_KEY_FILE:
+                args += ['--key-file', AUDIT_LOG_KEY_FILE]
+            args.append(path)
+            # Own session, so Ctrl+C reaches only the logger, whose close()
+            # then ends the writer's input and lets it commit what is pending.
+            self.proc = subprocess.Popen(args, stdin=subprocess.PIPE, start_new_session=True)
+            self.file = io.TextIOWrapper(self.proc.stdin, encoding='utf-8', newline='')
+            self.writer = csv.writer(self.file, lineterminator='\n')
+            # The caller only queues rows; formatting and writing them is
+            # left to one flusher thread, so a row costs no lock or syscall.
+            self.queue = collections.deque()
+            self.ready = threading.Event()
+            self.closing = False
+            self.error = None
+            self.flusher = threading.Thread(target=self._flush_loop, daemon=True)
+            self.flusher.start()
+        else:
+            print(f"WARNING: {AUDIT_LOG_BIN} not found. Logging to plain CSV without integrity protection.")
+            self.file = open(path, mode='a', newline='', encoding='utf-8')
+            self.writer = csv.writer(self.file)
+
+    def writerow(self, row):
+        if not self.proc:
+            self.writer.writerow(row)
+            self.file.flush()
+            return
+        if self.error:
+            raise RuntimeError(self.error)
+        self.queue.append(row)
+        if len(self.queue) >= AUDIT_LOG_BATCH and not self.ready.is_set():
+            self.ready.set()
+
+    def _flush_loop(self):
+        # Sends a batch when one is full, and whatever is queued once the
+        # interval has passed, one pipe write per batch.
+        queue = self.queue
+        while True:
+            self.ready.wait(AUDIT_LOG_INTERVAL_MS / 1000.0)
+            self.ready.clear()
+            closing = self.closing
+            if queue:
+                rows = [queue.popleft() for _ in range(len(queue))]
+                try:
+                    self.writer.writerows(rows)
+                    self.file.flush()
+                except BrokenPipeError:
+                    self.error = f"audit log writer for {self.path} exited with status {self.proc.wait()}"
+                    return
+            if closing:
+                return
+
+    def close(self):
+        if self.flusher:
+            self.closing = True
+            self.ready.set()
+            self.flusher.join()
+            self.flusher = None
+        if self.file:
+            try:
+                self.file.close()
+            except BrokenPipeError:
+                pass
+            self.file = None
+        if self.proc:
+            self.proc.wait()
+            self.proc = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
@@ -1,7 +1,7 @@
 import sqlite3
 import os
 
-DB_PATH = 'devices.db'
+DB_PATH = os.environ.get('DEVICES_DB', 'devices.db')
 
 def get_db_connection():
     conn = sqlite3.connect(DB_PATH)
@@ -6,7 +6,7 @@ import os
 import time
 
 from database import init_db, get_all_devices, get_device, add_device, delete_device, update_device
-from app import get_rtc_timestamp, generate_totp
+from app import get_rtc_timestamp, generate_totp, TIMESTEP
 
 app = Flask(__name__, static_folder="static", template_folder="templates")
 
@@ -15,6 +15,9 @@ app = Flask(__name__, static_folder="static", template_folder="templates")
 UART_PORT = os.environ.get('UART_PORT', '/dev/serial0')
 UART_BAUD = 9600
 
+# Timesteps of clock drift tolerated either side when checking a token's code
+TOTP_WINDOW = int(os.environ.get('TOTP_WINDOW', '1'))
+
 # Initialize Database
 with app.app_context():
     init_db()
@@ -132,6 +135,36 @@ def get_device_totp(device_id):
         "device_id": device_id
     })
 
+@app.route('/api/devices/<int:device_id>/totp/check', methods=['POST'])
+def check_device_totp(device_id):
+    """
+    Checks a code read off the token.
+    Accepts codes up to TOTP_WINDOW timesteps either side of the expected one
+    to allow for RTC drift, and reports which step matched.
+    """
+    device = get_device(device_id)
+    if not device:
+        return jsonify({"error": "Device not found"}), 404
+
+    data = request.json or {}
+    code = str(data.get('code', '')).strip()
+    if len(code) != 6 or not code.isdigit():
+        return jsonify({"error": "Code must be 6 digits"}), 400
+
+    elapsed = get_rtc_timestamp() - device['sync_time']
+    if elapsed < 0:
+        elapsed = 0
+
+    secret_bytes = device['secret_key'].encode('utf-8')
+    for offset in sorted(range(-TOTP_WINDOW, TOTP_WINDOW + 1), key=abs):
+        step_time = elapsed + offset * TIMESTEP
+        if step_time < 0:
+            continue
+        if generate_totp(secret_bytes, step_time) == int(code):
+            return jsonify({"valid": True, "offset": offset, "device_id": device_id})
+
+    return jsonify({"valid": False, "offset": None, "device_id": device_id})
+
 @app.route('/api/devices/<int:device_id>/verify', methods=['POST'])
 def verify_device_admin(device_id):
     device = get_device(device_id)
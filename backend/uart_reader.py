@@ -1,15 +1,14 @@
 import serial
-import csv
 import datetime
+from audit_log import AuditLog
 
 COM_PORT    = '/dev/serial0'
 BAUD_RATE   = 9600
 CSV_FILE    = 'attiny_log.csv'
 
 with serial.Serial(COM_PORT, BAUD_RATE, timeout=1) as ser, \
-     open(CSV_FILE, mode='a', newline='', encoding='utf-8') as f:
+     AuditLog(CSV_FILE) as writer:
 
-    writer = csv.writer(f)
     writer.writerow(["UTC Timestamp", "TOTP Code", "Elapsed HH:MM:SS", "Elapsed (s)"])
     print(f"Logging to {CSV_FILE}. Ctrl+C to stop.")
 
@@ -25,7 +24,6 @@ with serial.Serial(COM_PORT, BAUD_RATE, timeout=1) as ser, \
                 parts = line.split(" | ")
                 if len(parts) == 3:
                     writer.writerow([now_utc, parts[0], parts[1], parts[2]])
-                    f.flush()
             
             print(f"[{now_utc}] {line}")
 
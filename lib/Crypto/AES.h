@@ -266,4 +266,21 @@ typedef AES256 AESSmall256;
 
 #endif // CRYPTO_AES_ESP32
 
+// AES-128 implementation for applications that only need "an AES-128":
+// AES128 (fastest, largest), AESSmall128 or AESTiny128 (smallest).  The
+// build selects one with -DCRYPTO_AES128_VARIANT=n, normally set by
+// scripts/crypto_select.py from benchmark results for the target.
+#define CRYPTO_AES128_FULL  0
+#define CRYPTO_AES128_SMALL 1
+#define CRYPTO_AES128_TINY  2
+#if !defined(CRYPTO_AES128_VARIANT) || CRYPTO_AES128_VARIANT == CRYPTO_AES128_FULL
+typedef AES128 AESSelected128;
+#elif CRYPTO_AES128_VARIANT == CRYPTO_AES128_SMALL
+typedef AESSmall128 AESSelected128;
+#elif CRYPTO_AES128_VARIANT == CRYPTO_AES128_TINY
+typedef AESTiny128 AESSelected128;
+#else
+#error "Unknown CRYPTO_AES128_VARIANT"
+#endif
+
 #endif
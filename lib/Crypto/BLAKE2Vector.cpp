@@ -0,0 +1,622 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "utility/BLAKE2VectorUtil.h"
+#include "utility/EndianUtil.h"
+#include <string.h>
+
+// BLAKE2s and BLAKE2b compression for 64-bit hosts.  See
+// utility/BLAKE2VectorUtil.h for when this is compiled in.
+
+#if CRYPTO_BLAKE2_VEC
+
+// Message word permutations.  BLAKE2b has 12 rounds and reuses the first
+// two rows for the last two.
+static const uint8_t blake2VectorSigma[12][16] = {
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+    {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+    {11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4},
+    { 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8},
+    { 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13},
+    { 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9},
+    {12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11},
+    {13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10},
+    { 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5},
+    {10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13 , 0},
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+    {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3}
+};
+
+typedef uint64_t u64x4 __attribute__((vector_size(32)));
+typedef uint32_t u32x8 __attribute__((vector_size(32)));
+typedef uint16_t u16x16 __attribute__((vector_size(32)));
+typedef uint8_t u8x32 __attribute__((vector_size(32)));
+typedef uint64_t u64x2 __attribute__((vector_size(16)));
+typedef uint32_t u32x4 __attribute__((vector_size(16)));
+typedef uint16_t u16x8 __attribute__((vector_size(16)));
+typedef uint8_t u8x16 __attribute__((vector_size(16)));
+
+#define VEC_INLINE inline __attribute__((always_inline))
+
+// Rotations by whole bytes are lane shuffles.  A shuffle of 16-bit or
+// 32-bit units is cheap everywhere, but a byte shuffle needs pshufb on
+// x86, so the baseline SSE2 copy ("Bytes" false) shifts instead.  These
+// are macros rather than functions because GCC warns about passing
+// 256-bit vectors by value when AVX is not enabled for the whole file.
+#define ROTR16_32(x) \
+    ((u32x4)__builtin_shuffle((u16x8)(x), (u16x8){1, 0, 3, 2, 5, 4, 7, 6}))
+#define ROTR12_32(x) (((x) >> 12) | ((x) << 20))
+#define ROTR8_32(x) \
+    (Bytes ? (u32x4)__builtin_shuffle \
+        ((u8x16)(x), (u8x16){1, 2, 3, 0, 5, 6, 7, 4, \
+                             9, 10, 11, 8, 13, 14, 15, 12}) \
+           : (((x) >> 8) | ((x) << 24)))
+#define ROTR7_32(x) (((x) >> 7) | ((x) << 25))
+
+#define ROTR32_64(x) \
+    ((u64x2)__builtin_shuffle((u32x4)(x), (u32x4){1, 0, 3, 2}))
+#define ROTR24_64(x) \
+    (Bytes ? (u64x2)__builtin_shuffle \
+        ((u8x16)(x), (u8x16){3, 4, 5, 6, 7, 0, 1, 2, \
+                             11, 12, 13, 14, 15, 8, 9, 10}) \
+           : (((x) >> 24) | ((x) << 40)))
+#define ROTR16_64(x) \
+    ((u64x2)__builtin_shuffle((u16x8)(x), (u16x8){1, 2, 3, 0, 5, 6, 7, 4}))
+#define ROTR63_64(x) (((x) >> 63) | ((x) + (x)))
+
+#define ROTR32_64x4(x) \
+    ((u64x4)__builtin_shuffle((u32x8)(x), (u32x8){1, 0, 3, 2, 5, 4, 7, 6}))
+#define ROTR24_64x4(x) \
+    ((u64x4)__builtin_shuffle \
+        ((u8x32)(x), (u8x32){3, 4, 5, 6, 7, 0, 1, 2, \
+                             11, 12, 13, 14, 15, 8, 9, 10, \
+                             19, 20, 21, 22, 23, 16, 17, 18, \
+                             27, 28, 29, 30, 31, 24, 25, 26}))
+#define ROTR16_64x4(x) \
+    ((u64x4)__builtin_shuffle \
+        ((u16x16)(x), (u16x16){1, 2, 3, 0, 5, 6, 7, 4, \
+                               9, 10, 11, 8, 13, 14, 15, 12}))
+
+// The G function on all four columns (or diagonals) at once.
+#define G(a, b, c, d, x, y, rot1, rot2, rot3, rot4) \
+    do { \
+        (a) += (b) + (x); \
+        (d) = rot1((d) ^ (a)); \
+        (c) += (d); \
+        (b) = rot2((b) ^ (c)); \
+        (a) += (b) + (y); \
+        (d) = rot3((d) ^ (a)); \
+        (c) += (d); \
+        (b) = rot4((b) ^ (c)); \
+    } while (0)
+
+// Moves the diagonals into the columns and back again by rotating the
+// lanes of rows b, c and d left by one, two and three.
+#define DIAGONALIZE(b, c, d, type) \
+    do { \
+        (b) = __builtin_shuffle((b), (type){1, 2, 3, 0}); \
+        (c) = __builtin_shuffle((c), (type){2, 3, 0, 1}); \
+        (d) = __builtin_shuffle((d), (type){3, 0, 1, 2}); \
+    } while (0)
+#define UNDIAGONALIZE(b, c, d, type) \
+    do { \
+        (b) = __builtin_shuffle((b), (type){3, 0, 1, 2}); \
+        (c) = __builtin_shuffle((c), (type){2, 3, 0, 1}); \
+        (d) = __builtin_shuffle((d), (type){1, 2, 3, 0}); \
+    } while (0)
+
+// Same for rows split into two halves, where lane rotations become
+// shuffles across a pair of vectors.
+#define ROTL1_PAIR(lo, hi) \
+    do { \
+        u64x2 _t = __builtin_shuffle((lo), (hi), (u64x2){1, 2}); \
+        (hi) = __builtin_shuffle((hi), (lo), (u64x2){1, 2}); \
+        (lo) = _t; \
+    } while (0)
+#define ROTR1_PAIR(lo, hi) \
+    do { \
+        u64x2 _t = __builtin_shuffle((hi), (lo), (u64x2){1, 2}); \
+        (hi) = __builtin_shuffle((lo), (hi), (u64x2){1, 2}); \
+        (lo) = _t; \
+    } while (0)
+#define SWAP_PAIR(lo, hi) \
+    do { \
+        u64x2 _t = (lo); \
+        (lo) = (hi); \
+        (hi) = _t; \
+    } while (0)
+#define DIAGONALIZE_PAIR(b0, b1, c0, c1, d0, d1) \
+    do { \
+        ROTL1_PAIR(b0, b1); \
+        SWAP_PAIR(c0, c1); \
+        ROTR1_PAIR(d0, d1); \
+    } while (0)
+#define UNDIAGONALIZE_PAIR(b0, b1, c0, c1, d0, d1) \
+    do { \
+        ROTR1_PAIR(b0, b1); \
+        SWAP_PAIR(c0, c1); \
+        ROTL1_PAIR(d0, d1); \
+    } while (0)
+
+// Gathers message words s[i], s[i + 2], ... for one G argument.  The round
+// loops are fully unrolled so that the word offsets are constants.
+#define MSG_32(s, i) \
+    ((u32x4){loadLE32(data + (s)[(i)] * 4), \
+             loadLE32(data + (s)[(i) + 2] * 4), \
+             loadLE32(data + (s)[(i) + 4] * 4), \
+             loadLE32(data + (s)[(i) + 6] * 4)})
+#define MSG_64(s, i) \
+    ((u64x2){loadLE64(data + (s)[(i)] * 8), \
+             loadLE64(data + (s)[(i) + 2] * 8)})
+#define MSG_64x4(s, i) \
+    ((u64x4){loadLE64(data + (s)[(i)] * 8), \
+             loadLE64(data + (s)[(i) + 2] * 8), \
+             loadLE64(data + (s)[(i) + 4] * 8), \
+             loadLE64(data + (s)[(i) + 6] * 8)})
+
+#define BLAKE2b_IV0 0x6A09E667F3BCC908ULL
+#define BLAKE2b_IV1 0xBB67AE8584CAA73BULL
+#define BLAKE2b_IV2 0x3C6EF372FE94F82BULL
+#define BLAKE2b_IV3 0xA54FF53A5F1D36F1ULL
+#define BLAKE2b_IV4 0x510E527FADE682D1ULL
+#define BLAKE2b_IV5 0x9B05688C2B3E6C1FULL
+#define BLAKE2b_IV6 0x1F83D9ABFB41BD6BULL
+#define BLAKE2b_IV7 0x5BE0CD19137E2179ULL
+
+template <bool Bytes>
+static VEC_INLINE void blake2sBlocks(uint32_t h[8], const uint8_t *data,
+                                     size_t blocks, uint64_t t, uint32_t f0,
+                                     uint32_t f1)
+{
+    u32x4 h0, h1;
+    memcpy(&h0, h, sizeof(h0));
+    memcpy(&h1, h + 4, sizeof(h1));
+    while (blocks-- > 0) {
+        u32x4 a = h0;
+        u32x4 b = h1;
+        u32x4 c = {0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A};
+        u32x4 d = {0x510E527F ^ (uint32_t)t,
+                   0x9B05688C ^ (uint32_t)(t >> 32),
+                   0x1F83D9AB ^ f0, 0x5BE0CD19 ^ f1};
+#pragma GCC unroll 10
+        for (int round = 0; round < 10; ++round) {
+            const uint8_t *s = blake2VectorSigma[round];
+            G(a, b, c, d, MSG_32(s, 0), MSG_32(s, 1),
+              ROTR16_32, ROTR12_32, ROTR8_32, ROTR7_32);
+            DIAGONALIZE(b, c, d, u32x4);
+            G(a, b, c, d, MSG_32(s, 8), MSG_32(s, 9),
+              ROTR16_32, ROTR12_32, ROTR8_32, ROTR7_32);
+            UNDIAGONALIZE(b, c, d, u32x4);
+        }
+        h0 ^= a ^ c;
+        h1 ^= b ^ d;
+        data += 64;
+        t += 64;
+    }
+    memcpy(h, &h0, sizeof(h0));
+    memcpy(h + 4, &h1, sizeof(h1));
+}
+
+// BLAKE2b with each row split across two 128-bit vectors, for SSE and
+// NEON.  Generic 256-bit vectors would be broken up by GCC one lane at a
+// time when the target has no 256-bit registers.
+template <bool Bytes>
+static VEC_INLINE void blake2bBlocks(uint64_t h[8], const uint8_t *data,
+                                     size_t blocks, uint64_t t0, uint64_t t1,
+                                     uint64_t f0, uint64_t f1)
+{
+    u64x2 h0, h1, h2, h3;
+    memcpy(&h0, h, sizeof(h0));
+    memcpy(&h1, h + 2, sizeof(h1));
+    memcpy(&h2, h + 4, sizeof(h2));
+    memcpy(&h3, h + 6, sizeof(h3));
+    while (blocks-- > 0) {
+        u64x2 a0 = h0, a1 = h1;
+        u64x2 b0 = h2, b1 = h3;
+        u64x2 c0 = {BLAKE2b_IV0, BLAKE2b_IV1};
+        u64x2 c1 = {BLAKE2b_IV2, BLAKE2b_IV3};
+        u64x2 d0 = {BLAKE2b_IV4 ^ t0, BLAKE2b_IV5 ^ t1};
+        u64x2 d1 = {BLAKE2b_IV6 ^ f0, BLAKE2b_IV7 ^ f1};
+#pragma GCC unroll 12
+        for (int round = 0; round < 12; ++round) {
+            const uint8_t *s = blake2VectorSigma[round];
+            G(a0, b0, c0, d0, MSG_64(s, 0), MSG_64(s, 1),
+              ROTR32_64, ROTR24_64, ROTR16_64, ROTR63_64);
+            G(a1, b1, c1, d1, MSG_64(s, 4), MSG_64(s, 5),
+              ROTR32_64, ROTR24_64, ROTR16_64, ROTR63_64);
+            DIAGONALIZE_PAIR(b0, b1, c0, c1, d0, d1);
+            G(a0, b0, c0, d0, MSG_64(s, 8), MSG_64(s, 9),
+              ROTR32_64, ROTR24_64, ROTR16_64, ROTR63_64);
+            G(a1, b1, c1, d1, MSG_64(s, 12), MSG_64(s, 13),
+              ROTR32_64, ROTR24_64, ROTR16_64, ROTR63_64);
+            UNDIAGONALIZE_PAIR(b0, b1, c0, c1, d0, d1);
+        }
+        h0 ^= a0 ^ c0;
+        h1 ^= a1 ^ c1;
+        h2 ^= b0 ^ d0;
+        h3 ^= b1 ^ d1;
+        data += 128;
+        t0 += 128;
+        if (t0 < 128)
+            ++t1;
+    }
+    memcpy(h, &h0, sizeof(h0));
+    memcpy(h + 2, &h1, sizeof(h1));
+    memcpy(h + 4, &h2, sizeof(h2));
+    memcpy(h + 6, &h3, sizeof(h3));
+}
+
+// Byte shuffle masks for rotating every lane of the leaf kernels right by
+// 8, 16, 24 or 32 bits.  Each kernel takes as much as its vector width.
+static const uint8_t blake2LaneRot8_32[32] = {
+    1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+    17, 18, 19, 16, 21, 22, 23, 20, 25, 26, 27, 24, 29, 30, 31, 28
+};
+static const uint8_t blake2LaneRot16_32[32] = {
+    2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+    18, 19, 16, 17, 22, 23, 20, 21, 26, 27, 24, 25, 30, 31, 28, 29
+};
+static const uint8_t blake2LaneRot16_64[32] = {
+    2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+    18, 19, 20, 21, 22, 23, 16, 17, 26, 27, 28, 29, 30, 31, 24, 25
+};
+static const uint8_t blake2LaneRot24_64[32] = {
+    3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+    19, 20, 21, 22, 23, 16, 17, 18, 27, 28, 29, 30, 31, 24, 25, 26
+};
+static const uint8_t blake2LaneRot32_64[32] = {
+    4, 5, 6, 7, 0, 1, 2, 3, 12, 13, 14, 15, 8, 9, 10, 11,
+    20, 21, 22, 23, 16, 17, 18, 19, 28, 29, 30, 31, 24, 25, 26, 27
+};
+
+// Rotations in the leaf kernels, where V is the vector type and B is the
+// byte vector of the same width.
+#define LANE_ROTR(x, n, bits) (((x) >> (n)) | ((x) << ((bits) - (n))))
+#define LANE_ROTR_BYTES(x, mask, n, bits) \
+    (Bytes ? (V)__builtin_shuffle((B)(x), (mask)) : LANE_ROTR((x), (n), (bits)))
+
+// The G function for one column or diagonal of every leaf at once.
+#define LANE_G(a, b, c, d, x, y, rot1, rot2, rot3, rot4) \
+    do { \
+        (a) += (b) + (x); \
+        (d) = rot1((d) ^ (a)); \
+        (c) += (d); \
+        (b) = rot2((b) ^ (c)); \
+        (a) += (b) + (y); \
+        (d) = rot3((d) ^ (a)); \
+        (c) += (d); \
+        (b) = rot4((b) ^ (c)); \
+    } while (0)
+#define LANE_ROUND(v, m, s, rot1, rot2, rot3, rot4) \
+    do { \
+        LANE_G((v)[0], (v)[4], (v)[8],  (v)[12], (m)[(s)[0]],  (m)[(s)[1]], \
+               rot1, rot2, rot3, rot4); \
+        LANE_G((v)[1], (v)[5], (v)[9],  (v)[13], (m)[(s)[2]],  (m)[(s)[3]], \
+               rot1, rot2, rot3, rot4); \
+        LANE_G((v)[2], (v)[6], (v)[10], (v)[14], (m)[(s)[4]],  (m)[(s)[5]], \
+               rot1, rot2, rot3, rot4); \
+        LANE_G((v)[3], (v)[7], (v)[11], (v)[15], (m)[(s)[6]],  (m)[(s)[7]], \
+               rot1, rot2, rot3, rot4); \
+        LANE_G((v)[0], (v)[5], (v)[10], (v)[15], (m)[(s)[8]],  (m)[(s)[9]], \
+               rot1, rot2, rot3, rot4); \
+        LANE_G((v)[1], (v)[6], (v)[11], (v)[12], (m)[(s)[10]], (m)[(s)[11]], \
+               rot1, rot2, rot3, rot4); \
+        LANE_G((v)[2], (v)[7], (v)[8],  (v)[13], (m)[(s)[12]], (m)[(s)[13]], \
+               rot1, rot2, rot3, rot4); \
+        LANE_G((v)[3], (v)[4], (v)[9],  (v)[14], (m)[(s)[14]], (m)[(s)[15]], \
+               rot1, rot2, rot3, rot4); \
+    } while (0)
+
+#define LANE_ROTR16_32(x) LANE_ROTR_BYTES((x), rot16, 16, 32)
+#define LANE_ROTR12_32(x) LANE_ROTR((x), 12, 32)
+#define LANE_ROTR8_32(x)  LANE_ROTR_BYTES((x), rot8, 8, 32)
+#define LANE_ROTR7_32(x)  LANE_ROTR((x), 7, 32)
+#define LANE_ROTR32_64(x) LANE_ROTR_BYTES((x), rot32, 32, 64)
+#define LANE_ROTR24_64(x) LANE_ROTR_BYTES((x), rot24, 24, 64)
+#define LANE_ROTR16_64(x) LANE_ROTR_BYTES((x), rot16, 16, 64)
+#define LANE_ROTR63_64(x) (((x) >> 63) | ((x) + (x)))
+
+// Compresses "blocks" blocks into each of L BLAKE2s leaves, one leaf per
+// lane of V.  The state is transposed so that vector w holds word w of
+// every leaf, which needs no shuffles in the rounds at all.
+template <typename V, typename B, size_t L, bool Bytes>
+static VEC_INLINE void blake2sLanes(uint32_t (*h)[8], const uint8_t *data,
+                                    size_t stride, size_t blocks, uint64_t t,
+                                    uint32_t f0)
+{
+    B rot8, rot16;
+    V H[8], m[16], v[16];
+    size_t w, j;
+    memcpy(&rot8, blake2LaneRot8_32, sizeof(B));
+    memcpy(&rot16, blake2LaneRot16_32, sizeof(B));
+    for (w = 0; w < 8; ++w) {
+        for (j = 0; j < L; ++j)
+            H[w][j] = h[j][w];
+    }
+    while (blocks-- > 0) {
+        for (w = 0; w < 16; ++w) {
+            for (j = 0; j < L; ++j)
+                m[w][j] = loadLE32(data + j * 64 + w * 4);
+        }
+        for (w = 0; w < 8; ++w)
+            v[w] = H[w];
+        v[8]  = (V){} + 0x6A09E667;
+        v[9]  = (V){} + 0xBB67AE85;
+        v[10] = (V){} + 0x3C6EF372;
+        v[11] = (V){} + 0xA54FF53A;
+        v[12] = (V){} + (0x510E527F ^ (uint32_t)t);
+        v[13] = (V){} + (0x9B05688C ^ (uint32_t)(t >> 32));
+        v[14] = (V){} + (0x1F83D9AB ^ f0);
+        v[15] = (V){} + 0x5BE0CD19;
+#pragma GCC unroll 10
+        for (int round = 0; round < 10; ++round) {
+            LANE_ROUND(v, m, blake2VectorSigma[round], LANE_ROTR16_32,
+                       LANE_ROTR12_32, LANE_ROTR8_32, LANE_ROTR7_32);
+        }
+        for (w = 0; w < 8; ++w)
+            H[w] ^= v[w] ^ v[w + 8];
+        data += stride;
+        t += 64;
+    }
+    for (w = 0; w < 8; ++w) {
+        for (j = 0; j < L; ++j)
+            h[j][w] = H[w][j];
+    }
+}
+
+// Same for BLAKE2b.  The leaves of a tree never get near 2^64 bytes each,
+// so the high word of the counter is always zero.
+template <typename V, typename B, size_t L, bool Bytes>
+static VEC_INLINE void blake2bLanes(uint64_t (*h)[8], const uint8_t *data,
+                                    size_t stride, size_t blocks, uint64_t t,
+                                    uint64_t f0)
+{
+    B rot16, rot24, rot32;
+    V H[8], m[16], v[16];
+    size_t w, j;
+    memcpy(&rot16, blake2LaneRot16_64, sizeof(B));
+    memcpy(&rot24, blake2LaneRot24_64, sizeof(B));
+    memcpy(&rot32, blake2LaneRot32_64, sizeof(B));
+    for (w = 0; w < 8; ++w) {
+        for (j = 0; j < L; ++j)
+            H[w][j] = h[j][w];
+    }
+    while (blocks-- > 0) {
+        for (w = 0; w < 16; ++w) {
+            for (j = 0; j < L; ++j)
+                m[w][j] = loadLE64(data + j * 128 + w * 8);
+        }
+        for (w = 0; w < 8; ++w)
+            v[w] = H[w];
+        v[8]  = (V){} + BLAKE2b_IV0;
+        v[9]  = (V){} + BLAKE2b_IV1;
+        v[10] = (V){} + BLAKE2b_IV2;
+        v[11] = (V){} + BLAKE2b_IV3;
+        v[12] = (V){} + (BLAKE2b_IV4 ^ t);
+        v[13] = (V){} + BLAKE2b_IV5;
+        v[14] = (V){} + (BLAKE2b_IV6 ^ f0);
+        v[15] = (V){} + BLAKE2b_IV7;
+#pragma GCC unroll 12
+        for (int round = 0; round < 12; ++round) {
+            LANE_ROUND(v, m, blake2VectorSigma[round], LANE_ROTR32_64,
+                       LANE_ROTR24_64, LANE_ROTR16_64, LANE_ROTR63_64);
+        }
+        for (w = 0; w < 8; ++w)
+            H[w] ^= v[w] ^ v[w + 8];
+        data += stride;
+        t += 128;
+    }
+    for (w = 0; w < 8; ++w) {
+        for (j = 0; j < L; ++j)
+            h[j][w] = H[w][j];
+    }
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.1")))
+static void blake2sBlocksSSE41(uint32_t h[8], const uint8_t *data,
+                               size_t blocks, uint64_t t, uint32_t f0,
+                               uint32_t f1)
+{
+    blake2sBlocks<true>(h, data, blocks, t, f0, f1);
+}
+
+__attribute__((target("sse4.1")))
+static void blake2bBlocksSSE41(uint64_t h[8], const uint8_t *data,
+                               size_t blocks, uint64_t t0, uint64_t t1,
+                               uint64_t f0, uint64_t f1)
+{
+    blake2bBlocks<true>(h, data, blocks, t0, t1, f0, f1);
+}
+
+// BLAKE2b with whole 256-bit rows.
+__attribute__((target("avx2")))
+static void blake2bBlocksAVX2(uint64_t h[8], const uint8_t *data,
+                              size_t blocks, uint64_t t0, uint64_t t1,
+                              uint64_t f0, uint64_t f1)
+{
+    u64x4 h0, h1;
+    memcpy(&h0, h, sizeof(h0));
+    memcpy(&h1, h + 4, sizeof(h1));
+    while (blocks-- > 0) {
+        u64x4 a = h0;
+        u64x4 b = h1;
+        u64x4 c = {BLAKE2b_IV0, BLAKE2b_IV1, BLAKE2b_IV2, BLAKE2b_IV3};
+        u64x4 d = {BLAKE2b_IV4 ^ t0, BLAKE2b_IV5 ^ t1,
+                   BLAKE2b_IV6 ^ f0, BLAKE2b_IV7 ^ f1};
+#pragma GCC unroll 12
+        for (int round = 0; round < 12; ++round) {
+            const uint8_t *s = blake2VectorSigma[round];
+            G(a, b, c, d, MSG_64x4(s, 0), MSG_64x4(s, 1),
+              ROTR32_64x4, ROTR24_64x4, ROTR16_64x4, ROTR63_64);
+            DIAGONALIZE(b, c, d, u64x4);
+            G(a, b, c, d, MSG_64x4(s, 8), MSG_64x4(s, 9),
+              ROTR32_64x4, ROTR24_64x4, ROTR16_64x4, ROTR63_64);
+            UNDIAGONALIZE(b, c, d, u64x4);
+        }
+        h0 ^= a ^ c;
+        h1 ^= b ^ d;
+        data += 128;
+        t0 += 128;
+        if (t0 < 128)
+            ++t1;
+    }
+    memcpy(h, &h0, sizeof(h0));
+    memcpy(h + 4, &h1, sizeof(h1));
+}
+
+__attribute__((target("sse4.1")))
+static void blake2sLanesSSE41(uint32_t (*h)[8], const uint8_t *data,
+                              size_t stride, size_t blocks, uint64_t t,
+                              uint32_t f0)
+{
+    blake2sLanes<u32x4, u8x16, 4, true>(h, data, stride, blocks, t, f0);
+}
+
+__attribute__((target("avx2")))
+static void blake2sLanesAVX2(uint32_t (*h)[8], const uint8_t *data,
+                             size_t stride, size_t blocks, uint64_t t,
+                             uint32_t f0)
+{
+    blake2sLanes<u32x8, u8x32, 8, true>(h, data, stride, blocks, t, f0);
+}
+
+__attribute__((target("sse4.1")))
+static void blake2bLanesSSE41(uint64_t (*h)[8], const uint8_t *data,
+                              size_t stride, size_t blocks, uint64_t t,
+                              uint64_t f0)
+{
+    blake2bLanes<u64x2, u8x16, 2, true>(h, data, stride, blocks, t, f0);
+}
+
+__attribute__((target("avx2")))
+static void blake2bLanesAVX2(uint64_t (*h)[8], const uint8_t *data,
+                             size_t stride, size_t blocks, uint64_t t,
+                             uint64_t f0)
+{
+    blake2bLanes<u64x4, u8x32, 4, true>(h, data, stride, blocks, t, f0);
+}
+
+// 2 for AVX2, 1 for SSE4.1, 0 for the SSE2 baseline.  BLAKE2s rows are
+// only 128 bits, so BLAKE2s uses the SSE4.1 copy on AVX2 machines too.
+static int detectBLAKE2Level()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return 2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return 1;
+    return 0;
+}
+
+#endif
+
+void blake2sVectorCompress(uint32_t h[8], const uint8_t *data, size_t blocks,
+                           uint64_t t, uint32_t f0, uint32_t f1)
+{
+#if defined(__x86_64__)
+    static const int level = detectBLAKE2Level();
+    if (level >= 1)
+        blake2sBlocksSSE41(h, data, blocks, t, f0, f1);
+    else
+        blake2sBlocks<false>(h, data, blocks, t, f0, f1);
+#else
+    blake2sBlocks<true>(h, data, blocks, t, f0, f1);
+#endif
+}
+
+void blake2bVectorCompress(uint64_t h[8], const uint8_t *data, size_t blocks,
+                           uint64_t t0, uint64_t t1, uint64_t f0, uint64_t f1)
+{
+#if defined(__x86_64__)
+    static const int level = detectBLAKE2Level();
+    if (level == 2)
+        blake2bBlocksAVX2(h, data, blocks, t0, t1, f0, f1);
+    else if (level == 1)
+        blake2bBlocksSSE41(h, data, blocks, t0, t1, f0, f1);
+    else
+        blake2bBlocks<false>(h, data, blocks, t0, t1, f0, f1);
+#else
+    blake2bBlocks<true>(h, data, blocks, t0, t1, f0, f1);
+#endif
+}
+
+void blake2sLanesCompress(uint32_t (*h)[8], size_t leaves,
+                          const uint8_t *data, size_t stride, size_t blocks,
+                          uint64_t t, uint32_t f0)
+{
+    size_t j = 0;
+#if defined(__x86_64__)
+    static const int level = detectBLAKE2Level();
+    if (level == 2) {
+        for (; (j + 8) <= leaves; j += 8)
+            blake2sLanesAVX2(h + j, data + j * 64, stride, blocks, t, f0);
+    }
+    for (; (j + 4) <= leaves; j += 4) {
+        if (level >= 1)
+            blake2sLanesSSE41(h + j, data + j * 64, stride, blocks, t, f0);
+        else
+            blake2sLanes<u32x4, u8x16, 4, false>(h + j, data + j * 64, stride, blocks, t, f0);
+    }
+#else
+    for (; (j + 4) <= leaves; j += 4)
+        blake2sLanes<u32x4, u8x16, 4, true>(h + j, data + j * 64, stride, blocks, t, f0);
+#endif
+
+    // Leftover leaves go through the single-stream code a block at a time.
+    for (; j < leaves; ++j) {
+        const uint8_t *d = data + j * 64;
+        for (size_t k = 0; k < blocks; ++k, d += stride)
+            blake2sVectorCompress(h[j], d, 1, t + k * 64, f0, 0);
+    }
+}
+
+void blake2bLanesCompress(uint64_t (*h)[8], size_t leaves,
+                          const uint8_t *data, size_t stride, size_t blocks,
+                          uint64_t t, uint64_t f0)
+{
+    size_t j = 0;
+#if defined(__x86_64__)
+    static const int level = detectBLAKE2Level();
+    if (level == 2) {
+        for (; (j + 4) <= leaves; j += 4)
+            blake2bLanesAVX2(h + j, data + j * 128, stride, blocks, t, f0);
+    }
+    for (; (j + 2) <= leaves; j += 2) {
+        if (level >= 1)
+            blake2bLanesSSE41(h + j, data + j * 128, stride, blocks, t, f0);
+        else
+            blake2bLanes<u64x2, u8x16, 2, false>(h + j, data + j * 128, stride, blocks, t, f0);
+    }
+#else
+    for (; (j + 2) <= leaves; j += 2)
+        blake2bLanes<u64x2, u8x16, 2, true>(h + j, data + j * 128, stride, blocks, t, f0);
+#endif
+
+    for (; j < leaves; ++j) {
+        const uint8_t *d = data + j * 128;
+        for (size_t k = 0; k < blocks; ++k, d += stride)
+            blake2bVectorCompress(h[j], d, 1, t + k * 128, 0, f0, 0);
+    }
+}
+
+#endif // CRYPTO_BLAKE2_VEC
@@ -0,0 +1,339 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "BLAKE2Xb.h"
+#include "Crypto.h"
+#include "utility/EndianUtil.h"
+#include "utility/BLAKE2VectorUtil.h"
+#include <string.h>
+
+/**
+ * \class BLAKE2Xb BLAKE2Xb.h <BLAKE2Xb.h>
+ * \brief BLAKE2Xb extendable-output function (XOF).
+ *
+ * BLAKE2Xb hashes the input with BLAKE2b into a 64-byte seed and then
+ * expands the seed into 64-byte output blocks.  Output block i is the
+ * BLAKE2b hash of the seed with the node offset set to i, so each block
+ * can be computed on its own.  seek() uses that to jump to any point of
+ * the output without generating what comes before it, and on 64-bit hosts
+ * extend() computes up to 4 blocks side by side in SIMD lanes.  BLAKE2Xb
+ * is the faster of the two on 64-bit hosts; BLAKE2Xs suits 8-bit and
+ * 32-bit platforms better.
+ *
+ * \code
+ * BLAKE2Xb xof;
+ * xof.reset(key, sizeof(key));
+ * xof.update(salt, sizeof(salt));
+ * xof.extend(output, sizeof(output));
+ * \endcode
+ *
+ * The total output length is an input to every block, so the same input
+ * gives unrelated outputs for different lengths.  When the length is
+ * known, pass it to reset() to get the output of the BLAKE2 reference
+ * code for that length.  Otherwise it defaults to UNKNOWN_LENGTH and
+ * the output can be extended up to 256 GiB.
+ *
+ * Reference: https://www.blake2.net/blake2x.pdf
+ *
+ * \sa BLAKE2Xs, BLAKE2b, SHAKE256
+ */
+
+/**
+ * \var BLAKE2Xb::UNKNOWN_LENGTH
+ * \brief Output length to use when the length of the output is not
+ * known in advance.
+ */
+
+/**
+ * \var BLAKE2Xb::OUTPUT_BLOCK_SIZE
+ * \brief Size of the output blocks that are generated independently.
+ */
+
+// Initialization vectors for BLAKE2b.
+#define BLAKE2b_IV0 0x6a09e667f3bcc908ULL
+#define BLAKE2b_IV1 0xbb67ae8584caa73bULL
+#define BLAKE2b_IV2 0x3c6ef372fe94f82bULL
+#define BLAKE2b_IV3 0xa54ff53a5f1d36f1ULL
+#define BLAKE2b_IV4 0x510e527fade682d1ULL
+#define BLAKE2b_IV5 0x9b05688c2b3e6c1fULL
+#define BLAKE2b_IV6 0x1f83d9abfb41bd6bULL
+#define BLAKE2b_IV7 0x5be0cd19137e2179ULL
+
+// Number of output blocks that are computed at once.
+#if CRYPTO_BLAKE2_VEC
+#define BLAKE2XB_BATCH 4
+#else
+#define BLAKE2XB_BATCH 1
+#endif
+
+/**
+ * \brief Constructs a new BLAKE2Xb object.
+ */
+BLAKE2Xb::BLAKE2Xb()
+{
+    reset();
+}
+
+/**
+ * \brief Destroys this BLAKE2Xb object after clearing sensitive
+ * information.
+ */
+BLAKE2Xb::~BLAKE2Xb()
+{
+    clean(seed);
+    clean(block);
+}
+
+/**
+ * \brief Returns the input block size of BLAKE2Xb, which is 128.
+ */
+size_t BLAKE2Xb::blockSize() const
+{
+    return 128;
+}
+
+/**
+ * \brief Resets the XOF for a new unkeyed session with an unknown
+ * output length.
+ */
+void BLAKE2Xb::reset()
+{
+    reset(0, 0, UNKNOWN_LENGTH);
+}
+
+/**
+ * \brief Resets the XOF for a new unkeyed session with a specified
+ * output length.
+ *
+ * \param outputLength The total number of bytes that will be generated,
+ * between 1 and 2^32 - 2, or UNKNOWN_LENGTH.
+ */
+void BLAKE2Xb::reset(uint32_t outputLength)
+{
+    reset(0, 0, outputLength);
+}
+
+/**
+ * \brief Resets the XOF for a new keyed session.
+ *
+ * \param key Points to the key.
+ * \param keyLen The length of the key in bytes, between 0 and 64.
+ * \param outputLength The total number of bytes that will be generated,
+ * between 1 and 2^32 - 2, or UNKNOWN_LENGTH.
+ *
+ * If \a keyLen is greater than 64, then the \a key will be truncated to
+ * the first 64 bytes.
+ */
+void BLAKE2Xb::reset(const void *key, size_t keyLen, uint32_t outputLength)
+{
+    if (outputLength < 1)
+        outputLength = 1;
+    root.reset(key, keyLen, 64);
+    root.state.h[1] ^= ((uint64_t)outputLength) << 32;
+    xofLength = outputLength;
+    counter = 0;
+    posn = 64;
+    finalized = false;
+}
+
+void BLAKE2Xb::update(const void *data, size_t len)
+{
+    if (finalized)
+        reset();
+    root.update(data, len);
+}
+
+void BLAKE2Xb::extend(uint8_t *data, size_t len)
+{
+    if (!finalized)
+        finish();
+    while (len > 0) {
+        if (posn >= 64) {
+            if (len >= 64) {
+                // Whole blocks go straight into the caller's buffer.
+                size_t count = len / 64;
+                generate(data, counter, count);
+                counter += count;
+                data += count * 64;
+                len -= count * 64;
+                continue;
+            }
+            generate(block, counter++, 1);
+            posn = 0;
+        }
+        uint8_t size = 64 - posn;
+        if (size > len)
+            size = len;
+        memcpy(data, block + posn, size);
+        posn += size;
+        data += size;
+        len -= size;
+    }
+}
+
+void BLAKE2Xb::encrypt(uint8_t *output, const uint8_t *input, size_t len)
+{
+    uint8_t temp[BLAKE2XB_BATCH * 64];
+    if (!finalized)
+        finish();
+    while (len > 0) {
+        if (posn >= 64 && len >= sizeof(temp)) {
+            generate(temp, counter, BLAKE2XB_BATCH);
+            counter += BLAKE2XB_BATCH;
+            for (size_t index = 0; index < sizeof(temp); ++index)
+                output[index] = input[index] ^ temp[index];
+            output += sizeof(temp);
+            input += sizeof(temp);
+            len -= sizeof(temp);
+            continue;
+        }
+        if (posn >= 64) {
+            generate(block, counter++, 1);
+            posn = 0;
+        }
+        uint8_t size = 64 - posn;
+        if (size > len)
+            size = len;
+        for (uint8_t index = 0; index < size; ++index)
+            output[index] = input[index] ^ block[posn + index];
+        posn += size;
+        output += size;
+        input += size;
+        len -= size;
+    }
+    clean(temp);
+}
+
+/**
+ * \brief Seeks to a position in the output.
+ *
+ * \param offset Byte offset into the output of the next call to extend()
+ * or encrypt().
+ *
+ * Only the output block that contains \a offset is computed.  This
+ * switches the XOF into extend mode if it was not already.
+ *
+ * Copies of a BLAKE2Xb object that seek to different offsets generate
+ * different parts of the same output, so a large output can be split
+ * over several threads.
+ *
+ * \sa position()
+ */
+void BLAKE2Xb::seek(uint64_t offset)
+{
+    if (!finalized)
+        finish();
+    counter = (uint32_t)(offset / 64);
+    posn = (uint8_t)(offset % 64);
+    if (posn != 0)
+        generate(block, counter++, 1);
+    else
+        posn = 64;
+}
+
+/**
+ * \brief Returns the byte offset of the next output from extend() or
+ * encrypt().
+ *
+ * \sa seek()
+ */
+uint64_t BLAKE2Xb::position() const
+{
+    if (posn >= 64)
+        return ((uint64_t)counter) * 64;
+    return ((uint64_t)(counter - 1)) * 64 + posn;
+}
+
+void BLAKE2Xb::clear()
+{
+    root.clear();
+    clean(seed);
+    clean(block);
+    reset();
+}
+
+/**
+ * \brief Finishes the root hash and switches to extend mode.
+ */
+void BLAKE2Xb::finish()
+{
+    root.finalize(seed, sizeof(seed));
+    finalized = true;
+}
+
+/**
+ * \brief Generates consecutive output blocks.
+ *
+ * \param out Points to the buffer for count * 64 bytes of output.
+ * \param first Index of the first block.
+ * \param count Number of blocks to generate.
+ */
+void BLAKE2Xb::generate(uint8_t *out, uint32_t first, size_t count)
+{
+    uint64_t h[BLAKE2XB_BATCH][8];
+#if CRYPTO_BLAKE2_VEC
+    uint8_t m[BLAKE2XB_BATCH * 128];
+    for (uint8_t lane = 0; lane < BLAKE2XB_BATCH; ++lane) {
+        memcpy(m + lane * 128, seed, 64);
+        memset(m + lane * 128 + 64, 0, 64);
+    }
+#else
+    uint64_t m[16];
+#endif
+    while (count > 0) {
+        size_t n = (count < BLAKE2XB_BATCH) ? count : BLAKE2XB_BATCH;
+        for (size_t lane = 0; lane < n; ++lane) {
+            // Parameter block: digest length, leaf length 64, node offset
+            // "index", XOF length and inner length 64.  The last block is
+            // shorter if the output length is known and not a multiple
+            // of 64.
+            uint32_t index = first + lane;
+            uint64_t start = ((uint64_t)index) * 64;
+            uint64_t digestLen = 64;
+            if (xofLength != UNKNOWN_LENGTH && start < xofLength &&
+                    (xofLength - start) < 64)
+                digestLen = xofLength - start;
+            h[lane][0] = BLAKE2b_IV0 ^ digestLen ^ (64ULL << 32);
+            h[lane][1] = BLAKE2b_IV1 ^ index ^ (((uint64_t)xofLength) << 32);
+            h[lane][2] = BLAKE2b_IV2 ^ 0x4000;
+            h[lane][3] = BLAKE2b_IV3;
+            h[lane][4] = BLAKE2b_IV4;
+            h[lane][5] = BLAKE2b_IV5;
+            h[lane][6] = BLAKE2b_IV6;
+            h[lane][7] = BLAKE2b_IV7;
+        }
+#if CRYPTO_BLAKE2_VEC
+        blake2bLanesCompress(h, n, m, 0, 1, 64, 0xFFFFFFFFFFFFFFFFULL);
+#else
+        memcpy(m, seed, 64);
+        memset(m + 8, 0, 64);
+        BLAKE2b::compress(h[0], m, 64, 0, 0xFFFFFFFFFFFFFFFFULL, 0);
+#endif
+        for (size_t lane = 0; lane < n; ++lane) {
+            for (uint8_t word = 0; word < 8; ++word, out += 8)
+                storeLE64(out, h[lane][word]);
+        }
+        first += n;
+        count -= n;
+    }
+    clean(h);
+    clean(m);
+}
@@ -0,0 +1,339 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "BLAKE2Xs.h"
+#include "Crypto.h"
+#include "utility/EndianUtil.h"
+#include "utility/BLAKE2VectorUtil.h"
+#include <string.h>
+
+/**
+ * \class BLAKE2Xs BLAKE2Xs.h <BLAKE2Xs.h>
+ * \brief BLAKE2Xs extendable-output function (XOF).
+ *
+ * BLAKE2Xs hashes the input with BLAKE2s into a 32-byte seed and then
+ * expands the seed into 32-byte output blocks.  Output block i is the
+ * BLAKE2s hash of the seed with the node offset set to i, so each block
+ * can be computed on its own.  seek() uses that to jump to any point of
+ * the output without generating what comes before it, and on 64-bit hosts
+ * extend() computes up to 8 blocks side by side in SIMD lanes.  A block
+ * costs one BLAKE2s compression, which is much cheaper than Keccak on AVR
+ * and on hosts without SHA-3 instructions.
+ *
+ * \code
+ * BLAKE2Xs xof;
+ * xof.reset(key, sizeof(key));
+ * xof.update(salt, sizeof(salt));
+ * xof.extend(output, sizeof(output));
+ * \endcode
+ *
+ * The total output length is an input to every block, so the same input
+ * gives unrelated outputs for different lengths.  When the length is
+ * known, pass it to reset() to get the output of the BLAKE2 reference
+ * code for that length.  Otherwise it defaults to UNKNOWN_LENGTH and
+ * the output can be extended up to 128 GiB.
+ *
+ * Reference: https://www.blake2.net/blake2x.pdf
+ *
+ * \sa BLAKE2Xb, BLAKE2s, SHAKE128
+ */
+
+/**
+ * \var BLAKE2Xs::UNKNOWN_LENGTH
+ * \brief Output length to use when the length of the output is not
+ * known in advance.
+ */
+
+/**
+ * \var BLAKE2Xs::OUTPUT_BLOCK_SIZE
+ * \brief Size of the output blocks that are generated independently.
+ */
+
+// Initialization vectors for BLAKE2s.
+#define BLAKE2s_IV0 0x6A09E667
+#define BLAKE2s_IV1 0xBB67AE85
+#define BLAKE2s_IV2 0x3C6EF372
+#define BLAKE2s_IV3 0xA54FF53A
+#define BLAKE2s_IV4 0x510E527F
+#define BLAKE2s_IV5 0x9B05688C
+#define BLAKE2s_IV6 0x1F83D9AB
+#define BLAKE2s_IV7 0x5BE0CD19
+
+// Number of output blocks that are computed at once.
+#if CRYPTO_BLAKE2_VEC
+#define BLAKE2XS_BATCH 8
+#else
+#define BLAKE2XS_BATCH 1
+#endif
+
+/**
+ * \brief Constructs a new BLAKE2Xs object.
+ */
+BLAKE2Xs::BLAKE2Xs()
+{
+    reset();
+}
+
+/**
+ * \brief Destroys this BLAKE2Xs object after clearing sensitive
+ * information.
+ */
+BLAKE2Xs::~BLAKE2Xs()
+{
+    clean(seed);
+    clean(block);
+}
+
+/**
+ * \brief Returns the input block size of BLAKE2Xs, which is 64.
+ */
+size_t BLAKE2Xs::blockSize() const
+{
+    return 64;
+}
+
+/**
+ * \brief Resets the XOF for a new unkeyed session with an unknown
+ * output length.
+ */
+void BLAKE2Xs::reset()
+{
+    reset(0, 0, UNKNOWN_LENGTH);
+}
+
+/**
+ * \brief Resets the XOF for a new unkeyed session with a specified
+ * output length.
+ *
+ * \param outputLength The total number of bytes that will be generated,
+ * between 1 and 65534, or UNKNOWN_LENGTH.
+ */
+void BLAKE2Xs::reset(uint16_t outputLength)
+{
+    reset(0, 0, outputLength);
+}
+
+/**
+ * \brief Resets the XOF for a new keyed session.
+ *
+ * \param key Points to the key.
+ * \param keyLen The length of the key in bytes, between 0 and 32.
+ * \param outputLength The total number of bytes that will be generated,
+ * between 1 and 65534, or UNKNOWN_LENGTH.
+ *
+ * If \a keyLen is greater than 32, then the \a key will be truncated to
+ * the first 32 bytes.
+ */
+void BLAKE2Xs::reset(const void *key, size_t keyLen, uint16_t outputLength)
+{
+    if (outputLength < 1)
+        outputLength = 1;
+    root.reset(key, keyLen, 32);
+    root.state.h[3] ^= outputLength;
+    xofLength = outputLength;
+    counter = 0;
+    posn = 32;
+    finalized = false;
+}
+
+void BLAKE2Xs::update(const void *data, size_t len)
+{
+    if (finalized)
+        reset();
+    root.update(data, len);
+}
+
+void BLAKE2Xs::extend(uint8_t *data, size_t len)
+{
+    if (!finalized)
+        finish();
+    while (len > 0) {
+        if (posn >= 32) {
+            if (len >= 32) {
+                // Whole blocks go straight into the caller's buffer.
+                size_t count = len / 32;
+                generate(data, counter, count);
+                counter += count;
+                data += count * 32;
+                len -= count * 32;
+                continue;
+            }
+            generate(block, counter++, 1);
+            posn = 0;
+        }
+        uint8_t size = 32 - posn;
+        if (size > len)
+            size = len;
+        memcpy(data, block + posn, size);
+        posn += size;
+        data += size;
+        len -= size;
+    }
+}
+
+void BLAKE2Xs::encrypt(uint8_t *output, const uint8_t *input, size_t len)
+{
+    uint8_t temp[BLAKE2XS_BATCH * 32];
+    if (!finalized)
+        finish();
+    while (len > 0) {
+        if (posn >= 32 && len >= sizeof(temp)) {
+            generate(temp, counter, BLAKE2XS_BATCH);
+            counter += BLAKE2XS_BATCH;
+            for (size_t index = 0; index < sizeof(temp); ++index)
+                output[index] = input[index] ^ temp[index];
+            output += sizeof(temp);
+            input += sizeof(temp);
+            len -= sizeof(temp);
+            continue;
+        }
+        if (posn >= 32) {
+            generate(block, counter++, 1);
+            posn = 0;
+        }
+        uint8_t size = 32 - posn;
+        if (size > len)
+            size = len;
+        for (uint8_t index = 0; index < size; ++index)
+            output[index] = input[index] ^ block[posn + index];
+        posn += size;
+        output += size;
+        input += size;
+        len -= size;
+    }
+    clean(temp);
+}
+
+/**
+ * \brief Seeks to a position in the output.
+ *
+ * \param offset Byte offset into the output of the next call to extend()
+ * or encrypt().
+ *
+ * Only the output block that contains \a offset is computed.  This
+ * switches the XOF into extend mode if it was not already.
+ *
+ * Copies of a BLAKE2Xs object that seek to different offsets generate
+ * different parts of the same output, so a large output can be split
+ * over several threads.
+ *
+ * \sa position()
+ */
+void BLAKE2Xs::seek(uint64_t offset)
+{
+    if (!finalized)
+        finish();
+    counter = (uint32_t)(offset / 32);
+    posn = (uint8_t)(offset % 32);
+    if (posn != 0)
+        generate(block, counter++, 1);
+    else
+        posn = 32;
+}
+
+/**
+ * \brief Returns the byte offset of the next output from extend() or
+ * encrypt().
+ *
+ * \sa seek()
+ */
+uint64_t BLAKE2Xs::position() const
+{
+    if (posn >= 32)
+        return ((uint64_t)counter) * 32;
+    return ((uint64_t)(counter - 1)) * 32 + posn;
+}
+
+void BLAKE2Xs::clear()
+{
+    root.clear();
+    clean(seed);
+    clean(block);
+    reset();
+}
+
+/**
+ * \brief Finishes the root hash and switches to extend mode.
+ */
+void BLAKE2Xs::finish()
+{
+    root.finalize(seed, sizeof(seed));
+    finalized = true;
+}
+
+/**
+ * \brief Generates consecutive output blocks.
+ *
+ * \param out Points to the buffer for count * 32 bytes of output.
+ * \param first Index of the first block.
+ * \param count Number of blocks to generate.
+ */
+void BLAKE2Xs::generate(uint8_t *out, uint32_t first, size_t count)
+{
+    uint32_t h[BLAKE2XS_BATCH][8];
+#if CRYPTO_BLAKE2_VEC
+    uint8_t m[BLAKE2XS_BATCH * 64];
+    for (uint8_t lane = 0; lane < BLAKE2XS_BATCH; ++lane) {
+        memcpy(m + lane * 64, seed, 32);
+        memset(m + lane * 64 + 32, 0, 32);
+    }
+#else
+    uint32_t m[16];
+#endif
+    while (count > 0) {
+        size_t n = (count < BLAKE2XS_BATCH) ? count : BLAKE2XS_BATCH;
+        for (size_t lane = 0; lane < n; ++lane) {
+            // Parameter block: digest length, leaf length 32, node offset
+            // "index", XOF length and inner length 32.  The last block is
+            // shorter if the output length is known and not a multiple
+            // of 32.
+            uint32_t index = first + lane;
+            uint64_t start = ((uint64_t)index) * 32;
+            uint32_t digestLen = 32;
+            if (xofLength != UNKNOWN_LENGTH && start < xofLength &&
+                    (xofLength - start) < 32)
+                digestLen = (uint32_t)(xofLength - start);
+            h[lane][0] = BLAKE2s_IV0 ^ digestLen;
+            h[lane][1] = BLAKE2s_IV1 ^ 32;
+            h[lane][2] = BLAKE2s_IV2 ^ index;
+            h[lane][3] = BLAKE2s_IV3 ^ xofLength ^ 0x20000000;
+            h[lane][4] = BLAKE2s_IV4;
+            h[lane][5] = BLAKE2s_IV5;
+            h[lane][6] = BLAKE2s_IV6;
+            h[lane][7] = BLAKE2s_IV7;
+        }
+#if CRYPTO_BLAKE2_VEC
+        blake2sLanesCompress(h, n, m, 0, 1, 32, 0xFFFFFFFF);
+#else
+        memcpy(m, seed, 32);
+        memset(m + 8, 0, 32);
+        BLAKE2s::compress(h[0], m, 32, 0xFFFFFFFF, 0);
+#endif
+        for (size_t lane = 0; lane < n; ++lane) {
+            for (uint8_t word = 0; word < 8; ++word, out += 4)
+                storeLE32(out, h[lane][word]);
+        }
+        first += n;
+        count -= n;
+    }
+    clean(h);
+    clean(m);
+}
@@ -0,0 +1,67 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_BLAKE2XS_H
+#define CRYPTO_BLAKE2XS_H
+
+#include "XOF.h"
+#include "BLAKE2s.h"
+
+class BLAKE2Xs : public XOF
+{
+public:
+    BLAKE2Xs();
+    virtual ~BLAKE2Xs();
+
+    size_t blockSize() const;
+
+    void reset();
+    void reset(uint16_t outputLength);
+    void reset(const void *key, size_t keyLen,
+               uint16_t outputLength = UNKNOWN_LENGTH);
+
+    void update(const void *data, size_t len);
+
+    void extend(uint8_t *data, size_t len);
+    void encrypt(uint8_t *output, const uint8_t *input, size_t len);
+
+    void seek(uint64_t offset);
+    uint64_t position() const;
+
+    void clear();
+
+    static const uint16_t UNKNOWN_LENGTH = 0xFFFF;
+    static const size_t OUTPUT_BLOCK_SIZE = 32;
+
+private:
+    BLAKE2s root;
+    uint8_t seed[32];
+    uint8_t block[32];
+    uint32_t counter;
+    uint16_t xofLength;
+    uint8_t posn;
+    bool finalized;
+
+    void finish();
+    void generate(uint8_t *out, uint32_t first, size_t count);
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include "utility/EndianUtil.h"
 #include "utility/RotateUtil.h"
 #include "utility/ProgMemUtil.h"
+#include "utility/BLAKE2VectorUtil.h"
 #include <string.h>
 
 /**
@@ -210,6 +211,22 @@ void BLAKE2b::update(const void *data, size_t len)
             processChunk(0);
             state.chunkSize = 0;
         }
+#if CRYPTO_BLAKE2_VEC
+        if (state.chunkSize == 0 && len > 128) {
+            // Compress whole blocks straight from the caller's buffer,
+            // keeping back at least one byte for the last chunk.
+            size_t blocks = (len - 1) / 128;
+            uint64_t t0 = state.lengthLow + 128;
+            blake2bVectorCompress(state.h, d, blocks, t0,
+                                  state.lengthHigh + (t0 < 128), 0, 0);
+            t0 = state.lengthLow;
+            state.lengthLow += blocks * 128;
+            if (state.lengthLow < t0)
+                ++state.lengthHigh;
+            len -= blocks * 128;
+            d += blocks * 128;
+        }
+#endif
         uint8_t size = 128 - state.chunkSize;
         if (size > len)
             size = len;
@@ -256,15 +273,74 @@ void BLAKE2b::resetHMAC(const void *key, size_t keyLen)
 void BLAKE2b::finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen)
 {
     uint8_t temp[64];
-    finalize(temp, sizeof(temp));
+    BLAKE2b::finalize(temp, sizeof(temp));
     formatHMACKey(state.m, key, keyLen, 0x5C);
     state.lengthLow += 128;
     state.chunkSize = 128;
-    update(temp, sizeof(temp));
-    finalize(hash, hashLen);
+    BLAKE2b::update(temp, sizeof(temp));
+    BLAKE2b::finalize(hash, hashLen);
     clean(temp);
 }
 
+/**
+ * \brief Size of the snapshot blob, always SNAPSHOT_SIZE.
+ */
+size_t BLAKE2b::snapshotSize() const
+{
+    return SNAPSHOT_SIZE;
+}
+
+/**
+ * \brief Writes the current state of the hashing process to a blob.
+ *
+ * \param blob Points to SNAPSHOT_SIZE bytes to receive the snapshot.
+ *
+ * \sa restore(), snapshotSize()
+ */
+void BLAKE2b::snapshot(void *blob) const
+{
+    uint8_t *b = (uint8_t *)blob;
+    b[0] = SnapshotBLAKE2b;
+    b[1] = SnapshotVersion;
+    b[2] = state.chunkSize;
+    b[3] = 0;
+    b += SnapshotHeaderSize;
+    for (uint8_t posn = 0; posn < 8; ++posn, b += 8)
+        storeLE64(b, state.h[posn]);
+    storeLE64(b, state.lengthLow);
+    storeLE64(b + 8, state.lengthHigh);
+    b += 16;
+    memcpy(b, state.m, state.chunkSize);
+    memset(b + state.chunkSize, 0, 128 - state.chunkSize);
+}
+
+/**
+ * \brief Restores the state of a hashing process from a snapshot blob.
+ *
+ * \param blob Points to the blob that was written by snapshot().
+ * \param len Length of the \a blob, which must be SNAPSHOT_SIZE.
+ *
+ * \return Returns false if the blob is not a valid BLAKE2b snapshot.
+ *
+ * \sa snapshot()
+ */
+bool BLAKE2b::restore(const void *blob, size_t len)
+{
+    const uint8_t *b = (const uint8_t *)blob;
+    if (len != SNAPSHOT_SIZE || b[0] != SnapshotBLAKE2b ||
+            b[1] != SnapshotVersion || b[2] > 128 || b[3] != 0)
+        return false;
+    state.chunkSize = b[2];
+    b += SnapshotHeaderSize;
+    for (uint8_t posn = 0; posn < 8; ++posn, b += 8)
+        state.h[posn] = loadLE64(b);
+    state.lengthLow = loadLE64(b);
+    state.lengthHigh = loadLE64(b + 8);
+    b += 16;
+    memcpy(state.m, b, 128);
+    return true;
+}
+
 // Permutation on the message input state for BLAKE2b.
 static const uint8_t sigma[12][16] PROGMEM = {
     { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
@@ -285,11 +361,11 @@ static const uint8_t sigma[12][16] PROGMEM = {
 #define quarterRound(a, b, c, d, i)    \
     do { \
         uint64_t _b = (b); \
-        uint64_t _a = (a) + _b + state.m[pgm_read_byte(&(sigma[index][2 * (i)]))]; \
+        uint64_t _a = (a) + _b + m[pgm_read_byte(&(sigma[index][2 * (i)]))]; \
         uint64_t _d = rightRotate32_64((d) ^ _a); \
         uint64_t _c = (c) + _d; \
         _b = rightRotate24_64(_b ^ _c); \
-        _a += _b + state.m[pgm_read_byte(&(sigma[index][2 * (i) + 1]))]; \
+        _a += _b + m[pgm_read_byte(&(sigma[index][2 * (i) + 1]))]; \
         (d) = _d = rightRotate16_64(_d ^ _a); \
         _c += _d; \
         (a) = _a; \
@@ -298,26 +374,49 @@ static const uint8_t sigma[12][16] PROGMEM = {
     } while (0)
 
 void BLAKE2b::processChunk(uint64_t f0)
+{
+    compress(state.h, state.m, state.lengthLow, state.lengthHigh, f0, 0);
+}
+
+/**
+ * \brief Compresses a single 1024-bit block into a chaining value.
+ *
+ * \param h The chaining value.
+ * \param m The message block, which may be byte-swapped in place.
+ * \param lengthLow The low word of the byte counter, including this block.
+ * \param lengthHigh The high word of the byte counter.
+ * \param f0 The finalization flag for the last block of the message.
+ * \param f1 The last node flag for the last leaf of a tree, which is
+ * only used by BLAKE2bp.
+ */
+void BLAKE2b::compress(uint64_t h[8], uint64_t m[16], uint64_t lengthLow,
+                       uint64_t lengthHigh, uint64_t f0, uint64_t f1)
 {
     uint8_t index;
     uint64_t v[16];
 
+#if CRYPTO_BLAKE2_VEC
+    blake2bVectorCompress(h, (const uint8_t *)m, 1, lengthLow, lengthHigh,
+                          f0, f1);
+    return;
+#endif
+
     // Byte-swap the message buffer into little-endian if necessary.
 #if !defined(CRYPTO_LITTLE_ENDIAN)
     for (index = 0; index < 16; ++index)
-        state.m[index] = le64toh(state.m[index]);
+        m[index] = le64toh(m[index]);
 #endif
 
     // Format the block to be hashed.
-    memcpy(v, state.h, sizeof(state.h));
+    memcpy(v, h, 8 * sizeof(uint64_t));
     v[8]  = BLAKE2b_IV0;
     v[9]  = BLAKE2b_IV1;
     v[10] = BLAKE2b_IV2;
     v[11] = BLAKE2b_IV3;
-    v[12] = BLAKE2b_IV4 ^ state.lengthLow;
-    v[13] = BLAKE2b_IV5 ^ state.lengthHigh;
+    v[12] = BLAKE2b_IV4 ^ lengthLow;
+    v[13] = BLAKE2b_IV5 ^ lengthHigh;
     v[14] = BLAKE2b_IV6 ^ f0;
-    v[15] = BLAKE2b_IV7;
+    v[15] = BLAKE2b_IV7 ^ f1;
 
     // Perform the 12 BLAKE2b rounds.
     for (index = 0; index < 12; ++index) {
@@ -336,5 +435,5 @@ void BLAKE2b::processChunk(uint64_t f0)
 
     // Combine the new and old hash values.
     for (index = 0; index < 8; ++index)
-        state.h[index] ^= (v[index] ^ v[index + 8]);
+        h[index] ^= (v[index] ^ v[index + 8]);
 }
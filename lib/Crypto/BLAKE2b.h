@@ -46,8 +46,13 @@ public:
     void resetHMAC(const void *key, size_t keyLen);
     void finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen);
 
+    size_t snapshotSize() const;
+    void snapshot(void *blob) const;
+    bool restore(const void *blob, size_t len);
+
     static const size_t HASH_SIZE  = 64;
     static const size_t BLOCK_SIZE = 128;
+    static const size_t SNAPSHOT_SIZE = 212;
 
 private:
     struct {
@@ -59,6 +64,11 @@ private:
     } state;
 
     void processChunk(uint64_t f0);
+    static void compress(uint64_t h[8], uint64_t m[16], uint64_t lengthLow,
+                         uint64_t lengthHigh, uint64_t f0, uint64_t f1);
+
+    friend class BLAKE2bp;
+    friend class BLAKE2Xb;
 };
 
 #endif
@@ -0,0 +1,457 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "BLAKE2bp.h"
+#include "BLAKE2b.h"
+#include "Crypto.h"
+#include "utility/EndianUtil.h"
+#include "utility/BLAKE2VectorUtil.h"
+#include "ThreadPool.h"
+#include <string.h>
+
+/**
+ * \class BLAKE2bp BLAKE2bp.h <BLAKE2bp.h>
+ * \brief BLAKE2bp hash algorithm, the 4-way parallel form of BLAKE2b.
+ *
+ * BLAKE2bp splits the message into 128-byte blocks and deals them out in
+ * turn to 4 BLAKE2b leaves, then hashes the 4 leaf digests with a root
+ * BLAKE2b node.  The output is not the same as BLAKE2b over the same
+ * data.  The leaves are independent, so on 64-bit hosts they run side by
+ * side in SIMD lanes (all 4 at once with AVX2, 2 at a time with SSE or
+ * NEON), which makes BLAKE2bp faster than BLAKE2b for long messages.  On
+ * other platforms the leaves are compressed one after the other and
+ * BLAKE2bp is a little slower than BLAKE2b.
+ *
+ * The object holds 4 chaining values and up to 1K of buffered input, which
+ * is too much for the smaller AVR boards.
+ *
+ * For very large inputs that are in memory already, hash() can also
+ * spread the leaves over the threads of a ThreadPool:
+ *
+ * \code
+ * ThreadPool pool;
+ * uint8_t digest[64];
+ * BLAKE2bp::hash(digest, sizeof(digest), bundle, bundleLen, &pool);
+ * \endcode
+ *
+ * The keyed hash and HMAC work the same way as for BLAKE2b.
+ *
+ * Reference: https://blake2.net/blake2.pdf
+ *
+ * \sa BLAKE2b, BLAKE2sp, TreeHash
+ */
+
+/**
+ * \var BLAKE2bp::HASH_SIZE
+ * \brief Constant for the size of the hash output of BLAKE2bp.
+ */
+
+/**
+ * \var BLAKE2bp::BLOCK_SIZE
+ * \brief Constant for the block size of BLAKE2bp.
+ */
+
+/**
+ * \var BLAKE2bp::LEAVES
+ * \brief Number of leaves that the message is spread over.
+ */
+
+// Initialization vectors for BLAKE2b.
+#define BLAKE2b_IV0 0x6a09e667f3bcc908ULL
+#define BLAKE2b_IV1 0xbb67ae8584caa73bULL
+#define BLAKE2b_IV2 0x3c6ef372fe94f82bULL
+#define BLAKE2b_IV3 0xa54ff53a5f1d36f1ULL
+#define BLAKE2b_IV4 0x510e527fade682d1ULL
+#define BLAKE2b_IV5 0x9b05688c2b3e6c1fULL
+#define BLAKE2b_IV6 0x1f83d9abfb41bd6bULL
+#define BLAKE2b_IV7 0x5be0cd19137e2179ULL
+
+// One block for each leaf.
+#define STRIPE_SIZE (BLAKE2bp::LEAVES * BLAKE2bp::BLOCK_SIZE)
+
+/**
+ * \brief Constructs a BLAKE2bp hash object.
+ */
+BLAKE2bp::BLAKE2bp()
+{
+    reset();
+}
+
+/**
+ * \brief Destroys this BLAKE2bp hash object after clearing
+ * sensitive information.
+ */
+BLAKE2bp::~BLAKE2bp()
+{
+    clean(h);
+    clean(buffer);
+}
+
+size_t BLAKE2bp::hashSize() const
+{
+    return 64;
+}
+
+size_t BLAKE2bp::blockSize() const
+{
+    return 128;
+}
+
+void BLAKE2bp::reset()
+{
+    init(0, 64);
+}
+
+/**
+ * \brief Resets the hash ready for a new hashing process with a specified
+ * output length.
+ *
+ * \param outputLength The output length to use for the final hash in bytes,
+ * between 1 and 64.
+ */
+void BLAKE2bp::reset(uint8_t outputLength)
+{
+    if (outputLength < 1)
+        outputLength = 1;
+    else if (outputLength > 64)
+        outputLength = 64;
+    init(0, outputLength);
+}
+
+/**
+ * \brief Resets the hash ready for a new hashing process with a specified
+ * key and output length.
+ *
+ * \param key Points to the key.
+ * \param keyLen The length of the key in bytes, between 0 and 64.
+ * \param outputLength The output length to use for the final hash in bytes,
+ * between 1 and 64.
+ *
+ * If \a keyLen is greater than 64, then the \a key will be truncated to
+ * the first 64 bytes.
+ */
+void BLAKE2bp::reset(const void *key, size_t keyLen, uint8_t outputLength)
+{
+    if (keyLen > 64)
+        keyLen = 64;
+    if (outputLength < 1)
+        outputLength = 1;
+    else if (outputLength > 64)
+        outputLength = 64;
+    init(keyLen, outputLength);
+    if (keyLen > 0) {
+        // Every leaf starts with the key padded to a block.
+        for (uint8_t leaf = 0; leaf < LEAVES; ++leaf) {
+            uint8_t *block = buffer + leaf * BLOCK_SIZE;
+            memcpy(block, key, keyLen);
+            memset(block + keyLen, 0, BLOCK_SIZE - keyLen);
+        }
+        posn = STRIPE_SIZE;
+    }
+}
+
+void BLAKE2bp::update(const void *data, size_t len)
+{
+    // The buffer holds up to two stripes.  A stripe can only be compressed
+    // once every leaf is known to have a block after it, because the last
+    // block of each leaf is compressed differently.
+    const uint8_t *d = (const uint8_t *)data;
+    while (len > 0) {
+        if (posn == sizeof(buffer)) {
+            compressLeaves(h, LEAVES, buffer, 1, length);
+            length += BLOCK_SIZE;
+            memcpy(buffer, buffer + STRIPE_SIZE, STRIPE_SIZE);
+            posn = STRIPE_SIZE;
+        }
+        if (posn == STRIPE_SIZE && len > STRIPE_SIZE) {
+            // Compress the buffered stripe and then whole stripes straight
+            // from the caller's data, keeping back between one and two
+            // stripes' worth for later.
+            compressLeaves(h, LEAVES, buffer, 1, length);
+            length += BLOCK_SIZE;
+            posn = 0;
+            size_t stripes = (len - 1) / STRIPE_SIZE - 1;
+            if (stripes > 0) {
+                compressLeaves(h, LEAVES, d, stripes, length);
+                length += stripes * BLOCK_SIZE;
+                d += stripes * STRIPE_SIZE;
+                len -= stripes * STRIPE_SIZE;
+            }
+        }
+        size_t size = sizeof(buffer) - posn;
+        if (size > len)
+            size = len;
+        memcpy(buffer + posn, d, size);
+        posn += size;
+        d += size;
+        len -= size;
+    }
+}
+
+void BLAKE2bp::finalize(void *hash, size_t len)
+{
+    for (uint8_t leaf = 0; leaf < LEAVES; ++leaf)
+        finishLeaf(h[leaf], leaf, buffer, posn, length);
+    finishRoot(hash, len, h, keyLen, outLen);
+}
+
+void BLAKE2bp::clear()
+{
+    clean(h);
+    clean(buffer);
+    reset();
+}
+
+void BLAKE2bp::resetHMAC(const void *key, size_t keyLen)
+{
+    uint8_t block[BLOCK_SIZE];
+    formatHMACKey(block, key, keyLen, 0x36);
+    update(block, sizeof(block));
+    clean(block);
+}
+
+void BLAKE2bp::finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen)
+{
+    uint8_t block[BLOCK_SIZE];
+    uint8_t temp[HASH_SIZE];
+    finalize(temp, sizeof(temp));
+    formatHMACKey(block, key, keyLen, 0x5C);
+    update(block, sizeof(block));
+    update(temp, sizeof(temp));
+    finalize(hash, hashLen);
+    clean(block);
+    clean(temp);
+}
+
+/**
+ * \brief Hashes a message that is already in memory with BLAKE2bp.
+ *
+ * \param out Points to the buffer to receive the hash.
+ * \param outLen Length of the hash to produce, up to 64 bytes.
+ * \param data Points to the message.
+ * \param len Length of the message in bytes.
+ * \param pool Optional thread pool to hash the leaves on, or NULL to hash
+ * them all on the calling thread.
+ *
+ * The result is the same as reset(), update() and finalize() on a
+ * BLAKE2bp object.  With a pool of N threads the leaves are split into
+ * min(N, 4) groups (rounded down to a power of two) and each group is
+ * hashed on its own thread, still using SIMD lanes within the group.
+ * Thread pools are not available on Arduino builds and \a pool is ignored.
+ */
+void BLAKE2bp::hash(void *out, size_t outLen, const void *data, size_t len,
+                    ThreadPool *pool)
+{
+    uint64_t h[LEAVES][8];
+    BulkJob job;
+    size_t tasks = 1;
+    initLeaves(h, 0, 64);
+    job.h = h;
+    job.data = (const uint8_t *)data;
+    job.len = len;
+
+    // Every stripe that has more than 3 blocks after it is followed by a
+    // block for each of the leaves.
+    if (len > (LEAVES - 1) * BLOCK_SIZE)
+        job.stripes = (len - (LEAVES - 1) * BLOCK_SIZE - 1) / STRIPE_SIZE;
+    else
+        job.stripes = 0;
+
+#if CRYPTO_THREADS
+    if (pool && job.stripes > 0) {
+        size_t threads = pool->size();
+        while ((tasks * 2) <= threads && tasks < LEAVES)
+            tasks *= 2;
+    }
+#else
+    (void)pool;
+#endif
+    job.group = LEAVES / tasks;
+#if CRYPTO_THREADS
+    if (tasks > 1) {
+        pool->run(hashLeaves, &job, tasks);
+        finishRoot(out, outLen, h, 0, 64);
+        clean(h);
+        return;
+    }
+#endif
+    hashLeaves(&job, 0);
+    finishRoot(out, outLen, h, 0, 64);
+    clean(h);
+}
+
+void BLAKE2bp::init(uint8_t keyLen, uint8_t outputLength)
+{
+    initLeaves(h, keyLen, outputLength);
+    length = 0;
+    posn = 0;
+    this->keyLen = keyLen;
+    outLen = outputLength;
+}
+
+/**
+ * \brief Sets up the chaining values of the leaves.
+ */
+void BLAKE2bp::initLeaves(uint64_t (*h)[8], uint8_t keyLen, uint8_t outLen)
+{
+    // Parameter block: fanout 4, depth 2, node offset "leaf",
+    // node depth 0 and inner length 64.
+    for (uint8_t leaf = 0; leaf < LEAVES; ++leaf) {
+        h[leaf][0] = BLAKE2b_IV0 ^ 0x02040000 ^
+                     (((uint64_t)keyLen) << 8) ^ outLen;
+        h[leaf][1] = BLAKE2b_IV1 ^ leaf;
+        h[leaf][2] = BLAKE2b_IV2 ^ 0x4000;
+        h[leaf][3] = BLAKE2b_IV3;
+        h[leaf][4] = BLAKE2b_IV4;
+        h[leaf][5] = BLAKE2b_IV5;
+        h[leaf][6] = BLAKE2b_IV6;
+        h[leaf][7] = BLAKE2b_IV7;
+    }
+}
+
+/**
+ * \brief Compresses whole stripes into a run of leaves.
+ *
+ * \param h Chaining values of the leaves.
+ * \param leaves Number of leaves in the run.
+ * \param data Points to the first block of the first leaf in the run;
+ * the leaf's next block is STRIPE_SIZE bytes later.
+ * \param stripes Number of blocks to compress into each leaf.
+ * \param length Number of bytes already compressed into each leaf.
+ */
+void BLAKE2bp::compressLeaves(uint64_t (*h)[8], size_t leaves,
+                              const uint8_t *data, size_t stripes,
+                              uint64_t length)
+{
+#if CRYPTO_BLAKE2_VEC
+    blake2bLanesCompress(h, leaves, data, STRIPE_SIZE, stripes,
+                         length + BLOCK_SIZE, 0);
+#else
+    uint64_t m[16];
+    while (stripes-- > 0) {
+        length += BLOCK_SIZE;
+        for (size_t leaf = 0; leaf < leaves; ++leaf) {
+            memcpy(m, data + leaf * BLOCK_SIZE, BLOCK_SIZE);
+            BLAKE2b::compress(h[leaf], m, length, 0, 0, 0);
+        }
+        data += STRIPE_SIZE;
+    }
+    clean(m);
+#endif
+}
+
+/**
+ * \brief Compresses the last one or two blocks of a leaf.
+ *
+ * \param h Chaining value of the leaf.
+ * \param leaf Index of the leaf.
+ * \param rest Points to the rest of the message after the stripes that
+ * have been compressed already.
+ * \param restLen Length of the rest of the message, at most two stripes.
+ * \param length Number of bytes already compressed into each leaf.
+ */
+void BLAKE2bp::finishLeaf(uint64_t h[8], size_t leaf, const uint8_t *rest,
+                          size_t restLen, uint64_t length)
+{
+    uint64_t m[16];
+    size_t offset = leaf * BLOCK_SIZE;
+    if (restLen > (offset + STRIPE_SIZE)) {
+        memcpy(m, rest + offset, BLOCK_SIZE);
+        length += BLOCK_SIZE;
+        BLAKE2b::compress(h, m, length, 0, 0, 0);
+        offset += STRIPE_SIZE;
+    }
+    size_t size = 0;
+    if (restLen > offset) {
+        size = restLen - offset;
+        if (size > BLOCK_SIZE)
+            size = BLOCK_SIZE;
+        memcpy(m, rest + offset, size);
+    }
+    memset(((uint8_t *)m) + size, 0, BLOCK_SIZE - size);
+    BLAKE2b::compress(h, m, length + size, 0, 0xFFFFFFFFFFFFFFFFULL,
+                      leaf == (LEAVES - 1) ? 0xFFFFFFFFFFFFFFFFULL : 0);
+    clean(m);
+}
+
+/**
+ * \brief Hashes the leaf digests with the root node.
+ *
+ * \param hash Points to the buffer to receive the hash.
+ * \param len Length of the hash to return.
+ * \param h Final chaining values of the leaves.
+ * \param keyLen Length of the key, which is part of the root parameters.
+ * \param outLen Output length parameter.
+ */
+void BLAKE2bp::finishRoot(void *hash, size_t len, uint64_t (*h)[8],
+                          uint8_t keyLen, uint8_t outLen)
+{
+    // Parameter block: fanout 4, depth 2, node offset 0, node depth 1
+    // and inner length 64.
+    uint64_t root[8];
+    uint64_t m[16];
+    root[0] = BLAKE2b_IV0 ^ 0x02040000 ^ (((uint64_t)keyLen) << 8) ^ outLen;
+    root[1] = BLAKE2b_IV1;
+    root[2] = BLAKE2b_IV2 ^ 0x4001;
+    root[3] = BLAKE2b_IV3;
+    root[4] = BLAKE2b_IV4;
+    root[5] = BLAKE2b_IV5;
+    root[6] = BLAKE2b_IV6;
+    root[7] = BLAKE2b_IV7;
+
+    // The 4 leaf digests fill exactly 2 blocks.
+    for (uint8_t block = 0; block < (LEAVES / 2); ++block) {
+        for (uint8_t posn = 0; posn < 16; ++posn)
+            m[posn] = htole64(h[block * 2 + posn / 8][posn % 8]);
+        uint64_t last = (block == (LEAVES / 2 - 1)) ? 0xFFFFFFFFFFFFFFFFULL : 0;
+        BLAKE2b::compress(root, m, (block + 1) * BLOCK_SIZE, 0, last, last);
+    }
+
+    for (uint8_t posn = 0; posn < 8; ++posn)
+        m[posn] = htole64(root[posn]);
+    if (len > 64)
+        len = 64;
+    memcpy(hash, m, len);
+    clean(root);
+    clean(m);
+}
+
+/**
+ * \brief Hashes one group of leaves for hash().
+ */
+void BLAKE2bp::hashLeaves(void *arg, size_t index)
+{
+    const BulkJob *job = (const BulkJob *)arg;
+    size_t first = index * job->group;
+    size_t restPosn = job->stripes * STRIPE_SIZE;
+    uint64_t h[LEAVES][8];
+
+    // Work on a local copy so that threads do not share cache lines.
+    memcpy(h, job->h + first, job->group * sizeof(h[0]));
+    compressLeaves(h, job->group, job->data + first * BLOCK_SIZE,
+                   job->stripes, 0);
+    for (size_t leaf = 0; leaf < job->group; ++leaf) {
+        finishLeaf(h[leaf], first + leaf, job->data + restPosn,
+                   job->len - restPosn, job->stripes * BLOCK_SIZE);
+    }
+    memcpy(job->h + first, h, job->group * sizeof(h[0]));
+    clean(h);
+}
@@ -0,0 +1,87 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_BLAKE2BP_H
+#define CRYPTO_BLAKE2BP_H
+
+#include "Hash.h"
+
+class ThreadPool;
+
+class BLAKE2bp : public Hash
+{
+public:
+    BLAKE2bp();
+    virtual ~BLAKE2bp();
+
+    size_t hashSize() const;
+    size_t blockSize() const;
+
+    void reset();
+    void reset(uint8_t outputLength);
+    void reset(const void *key, size_t keyLen, uint8_t outputLength = 64);
+
+    void update(const void *data, size_t len);
+    void finalize(void *hash, size_t len);
+
+    void clear();
+
+    void resetHMAC(const void *key, size_t keyLen);
+    void finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen);
+
+    static void hash(void *out, size_t outLen, const void *data, size_t len,
+                     ThreadPool *pool = 0);
+
+    static const size_t HASH_SIZE  = 64;
+    static const size_t BLOCK_SIZE = 128;
+    static const size_t LEAVES = 4;
+
+private:
+    uint64_t h[LEAVES][8];
+    uint8_t buffer[2 * LEAVES * BLOCK_SIZE];
+    uint64_t length;
+    uint16_t posn;
+    uint8_t keyLen;
+    uint8_t outLen;
+
+    void init(uint8_t keyLen, uint8_t outputLength);
+
+    static void initLeaves(uint64_t (*h)[8], uint8_t keyLen, uint8_t outLen);
+    static void compressLeaves(uint64_t (*h)[8], size_t leaves,
+                               const uint8_t *data, size_t stripes,
+                               uint64_t length);
+    static void finishLeaf(uint64_t h[8], size_t leaf, const uint8_t *rest,
+                           size_t restLen, uint64_t length);
+    static void finishRoot(void *hash, size_t len, uint64_t (*h)[8],
+                           uint8_t keyLen, uint8_t outLen);
+
+    struct BulkJob
+    {
+        uint64_t (*h)[8];
+        const uint8_t *data;
+        size_t len;
+        size_t stripes;
+        size_t group;
+    };
+    static void hashLeaves(void *arg, size_t index);
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include "utility/EndianUtil.h"
 #include "utility/RotateUtil.h"
 #include "utility/ProgMemUtil.h"
+#include "utility/BLAKE2VectorUtil.h"
 #include <string.h>
 
 /**
@@ -207,6 +208,17 @@ void BLAKE2s::update(const void *data, size_t len)
             processChunk(0);
             state.chunkSize = 0;
         }
+#if CRYPTO_BLAKE2_VEC
+        if (state.chunkSize == 0 && len > 64) {
+            // Compress whole blocks straight from the caller's buffer,
+            // keeping back at least one byte for the last chunk.
+            size_t blocks = (len - 1) / 64;
+            blake2sVectorCompress(state.h, d, blocks, state.length + 64, 0, 0);
+            state.length += blocks * 64;
+            len -= blocks * 64;
+            d += blocks * 64;
+        }
+#endif
         uint8_t size = 64 - state.chunkSize;
         if (size > len)
             size = len;
@@ -250,15 +262,72 @@ void BLAKE2s::resetHMAC(const void *key, size_t keyLen)
 void BLAKE2s::finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen)
 {
     uint8_t temp[32];
-    finalize(temp, sizeof(temp));
+    BLAKE2s::finalize(temp, sizeof(temp));
     formatHMACKey(state.m, key, keyLen, 0x5C);
     state.length += 64;
     state.chunkSize = 64;
-    update(temp, sizeof(temp));
-    finalize(hash, hashLen);
+    BLAKE2s::update(temp, sizeof(temp));
+    BLAKE2s::finalize(hash, hashLen);
     clean(temp);
 }
 
+/**
+ * \brief Size of the snapshot blob, always SNAPSHOT_SIZE.
+ */
+size_t BLAKE2s::snapshotSize() const
+{
+    return SNAPSHOT_SIZE;
+}
+
+/**
+ * \brief Writes the current state of the hashing process to a blob.
+ *
+ * \param blob Points to SNAPSHOT_SIZE bytes to receive the snapshot.
+ *
+ * \sa restore(), snapshotSize()
+ */
+void BLAKE2s::snapshot(void *blob) const
+{
+    uint8_t *b = (uint8_t *)blob;
+    b[0] = SnapshotBLAKE2s;
+    b[1] = SnapshotVersion;
+    b[2] = state.chunkSize;
+    b[3] = 0;
+    b += SnapshotHeaderSize;
+    for (uint8_t posn = 0; posn < 8; ++posn, b += 4)
+        storeLE32(b, state.h[posn]);
+    storeLE64(b, state.length);
+    b += 8;
+    memcpy(b, state.m, state.chunkSize);
+    memset(b + state.chunkSize, 0, 64 - state.chunkSize);
+}
+
+/**
+ * \brief Restores the state of a hashing process from a snapshot blob.
+ *
+ * \param blob Points to the blob that was written by snapshot().
+ * \param len Length of the \a blob, which must be SNAPSHOT_SIZE.
+ *
+ * \return Returns false if the blob is not a valid BLAKE2s snapshot.
+ *
+ * \sa snapshot()
+ */
+bool BLAKE2s::restore(const void *blob, size_t len)
+{
+    const uint8_t *b = (const uint8_t *)blob;
+    if (len != SNAPSHOT_SIZE || b[0] != SnapshotBLAKE2s ||
+            b[1] != SnapshotVersion || b[2] > 64 || b[3] != 0)
+        return false;
+    state.chunkSize = b[2];
+    b += SnapshotHeaderSize;
+    for (uint8_t posn = 0; posn < 8; ++posn, b += 4)
+        state.h[posn] = loadLE32(b);
+    state.length = loadLE64(b);
+    b += 8;
+    memcpy(state.m, b, 64);
+    return true;
+}
+
 // Permutation on the message input state for BLAKE2s.
 static const uint8_t sigma[10][16] PROGMEM = {
     { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
@@ -277,11 +346,11 @@ static const uint8_t sigma[10][16] PROGMEM = {
 #define quarterRound(a, b, c, d, i)    \
     do { \
         uint32_t _b = (b); \
-        uint32_t _a = (a) + _b + state.m[pgm_read_byte(&(sigma[index][2 * (i)]))]; \
+        uint32_t _a = (a) + _b + m[pgm_read_byte(&(sigma[index][2 * (i)]))]; \
         uint32_t _d = rightRotate16((d) ^ _a); \
         uint32_t _c = (c) + _d; \
         _b = rightRotate12(_b ^ _c); \
-        _a += _b + state.m[pgm_read_byte(&(sigma[index][2 * (i) + 1]))]; \
+        _a += _b + m[pgm_read_byte(&(sigma[index][2 * (i) + 1]))]; \
         (d) = _d = rightRotate8(_d ^ _a); \
         _c += _d; \
         (a) = _a; \
@@ -290,26 +359,47 @@ static const uint8_t sigma[10][16] PROGMEM = {
     } while (0)
 
 void BLAKE2s::processChunk(uint32_t f0)
+{
+    compress(state.h, state.m, state.length, f0, 0);
+}
+
+/**
+ * \brief Compresses a single 512-bit block into a chaining value.
+ *
+ * \param h The chaining value.
+ * \param m The message block, which may be byte-swapped in place.
+ * \param length The byte counter, including this block.
+ * \param f0 The finalization flag for the last block of the message.
+ * \param f1 The last node flag for the last leaf of a tree, which is
+ * only used by BLAKE2sp.
+ */
+void BLAKE2s::compress(uint32_t h[8], uint32_t m[16], uint64_t length,
+                       uint32_t f0, uint32_t f1)
 {
     uint8_t index;
     uint32_t v[16];
 
+#if CRYPTO_BLAKE2_VEC
+    blake2sVectorCompress(h, (const uint8_t *)m, 1, length, f0, f1);
+    return;
+#endif
+
     // Byte-swap the message buffer into little-endian if necessary.
 #if !defined(CRYPTO_LITTLE_ENDIAN)
     for (index = 0; index < 16; ++index)
-        state.m[index] = le32toh(state.m[index]);
+        m[index] = le32toh(m[index]);
 #endif
 
     // Format the block to be hashed.
-    memcpy(v, state.h, sizeof(state.h));
+    memcpy(v, h, 8 * sizeof(uint32_t));
     v[8]  = BLAKE2s_IV0;
     v[9]  = BLAKE2s_IV1;
     v[10] = BLAKE2s_IV2;
     v[11] = BLAKE2s_IV3;
-    v[12] = BLAKE2s_IV4 ^ (uint32_t)(state.length);
-    v[13] = BLAKE2s_IV5 ^ (uint32_t)(state.length >> 32);
+    v[12] = BLAKE2s_IV4 ^ (uint32_t)length;
+    v[13] = BLAKE2s_IV5 ^ (uint32_t)(length >> 32);
     v[14] = BLAKE2s_IV6 ^ f0;
-    v[15] = BLAKE2s_IV7;
+    v[15] = BLAKE2s_IV7 ^ f1;
 
     // Perform the 10 BLAKE2s rounds.
     for (index = 0; index < 10; ++index) {
@@ -328,5 +418,5 @@ void BLAKE2s::processChunk(uint32_t f0)
 
     // Combine the new and old hash values.
     for (index = 0; index < 8; ++index)
-        state.h[index] ^= (v[index] ^ v[index + 8]);
+        h[index] ^= (v[index] ^ v[index + 8]);
 }
@@ -46,8 +46,13 @@ public:
     void resetHMAC(const void *key, size_t keyLen);
     void finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen);
 
+    size_t snapshotSize() const;
+    void snapshot(void *blob) const;
+    bool restore(const void *blob, size_t len);
+
     static const size_t HASH_SIZE  = 32;
     static const size_t BLOCK_SIZE = 64;
+    static const size_t SNAPSHOT_SIZE = 108;
 
 private:
     struct {
@@ -58,6 +63,12 @@ private:
     } state;
 
     void processChunk(uint32_t f0);
+    static void compress(uint32_t h[8], uint32_t m[16], uint64_t length,
+                         uint32_t f0, uint32_t f1);
+
+    friend class BLAKE2sp;
+    friend class BLAKE2sMAC;
+    friend class BLAKE2Xs;
 };
 
 #endif
@@ -0,0 +1,282 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "BLAKE2sMAC.h"
+#include "Crypto.h"
+#include <string.h>
+
+/**
+ * \class BLAKE2sMAC BLAKE2sMAC.h <BLAKE2sMAC.h>
+ * \brief Keyed BLAKE2s message authentication with the key block
+ * compressed once per key.
+ *
+ * BLAKE2s has a native keyed mode (BLAKE2s::reset() with a key) that
+ * needs a single compression chain: the key padded to a block, then the
+ * message.  HMAC needs two chains and at least four compressions per
+ * message, or two with the midstates that HMAC caches.  BLAKE2sMAC goes
+ * one step further and compresses the key block in setKey(), so a message
+ * of up to 64 bytes costs a single BLAKE2s compression.
+ *
+ * A key block can only be compressed ahead of time if a message block
+ * follows it.  The MAC of the empty message, where the key block is the
+ * last block, is therefore also computed in setKey() and kept.
+ *
+ * \code
+ * BLAKE2sMAC mac(key, sizeof(key), 16);
+ * mac.compute(tag, sizeof(tag), frame, frameLen);
+ * ...
+ * if (!mac.verify(tag, sizeof(tag), frame, frameLen))
+ *     reject(frame);
+ * \endcode
+ *
+ * The values are the same as BLAKE2s keyed with the same key and output
+ * length, so the other end can use any BLAKE2 implementation, for
+ * example Python's hashlib.blake2s(data, key=key, digest_size=16).  Note
+ * that BLAKE2s with an output length of 16 is not the first 16 bytes of
+ * BLAKE2s with an output length of 32; the length is part of the key
+ * setup.
+ *
+ * Reference: https://blake2.net/, RFC 7693 section 2.9.
+ *
+ * \sa BLAKE2s, HMAC
+ */
+
+/**
+ * \brief Constructs a new BLAKE2sMAC object.  setKey() must be called
+ * before use.
+ */
+BLAKE2sMAC::BLAKE2sMAC()
+    : outLen(BLAKE2s::HASH_SIZE)
+    , started(false)
+{
+    memset(emptyMac, 0, sizeof(emptyMac));
+}
+
+/**
+ * \brief Constructs a new BLAKE2sMAC object and sets its key.
+ *
+ * \param key Points to the key.
+ * \param keyLen Length of the \a key in bytes, between 0 and 32.
+ * \param macLen Length of the MAC values in bytes, between 1 and 32.
+ *
+ * \sa setKey()
+ */
+BLAKE2sMAC::BLAKE2sMAC(const void *key, size_t keyLen, uint8_t macLen)
+{
+    setKey(key, keyLen, macLen);
+}
+
+/**
+ * \brief Destroys this BLAKE2sMAC object after clearing sensitive
+ * information.
+ */
+BLAKE2sMAC::~BLAKE2sMAC()
+{
+    clean(emptyMac);
+}
+
+/**
+ * \fn size_t BLAKE2sMAC::macSize() const
+ * \brief Returns the length of the MAC values that was passed to setKey().
+ */
+
+/**
+ * \brief Sets the key and compresses the key block.
+ *
+ * \param key Points to the key.
+ * \param keyLen Length of the \a key in bytes, between 0 and 32.  Longer
+ * keys are truncated to the first 32 bytes, as by BLAKE2s::reset().
+ * \param macLen Length of the MAC values in bytes, between 1 and 32.
+ *
+ * The object is ready for a new message afterwards.
+ */
+void BLAKE2sMAC::setKey(const void *key, size_t keyLen, uint8_t macLen)
+{
+    if (macLen < 1)
+        macLen = 1;
+    else if (macLen > BLAKE2s::HASH_SIZE)
+        macLen = BLAKE2s::HASH_SIZE;
+    outLen = macLen;
+
+    context.reset(key, keyLen, macLen);
+    keyed = context;
+    if (keyed.state.chunkSize != 0) {
+        // The key block is not the last block of any non-empty message.
+        keyed.processChunk(0);
+        keyed.state.chunkSize = 0;
+        clean(keyed.state.m);
+    }
+    context.finalize(emptyMac, sizeof(emptyMac));
+    reset();
+}
+
+/**
+ * \brief Abandons the current message and starts a new one under the
+ * same key.
+ */
+void BLAKE2sMAC::reset()
+{
+    context = keyed;
+    started = false;
+}
+
+/**
+ * \brief Adds data to the current message.
+ *
+ * \param data Points to the data.
+ * \param len Number of bytes of \a data.
+ */
+void BLAKE2sMAC::update(const void *data, size_t len)
+{
+    if (len > 0) {
+        context.update(data, len);
+        started = true;
+    }
+}
+
+/**
+ * \brief Finalizes the current message and returns its MAC value.
+ *
+ * \param mac The buffer to return the MAC value in.
+ * \param len The length of the \a mac buffer, normally macSize().  At most
+ * macSize() bytes are written.
+ *
+ * The object is ready for a new message under the same key afterwards.
+ */
+void BLAKE2sMAC::finalize(void *mac, size_t len)
+{
+    if (len > outLen)
+        len = outLen;
+    if (started)
+        context.finalize(mac, len);
+    else
+        memcpy(mac, emptyMac, len);
+    reset();
+}
+
+/**
+ * \brief Computes the MAC value of a single message.
+ *
+ * \param mac The buffer to return the MAC value in.
+ * \param macLen The length of the \a mac buffer, normally macSize().
+ * \param data Points to the message.
+ * \param dataLen Length of the message in bytes.
+ *
+ * Any message in progress through update() is discarded.
+ */
+void BLAKE2sMAC::compute(void *mac, size_t macLen, const void *data, size_t dataLen)
+{
+    reset();
+    update(data, dataLen);
+    finalize(mac, macLen);
+}
+
+/**
+ * \brief Verifies the MAC value of a single message.
+ *
+ * \param mac Points to the MAC value to check.
+ * \param macLen Length of the \a mac value, which must be macSize().
+ * \param data Points to the message.
+ * \param dataLen Length of the message in bytes.
+ *
+ * \return Returns true if \a mac is the MAC value of the message.
+ *
+ * The comparison takes the same time whichever bytes differ.  Any message
+ * in progress through update() is discarded.
+ */
+bool BLAKE2sMAC::verify(const void *mac, size_t macLen, const void *data, size_t dataLen)
+{
+    uint8_t temp[BLAKE2s::HASH_SIZE];
+    compute(temp, sizeof(temp), data, dataLen);
+    bool ok = (macLen == outLen) && secure_compare(temp, mac, outLen);
+    clean(temp);
+    return ok;
+}
+
+/**
+ * \brief Clears the key and all hash state.  setKey() must be called
+ * again before further use.
+ */
+void BLAKE2sMAC::clear()
+{
+    keyed.clear();
+    context.clear();
+    clean(emptyMac);
+    started = false;
+}
+
+/**
+ * \brief Saves the precomputed key state.
+ *
+ * \param blob Points to KEY_STATE_SIZE bytes to receive the key state.
+ *
+ * The blob holds the chaining value after the key block, the MAC length
+ * and the MAC of the empty message.  It lets a keyed object be recreated
+ * with loadKey() without the raw key, for example from EEPROM or a
+ * database row.  It must be protected like the key itself because it is
+ * sufficient to compute MAC values.
+ *
+ * \sa loadKey()
+ */
+void BLAKE2sMAC::saveKey(void *blob) const
+{
+    uint8_t *b = (uint8_t *)blob;
+    keyed.snapshot(b);
+    b[BLAKE2s::SNAPSHOT_SIZE] = outLen;
+    memcpy(b + BLAKE2s::SNAPSHOT_SIZE + 1, emptyMac, sizeof(emptyMac));
+}
+
+/**
+ * \brief Loads a key state saved by saveKey().
+ *
+ * \param blob Points to the saved key state.
+ * \param len Length of the \a blob, which must be KEY_STATE_SIZE.
+ *
+ * \return Returns false if the blob is not a BLAKE2sMAC key state, in
+ * which case the current key is left unchanged.
+ *
+ * The object is ready for a new message afterwards.
+ *
+ * \sa saveKey()
+ */
+bool BLAKE2sMAC::loadKey(const void *blob, size_t len)
+{
+    const uint8_t *b = (const uint8_t *)blob;
+    if (len != KEY_STATE_SIZE)
+        return false;
+    uint8_t macLen = b[BLAKE2s::SNAPSHOT_SIZE];
+    if (macLen < 1 || macLen > BLAKE2s::HASH_SIZE)
+        return false;
+    BLAKE2s state;
+    if (!state.restore(b, BLAKE2s::SNAPSHOT_SIZE) ||
+            state.state.chunkSize != 0)
+        return false;
+    keyed = state;
+    outLen = macLen;
+    memcpy(emptyMac, b + BLAKE2s::SNAPSHOT_SIZE + 1, sizeof(emptyMac));
+    reset();
+    return true;
+}
+
+/**
+ * \var BLAKE2sMAC::KEY_STATE_SIZE
+ * \brief Size of the blob written by saveKey().
+ */
@@ -0,0 +1,61 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_BLAKE2SMAC_h
+#define CRYPTO_BLAKE2SMAC_h
+
+#include "BLAKE2s.h"
+
+class BLAKE2sMAC
+{
+public:
+    BLAKE2sMAC();
+    BLAKE2sMAC(const void *key, size_t keyLen, uint8_t macLen = 32);
+    ~BLAKE2sMAC();
+
+    size_t macSize() const { return outLen; }
+
+    void setKey(const void *key, size_t keyLen, uint8_t macLen = 32);
+
+    void reset();
+    void update(const void *data, size_t len);
+    void finalize(void *mac, size_t len);
+
+    void compute(void *mac, size_t macLen, const void *data, size_t dataLen);
+    bool verify(const void *mac, size_t macLen, const void *data, size_t dataLen);
+
+    void clear();
+
+    void saveKey(void *blob) const;
+    bool loadKey(const void *blob, size_t len);
+
+    static const size_t KEY_STATE_SIZE =
+        BLAKE2s::SNAPSHOT_SIZE + 1 + BLAKE2s::HASH_SIZE;
+
+private:
+    BLAKE2s keyed;
+    BLAKE2s context;
+    uint8_t emptyMac[BLAKE2s::HASH_SIZE];
+    uint8_t outLen;
+    bool started;
+};
+
+#endif
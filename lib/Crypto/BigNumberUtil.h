@@ -27,7 +27,26 @@
 #include <stddef.h>
 
 // Define exactly one of these to 1 to set the size of the basic limb type.
-#if defined(__AVR__) || defined(ESP8266)
+// A build can select the limb size itself by defining one of them on the
+// command line (see scripts/crypto_select.py); the others default to 0.
+#if defined(BIGNUMBER_LIMB_8BIT) || defined(BIGNUMBER_LIMB_16BIT) || \
+    defined(BIGNUMBER_LIMB_32BIT) || defined(BIGNUMBER_LIMB_64BIT)
+#if !defined(BIGNUMBER_LIMB_8BIT)
+#define BIGNUMBER_LIMB_8BIT  0
+#endif
+#if !defined(BIGNUMBER_LIMB_16BIT)
+#define BIGNUMBER_LIMB_16BIT 0
+#endif
+#if !defined(BIGNUMBER_LIMB_32BIT)
+#define BIGNUMBER_LIMB_32BIT 0
+#endif
+#if !defined(BIGNUMBER_LIMB_64BIT)
+#define BIGNUMBER_LIMB_64BIT 0
+#endif
+#if (BIGNUMBER_LIMB_8BIT + BIGNUMBER_LIMB_16BIT + BIGNUMBER_LIMB_32BIT + BIGNUMBER_LIMB_64BIT) != 1
+#error "Exactly one of BIGNUMBER_LIMB_8BIT/16BIT/32BIT/64BIT must be 1"
+#endif
+#elif defined(__AVR__) || defined(ESP8266)
 // 16-bit limbs seem to give the best performance on 8-bit AVR micros.
 // They also seem to give better performance on ESP8266 as well.
 #define BIGNUMBER_LIMB_8BIT  0
@@ -0,0 +1,256 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "CSHAKE.h"
+
+/**
+ * \class CSHAKE CSHAKE.h <CSHAKE.h>
+ * \brief Abstract base class for the customizable SHAKE Extendable-Output
+ * Functions (cSHAKE) from NIST SP 800-185.
+ *
+ * cSHAKE is SHAKE with a function name and a customization string
+ * absorbed ahead of the data, so that outputs for different purposes are
+ * unrelated.  The name and string are padded to a whole block, so the
+ * sponge state after them is computed once by setCustomization() and
+ * reset() just copies it back.  With an empty name and string, cSHAKE is
+ * the same as SHAKE.
+ *
+ * Reference: https://doi.org/10.6028/NIST.SP.800-185
+ *
+ * \sa CSHAKE128, CSHAKE256, KMAC, TupleHash, SHAKE
+ */
+
+/**
+ * \class CSHAKE128 CSHAKE.h <CSHAKE.h>
+ * \brief cSHAKE128 Extendable-Output Function (XOF).
+ *
+ * \sa CSHAKE256
+ */
+
+/**
+ * \class CSHAKE256 CSHAKE.h <CSHAKE.h>
+ * \brief cSHAKE256 Extendable-Output Function (XOF).
+ *
+ * \sa CSHAKE128
+ */
+
+/**
+ * \brief Constructs a cSHAKE object with an empty name and customization
+ * string.
+ *
+ * \param capacity The capacity of the Keccak sponge function in bits,
+ * 256 for cSHAKE128 or 512 for cSHAKE256.
+ */
+CSHAKE::CSHAKE(size_t capacity)
+    : finalized(false)
+    , encodeLength(false)
+    , tag(0x1F)
+{
+    core.setCapacity(capacity);
+    prefix.setCapacity(capacity);
+}
+
+/**
+ * \brief Destroys this cSHAKE object after clearing all sensitive
+ * information.
+ */
+CSHAKE::~CSHAKE()
+{
+}
+
+size_t CSHAKE::blockSize() const
+{
+    return core.blockSize();
+}
+
+/**
+ * \brief Sets the function name and customization string.
+ *
+ * \param name Points to the function name, which is reserved for names
+ * defined by NIST; pass an empty name for plain cSHAKE.
+ * \param nameLen Length of the function name in bytes.
+ * \param custom Points to the customization string chosen by the
+ * application.
+ * \param customLen Length of the customization string in bytes.
+ *
+ * The padded block holding the name and string is absorbed here and the
+ * state is saved, so later calls to reset() do not absorb it again.
+ *
+ * \sa reset()
+ */
+void CSHAKE::setCustomization(const void *name, size_t nameLen,
+                              const void *custom, size_t customLen)
+{
+    core.reset();
+    if (nameLen || customLen) {
+        // bytepad(encode_string(N) || encode_string(S), rate)
+        size_t len = absorbLeftEncode(core.blockSize());
+        len += absorbLeftEncode(((uint64_t)nameLen) * 8);
+        core.update(name, nameLen);
+        len += nameLen;
+        len += absorbLeftEncode(((uint64_t)customLen) * 8);
+        core.update(custom, customLen);
+        len += customLen;
+        absorbZeroes(len);
+        tag = 0x04;
+    } else {
+        tag = 0x1F;
+    }
+    saveResetPoint();
+}
+
+void CSHAKE::reset()
+{
+    core = prefix;
+    finalized = false;
+}
+
+void CSHAKE::update(const void *data, size_t len)
+{
+    if (finalized)
+        reset();
+    core.update(data, len);
+}
+
+void CSHAKE::extend(uint8_t *data, size_t len)
+{
+    if (!finalized)
+        finish(0);
+    core.extract(data, len);
+}
+
+void CSHAKE::encrypt(uint8_t *output, const uint8_t *input, size_t len)
+{
+    if (!finalized)
+        finish(0);
+    core.encrypt(output, input, len);
+}
+
+void CSHAKE::clear()
+{
+    core.clear();
+    prefix.clear();
+    tag = 0x1F;
+    finalized = false;
+}
+
+/**
+ * \brief Absorbs encode_string() of a byte string: its length in bits
+ * followed by the string itself.
+ *
+ * \param data Points to the string.
+ * \param len Length of the string in bytes.
+ */
+void CSHAKE::absorbString(const void *data, size_t len)
+{
+    absorbLeftEncode(((uint64_t)len) * 8);
+    core.update(data, len);
+}
+
+/**
+ * \brief Absorbs a key padded to a whole block, as in KMAC.
+ *
+ * \param key Points to the key.
+ * \param len Length of the key in bytes.
+ */
+void CSHAKE::absorbKey(const void *key, size_t len)
+{
+    // bytepad(encode_string(K), rate)
+    size_t total = absorbLeftEncode(core.blockSize());
+    total += absorbLeftEncode(((uint64_t)len) * 8);
+    core.update(key, len);
+    absorbZeroes(total + len);
+}
+
+/**
+ * \brief Makes the current state the one that reset() returns to.
+ */
+void CSHAKE::saveResetPoint()
+{
+    prefix = core;
+    finalized = false;
+}
+
+/**
+ * \brief Pads the input ready for output.
+ *
+ * \param outputBits The number of output bits, which is appended with
+ * right_encode() if encodeLength is set.  Zero for variable-length output.
+ */
+void CSHAKE::finish(uint64_t outputBits)
+{
+    if (encodeLength) {
+        uint8_t buf[9];
+        uint8_t n = 0;
+        do {
+            ++n;
+        } while (n < 8 && (outputBits >> (n * 8)) != 0);
+        for (uint8_t posn = 0; posn < n; ++posn)
+            buf[posn] = (uint8_t)(outputBits >> ((n - 1 - posn) * 8));
+        buf[n] = n;
+        core.update(buf, n + 1);
+    }
+    core.pad(tag);
+    finalized = true;
+}
+
+/**
+ * \brief Absorbs left_encode() of a value: the number of bytes in the
+ * value followed by the value in big-endian order.
+ *
+ * \return The number of bytes that were absorbed.
+ */
+size_t CSHAKE::absorbLeftEncode(uint64_t value)
+{
+    uint8_t buf[9];
+    uint8_t n = 0;
+    do {
+        ++n;
+    } while (n < 8 && (value >> (n * 8)) != 0);
+    buf[0] = n;
+    for (uint8_t posn = 0; posn < n; ++posn)
+        buf[posn + 1] = (uint8_t)(value >> ((n - 1 - posn) * 8));
+    core.update(buf, n + 1);
+    return n + 1;
+}
+
+/**
+ * \brief Absorbs the zeroes that pad \a len bytes out to a whole block.
+ */
+void CSHAKE::absorbZeroes(size_t len)
+{
+    static const uint8_t zeroes[16] = {0};
+    size_t rate = core.blockSize();
+    len = (rate - (len % rate)) % rate;
+    while (len > 0) {
+        size_t size = (len < sizeof(zeroes)) ? len : sizeof(zeroes);
+        core.update(zeroes, size);
+        len -= size;
+    }
+}
+
+CSHAKE128::~CSHAKE128()
+{
+}
+
+CSHAKE256::~CSHAKE256()
+{
+}
@@ -0,0 +1,80 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_CSHAKE_h
+#define CRYPTO_CSHAKE_h
+
+#include "XOF.h"
+#include "KeccakCore.h"
+
+class CSHAKE : public XOF
+{
+public:
+    virtual ~CSHAKE();
+
+    size_t blockSize() const;
+
+    void setCustomization(const void *name, size_t nameLen,
+                          const void *custom, size_t customLen);
+
+    void reset();
+    void update(const void *data, size_t len);
+
+    void extend(uint8_t *data, size_t len);
+    void encrypt(uint8_t *output, const uint8_t *input, size_t len);
+
+    void clear();
+
+protected:
+    CSHAKE(size_t capacity);
+
+    void absorbString(const void *data, size_t len);
+    void absorbKey(const void *key, size_t len);
+    void saveResetPoint();
+    void finish(uint64_t outputBits);
+
+    bool finalized;
+    bool encodeLength;
+
+private:
+    KeccakCore core;
+    KeccakCore prefix;
+    uint8_t tag;
+
+    size_t absorbLeftEncode(uint64_t value);
+    void absorbZeroes(size_t len);
+};
+
+class CSHAKE128 : public CSHAKE
+{
+public:
+    CSHAKE128() : CSHAKE(256) {}
+    virtual ~CSHAKE128();
+};
+
+class CSHAKE256 : public CSHAKE
+{
+public:
+    CSHAKE256() : CSHAKE(512) {}
+    virtual ~CSHAKE256();
+};
+
+#endif
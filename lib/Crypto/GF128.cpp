@@ -24,6 +24,18 @@
 #include "utility/EndianUtil.h"
 #include <string.h>
 
+// Use the AVR assembly versions of mul(), dbl(), dblEAX() and dblXTS() on
+// AVR unless the build selects the C versions with -DCRYPTO_GF128_AVR_ASM=0.
+#if !defined(CRYPTO_GF128_AVR_ASM)
+#if defined(__AVR__)
+#define CRYPTO_GF128_AVR_ASM 1
+#else
+#define CRYPTO_GF128_AVR_ASM 0
+#endif
+#elif CRYPTO_GF128_AVR_ASM && !defined(__AVR__)
+#error "CRYPTO_GF128_AVR_ASM requires an AVR target"
+#endif
+
 /**
  * \class GF128 GF128.h <GF128.h>
  * \brief Operations in the Galois field GF(2^128).
@@ -57,7 +69,7 @@
  */
 void GF128::mulInit(uint32_t H[4], const void *key)
 {
-#if defined(__AVR__)
+#if CRYPTO_GF128_AVR_ASM
     // Copy the key into H but leave it in big endian order because
     // we can correct for the byte order in mul() below.
     memcpy(H, key, 16);
@@ -89,7 +101,7 @@ void GF128::mulInit(uint32_t H[4], const void *key)
  */
 void GF128::mul(uint32_t Y[4], const uint32_t H[4])
 {
-#if defined(__AVR__)
+#if CRYPTO_GF128_AVR_ASM
     uint32_t Z[4] = {0, 0, 0, 0};   // Z = 0
     uint32_t V0 = H[0];             // V = H
     uint32_t V1 = H[1];
@@ -256,7 +268,7 @@ void GF128::mul(uint32_t Y[4], const uint32_t H[4])
         "st X,__tmp_reg__\n"
         : : "Q"(Z[0]), "Q"(Z[1]), "Q"(Z[2]), "Q"(Z[3]), "x"(Y)
     );
-#else // !__AVR__
+#else // !CRYPTO_GF128_AVR_ASM
     uint32_t Z0 = 0;        // Z = 0
     uint32_t Z1 = 0;
     uint32_t Z2 = 0;
@@ -295,7 +307,7 @@ void GF128::mul(uint32_t Y[4], const uint32_t H[4])
     Y[1] = htobe32(Z1);
     Y[2] = htobe32(Z2);
     Y[3] = htobe32(Z3);
-#endif // !__AVR__
+#endif // !CRYPTO_GF128_AVR_ASM
 }
 
 /**
@@ -313,7 +325,7 @@ void GF128::mul(uint32_t Y[4], const uint32_t H[4])
  */
 void GF128::dbl(uint32_t V[4])
 {
-#if defined(__AVR__)
+#if CRYPTO_GF128_AVR_ASM
     __asm__ __volatile__ (
         "ld r16,Z\n"
         "ldd r17,Z+1\n"
@@ -405,7 +417,7 @@ void GF128::dbl(uint32_t V[4])
  */
 void GF128::dblEAX(uint32_t V[4])
 {
-#if defined(__AVR__)
+#if CRYPTO_GF128_AVR_ASM
     __asm__ __volatile__ (
         "ldd r16,Z+15\n"
         "ldd r17,Z+14\n"
@@ -496,7 +508,7 @@ void GF128::dblEAX(uint32_t V[4])
  */
 void GF128::dblXTS(uint32_t V[4])
 {
-#if defined(__AVR__)
+#if CRYPTO_GF128_AVR_ASM
     __asm__ __volatile__ (
         "ld r16,Z\n"
         "ldd r17,Z+1\n"
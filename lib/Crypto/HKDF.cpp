@@ -28,6 +28,11 @@
  * \brief Concrete base class to assist with implementing HKDF mode for
  * hash algorithms.
  *
+ * HKDFCommon drives the hash through the virtual Hash interface on purpose:
+ * it is compiled once for every HKDF<T>, which keeps flash usage down on
+ * AVR.  Use HKDFExpand or hkdf() when the expand loop is hot; they call
+ * the hash algorithm directly.
+ *
  * Reference: https://datatracker.ietf.org/doc/html/rfc5869
  *
  * \sa HKDF
@@ -205,5 +210,185 @@ void HKDFCommon::clear()
  * \param info Points to the application-specific information string.
  * \param infoLen Length of the \a info string in bytes.
  *
- * The template parameter T must be a subclass of Hash.
+ * The template parameter T must be a subclass of Hash.  Unlike the HKDF
+ * class, this function calls T directly rather than through the Hash
+ * interface, and computes the HMAC pad blocks of the PRK once for all
+ * output blocks.
+ *
+ * \sa HKDFExpand
+ */
+
+/**
+ * \fn void hkdfBatch<T>(void *const out[], size_t outLen, const void *const key[], const size_t keyLen[], const void *salt, size_t saltLen, const void *info, size_t infoLen, size_t count)
+ * \brief Derives keys from many input keys with the same salt and info.
+ *
+ * \param out Points to the buffers to receive each derived key.
+ * \param outLen Number of bytes to derive for each key.
+ * \param key Points to each input key.
+ * \param keyLen Points to the length of each input key in bytes.
+ * \param salt Points to the salt, or NULL for no salt.
+ * \param saltLen Length of the \a salt in bytes.
+ * \param info Points to the info value, or NULL for no info.
+ * \param infoLen Length of the \a info value in bytes.
+ * \param count Number of input keys.
+ *
+ * The result is the same as calling hkdf<T>() for each input key, but
+ * the HMAC computations go through hmacBatch() and hmacBatchKeys(), so
+ * hash algorithms with a multi-buffer implementation such as SHA256
+ * derive HMAC_BATCH_SIZE keys side by side.  This suits bulk jobs such
+ * as deriving a key for every device of a provisioning run:
+ *
+ * \code
+ * hkdfBatch<SHA256>(deviceKeys, 32, deviceSecrets, secretLens,
+ *                   salt, sizeof(salt), "device-key", 10, count);
+ * \endcode
+ *
+ * \sa hkdf(), hmacBatch()
+ */
+
+/**
+ * \class HKDFExpand HKDF.h <HKDF.h>
+ * \brief HKDF expansion of many info values from one cached PRK.
+ *
+ * HKDF::extract() recomputes the HMAC pad blocks of the PRK for every
+ * output block.  HKDFExpand computes the PRK once in setKey(), keeps the
+ * hash states that follow the inner and outer pad blocks, and starts
+ * every output block from a copy of them.  A 32-byte SHA256 output then
+ * costs two block compressions when the info value is short.
+ *
+ * This suits deriving a key for each device of a fleet from one master
+ * key, with the device identity as the info value:
+ *
+ * \code
+ * HKDFExpand<SHA256> master(masterKey, sizeof(masterKey), salt, sizeof(salt));
+ * master.expand(deviceKey, 32, deviceId, deviceIdLen);
+ *
+ * master.expandBatch(deviceKeys, 32, deviceIds, deviceIdLens, count);
+ * \endcode
+ *
+ * expandBatch() goes through updateBatch() and finalizeBatch(), so hash
+ * algorithms with a multi-buffer implementation such as SHA256 expand
+ * HMAC_BATCH_SIZE outputs side by side.
+ *
+ * The template parameter T must be a hash algorithm that HMAC accepts.
+ *
+ * Reference: https://datatracker.ietf.org/doc/html/rfc5869
+ *
+ * \sa HKDF, hkdfBatch()
+ */
+
+/**
+ * \fn HKDFExpand::HKDFExpand()
+ * \brief Constructs a new HKDF expander.  setKey() or setPRK() must be
+ * called before use.
+ */
+
+/**
+ * \fn HKDFExpand::HKDFExpand(const void *key, size_t keyLen, const void *salt, size_t saltLen)
+ * \brief Constructs a new HKDF expander and sets its key.
+ *
+ * \param key Points to the input key.
+ * \param keyLen Length of the \a key in bytes.
+ * \param salt Points to the salt, or NULL for no salt.
+ * \param saltLen Length of the \a salt in bytes.
+ */
+
+/**
+ * \fn HKDFExpand::~HKDFExpand()
+ * \brief Destroys this HKDF expander.  The hash objects clear their own
+ * state.
+ */
+
+/**
+ * \fn void HKDFExpand::setKey(const void *key, size_t keyLen, const void *salt, size_t saltLen)
+ * \brief Extracts the PRK from a key and salt and caches its HMAC states.
+ *
+ * \param key Points to the input key.
+ * \param keyLen Length of the \a key in bytes.
+ * \param salt Points to the salt, or NULL for no salt.
+ * \param saltLen Length of the \a salt in bytes.
+ */
+
+/**
+ * \fn void HKDFExpand::setPRK(const void *prk, size_t prkLen)
+ * \brief Sets the PRK directly, skipping the extract step.
+ *
+ * \param prk Points to the pseudorandom key.
+ * \param prkLen Length of the \a prk in bytes, normally T::HASH_SIZE.
+ */
+
+/**
+ * \fn void HKDFExpand::expand(void *out, size_t outLen, const void *info, size_t infoLen)
+ * \brief Expands the PRK with one info value.
+ *
+ * \param out Points to the buffer to fill with key material.
+ * \param outLen Number of bytes to write to \a out.
+ * \param info Points to the info value, or NULL for no info.
+ * \param infoLen Length of the \a info value in bytes.
+ *
+ * The result is the same as hkdf<T>() with the key and salt of setKey().
+ */
+
+/**
+ * \fn void HKDFExpand::expandBatch(void *const out[], size_t outLen, const void *const info[], const size_t infoLen[], size_t count)
+ * \brief Expands the PRK with many info values.
+ *
+ * \param out Points to the buffers to receive each output.
+ * \param outLen Number of bytes to write to each output buffer.
+ * \param info Points to each info value.
+ * \param infoLen Points to the length of each info value in bytes.
+ * \param count Number of info values.
+ *
+ * The result is the same as calling expand() for each info value.
+ */
+
+/**
+ * \fn void HKDFExpand::clear()
+ * \brief Clears the cached PRK states.  setKey() or setPRK() must be
+ * called again before further use.
+ */
+
+/**
+ * \fn void HKDFExpand::saveKey(void *blob) const
+ * \brief Saves the cached PRK states.
+ *
+ * \param blob Points to KEY_STATE_SIZE bytes to receive the states.
+ *
+ * The blob must be protected like the PRK itself.
+ *
+ * \sa loadKey(), HMAC::saveKey()
+ */
+
+/**
+ * \fn bool HKDFExpand::loadKey(const void *blob, size_t len)
+ * \brief Loads PRK states saved by saveKey().
+ *
+ * \param blob Points to the saved states.
+ * \param len Length of the \a blob, which must be KEY_STATE_SIZE.
+ *
+ * \return Returns false if the blob is not a key state for T, in which
+ * case the current PRK is left unchanged.
+ */
+
+/**
+ * \var HKDFExpand::KEY_STATE_SIZE
+ * \brief Size of the blob written by saveKey().
+ */
+
+/**
+ * \fn void hkdfExpandBatch<T>(void *const out[], size_t outLen, const T *const inner[], const T *const outer[], const void *const info[], const size_t infoLen[], size_t count)
+ * \brief Runs the HKDF expand step for a batch of outputs.
+ *
+ * \param out Points to the buffers to receive each output.
+ * \param outLen Number of bytes to write to each output buffer.
+ * \param inner Points to the inner HMAC state of each output's PRK.
+ * \param outer Points to the outer HMAC state of each output's PRK.
+ * \param info Points to each info value.
+ * \param infoLen Points to the length of each info value in bytes.
+ * \param count Number of outputs.  They are computed HMAC_BATCH_SIZE at
+ * a time, which bounds the stack use.
+ *
+ * This is the common part of hkdfBatch() and HKDFExpand::expandBatch().
+ *
+ * \sa hmacBatchKeys()
  */
@@ -25,6 +25,7 @@
 
 #include "Hash.h"
 #include "Crypto.h"
+#include "HMAC.h"
 
 class HKDFCommon
 {
@@ -64,13 +65,277 @@ private:
     uint8_t buffer[T::HASH_SIZE * 2];
 };
 
+template <typename T>
+class HKDFExpand
+{
+public:
+    HKDFExpand() {}
+    HKDFExpand(const void *key, size_t keyLen, const void *salt = 0, size_t saltLen = 0)
+        { setKey(key, keyLen, salt, saltLen); }
+    ~HKDFExpand() {}
+
+    void setKey(const void *key, size_t keyLen, const void *salt = 0, size_t saltLen = 0);
+    void setPRK(const void *prk, size_t prkLen);
+
+    void expand(void *out, size_t outLen, const void *info = 0, size_t infoLen = 0);
+    void expandBatch(void *const out[], size_t outLen, const void *const info[],
+                     const size_t infoLen[], size_t count);
+
+    void clear();
+
+    void saveKey(void *blob) const;
+    bool loadKey(const void *blob, size_t len);
+
+    static const size_t KEY_STATE_SIZE = 2 * T::SNAPSHOT_SIZE;
+
+private:
+    T inner;
+    T outer;
+};
+
+template <typename T>
+void hkdfExpandBatch(void *const out[], size_t outLen, const T *const inner[],
+                     const T *const outer[], const void *const info[],
+                     const size_t infoLen[], size_t count)
+{
+    T context[HMAC_BATCH_SIZE];
+    uint8_t block[HMAC_BATCH_SIZE][T::HASH_SIZE];
+    T *hashes[HMAC_BATCH_SIZE];
+    const void *ptrs[HMAC_BATCH_SIZE];
+    size_t lens[HMAC_BATCH_SIZE];
+    void *blockOut[HMAC_BATCH_SIZE];
+    const void *blockIn[HMAC_BATCH_SIZE];
+    size_t blockLen[HMAC_BATCH_SIZE];
+    uint8_t counter;
+    size_t posn, offset;
+
+    for (posn = 0; posn < HMAC_BATCH_SIZE; ++posn) {
+        blockOut[posn] = block[posn];
+        blockIn[posn] = block[posn];
+        blockLen[posn] = T::HASH_SIZE;
+    }
+
+    while (count > 0) {
+        // The buffers above hold HMAC_BATCH_SIZE outputs at a time.
+        size_t batch = (count < HMAC_BATCH_SIZE) ? count : HMAC_BATCH_SIZE;
+
+        // T(i) = HMAC(PRK, T(i - 1) | info | i), concatenated.
+        for (counter = 1, offset = 0; offset < outLen; ++counter) {
+            for (posn = 0; posn < batch; ++posn) {
+                context[posn] = *(inner[posn]);
+                hashes[posn] = &context[posn];
+            }
+            if (counter != 1)
+                updateBatch(hashes, blockIn, blockLen, batch);
+            updateBatch(hashes, info, infoLen, batch);
+            for (posn = 0; posn < batch; ++posn) {
+                ptrs[posn] = &counter;
+                lens[posn] = 1;
+            }
+            updateBatch(hashes, ptrs, lens, batch);
+            finalizeBatch(hashes, blockOut, T::HASH_SIZE, batch);
+            for (posn = 0; posn < batch; ++posn)
+                context[posn] = *(outer[posn]);
+            updateBatch(hashes, blockIn, blockLen, batch);
+            finalizeBatch(hashes, blockOut, T::HASH_SIZE, batch);
+
+            size_t size = outLen - offset;
+            if (size > T::HASH_SIZE)
+                size = T::HASH_SIZE;
+            for (posn = 0; posn < batch; ++posn)
+                memcpy(((uint8_t *)(out[posn])) + offset, block[posn], size);
+            offset += size;
+        }
+
+        out += batch;
+        inner += batch;
+        outer += batch;
+        info += batch;
+        infoLen += batch;
+        count -= batch;
+    }
+    ::clean(block, sizeof(block));
+}
+
+template <typename T>
+void HKDFExpand<T>::setKey(const void *key, size_t keyLen, const void *salt, size_t saltLen)
+{
+    uint8_t prk[T::HASH_SIZE];
+    if (salt && saltLen) {
+        hmac<T>(prk, sizeof(prk), salt, saltLen, key, keyLen);
+    } else {
+        // If no salt is provided, RFC 5869 says that a string of
+        // hashSize zeroes should be used instead.
+        memset(prk, 0, sizeof(prk));
+        hmac<T>(prk, sizeof(prk), prk, sizeof(prk), key, keyLen);
+    }
+    setPRK(prk, sizeof(prk));
+    ::clean(prk, sizeof(prk));
+}
+
+template <typename T>
+void HKDFExpand<T>::setPRK(const void *prk, size_t prkLen)
+{
+    // Same key schedule as HMAC<T>::setKey().
+    uint8_t block[T::BLOCK_SIZE];
+    if (prkLen > T::BLOCK_SIZE) {
+        inner.reset();
+        inner.update(prk, prkLen);
+        inner.finalize(block, T::HASH_SIZE);
+        prkLen = T::HASH_SIZE;
+    } else {
+        memcpy(block, prk, prkLen);
+    }
+    memset(block + prkLen, 0, T::BLOCK_SIZE - prkLen);
+    inner.resetHMAC(block, T::BLOCK_SIZE);
+    for (size_t posn = 0; posn < T::BLOCK_SIZE; ++posn)
+        block[posn] ^= (0x36 ^ 0x5C);
+    outer.resetHMAC(block, T::BLOCK_SIZE);
+    ::clean(block, sizeof(block));
+}
+
+template <typename T>
+void HKDFExpand<T>::expand(void *out, size_t outLen, const void *info, size_t infoLen)
+{
+    T context;
+    uint8_t block[T::HASH_SIZE];
+    uint8_t counter;
+    size_t offset;
+    for (counter = 1, offset = 0; offset < outLen; ++counter) {
+        context = inner;
+        if (counter != 1)
+            context.update(block, sizeof(block));
+        if (info && infoLen)
+            context.update(info, infoLen);
+        context.update(&counter, 1);
+        context.finalize(block, sizeof(block));
+        context = outer;
+        context.update(block, sizeof(block));
+        context.finalize(block, sizeof(block));
+
+        size_t size = outLen - offset;
+        if (size > T::HASH_SIZE)
+            size = T::HASH_SIZE;
+        memcpy(((uint8_t *)out) + offset, block, size);
+        offset += size;
+    }
+    ::clean(block, sizeof(block));
+}
+
+template <typename T>
+void HKDFExpand<T>::expandBatch(void *const out[], size_t outLen,
+                                const void *const info[],
+                                const size_t infoLen[], size_t count)
+{
+    const T *in[HMAC_BATCH_SIZE];
+    const T *ou[HMAC_BATCH_SIZE];
+    for (size_t posn = 0; posn < HMAC_BATCH_SIZE; ++posn) {
+        in[posn] = &inner;
+        ou[posn] = &outer;
+    }
+    while (count > 0) {
+        size_t n = (count < HMAC_BATCH_SIZE) ? count : HMAC_BATCH_SIZE;
+        hkdfExpandBatch(out, outLen, in, ou, info, infoLen, n);
+        out += n;
+        info += n;
+        infoLen += n;
+        count -= n;
+    }
+}
+
+template <typename T>
+void HKDFExpand<T>::clear()
+{
+    inner.clear();
+    outer.clear();
+}
+
+template <typename T>
+void HKDFExpand<T>::saveKey(void *blob) const
+{
+    inner.snapshot(blob);
+    outer.snapshot(((uint8_t *)blob) + T::SNAPSHOT_SIZE);
+}
+
+template <typename T>
+bool HKDFExpand<T>::loadKey(const void *blob, size_t len)
+{
+    const uint8_t *b = (const uint8_t *)blob;
+    if (len != KEY_STATE_SIZE)
+        return false;
+    T in, out;
+    if (!in.restore(b, T::SNAPSHOT_SIZE) ||
+            !out.restore(b + T::SNAPSHOT_SIZE, T::SNAPSHOT_SIZE))
+        return false;
+    inner = in;
+    outer = out;
+    return true;
+}
+
 template <typename T> void hkdf
     (void *out, size_t outLen, const void *key, size_t keyLen,
      const void *salt, size_t saltLen, const void *info, size_t infoLen)
 {
-    HKDF<T> context;
-    context.setKey(key, keyLen, salt, saltLen);
-    context.extract(out, outLen, info, infoLen);
+    HKDFExpand<T> context(key, keyLen, salt, saltLen);
+    context.expand(out, outLen, info, infoLen);
+}
+
+template <typename T> void hkdfBatch
+    (void *const out[], size_t outLen, const void *const key[],
+     const size_t keyLen[], const void *salt, size_t saltLen,
+     const void *info, size_t infoLen, size_t count)
+{
+    T inner[HMAC_BATCH_SIZE];
+    T outer[HMAC_BATCH_SIZE];
+    uint8_t block[HMAC_BATCH_SIZE][T::HASH_SIZE];
+    uint8_t zeroes[T::HASH_SIZE];
+    const T *in[HMAC_BATCH_SIZE];
+    const T *ou[HMAC_BATCH_SIZE];
+    const void *ptrs[HMAC_BATCH_SIZE];
+    size_t lens[HMAC_BATCH_SIZE];
+    void *blockOut[HMAC_BATCH_SIZE];
+    const void *blockIn[HMAC_BATCH_SIZE];
+    const void *infos[HMAC_BATCH_SIZE];
+    size_t infoLens[HMAC_BATCH_SIZE];
+    size_t blockLen[HMAC_BATCH_SIZE];
+    size_t posn, n;
+
+    // If no salt is provided, RFC 5869 says that a string of
+    // hashSize zeroes should be used instead.
+    if (!salt || !saltLen) {
+        memset(zeroes, 0, sizeof(zeroes));
+        salt = zeroes;
+        saltLen = sizeof(zeroes);
+    }
+    if (!info)
+        infoLen = 0;
+
+    for (posn = 0; posn < HMAC_BATCH_SIZE; ++posn) {
+        ptrs[posn] = salt;
+        lens[posn] = saltLen;
+        blockOut[posn] = block[posn];
+        blockIn[posn] = block[posn];
+        blockLen[posn] = T::HASH_SIZE;
+        infos[posn] = info;
+        infoLens[posn] = infoLen;
+        in[posn] = &inner[posn];
+        ou[posn] = &outer[posn];
+    }
+
+    while (count > 0) {
+        n = (count < HMAC_BATCH_SIZE) ? count : HMAC_BATCH_SIZE;
+
+        // PRK = HMAC(salt, key) for each key.
+        hmacBatch<T>(blockOut, T::HASH_SIZE, ptrs, lens, key, keyLen, n);
+        hmacBatchKeys(inner, outer, blockIn, blockLen, n);
+        hkdfExpandBatch(out, outLen, in, ou, infos, infoLens, n);
+
+        out += n;
+        key += n;
+        keyLen += n;
+        count -= n;
+    }
+    ::clean(block, sizeof(block));
 }
 
 #endif
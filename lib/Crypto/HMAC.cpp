@@ -0,0 +1,213 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "HMAC.h"
+
+/**
+ * \class HMAC HMAC.h <HMAC.h>
+ * \brief HMAC with the key schedule computed once per key.
+ *
+ * Hash::resetHMAC() and Hash::finalizeHMAC() format the key and compress
+ * the inner and outer pad blocks again for every message.  HMAC instead
+ * derives the two hash states that follow the pad blocks once in setKey()
+ * and starts each message from a copy of them, which saves two block
+ * compressions per message (plus a hash of the key if it is longer than
+ * a block).
+ *
+ * The template parameter T must be a concrete subclass of Hash that
+ * defines HASH_SIZE and BLOCK_SIZE and can be copied, which includes
+ * SHA1, SHA224, SHA256, SHA384, SHA512, SHA3_256, SHA3_512, BLAKE2s and
+ * BLAKE2b.
+ *
+ * \code
+ * HMAC<SHA256> mac(key, sizeof(key));
+ * mac.update(data1, sizeof(data1));
+ * mac.update(data2, sizeof(data2));
+ * mac.finalize(tag, sizeof(tag));
+ *
+ * mac.compute(tag, sizeof(tag), message, sizeof(message));
+ * \endcode
+ *
+ * An HMAC object can itself be copied to hand a keyed instance to
+ * another user without going through setKey() again.
+ *
+ * Reference: https://datatracker.ietf.org/doc/html/rfc2104
+ *
+ * \sa hmac(), Hash::resetHMAC()
+ */
+
+/**
+ * \fn HMAC::HMAC()
+ * \brief Constructs a new HMAC object.  setKey() must be called before use.
+ */
+
+/**
+ * \fn HMAC::HMAC(const void *key, size_t keyLen)
+ * \brief Constructs a new HMAC object and sets its key.
+ *
+ * \param key Points to the HMAC key.
+ * \param keyLen Length of the \a key in bytes.
+ */
+
+/**
+ * \fn HMAC::~HMAC()
+ * \brief Destroys this HMAC object.  The hash objects clear their own
+ * state, including the keyed midstates.
+ */
+
+/**
+ * \fn size_t HMAC::macSize() const
+ * \brief Returns the size of the HMAC output, which is the hash size of T.
+ */
+
+/**
+ * \fn void HMAC::setKey(const void *key, size_t keyLen)
+ * \brief Sets the HMAC key and precomputes the inner and outer hash states.
+ *
+ * \param key Points to the HMAC key.
+ * \param keyLen Length of the \a key in bytes.  Keys longer than the
+ * block size of T are hashed first, as specified by RFC 2104.
+ *
+ * The object is ready for a new message afterwards.
+ */
+
+/**
+ * \fn void HMAC::reset()
+ * \brief Abandons the current message and starts a new one under the
+ * same key.
+ */
+
+/**
+ * \fn void HMAC::update(const void *data, size_t len)
+ * \brief Adds data to the current message.
+ *
+ * \param data Points to the data.
+ * \param len Number of bytes of \a data.
+ */
+
+/**
+ * \fn void HMAC::finalize(void *mac, size_t len)
+ * \brief Finalizes the current message and returns its HMAC value.
+ *
+ * \param mac The buffer to return the HMAC value in.
+ * \param len The length of the \a mac buffer, normally macSize().  Shorter
+ * lengths truncate the value.
+ *
+ * The object is ready for a new message under the same key afterwards,
+ * so reset() does not need to be called.
+ */
+
+/**
+ * \fn void HMAC::compute(void *mac, size_t macLen, const void *data, size_t dataLen)
+ * \brief Computes the HMAC value of a single message.
+ *
+ * \param mac The buffer to return the HMAC value in.
+ * \param macLen The length of the \a mac buffer.
+ * \param data Points to the message.
+ * \param dataLen Length of the message in bytes.
+ *
+ * Any message in progress through update() is discarded.
+ */
+
+/**
+ * \fn void HMAC::clear()
+ * \brief Clears the key and all hash state.  setKey() must be called
+ * again before further use.
+ */
+
+/**
+ * \fn void HMAC::saveKey(void *blob) const
+ * \brief Saves the precomputed inner and outer hash states of the key.
+ *
+ * \param blob Points to KEY_STATE_SIZE bytes to receive the key state.
+ *
+ * The blob lets a keyed object be recreated with loadKey() without the
+ * raw key, for example from EEPROM or a database row.  It must be
+ * protected like the key itself because it is sufficient to compute
+ * HMAC values.
+ *
+ * \sa loadKey()
+ */
+
+/**
+ * \fn bool HMAC::loadKey(const void *blob, size_t len)
+ * \brief Loads inner and outer hash states saved by saveKey().
+ *
+ * \param blob Points to the saved key state.
+ * \param len Length of the \a blob, which must be KEY_STATE_SIZE.
+ *
+ * \return Returns false if the blob is not a key state for T, in which
+ * case the current key is left unchanged.
+ *
+ * The object is ready for a new message afterwards.
+ *
+ * \sa saveKey()
+ */
+
+/**
+ * \var HMAC::KEY_STATE_SIZE
+ * \brief Size of the blob written by saveKey().
+ */
+
+/**
+ * \fn void hmacBatch<T>(void *const out[], size_t outLen, const void *const key[], const size_t keyLen[], const void *const data[], const size_t dataLen[], size_t count)
+ * \brief Computes the HMAC values of many messages, each under its own key.
+ *
+ * \param out Points to the buffers to receive each HMAC value.
+ * \param outLen Length of each output buffer, normally T::HASH_SIZE.
+ * \param key Points to the HMAC key for each message.
+ * \param keyLen Points to the length of each key in bytes.
+ * \param data Points to each message.
+ * \param dataLen Points to the length of each message in bytes.
+ * \param count Number of messages.
+ *
+ * The result is the same as calling hmac<T>() for each message.  The pad
+ * blocks, messages and outer hashes all go through updateBatch() and
+ * finalizeBatch(), so hash algorithms with a multi-buffer implementation
+ * such as SHA256 process HMAC_BATCH_SIZE messages side by side.
+ *
+ * \code
+ * const void *keys[N];  size_t keyLens[N];
+ * const void *msgs[N];  size_t msgLens[N];
+ * void *tags[N];
+ * ...
+ * hmacBatch<SHA256>(tags, 32, keys, keyLens, msgs, msgLens, N);
+ * \endcode
+ *
+ * \sa hmac(), hkdfBatch(), updateBatch()
+ */
+
+/**
+ * \fn void hmacBatchKeys<T>(T *inner, T *outer, const void *const key[], const size_t keyLen[], size_t count)
+ * \brief Prepares the inner and outer HMAC hash states for a batch of keys.
+ *
+ * \param inner Array of \a count hash objects that receive the state after
+ * the inner pad block.
+ * \param outer Array of \a count hash objects that receive the state after
+ * the outer pad block.
+ * \param key Points to each HMAC key.
+ * \param keyLen Points to the length of each key in bytes.
+ * \param count Number of keys.  They are prepared HMAC_BATCH_SIZE at a
+ * time, which bounds the stack use.
+ *
+ * This is the building block of hmacBatch() and hkdfBatch() for callers
+ * that feed the messages in several pieces.
+ */
@@ -0,0 +1,245 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_HMAC_h
+#define CRYPTO_HMAC_h
+
+#include "Hash.h"
+#include "Crypto.h"
+#include <string.h>
+
+template <typename T>
+class HMAC
+{
+public:
+    HMAC() {}
+    HMAC(const void *key, size_t keyLen) { setKey(key, keyLen); }
+    ~HMAC() {}
+
+    size_t macSize() const { return T::HASH_SIZE; }
+
+    void setKey(const void *key, size_t keyLen);
+
+    void reset() { context = inner; }
+    void update(const void *data, size_t len) { context.update(data, len); }
+    void finalize(void *mac, size_t len);
+
+    void compute(void *mac, size_t macLen, const void *data, size_t dataLen)
+    {
+        context = inner;
+        context.update(data, dataLen);
+        finalize(mac, macLen);
+    }
+
+    void clear();
+
+    void saveKey(void *blob) const;
+    bool loadKey(const void *blob, size_t len);
+
+    static const size_t KEY_STATE_SIZE = 2 * T::SNAPSHOT_SIZE;
+
+private:
+    T inner;
+    T outer;
+    T context;
+};
+
+template <typename T>
+void HMAC<T>::setKey(const void *key, size_t keyLen)
+{
+    uint8_t block[T::BLOCK_SIZE];
+    if (keyLen > T::BLOCK_SIZE) {
+        context.reset();
+        context.update(key, keyLen);
+        context.finalize(block, T::HASH_SIZE);
+        keyLen = T::HASH_SIZE;
+    } else {
+        memcpy(block, key, keyLen);
+    }
+    memset(block + keyLen, 0, T::BLOCK_SIZE - keyLen);
+
+    // A full-block key is used as-is by resetHMAC(), which then XORs in
+    // the inner pad.  Pre-XORing the difference of the two pads gives the
+    // outer midstate through the same path.
+    inner.resetHMAC(block, T::BLOCK_SIZE);
+    for (size_t posn = 0; posn < T::BLOCK_SIZE; ++posn)
+        block[posn] ^= (0x36 ^ 0x5C);
+    outer.resetHMAC(block, T::BLOCK_SIZE);
+    ::clean(block, sizeof(block));
+
+    context = inner;
+}
+
+template <typename T>
+void HMAC<T>::finalize(void *mac, size_t len)
+{
+    uint8_t temp[T::HASH_SIZE];
+    context.finalize(temp, sizeof(temp));
+    context = outer;
+    context.update(temp, sizeof(temp));
+    context.finalize(mac, len);
+    ::clean(temp, sizeof(temp));
+    context = inner;
+}
+
+template <typename T>
+void HMAC<T>::saveKey(void *blob) const
+{
+    inner.snapshot(blob);
+    outer.snapshot(((uint8_t *)blob) + T::SNAPSHOT_SIZE);
+}
+
+template <typename T>
+bool HMAC<T>::loadKey(const void *blob, size_t len)
+{
+    const uint8_t *b = (const uint8_t *)blob;
+    if (len != KEY_STATE_SIZE)
+        return false;
+    T in, out;
+    if (!in.restore(b, T::SNAPSHOT_SIZE) ||
+            !out.restore(b + T::SNAPSHOT_SIZE, T::SNAPSHOT_SIZE))
+        return false;
+    inner = in;
+    outer = out;
+    context = inner;
+    return true;
+}
+
+template <typename T>
+void HMAC<T>::clear()
+{
+    inner.clear();
+    outer.clear();
+    context.clear();
+}
+
+// Number of messages the batch functions work on at a time, which sets
+// their stack use.  Batching gains nothing on AVR.
+#if !defined(HMAC_BATCH_SIZE)
+#if defined(__AVR__)
+#define HMAC_BATCH_SIZE 1
+#else
+#define HMAC_BATCH_SIZE 16
+#endif
+#endif
+
+template <typename T>
+void hmacBatchKeys(T *inner, T *outer, const void *const key[],
+                   const size_t keyLen[], size_t count)
+{
+    uint8_t block[HMAC_BATCH_SIZE][T::BLOCK_SIZE];
+    T *hashes[HMAC_BATCH_SIZE];
+    const void *data[HMAC_BATCH_SIZE];
+    size_t len[HMAC_BATCH_SIZE];
+    void *digest[HMAC_BATCH_SIZE];
+    size_t posn, n;
+    while (count > 0) {
+        // The buffers above hold HMAC_BATCH_SIZE keys at a time.
+        size_t batch = (count < HMAC_BATCH_SIZE) ? count : HMAC_BATCH_SIZE;
+
+        // Hash the keys that are longer than a block first.
+        for (posn = 0, n = 0; posn < batch; ++posn) {
+            inner[posn].reset();
+            if (keyLen[posn] > T::BLOCK_SIZE) {
+                hashes[n] = &inner[posn];
+                data[n] = key[posn];
+                len[n] = keyLen[posn];
+                digest[n] = block[posn];
+                ++n;
+            }
+        }
+        if (n) {
+            updateBatch(hashes, data, len, n);
+            finalizeBatch(hashes, digest, T::HASH_SIZE, n);
+        }
+
+        // Absorb the inner and outer pad blocks.
+        for (posn = 0; posn < batch; ++posn) {
+            size_t size = keyLen[posn];
+            if (size > T::BLOCK_SIZE) {
+                size = T::HASH_SIZE;
+                inner[posn].reset();
+            } else {
+                memcpy(block[posn], key[posn], size);
+            }
+            memset(block[posn] + size, 0, T::BLOCK_SIZE - size);
+            for (size_t index = 0; index < T::BLOCK_SIZE; ++index)
+                block[posn][index] ^= 0x36;
+            hashes[posn] = &inner[posn];
+            data[posn] = block[posn];
+            len[posn] = T::BLOCK_SIZE;
+        }
+        updateBatch(hashes, data, len, batch);
+        for (posn = 0; posn < batch; ++posn) {
+            for (size_t index = 0; index < T::BLOCK_SIZE; ++index)
+                block[posn][index] ^= (0x36 ^ 0x5C);
+            outer[posn].reset();
+            hashes[posn] = &outer[posn];
+        }
+        updateBatch(hashes, data, len, batch);
+
+        inner += batch;
+        outer += batch;
+        key += batch;
+        keyLen += batch;
+        count -= batch;
+    }
+    ::clean(block, sizeof(block));
+}
+
+template <typename T>
+void hmacBatch(void *const out[], size_t outLen,
+               const void *const key[], const size_t keyLen[],
+               const void *const data[], const size_t dataLen[], size_t count)
+{
+    T inner[HMAC_BATCH_SIZE];
+    T outer[HMAC_BATCH_SIZE];
+    uint8_t digest[HMAC_BATCH_SIZE][T::HASH_SIZE];
+    T *hashes[HMAC_BATCH_SIZE];
+    void *digestOut[HMAC_BATCH_SIZE];
+    const void *digestIn[HMAC_BATCH_SIZE];
+    size_t digestLen[HMAC_BATCH_SIZE];
+    while (count > 0) {
+        size_t n = (count < HMAC_BATCH_SIZE) ? count : HMAC_BATCH_SIZE;
+        hmacBatchKeys(inner, outer, key, keyLen, n);
+        for (size_t posn = 0; posn < n; ++posn) {
+            hashes[posn] = &inner[posn];
+            digestOut[posn] = digest[posn];
+            digestIn[posn] = digest[posn];
+            digestLen[posn] = T::HASH_SIZE;
+        }
+        updateBatch(hashes, data, dataLen, n);
+        finalizeBatch(hashes, digestOut, T::HASH_SIZE, n);
+        for (size_t posn = 0; posn < n; ++posn)
+            hashes[posn] = &outer[posn];
+        updateBatch(hashes, digestIn, digestLen, n);
+        finalizeBatch(hashes, out, outLen, n);
+        out += n;
+        key += n;
+        keyLen += n;
+        data += n;
+        dataLen += n;
+        count -= n;
+    }
+    ::clean(digest, sizeof(digest));
+}
+
+#endif
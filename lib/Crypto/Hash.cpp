@@ -27,6 +27,43 @@
  * \class Hash Hash.h <Hash.h>
  * \brief Abstract base class for cryptographic hash algorithms.
  *
+ * \par Snapshots
+ *
+ * SHA1, SHA256, SHA512, SHA3_256, SHA3_512, BLAKE2s, BLAKE2b and their
+ * subclasses can write the state of a hashing process to a blob with
+ * snapshot() and resume it later with restore().  This is useful for
+ * precomputing a common prefix such as a HMAC key block or a per-device
+ * salt and storing it in RAM, EEPROM or a database:
+ *
+ * \code
+ * SHA256 sha256;
+ * uint8_t prefix[SHA256::SNAPSHOT_SIZE];
+ * sha256.update(salt, sizeof(salt));
+ * sha256.snapshot(prefix);
+ * ...
+ * sha256.restore(prefix, sizeof(prefix));
+ * sha256.update(message, messageLen);
+ * sha256.finalize(hash, sizeof(hash));
+ * \endcode
+ *
+ * These methods are not virtual and are not part of the Hash interface,
+ * so firmware that never takes a snapshot does not link them in.  The
+ * blob size is fixed per algorithm and available at compile time as the
+ * \c SNAPSHOT_SIZE constant on the class.
+ *
+ * The blob has the same layout on every platform: a four byte header
+ * (algorithm tag, format version, number of buffered input bytes and an
+ * algorithm-specific byte) followed by the chaining state and length
+ * counters in little-endian order and then the buffered input.
+ * restore() rejects a blob of the wrong length, algorithm or format
+ * version and leaves the current state unchanged in that case.
+ *
+ * The blob contains sensitive data if the hashed prefix does, such as a
+ * HMAC key.  It should be protected accordingly and cleaned after use.
+ *
+ * Hash objects can also be copied with the assignment operator to fork
+ * a hashing process in memory without going through a blob.
+ *
  * \sa SHA224, SHA256, SHA384, SHA3_256, BLAKE2s
  */
 
@@ -199,4 +236,38 @@ void Hash::formatHMACKey(void *block, const void *key, size_t len, uint8_t pad)
  * uint8_t out[SHA256::HASH_SIZE];
  * hmac<SHA256>(out, sizeof(out), key, keyLen, data, dataLen);
  * \endcode
+ *
+ * When many messages are authenticated under the same key, use the HMAC
+ * class instead, which prepares the key once.
+ *
+ * \sa HMAC
+ */
+
+/**
+ * \fn void updateBatch<T>(T *const hashes[], const void *const data[], const size_t len[], size_t count)
+ * \brief Updates several independent hashing processes at once.
+ *
+ * \param hashes Points to \a count distinct hash objects.
+ * \param data Points to the data for each hash object.
+ * \param len Points to the length of the data for each hash object.
+ * \param count Number of hash objects.
+ *
+ * The result is the same as calling update() on each object in turn,
+ * which is what this generic version does.  Algorithms that can compress
+ * several messages side by side provide an overload for their own type,
+ * such as updateBatch(SHA256 *const[], ...), which is chosen instead.
+ *
+ * \sa finalizeBatch(), hmacBatch()
+ */
+
+/**
+ * \fn void finalizeBatch<T>(T *const hashes[], void *const hash[], size_t len, size_t count)
+ * \brief Finalizes several independent hashing processes at once.
+ *
+ * \param hashes Points to \a count distinct hash objects.
+ * \param hash Points to the buffers to return each hash value in.
+ * \param len The length of each \a hash buffer, normally hashSize().
+ * \param count Number of hash objects.
+ *
+ * \sa updateBatch()
  */
@@ -46,6 +46,23 @@ public:
 
 protected:
     void formatHMACKey(void *block, const void *key, size_t len, uint8_t pad);
+
+    // Snapshot header: tag, version, buffered bytes, algorithm-specific.
+    enum
+    {
+        SnapshotHeaderSize = 4,
+        SnapshotVersion = 1,
+
+        SnapshotSHA1 = 1,
+        SnapshotSHA256 = 2,
+        SnapshotSHA224 = 3,
+        SnapshotSHA512 = 4,
+        SnapshotSHA384 = 5,
+        SnapshotSHA3_256 = 6,
+        SnapshotSHA3_512 = 7,
+        SnapshotBLAKE2s = 8,
+        SnapshotBLAKE2b = 9
+    };
 };
 
 template <typename T> void hmac
@@ -58,4 +75,18 @@ template <typename T> void hmac
     context.finalizeHMAC(key, keyLen, out, outLen);
 }
 
+template <typename T> void updateBatch
+    (T *const hashes[], const void *const data[], const size_t len[], size_t count)
+{
+    for (size_t posn = 0; posn < count; ++posn)
+        hashes[posn]->update(data[posn], len[posn]);
+}
+
+template <typename T> void finalizeBatch
+    (T *const hashes[], void *const hash[], size_t len, size_t count)
+{
+    for (size_t posn = 0; posn < count; ++posn)
+        hashes[posn]->finalize(hash[posn], len);
+}
+
 #endif
@@ -0,0 +1,340 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "HashPipeline.h"
+
+#if CRYPTO_HASH_PIPELINE
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+/**
+ * \class HashPipeline HashPipeline.h <HashPipeline.h>
+ * \brief Hashes files and streams with one or more hash objects in a
+ * single pass.
+ *
+ * A loop of read() and Hash::update() leaves the disk idle while the
+ * data is hashed and the CPU idle while the next block is read.
+ * HashPipeline overlaps the two: regular files are mapped into memory
+ * with read-ahead requested for the next window, and other descriptors
+ * such as pipes are read by a separate thread into one buffer while the
+ * other buffer is hashed.
+ *
+ * Every hash object that was added with addHash() sees all of the data.
+ * The data is handed to them in 64K slices so that each slice is still
+ * in the cache for the next hash.  With a thread pool from
+ * setThreadPool(), the hash objects instead run on separate threads over
+ * each window.
+ *
+ * \code
+ * SHA256 sha256;
+ * BLAKE2b blake2b;
+ * HashPipeline pipeline;
+ * pipeline.addHash(&sha256);
+ * pipeline.addHash(&blake2b);
+ * if (pipeline.hashFile("firmware.bin")) {
+ *     sha256.finalize(digest1, sizeof(digest1));
+ *     blake2b.finalize(digest2, sizeof(digest2));
+ * }
+ * \endcode
+ *
+ * The pipeline only calls Hash::update(), so the hash objects must be
+ * reset beforehand and finalized afterwards, which also allows HMAC
+ * or keyed modes.  Hash pipelines are available on POSIX host builds
+ * only; see CRYPTO_HASH_PIPELINE in HashPipeline.h.
+ *
+ * \sa ThreadPool, TreeHash
+ */
+
+/**
+ * \brief Constructs a hash pipeline.
+ *
+ * \param bufferSize Number of bytes in each read buffer or mapped window,
+ * rounded up to a multiple of 64K.
+ */
+HashPipeline::HashPipeline(size_t bufferSize)
+    : count(0)
+    , bufferSize((bufferSize + 0xFFFF) & ~((size_t)0xFFFF))
+    , pool(0)
+    , total(0)
+{
+    if (!this->bufferSize)
+        this->bufferSize = HASH_PIPELINE_BUFFER_SIZE;
+    buffers[0] = 0;
+    buffers[1] = 0;
+}
+
+/**
+ * \brief Destroys this hash pipeline.  The hash objects are not affected.
+ */
+HashPipeline::~HashPipeline()
+{
+    delete [] buffers[0];
+    delete [] buffers[1];
+}
+
+/**
+ * \brief Adds a hash object to feed with the data.
+ *
+ * \param hash The hash object, which must remain valid while the pipeline
+ * is in use.
+ *
+ * \return Returns false if HASH_PIPELINE_MAX_HASHES objects have already
+ * been added.
+ */
+bool HashPipeline::addHash(Hash *hash)
+{
+    if (count >= HASH_PIPELINE_MAX_HASHES)
+        return false;
+    hashes[count++] = hash;
+    return true;
+}
+
+/**
+ * \fn void HashPipeline::clearHashes()
+ * \brief Removes all hash objects from the pipeline.
+ */
+
+/**
+ * \fn size_t HashPipeline::hashCount() const
+ * \brief Returns the number of hash objects that the pipeline feeds.
+ */
+
+/**
+ * \fn void HashPipeline::setThreadPool(ThreadPool *pool)
+ * \brief Sets a thread pool to run the hash objects on in parallel.
+ *
+ * \param pool The thread pool, or NULL to run all hash objects on the
+ * calling thread.
+ */
+
+/**
+ * \brief Hashes the contents of a file.
+ *
+ * \param path The path of the file.
+ *
+ * \return Returns false if the file could not be opened or read, with
+ * errno set.  The hash objects may have been given part of the file.
+ *
+ * Regular files are mapped into memory.  Other files, or files that
+ * cannot be mapped, are read through hashDescriptor().  A mapped file
+ * must not be truncated while it is being hashed.
+ */
+bool HashPipeline::hashFile(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    bool ok;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+            (uint64_t)st.st_size <= (uint64_t)(~((size_t)0))) {
+        ok = hashMapped(fd, (size_t)st.st_size) || hashDescriptor(fd);
+    } else {
+        ok = hashDescriptor(fd);
+    }
+    int err = errno;
+    close(fd);
+    errno = err;
+    return ok;
+}
+
+/**
+ * \fn uint64_t HashPipeline::length() const
+ * \brief Returns the number of bytes hashed by the last call to
+ * hashFile() or hashDescriptor().
+ */
+
+// State that is shared between hashDescriptor() and its reader thread.
+// Each buffer is either empty, so the reader may fill it, or full, so
+// the hash objects may consume it.
+struct HashPipeline::Reader
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    uint8_t *buffers[2];
+    size_t size;
+    size_t len[2];
+    bool full[2];
+    bool last[2];
+    bool error;
+    int err;
+    int fd;
+};
+
+/**
+ * \brief Hashes everything that can be read from a file descriptor.
+ *
+ * \param fd The file descriptor, such as a pipe or socket.  It is read
+ * until end of file but not closed.
+ *
+ * \return Returns false if a read failed, with errno set.  The hash
+ * objects will have been given the data up to the failure.
+ *
+ * A reader thread fills one buffer while the hash objects consume the
+ * other.
+ */
+bool HashPipeline::hashDescriptor(int fd)
+{
+    if (!buffers[0]) {
+        buffers[0] = new uint8_t [bufferSize];
+        buffers[1] = new uint8_t [bufferSize];
+    }
+    total = 0;
+
+    Reader reader;
+    reader.buffers[0] = buffers[0];
+    reader.buffers[1] = buffers[1];
+    reader.size = bufferSize;
+    reader.full[0] = reader.full[1] = false;
+    reader.last[0] = reader.last[1] = false;
+    reader.error = false;
+    reader.err = 0;
+    reader.fd = fd;
+    std::thread thread(readerThread, &reader);
+
+    for (uint8_t index = 0; ; index ^= 1) {
+        size_t len;
+        bool last;
+        {
+            std::unique_lock<std::mutex> lock(reader.mutex);
+            reader.changed.wait(lock, [&reader, index] { return reader.full[index]; });
+            len = reader.len[index];
+            last = reader.last[index];
+        }
+        feed(reader.buffers[index], len);
+        {
+            std::lock_guard<std::mutex> lock(reader.mutex);
+            reader.full[index] = false;
+        }
+        reader.changed.notify_one();
+        if (last)
+            break;
+    }
+
+    thread.join();
+    if (reader.error) {
+        errno = reader.err;
+        return false;
+    }
+    return true;
+}
+
+void HashPipeline::readerThread(Reader *reader)
+{
+    for (uint8_t index = 0; ; index ^= 1) {
+        {
+            std::unique_lock<std::mutex> lock(reader->mutex);
+            reader->changed.wait(lock, [reader, index] { return !reader->full[index]; });
+        }
+
+        // Fill the whole buffer so that pipes, which return a little at a
+        // time, do not turn into many small updates.
+        size_t len = 0;
+        bool last = false;
+        while (len < reader->size) {
+            ssize_t n = read(reader->fd, reader->buffers[index] + len, reader->size - len);
+            if (n > 0) {
+                len += (size_t)n;
+            } else if (n == 0) {
+                last = true;
+                break;
+            } else if (errno != EINTR) {
+                reader->err = errno;
+                reader->error = true;
+                last = true;
+                break;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(reader->mutex);
+            reader->len[index] = len;
+            reader->last[index] = last;
+            reader->full[index] = true;
+        }
+        reader->changed.notify_one();
+        if (last)
+            break;
+    }
+}
+
+bool HashPipeline::hashMapped(int fd, size_t size)
+{
+    void *map = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+        return false;
+    const uint8_t *data = (const uint8_t *)map;
+    total = 0;
+    madvise(map, size, MADV_SEQUENTIAL);
+    for (size_t posn = 0; posn < size; posn += bufferSize) {
+        // Ask for the next window to be read in while this one is hashed.
+        size_t len = size - posn;
+        if (len > bufferSize) {
+            size_t ahead = len - bufferSize;
+            if (ahead > bufferSize)
+                ahead = bufferSize;
+            madvise((void *)(data + posn + bufferSize), ahead, MADV_WILLNEED);
+            len = bufferSize;
+        }
+        feed(data + posn, len);
+    }
+    munmap(map, size);
+    return true;
+}
+
+struct HashPipeline::FeedJob
+{
+    Hash *const *hashes;
+    const uint8_t *data;
+    size_t len;
+};
+
+void HashPipeline::feed(const uint8_t *data, size_t len)
+{
+    total += len;
+    if (pool && pool->size() > 1 && count > 1) {
+        FeedJob job;
+        job.hashes = hashes;
+        job.data = data;
+        job.len = len;
+        pool->run(feedTask, &job, count);
+        return;
+    }
+    while (len > 0) {
+        size_t size = (len < 0x10000) ? len : 0x10000;
+        for (size_t index = 0; index < count; ++index)
+            hashes[index]->update(data, size);
+        data += size;
+        len -= size;
+    }
+}
+
+void HashPipeline::feedTask(void *arg, size_t index)
+{
+    const FeedJob *job = (const FeedJob *)arg;
+    job->hashes[index]->update(job->data, job->len);
+}
+
+#endif // CRYPTO_HASH_PIPELINE
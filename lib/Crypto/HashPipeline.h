@@ -0,0 +1,88 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_HASHPIPELINE_h
+#define CRYPTO_HASHPIPELINE_h
+
+#include "Hash.h"
+#include "ThreadPool.h"
+
+// Hashing of files and streams needs threads and POSIX file descriptors.
+#if !defined(CRYPTO_HASH_PIPELINE)
+#if CRYPTO_THREADS && (defined(__unix__) || defined(__APPLE__))
+#define CRYPTO_HASH_PIPELINE 1
+#else
+#define CRYPTO_HASH_PIPELINE 0
+#endif
+#endif
+
+#if CRYPTO_HASH_PIPELINE
+
+// Number of bytes that are mapped ahead or read per buffer.
+#ifndef HASH_PIPELINE_BUFFER_SIZE
+#define HASH_PIPELINE_BUFFER_SIZE (1024 * 1024)
+#endif
+
+// Maximum number of hash objects that are fed in one pass.
+#ifndef HASH_PIPELINE_MAX_HASHES
+#define HASH_PIPELINE_MAX_HASHES 8
+#endif
+
+class HashPipeline
+{
+public:
+    explicit HashPipeline(size_t bufferSize = HASH_PIPELINE_BUFFER_SIZE);
+    ~HashPipeline();
+
+    bool addHash(Hash *hash);
+    void clearHashes() { count = 0; }
+    size_t hashCount() const { return count; }
+
+    void setThreadPool(ThreadPool *pool) { this->pool = pool; }
+
+    bool hashFile(const char *path);
+    bool hashDescriptor(int fd);
+
+    uint64_t length() const { return total; }
+
+private:
+    Hash *hashes[HASH_PIPELINE_MAX_HASHES];
+    size_t count;
+    size_t bufferSize;
+    uint8_t *buffers[2];
+    ThreadPool *pool;
+    uint64_t total;
+
+    struct FeedJob;
+    struct Reader;
+
+    bool hashMapped(int fd, size_t size);
+    void feed(const uint8_t *data, size_t len);
+    static void feedTask(void *arg, size_t index);
+    static void readerThread(Reader *reader);
+
+    HashPipeline(const HashPipeline &) = delete;
+    HashPipeline &operator=(const HashPipeline &) = delete;
+};
+
+#endif // CRYPTO_HASH_PIPELINE
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "KMAC.h"
+
+/**
+ * \class KMAC KMAC.h <KMAC.h>
+ * \brief Abstract base class for the KECCAK Message Authentication Codes
+ * (KMAC) from NIST SP 800-185.
+ *
+ * KMAC is cSHAKE with the name "KMAC" and the key padded to a whole
+ * block ahead of the message.  setKey() absorbs the customization block
+ * and the key block once and saves the state, so each MAC after that is
+ * reset(), update() and finalize(): the message and its padding go
+ * through the permutation and nothing else.  For a message that fits in
+ * one block this is one permutation, against three for HMAC over SHA3
+ * even when the HMAC key blocks are precomputed.
+ *
+ * \code
+ * KMAC256 kmac;
+ * kmac.setKey(key, sizeof(key), "audit", 5);
+ * for (each record) {
+ *     kmac.reset();
+ *     kmac.update(record, recordLen);
+ *     kmac.finalize(mac, 32);
+ * }
+ * \endcode
+ *
+ * finalize() produces KMAC with the output length bound into the result,
+ * so a shorter MAC is not a prefix of a longer one.  extend() and
+ * encrypt() produce the variable-length KMACXOF instead.
+ *
+ * Reference: https://doi.org/10.6028/NIST.SP.800-185
+ *
+ * \sa KMAC128, KMAC256, CSHAKE
+ */
+
+/**
+ * \class KMAC128 KMAC.h <KMAC.h>
+ * \brief KMAC128 message authentication code.
+ *
+ * \sa KMAC256
+ */
+
+/**
+ * \class KMAC256 KMAC.h <KMAC.h>
+ * \brief KMAC256 message authentication code.
+ *
+ * \sa KMAC128
+ */
+
+/**
+ * \brief Constructs a KMAC object with an empty key and customization
+ * string.
+ *
+ * \param capacity The capacity of the Keccak sponge function in bits,
+ * 256 for KMAC128 or 512 for KMAC256.
+ */
+KMAC::KMAC(size_t capacity)
+    : CSHAKE(capacity)
+{
+    encodeLength = true;
+    setKey(0, 0);
+}
+
+/**
+ * \brief Destroys this KMAC object after clearing all sensitive
+ * information.
+ */
+KMAC::~KMAC()
+{
+}
+
+/**
+ * \brief Sets the key and customization string.
+ *
+ * \param key Points to the key.
+ * \param len Length of the key in bytes, which may be any length.
+ * \param custom Points to the optional customization string.
+ * \param customLen Length of the customization string in bytes.
+ *
+ * The key and customization string are absorbed here and the state is
+ * saved as the starting point for reset().
+ *
+ * \sa reset(), finalize()
+ */
+void KMAC::setKey(const void *key, size_t len, const void *custom, size_t customLen)
+{
+    setCustomization("KMAC", 4, custom, customLen);
+    absorbKey(key, len);
+    saveResetPoint();
+}
+
+/**
+ * \brief Finalizes the MAC and returns it.
+ *
+ * \param mac The buffer to return the MAC in.
+ * \param len The length of the MAC in bytes, which is bound into the
+ * result.
+ *
+ * Call reset() or update() afterwards to start on the next message with
+ * the same key.
+ */
+void KMAC::finalize(void *mac, size_t len)
+{
+    if (finalized)
+        reset();
+    finish(((uint64_t)len) * 8);
+    CSHAKE::extend((uint8_t *)mac, len);
+}
+
+KMAC128::~KMAC128()
+{
+}
+
+KMAC256::~KMAC256()
+{
+}
@@ -0,0 +1,55 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_KMAC_h
+#define CRYPTO_KMAC_h
+
+#include "CSHAKE.h"
+
+class KMAC : public CSHAKE
+{
+public:
+    virtual ~KMAC();
+
+    void setKey(const void *key, size_t len,
+                const void *custom = 0, size_t customLen = 0);
+
+    void finalize(void *mac, size_t len);
+
+protected:
+    KMAC(size_t capacity);
+};
+
+class KMAC128 : public KMAC
+{
+public:
+    KMAC128() : KMAC(256) {}
+    virtual ~KMAC128();
+};
+
+class KMAC256 : public KMAC
+{
+public:
+    KMAC256() : KMAC(512) {}
+    virtual ~KMAC256();
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include "utility/EndianUtil.h"
 #include "utility/RotateUtil.h"
 #include "utility/ProgMemUtil.h"
+#include "utility/KeccakMultiBufferUtil.h"
 #include <string.h>
 
 /**
@@ -34,6 +35,12 @@
  * KeccakCore provides the core sponge function for different capacities.
  * It is used to implement algorithms such as SHA3 and SHAKE.
  *
+ * On 32-bit platforms other than AVR the state is kept in bit-interleaved
+ * form, with the even and odd bits of each 64-bit lane in separate 32-bit
+ * words, which turns the lane rotations into 32-bit rotations.  Only the
+ * bytes that are absorbed or squeezed are converted.  Define
+ * CRYPTO_KECCAK_INTERLEAVED to 0 or 1 to override the choice.
+ *
  * References: http://en.wikipedia.org/wiki/SHA-3
  *
  * \sa SHA3_256, SHAKE256
@@ -44,6 +51,301 @@
 #error "KeccakCore is not supported on big-endian platforms yet - todo"
 #endif
 
+// Use the AVR assembly version of keccakp() on AVR unless the build
+// selects the portable C version with -DCRYPTO_KECCAK_AVR_ASM=0.
+#if !defined(CRYPTO_KECCAK_AVR_ASM)
+#if defined(__AVR__)
+#define CRYPTO_KECCAK_AVR_ASM 1
+#else
+#define CRYPTO_KECCAK_AVR_ASM 0
+#endif
+#elif CRYPTO_KECCAK_AVR_ASM && !defined(__AVR__)
+#error "CRYPTO_KECCAK_AVR_ASM requires an AVR target"
+#endif
+
+// On 32-bit targets other than AVR, keccakp() works on bit-interleaved
+// lanes so that each 64-bit rotation becomes two 32-bit rotations.
+#if !defined(CRYPTO_KECCAK_INTERLEAVED)
+#if !CRYPTO_KECCAK_AVR_ASM && defined(__SIZEOF_POINTER__) && __SIZEOF_POINTER__ == 4
+#define CRYPTO_KECCAK_INTERLEAVED 1
+#else
+#define CRYPTO_KECCAK_INTERLEAVED 0
+#endif
+#elif CRYPTO_KECCAK_INTERLEAVED && CRYPTO_KECCAK_AVR_ASM
+#error "CRYPTO_KECCAK_INTERLEAVED cannot be combined with CRYPTO_KECCAK_AVR_ASM"
+#endif
+
+#if CRYPTO_KECCAK_INTERLEAVED
+
+// Moves the even bits of x to the low half and the odd bits to the high half.
+static inline uint32_t unshuffleBits(uint32_t x)
+{
+    uint32_t t;
+    t = (x ^ (x >> 1)) & 0x22222222UL; x ^= t ^ (t << 1);
+    t = (x ^ (x >> 2)) & 0x0C0C0C0CUL; x ^= t ^ (t << 2);
+    t = (x ^ (x >> 4)) & 0x00F000F0UL; x ^= t ^ (t << 4);
+    t = (x ^ (x >> 8)) & 0x0000FF00UL; x ^= t ^ (t << 8);
+    return x;
+}
+
+// Inverse of unshuffleBits().
+static inline uint32_t shuffleBits(uint32_t x)
+{
+    uint32_t t;
+    t = (x ^ (x >> 8)) & 0x0000FF00UL; x ^= t ^ (t << 8);
+    t = (x ^ (x >> 4)) & 0x00F000F0UL; x ^= t ^ (t << 4);
+    t = (x ^ (x >> 2)) & 0x0C0C0C0CUL; x ^= t ^ (t << 2);
+    t = (x ^ (x >> 1)) & 0x22222222UL; x ^= t ^ (t << 1);
+    return x;
+}
+
+// Converts a lane into its even bits in the low word and its odd bits
+// in the high word.
+static uint64_t toInterleaved(uint64_t x)
+{
+    uint32_t lo = unshuffleBits((uint32_t)x);
+    uint32_t hi = unshuffleBits((uint32_t)(x >> 32));
+    return (((uint64_t)((lo >> 16) | (hi & 0xFFFF0000UL))) << 32) |
+           ((lo & 0x0000FFFFUL) | (hi << 16));
+}
+
+// Inverse of toInterleaved().
+static uint64_t fromInterleaved(uint64_t x)
+{
+    uint32_t even = (uint32_t)x;
+    uint32_t odd = (uint32_t)(x >> 32);
+    uint32_t lo = (even & 0x0000FFFFUL) | (odd << 16);
+    uint32_t hi = (even >> 16) | (odd & 0xFFFF0000UL);
+    return (((uint64_t)shuffleBits(hi)) << 32) | shuffleBits(lo);
+}
+
+// XORs bytes into the interleaved state starting at byte offset "posn",
+// and optionally reads the bytes of the state there first.  Since the
+// interleaving is linear, XORing interleaved values is the same as
+// interleaving the XOR.
+static void xorLanes(uint64_t *A, uint8_t posn, const uint8_t *data, uint8_t len)
+{
+    while (len > 0) {
+        uint8_t shift = posn % 8;
+        uint8_t size = 8 - shift;
+        if (size > len)
+            size = len;
+        uint64_t x = 0;
+        if (size == 8) {
+            x = loadLE64(data);
+        } else {
+            for (uint8_t index = 0; index < size; ++index)
+                x |= ((uint64_t)(data[index])) << ((shift + index) * 8);
+        }
+        A[posn / 8] ^= toInterleaved(x);
+        posn += size;
+        data += size;
+        len -= size;
+    }
+}
+
+// Reads bytes from the interleaved state starting at byte offset "posn",
+// XORed with "input" if it is not NULL.  "output" may be "input".
+static void readLanes(const uint64_t *A, uint8_t posn, uint8_t *output,
+                      const uint8_t *input, uint8_t len)
+{
+    while (len > 0) {
+        uint8_t shift = posn % 8;
+        uint8_t size = 8 - shift;
+        if (size > len)
+            size = len;
+        uint64_t x = fromInterleaved(A[posn / 8]) >> (shift * 8);
+        if (size == 8) {
+            storeLE64(output, input ? (x ^ loadLE64(input)) : x);
+        } else {
+            for (uint8_t index = 0; index < size; ++index, x >>= 8)
+                output[index] = (uint8_t)x ^ (input ? input[index] : 0);
+        }
+        posn += size;
+        output += size;
+        if (input)
+            input += size;
+        len -= size;
+    }
+}
+
+// Step mapping chi on one row of even or odd words.
+static inline void chiRow(uint32_t *A, const uint32_t *B)
+{
+    A[0] = B[0] ^ ((~B[1]) & B[2]);
+    A[1] = B[1] ^ ((~B[2]) & B[3]);
+    A[2] = B[2] ^ ((~B[3]) & B[4]);
+    A[3] = B[3] ^ ((~B[4]) & B[0]);
+    A[4] = B[4] ^ ((~B[0]) & B[1]);
+}
+
+// Keccak-p[1600] on a state whose lanes are split into a word of the
+// even-numbered bits (E) and a word of the odd-numbered bits (O).  The
+// state is kept in this form between calls; only the bytes that go in
+// or come out of the sponge are converted.
+// Rotating a lane left by 2n rotates both words by n; rotating it by
+// 2n + 1 swaps the words, rotating the new even word by n + 1 and the
+// new odd word by n.
+static void keccakpInterleaved(uint64_t A[5][5])
+{
+    static uint32_t const RC[48] PROGMEM = {
+        0x00000001UL, 0x00000000UL, 0x00000000UL, 0x00000089UL, 0x00000000UL, 0x8000008BUL,
+        0x00000000UL, 0x80008080UL, 0x00000001UL, 0x0000008BUL, 0x00000001UL, 0x00008000UL,
+        0x00000001UL, 0x80008088UL, 0x00000001UL, 0x80000082UL, 0x00000000UL, 0x0000000BUL,
+        0x00000000UL, 0x0000000AUL, 0x00000001UL, 0x00008082UL, 0x00000000UL, 0x00008003UL,
+        0x00000001UL, 0x0000808BUL, 0x00000001UL, 0x8000000BUL, 0x00000001UL, 0x8000008AUL,
+        0x00000001UL, 0x80000081UL, 0x00000000UL, 0x80000081UL, 0x00000000UL, 0x80000008UL,
+        0x00000000UL, 0x00000083UL, 0x00000000UL, 0x80008003UL, 0x00000001UL, 0x80008088UL,
+        0x00000000UL, 0x80000088UL, 0x00000001UL, 0x00008000UL, 0x00000000UL, 0x80008082UL
+    };
+    uint32_t E[5][5], O[5][5];
+    uint32_t BE[5][5], BO[5][5];
+    uint32_t CE[5], CO[5];
+    uint32_t DE[5], DO[5];
+    uint8_t index, index2;
+
+    for (index2 = 0; index2 < 5; ++index2) {
+        for (index = 0; index < 5; ++index) {
+            E[index2][index] = (uint32_t)(A[index2][index]);
+            O[index2][index] = (uint32_t)(A[index2][index] >> 32);
+        }
+    }
+
+    for (uint8_t round = 0; round < 24; ++round) {
+        // Step mapping theta.
+        for (index = 0; index < 5; ++index) {
+            CE[index] = E[0][index] ^ E[1][index] ^ E[2][index] ^
+                        E[3][index] ^ E[4][index];
+            CO[index] = O[0][index] ^ O[1][index] ^ O[2][index] ^
+                        O[3][index] ^ O[4][index];
+        }
+        DE[0] = CE[4] ^ leftRotate1(CO[1]);
+        DO[0] = CO[4] ^ CE[1];
+        DE[1] = CE[0] ^ leftRotate1(CO[2]);
+        DO[1] = CO[0] ^ CE[2];
+        DE[2] = CE[1] ^ leftRotate1(CO[3]);
+        DO[2] = CO[1] ^ CE[3];
+        DE[3] = CE[2] ^ leftRotate1(CO[4]);
+        DO[3] = CO[2] ^ CE[4];
+        DE[4] = CE[3] ^ leftRotate1(CO[0]);
+        DO[4] = CO[3] ^ CE[0];
+        for (index2 = 0; index2 < 5; ++index2) {
+            for (index = 0; index < 5; ++index) {
+                E[index2][index] ^= DE[index];
+                O[index2][index] ^= DO[index];
+            }
+        }
+
+        // Step mappings rho and pi combined into a single step.
+        BE[0][0] = E[0][0];
+        BO[0][0] = O[0][0];
+        BE[1][0] = leftRotate(E[0][3], 14);
+        BO[1][0] = leftRotate(O[0][3], 14);
+        BE[2][0] = leftRotate(O[0][1], 1);
+        BO[2][0] = E[0][1];
+        BE[3][0] = leftRotate(O[0][4], 14);
+        BO[3][0] = leftRotate(E[0][4], 13);
+        BE[4][0] = leftRotate(E[0][2], 31);
+        BO[4][0] = leftRotate(O[0][2], 31);
+        BE[0][1] = leftRotate(E[1][1], 22);
+        BO[0][1] = leftRotate(O[1][1], 22);
+        BE[1][1] = leftRotate(E[1][4], 10);
+        BO[1][1] = leftRotate(O[1][4], 10);
+        BE[2][1] = leftRotate(E[1][2], 3);
+        BO[2][1] = leftRotate(O[1][2], 3);
+        BE[3][1] = leftRotate(E[1][0], 18);
+        BO[3][1] = leftRotate(O[1][0], 18);
+        BE[4][1] = leftRotate(O[1][3], 28);
+        BO[4][1] = leftRotate(E[1][3], 27);
+        BE[0][2] = leftRotate(O[2][2], 22);
+        BO[0][2] = leftRotate(E[2][2], 21);
+        BE[1][2] = leftRotate(O[2][0], 2);
+        BO[1][2] = leftRotate(E[2][0], 1);
+        BE[2][2] = leftRotate(O[2][3], 13);
+        BO[2][2] = leftRotate(E[2][3], 12);
+        BE[3][2] = leftRotate(E[2][1], 5);
+        BO[3][2] = leftRotate(O[2][1], 5);
+        BE[4][2] = leftRotate(O[2][4], 20);
+        BO[4][2] = leftRotate(E[2][4], 19);
+        BE[0][3] = leftRotate(O[3][3], 11);
+        BO[0][3] = leftRotate(E[3][3], 10);
+        BE[1][3] = leftRotate(O[3][1], 23);
+        BO[1][3] = leftRotate(E[3][1], 22);
+        BE[2][3] = leftRotate(E[3][4], 4);
+        BO[2][3] = leftRotate(O[3][4], 4);
+        BE[3][3] = leftRotate(O[3][2], 8);
+        BO[3][3] = leftRotate(E[3][2], 7);
+        BE[4][3] = leftRotate(O[3][0], 21);
+        BO[4][3] = leftRotate(E[3][0], 20);
+        BE[0][4] = leftRotate(E[4][4], 7);
+        BO[0][4] = leftRotate(O[4][4], 7);
+        BE[1][4] = leftRotate(O[4][2], 31);
+        BO[1][4] = leftRotate(E[4][2], 30);
+        BE[2][4] = leftRotate(E[4][0], 9);
+        BO[2][4] = leftRotate(O[4][0], 9);
+        BE[3][4] = leftRotate(E[4][3], 28);
+        BO[3][4] = leftRotate(O[4][3], 28);
+        BE[4][4] = leftRotate(E[4][1], 1);
+        BO[4][4] = leftRotate(O[4][1], 1);
+
+        // Step mapping chi.  Combine each lane with two other lanes in its row.
+        for (index2 = 0; index2 < 5; ++index2) {
+            chiRow(E[index2], BE[index2]);
+            chiRow(O[index2], BO[index2]);
+        }
+
+        // Step mapping iota.
+        E[0][0] ^= pgm_read_dword(RC + round * 2);
+        O[0][0] ^= pgm_read_dword(RC + round * 2 + 1);
+    }
+
+    for (index2 = 0; index2 < 5; ++index2) {
+        for (index = 0; index < 5; ++index) {
+            A[index2][index] = (((uint64_t)(O[index2][index])) << 32) |
+                               E[index2][index];
+        }
+    }
+}
+
+#else // !CRYPTO_KECCAK_INTERLEAVED
+
+// XORs bytes into the state starting at byte offset "posn".  Whole lanes
+// go a word at a time, except on AVR where bytes are just as fast.
+static void xorLanes(uint64_t *A, uint8_t posn, const uint8_t *data, uint8_t len)
+{
+    uint8_t *Abytes = ((uint8_t *)A) + posn;
+#if !defined(__AVR__)
+    for (; len > 0 && (posn % 8) != 0; --len, ++posn)
+        *Abytes++ ^= *data++;
+    for (; len >= 8; len -= 8, posn += 8, data += 8, Abytes += 8)
+        A[posn / 8] ^= loadLE64(data);
+#endif
+    for (; len > 0; --len)
+        *Abytes++ ^= *data++;
+}
+
+// Reads bytes from the state starting at byte offset "posn", XORed with
+// "input" if it is not NULL.  "output" may be "input".
+static void readLanes(const uint64_t *A, uint8_t posn, uint8_t *output,
+                      const uint8_t *input, uint8_t len)
+{
+    const uint8_t *Abytes = ((const uint8_t *)A) + posn;
+    if (!input) {
+        memcpy(output, Abytes, len);
+        return;
+    }
+#if !defined(__AVR__)
+    for (; len > 0 && (posn % 8) != 0; --len, ++posn)
+        *output++ = *Abytes++ ^ *input++;
+    for (; len >= 8; len -= 8, posn += 8, input += 8, output += 8, Abytes += 8)
+        storeLE64(output, A[posn / 8] ^ loadLE64(input));
+#endif
+    for (; len > 0; --len)
+        *output++ = *Abytes++ ^ *input++;
+}
+
+#endif // !CRYPTO_KECCAK_INTERLEAVED
+
 /**
  * \brief Constructs a new Keccak sponge function.
  *
@@ -141,9 +443,7 @@ void KeccakCore::update(const void *data, size_t size)
         uint8_t len = _blockSize - state.inputSize;
         if (len > size)
             len = size;
-        uint8_t *Abytes = ((uint8_t *)state.A) + state.inputSize;
-        for (uint8_t posn = 0; posn < len; ++posn)
-            Abytes[posn] ^= d[posn];
+        xorLanes(&(state.A[0][0]), state.inputSize, d, len);
         state.inputSize += len;
         size -= len;
         d += len;
@@ -173,7 +473,12 @@ void KeccakCore::pad(uint8_t tag)
     // to 0x02 for byte-aligned data, not 0x40.
     uint8_t size = state.inputSize;
     uint64_t *Awords = &(state.A[0][0]);
+#if CRYPTO_KECCAK_INTERLEAVED
+    Awords[size / 8] ^= toInterleaved(((uint64_t)tag) << ((size % 8) * 8));
+#else
     Awords[size / 8] ^= (((uint64_t)tag) << ((size % 8) * 8));
+#endif
+    // Bit 63 is odd and interleaves to the same position.
     Awords[(_blockSize - 1) / 8] ^= 0x8000000000000000ULL;
     keccakp();
     state.inputSize = 0;
@@ -212,7 +517,7 @@ void KeccakCore::extract(void *data, size_t size)
             tempSize = size;
 
         // Copy the partial output data into the caller's return buffer.
-        memcpy(d, ((uint8_t *)(state.A)) + state.outputSize, tempSize);
+        readLanes(&(state.A[0][0]), state.outputSize, d, 0, tempSize);
         state.outputSize += tempSize;
         size -= tempSize;
         d += tempSize;
@@ -259,9 +564,7 @@ void KeccakCore::encrypt(void *output, const void *input, size_t size)
             tempSize = size;
 
         // XOR the partial output data into the caller's return buffer.
-        const uint8_t *d = ((const uint8_t *)(state.A)) + state.outputSize;
-        for (uint8_t index = 0; index < tempSize; ++index)
-            out[index] = in[index] ^ d[index];
+        readLanes(&(state.A[0][0]), state.outputSize, out, in, tempSize);
         state.outputSize += tempSize;
         size -= tempSize;
         out += tempSize;
@@ -307,6 +610,10 @@ void KeccakCore::setHMACKey(const void *key, size_t len, uint8_t pad, size_t has
         // bytes and XOR with the padding.
         update(key, len);
         this->pad(0x06);
+#if CRYPTO_KECCAK_INTERLEAVED
+        for (uint8_t posn = 0; posn < 25; ++posn)
+            (&(state.A[0][0]))[posn] = fromInterleaved((&(state.A[0][0]))[posn]);
+#endif
         memset(Abytes + hashSize, pad, size - hashSize);
         memset(Abytes + size, 0, sizeof(state.A) - size);
         size = hashSize;
@@ -315,16 +622,324 @@ void KeccakCore::setHMACKey(const void *key, size_t len, uint8_t pad, size_t has
         *Abytes++ ^= pad;
         --size;
     }
+#if CRYPTO_KECCAK_INTERLEAVED
+    for (uint8_t posn = 0; posn < 25; ++posn)
+        (&(state.A[0][0]))[posn] = toInterleaved((&(state.A[0][0]))[posn]);
+#endif
     keccakp();
 }
 
+/**
+ * \brief Writes the sponge state to a blob.
+ *
+ * \param blob Points to SNAPSHOT_SIZE bytes to receive the state: the
+ * input and output positions within the current block followed by the
+ * 25 lanes of the state in little-endian order.
+ *
+ * This function is intended to help classes implement snapshot().
+ * The capacity is not part of the blob; the caller is responsible for
+ * recording which algorithm the state belongs to.
+ *
+ * \sa restore()
+ */
+void KeccakCore::snapshot(uint8_t *blob) const
+{
+    const uint64_t *Awords = &(state.A[0][0]);
+    blob[0] = state.inputSize;
+    blob[1] = state.outputSize;
+    blob += 2;
+    for (uint8_t posn = 0; posn < 25; ++posn, blob += 8) {
+#if CRYPTO_KECCAK_INTERLEAVED
+        storeLE64(blob, fromInterleaved(Awords[posn]));
+#else
+        storeLE64(blob, Awords[posn]);
+#endif
+    }
+}
+
+/**
+ * \brief Restores the sponge state from a blob written by snapshot().
+ *
+ * \param blob Points to SNAPSHOT_SIZE bytes of saved state.
+ *
+ * \return Returns false if the saved positions do not fit the current
+ * block size, leaving the state unchanged.
+ *
+ * \sa snapshot()
+ */
+bool KeccakCore::restore(const uint8_t *blob)
+{
+    if (blob[0] >= _blockSize || blob[1] > _blockSize)
+        return false;
+    uint64_t *Awords = &(state.A[0][0]);
+    state.inputSize = blob[0];
+    state.outputSize = blob[1];
+    blob += 2;
+    for (uint8_t posn = 0; posn < 25; ++posn, blob += 8) {
+#if CRYPTO_KECCAK_INTERLEAVED
+        Awords[posn] = toInterleaved(loadLE64(blob));
+#else
+        Awords[posn] = loadLE64(blob);
+#endif
+    }
+    return true;
+}
+
+// The multi-buffer lanes work on plain 64-bit lanes, so they are not used
+// with the interleaved state.
+#if CRYPTO_KECCAK_MB && !CRYPTO_KECCAK_INTERLEAVED
+#define KECCAK_BATCH 1
+#else
+#define KECCAK_BATCH 0
+#endif
+
+#if KECCAK_BATCH
+
+// Number of states that the batch functions hand to the multi-buffer
+// engine at a time.  More than the lane count keeps the lanes busy when
+// the messages differ in length.
+#define KECCAK_BATCH_JOBS 32
+
+// Determine if a batch is worth running through the multi-buffer lanes.
+static bool useLanes(KeccakCore *const cores[], size_t count)
+{
+    if (count < 2 || keccakMultiBufferLanes() < 2)
+        return false;
+    for (size_t posn = 0; posn < count; ++posn) {
+        if (cores[posn]->blockSize() % 8)
+            return false;
+    }
+    return true;
+}
+
+#endif
+
+/**
+ * \brief Updates several independent sponge functions at once.
+ *
+ * \param cores Points to \a count distinct KeccakCore objects.
+ * \param data Points to the input data for each object.
+ * \param size Points to the size of the input data for each object.
+ * \param count Number of objects.
+ *
+ * The result is the same as calling update() on each object.  On 64-bit
+ * hosts with SIMD support the whole blocks of the inputs are absorbed
+ * side by side, 8 states at a time with AVX-512, 4 with AVX2 and 2 with
+ * SSE2 or NEON.
+ *
+ * \sa padBatch(), extractBatch()
+ */
+void KeccakCore::updateBatch(KeccakCore *const cores[], const void *const data[],
+                             const size_t size[], size_t count)
+{
+#if KECCAK_BATCH
+    if (useLanes(cores, count)) {
+        KeccakMultiBufferJob jobs[KECCAK_BATCH_JOBS];
+        const uint8_t *d[KECCAK_BATCH_JOBS];
+        size_t len[KECCAK_BATCH_JOBS];
+        while (count > 0) {
+            size_t n = (count < KECCAK_BATCH_JOBS) ? count : KECCAK_BATCH_JOBS;
+            size_t posn;
+            bool filled = false;
+
+            // Top up partially filled blocks, as in update().  The ones
+            // that fill up are permuted together before the whole blocks.
+            for (posn = 0; posn < n; ++posn) {
+                KeccakCore *core = cores[posn];
+                KeccakMultiBufferJob *job = &jobs[posn];
+                d[posn] = (const uint8_t *)(data[posn]);
+                len[posn] = size[posn];
+                core->state.outputSize = 0;
+                job->A = &(core->state.A[0][0]);
+                job->input = 0;
+                job->output = 0;
+                job->blocks = 0;
+                job->rate = core->_blockSize;
+                if (core->state.inputSize && len[posn]) {
+                    uint8_t fill = core->_blockSize - core->state.inputSize;
+                    if (fill > len[posn])
+                        fill = len[posn];
+                    xorLanes(&(core->state.A[0][0]), core->state.inputSize,
+                             d[posn], fill);
+                    core->state.inputSize += fill;
+                    d[posn] += fill;
+                    len[posn] -= fill;
+                    if (core->state.inputSize == core->_blockSize) {
+                        core->state.inputSize = 0;
+                        job->blocks = 1;
+                        filled = true;
+                    }
+                }
+            }
+            if (filled)
+                keccakMultiBufferPermute(jobs, n);
+
+            // Absorb the whole blocks.
+            for (posn = 0; posn < n; ++posn) {
+                jobs[posn].input = d[posn];
+                jobs[posn].blocks = len[posn] / jobs[posn].rate;
+            }
+            keccakMultiBufferPermute(jobs, n);
+
+            // XOR in what is left, which starts a new block.
+            for (posn = 0; posn < n; ++posn) {
+                size_t done = jobs[posn].blocks * jobs[posn].rate;
+                if (len[posn] > done) {
+                    KeccakCore *core = cores[posn];
+                    uint8_t tailLen = len[posn] - done;
+                    xorLanes(&(core->state.A[0][0]), 0, d[posn] + done, tailLen);
+                    core->state.inputSize = tailLen;
+                }
+            }
+            cores += n;
+            data += n;
+            size += n;
+            count -= n;
+        }
+        return;
+    }
+#endif
+    for (size_t posn = 0; posn < count; ++posn)
+        cores[posn]->update(data[posn], size[posn]);
+}
+
+/**
+ * \brief Pads the last block of input data for several independent
+ * sponge functions at once.
+ *
+ * \param cores Points to \a count distinct KeccakCore objects.
+ * \param tag The tag byte to add to the padding; see pad().
+ * \param count Number of objects.
+ *
+ * \sa updateBatch(), extractBatch()
+ */
+void KeccakCore::padBatch(KeccakCore *const cores[], uint8_t tag, size_t count)
+{
+#if KECCAK_BATCH
+    if (useLanes(cores, count)) {
+        KeccakMultiBufferJob jobs[KECCAK_BATCH_JOBS];
+        while (count > 0) {
+            size_t n = (count < KECCAK_BATCH_JOBS) ? count : KECCAK_BATCH_JOBS;
+            for (size_t posn = 0; posn < n; ++posn) {
+                KeccakCore *core = cores[posn];
+                KeccakMultiBufferJob *job = &jobs[posn];
+                uint8_t size = core->state.inputSize;
+                uint64_t *Awords = &(core->state.A[0][0]);
+                Awords[size / 8] ^= (((uint64_t)tag) << ((size % 8) * 8));
+                Awords[(core->_blockSize - 1) / 8] ^= 0x8000000000000000ULL;
+                core->state.inputSize = 0;
+                core->state.outputSize = 0;
+                job->A = Awords;
+                job->input = 0;
+                job->output = 0;
+                job->blocks = 1;
+                job->rate = core->_blockSize;
+            }
+            keccakMultiBufferPermute(jobs, n);
+            cores += n;
+            count -= n;
+        }
+        return;
+    }
+#endif
+    for (size_t posn = 0; posn < count; ++posn)
+        cores[posn]->pad(tag);
+}
+
+/**
+ * \brief Extracts data from several independent sponge functions at once.
+ *
+ * \param cores Points to \a count distinct KeccakCore objects.
+ * \param data Points to the buffers to fill with extracted data.
+ * \param size The number of bytes to extract into each buffer.
+ * \param count Number of objects.
+ *
+ * The result is the same as calling extract() on each object.  When more
+ * than blockSize() bytes are required, the extra output blocks are
+ * squeezed side by side on hosts with SIMD support.
+ *
+ * \sa updateBatch(), padBatch()
+ */
+void KeccakCore::extractBatch(KeccakCore *const cores[], void *const data[],
+                              size_t size, size_t count)
+{
+#if KECCAK_BATCH
+    if (useLanes(cores, count)) {
+        KeccakMultiBufferJob jobs[KECCAK_BATCH_JOBS];
+        uint8_t *tail[KECCAK_BATCH_JOBS];
+        uint8_t tailLen[KECCAK_BATCH_JOBS];
+        while (count > 0) {
+            size_t n = (count < KECCAK_BATCH_JOBS) ? count : KECCAK_BATCH_JOBS;
+            size_t posn;
+            bool tails = false;
+
+            // Copy out what is left of the current block, as in extract(),
+            // then squeeze whole blocks straight into the caller's buffers.
+            for (posn = 0; posn < n; ++posn) {
+                KeccakCore *core = cores[posn];
+                KeccakMultiBufferJob *job = &jobs[posn];
+                uint8_t *d = (uint8_t *)(data[posn]);
+                size_t len = size;
+                size_t avail = 0;
+                core->state.inputSize = 0;
+                if (core->state.outputSize < core->_blockSize)
+                    avail = core->_blockSize - core->state.outputSize;
+                if (avail > len)
+                    avail = len;
+                memcpy(d, ((uint8_t *)(core->state.A)) + core->state.outputSize, avail);
+                core->state.outputSize += avail;
+                len -= avail;
+                job->A = &(core->state.A[0][0]);
+                job->input = 0;
+                job->output = d + avail;
+                job->blocks = len / core->_blockSize;
+                job->rate = core->_blockSize;
+                tail[posn] = job->output + job->blocks * job->rate;
+                tailLen[posn] = len % core->_blockSize;
+                if (job->blocks)
+                    core->state.outputSize = core->_blockSize;
+                if (tailLen[posn])
+                    tails = true;
+            }
+            keccakMultiBufferPermute(jobs, n);
+
+            // Generate one more block for the buffers that end part way
+            // through it.
+            if (tails) {
+                for (posn = 0; posn < n; ++posn) {
+                    jobs[posn].output = 0;
+                    jobs[posn].blocks = tailLen[posn] ? 1 : 0;
+                }
+                keccakMultiBufferPermute(jobs, n);
+                for (posn = 0; posn < n; ++posn) {
+                    if (tailLen[posn]) {
+                        memcpy(tail[posn], cores[posn]->state.A, tailLen[posn]);
+                        cores[posn]->state.outputSize = tailLen[posn];
+                    }
+                }
+            }
+            cores += n;
+            data += n;
+            count -= n;
+        }
+        return;
+    }
+#endif
+    for (size_t posn = 0; posn < count; ++posn)
+        cores[posn]->extract(data[posn], size);
+}
+
+
 /**
  * \brief Transform the state with the KECCAK-p sponge function with b = 1600.
  */
 void KeccakCore::keccakp()
 {
+#if CRYPTO_KECCAK_INTERLEAVED
+    keccakpInterleaved(state.A);
+#else
     uint64_t B[5][5];
-#if defined(__AVR__)
+#if CRYPTO_KECCAK_AVR_ASM
     // This assembly code was generated by the "genkeccak.c" program.
     // Do not modify this code directly.  Instead modify "genkeccak.c"
     // and then re-generate the code here.
@@ -2010,4 +2625,5 @@ void KeccakCore::keccakp()
         };
         state.A[0][0] ^= pgm_read_qword(RC + round);
     }
+#endif
 }
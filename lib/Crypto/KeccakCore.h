@@ -49,6 +49,17 @@ public:
 
     void setHMACKey(const void *key, size_t len, uint8_t pad, size_t hashSize);
 
+    void snapshot(uint8_t *blob) const;
+    bool restore(const uint8_t *blob);
+
+    static const size_t SNAPSHOT_SIZE = 202;
+
+    static void updateBatch(KeccakCore *const cores[], const void *const data[],
+                            const size_t size[], size_t count);
+    static void padBatch(KeccakCore *const cores[], uint8_t tag, size_t count);
+    static void extractBatch(KeccakCore *const cores[], void *const data[],
+                             size_t size, size_t count);
+
 private:
     struct {
         uint64_t A[5][5];
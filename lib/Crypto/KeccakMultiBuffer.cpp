@@ -0,0 +1,274 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "utility/KeccakMultiBufferUtil.h"
+#include "Crypto.h"
+#include <string.h>
+
+// Multi-buffer Keccak-p[1600] for host builds.  See
+// utility/KeccakMultiBufferUtil.h for when this is compiled in.
+
+#if CRYPTO_KECCAK_MB
+
+// Round constants for Keccak-p[1600].
+static const uint64_t keccakMultiBufferRC[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL,
+    0x8000000080008000ULL, 0x000000000000808BULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008AULL,
+    0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL,
+    0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800AULL, 0x800000008000000AULL, 0x8000000080008081ULL,
+    0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+typedef uint64_t keccakx2 __attribute__((vector_size(16)));
+#if defined(__x86_64__)
+typedef uint64_t keccakx4 __attribute__((vector_size(32)));
+typedef uint64_t keccakx8 __attribute__((vector_size(64)));
+#endif
+
+#define MB_INLINE inline __attribute__((always_inline))
+#define MB_ROTL(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+// Wipes the lanes after a run.  clean() stores a byte at a time through a
+// volatile pointer, which for 1.6K of AVX-512 lanes costs about as much as
+// the permutation itself.  The barrier tells the compiler that the zeroes
+// are used, so the memset() is not removed as a dead store.
+static MB_INLINE void cleanLanes(void *S, size_t size)
+{
+    memset(S, 0, size);
+    __asm__ __volatile__("" : : "r"(S) : "memory");
+}
+
+// Permutes the L states in S.  The lanes are transposed, lane-major, so
+// lane i of every state loads as one vector.  Lane i is A[y][x] in
+// KeccakCore with i = 5 * y + x.
+template <typename V, int L>
+static MB_INLINE void keccakLanes(uint64_t (*S)[L])
+{
+    V A[25], B[25], C[5], D;
+    int i, x;
+
+    for (i = 0; i < 25; ++i)
+        memcpy(&A[i], S[i], sizeof(V));
+
+    for (int round = 0; round < 24; ++round) {
+        // Step mapping theta.
+#pragma GCC unroll 5
+        for (x = 0; x < 5; ++x)
+            C[x] = A[x] ^ A[x + 5] ^ A[x + 10] ^ A[x + 15] ^ A[x + 20];
+#pragma GCC unroll 5
+        for (x = 0; x < 5; ++x) {
+            D = C[(x + 4) % 5] ^ MB_ROTL(C[(x + 1) % 5], 1);
+            A[x] ^= D;
+            A[x + 5] ^= D;
+            A[x + 10] ^= D;
+            A[x + 15] ^= D;
+            A[x + 20] ^= D;
+        }
+
+        // Step mapping rho and pi combined into a single step.
+        B[0]  = A[0];
+        B[5]  = MB_ROTL(A[3], 28);
+        B[10] = MB_ROTL(A[1], 1);
+        B[15] = MB_ROTL(A[4], 27);
+        B[20] = MB_ROTL(A[2], 62);
+        B[1]  = MB_ROTL(A[6], 44);
+        B[6]  = MB_ROTL(A[9], 20);
+        B[11] = MB_ROTL(A[7], 6);
+        B[16] = MB_ROTL(A[5], 36);
+        B[21] = MB_ROTL(A[8], 55);
+        B[2]  = MB_ROTL(A[12], 43);
+        B[7]  = MB_ROTL(A[10], 3);
+        B[12] = MB_ROTL(A[13], 25);
+        B[17] = MB_ROTL(A[11], 10);
+        B[22] = MB_ROTL(A[14], 39);
+        B[3]  = MB_ROTL(A[18], 21);
+        B[8]  = MB_ROTL(A[16], 45);
+        B[13] = MB_ROTL(A[19], 8);
+        B[18] = MB_ROTL(A[17], 15);
+        B[23] = MB_ROTL(A[15], 41);
+        B[4]  = MB_ROTL(A[24], 14);
+        B[9]  = MB_ROTL(A[22], 61);
+        B[14] = MB_ROTL(A[20], 18);
+        B[19] = MB_ROTL(A[23], 56);
+        B[24] = MB_ROTL(A[21], 2);
+
+        // Step mapping chi.
+#pragma GCC unroll 25
+        for (i = 0; i < 25; i += 5) {
+#pragma GCC unroll 5
+            for (x = 0; x < 5; ++x) {
+                A[i + x] = B[i + x] ^
+                    (~B[i + (x + 1) % 5] & B[i + (x + 2) % 5]);
+            }
+        }
+
+        // Step mapping iota.
+        A[0] ^= keccakMultiBufferRC[round];
+    }
+
+    for (i = 0; i < 25; ++i)
+        memcpy(S[i], &A[i], sizeof(V));
+}
+
+// Feeds the job queue through L lanes.  A lane whose job finishes takes
+// the next one from the queue straight away, so jobs of different lengths
+// keep the lanes busy until the queue runs dry.  Idle lanes permute
+// whatever their last job left behind.
+template <typename V, int L>
+static MB_INLINE void keccakRunLanes(KeccakMultiBufferJob *jobs, size_t count)
+{
+    uint64_t S[25][L] __attribute__((aligned(sizeof(V))));
+    KeccakMultiBufferJob *current[L];
+    size_t posn[L];
+    size_t next = 0;
+    int active = 0;
+    int lane, i;
+
+    memset(S, 0, sizeof(S));
+    for (lane = 0; lane < L; ++lane)
+        current[lane] = 0;
+    for (;;) {
+        for (lane = 0; lane < L; ++lane) {
+            while (!current[lane] && next < count) {
+                KeccakMultiBufferJob *job = &jobs[next++];
+                if (!job->blocks)
+                    continue;
+                current[lane] = job;
+                posn[lane] = 0;
+                for (i = 0; i < 25; ++i)
+                    S[i][lane] = job->A[i];
+                ++active;
+            }
+        }
+        if (!active)
+            break;
+
+        for (lane = 0; lane < L; ++lane) {
+            KeccakMultiBufferJob *job = current[lane];
+            if (job && job->input) {
+                const uint8_t *p = job->input + posn[lane] * job->rate;
+                for (i = 0; i < (int)(job->rate / 8); ++i, p += 8) {
+                    uint64_t word;
+                    memcpy(&word, p, 8);
+                    S[i][lane] ^= word;
+                }
+            }
+        }
+        keccakLanes<V, L>(S);
+
+        for (lane = 0; lane < L; ++lane) {
+            KeccakMultiBufferJob *job = current[lane];
+            if (!job)
+                continue;
+            if (job->output) {
+                uint8_t *p = job->output + posn[lane] * job->rate;
+                for (i = 0; i < (int)(job->rate / 8); ++i, p += 8)
+                    memcpy(p, &(S[i][lane]), 8);
+            }
+            if (++posn[lane] == job->blocks) {
+                for (i = 0; i < 25; ++i)
+                    job->A[i] = S[i][lane];
+                current[lane] = 0;
+                --active;
+            }
+        }
+    }
+    cleanLanes(S, sizeof(S));
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx512f")))
+static void keccakRunLanesAVX512(KeccakMultiBufferJob *jobs, size_t count)
+{
+    keccakRunLanes<keccakx8, 8>(jobs, count);
+}
+
+__attribute__((target("avx2")))
+static void keccakRunLanesAVX2(KeccakMultiBufferJob *jobs, size_t count)
+{
+    keccakRunLanes<keccakx4, 4>(jobs, count);
+}
+
+static bool detectAVX512()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f");
+}
+
+static bool detectAVX2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+static bool haveAVX512()
+{
+    static const bool available = detectAVX512();
+    return available;
+}
+
+static bool haveAVX2()
+{
+    static const bool available = detectAVX2();
+    return available;
+}
+
+#endif
+
+size_t keccakMultiBufferLanes()
+{
+#if defined(__x86_64__)
+    if (haveAVX512())
+        return 8;
+    if (haveAVX2())
+        return 4;
+#endif
+    return 2;
+}
+
+void keccakMultiBufferPermute(KeccakMultiBufferJob *jobs, size_t count)
+{
+    // Skip setting up and cleaning the lanes when there is nothing to do.
+    size_t posn;
+    for (posn = 0; posn < count && !jobs[posn].blocks; ++posn)
+        ;
+    if (posn >= count)
+        return;
+    jobs += posn;
+    count -= posn;
+#if defined(__x86_64__)
+    if (haveAVX512()) {
+        keccakRunLanesAVX512(jobs, count);
+        return;
+    }
+    if (haveAVX2()) {
+        keccakRunLanesAVX2(jobs, count);
+        return;
+    }
+#endif
+    keccakRunLanes<keccakx2, 2>(jobs, count);
+}
+
+#endif // CRYPTO_KECCAK_MB
@@ -263,7 +263,9 @@ bool P521::dh2(const uint8_t k[132], uint8_t f[66])
  * This function generates deterministic ECDSA signatures according to
  * RFC 6979.  The \a hash function is used to generate the k value for
  * the signature.  If \a hash is NULL, then SHA512 is used.
- * The \a hash object must be capable of HMAC mode.
+ * The \a hash object must be capable of HMAC mode.  It is chosen at
+ * run time, so it is called through the virtual Hash interface; the hash
+ * is a small part of the cost of a signature next to the curve arithmetic.
  *
  * The length of the hashed message must be less than or equal to 64
  * bytes in size.  Longer messages will be truncated to 64 bytes.
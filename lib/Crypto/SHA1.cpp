@@ -24,6 +24,7 @@
 #include "Crypto.h"
 #include "utility/RotateUtil.h"
 #include "utility/EndianUtil.h"
+#include "utility/SHAHardwareUtil.h"
 #include <string.h>
 
 /**
@@ -87,9 +88,9 @@ void SHA1::update(const void *data, size_t len)
     // Update the total length (in bits, not bytes).
     state.length += ((uint64_t)len) << 3;
 
-    // Break the input up into 512-bit chunks and process each in turn.
+    // Top up a partially filled chunk first.
     const uint8_t *d = (const uint8_t *)data;
-    while (len > 0) {
+    if (state.chunkSize) {
         uint8_t size = 64 - state.chunkSize;
         if (size > len)
             size = len;
@@ -102,6 +103,20 @@ void SHA1::update(const void *data, size_t len)
             state.chunkSize = 0;
         }
     }
+
+    // Compress whole chunks straight from the caller's buffer.
+    if (len >= 64) {
+        size_t blocks = len / 64;
+        processBlocks(d, blocks);
+        d += blocks * 64;
+        len -= blocks * 64;
+    }
+
+    // Buffer the remainder until the next update() or finalize().
+    if (len > 0) {
+        memcpy(state.w, d, len);
+        state.chunkSize = len;
+    }
 }
 
 void SHA1::finalize(void *hash, size_t len)
@@ -151,101 +166,226 @@ void SHA1::resetHMAC(const void *key, size_t keyLen)
 void SHA1::finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen)
 {
     uint8_t temp[20];
-    finalize(temp, sizeof(temp));
+    SHA1::finalize(temp, sizeof(temp));
     formatHMACKey(state.w, key, keyLen, 0x5C);
     state.length += 64 * 8;
     processChunk();
-    update(temp, sizeof(temp));
-    finalize(hash, hashLen);
+    SHA1::update(temp, sizeof(temp));
+    SHA1::finalize(hash, hashLen);
     clean(temp);
 }
 
 /**
- * \brief Processes a single 512-bit chunk with the core SHA-1 algorithm.
+ * \brief Size of the snapshot blob, always SNAPSHOT_SIZE.
+ */
+size_t SHA1::snapshotSize() const
+{
+    return SNAPSHOT_SIZE;
+}
+
+/**
+ * \brief Writes the current state of the hashing process to a blob.
  *
- * Reference: http://en.wikipedia.org/wiki/SHA-1
+ * \param blob Points to SNAPSHOT_SIZE bytes to receive the snapshot.
+ *
+ * \sa restore(), snapshotSize()
+ */
+void SHA1::snapshot(void *blob) const
+{
+    uint8_t *b = (uint8_t *)blob;
+    b[0] = SnapshotSHA1;
+    b[1] = SnapshotVersion;
+    b[2] = state.chunkSize;
+    b[3] = 0;
+    b += SnapshotHeaderSize;
+    for (uint8_t posn = 0; posn < 5; ++posn, b += 4)
+        storeLE32(b, state.h[posn]);
+    storeLE64(b, state.length);
+    b += 8;
+    memcpy(b, state.w, state.chunkSize);
+    memset(b + state.chunkSize, 0, 64 - state.chunkSize);
+}
+
+/**
+ * \brief Restores the state of a hashing process from a snapshot blob.
+ *
+ * \param blob Points to the blob that was written by snapshot().
+ * \param len Length of the \a blob, which must be SNAPSHOT_SIZE.
+ *
+ * \return Returns false if the blob is not a valid SHA-1 snapshot.
+ *
+ * \sa snapshot()
+ */
+bool SHA1::restore(const void *blob, size_t len)
+{
+    const uint8_t *b = (const uint8_t *)blob;
+    if (len != SNAPSHOT_SIZE || b[0] != SnapshotSHA1 ||
+            b[1] != SnapshotVersion || b[2] >= 64 || b[3] != 0)
+        return false;
+    state.chunkSize = b[2];
+    b += SnapshotHeaderSize;
+    for (uint8_t posn = 0; posn < 5; ++posn, b += 4)
+        state.h[posn] = loadLE32(b);
+    state.length = loadLE64(b);
+    b += 8;
+    memcpy(state.w, b, 64);
+    return true;
+}
+
+/**
+ * \brief Gets the chaining state of the hashing process.
+ *
+ * \param h Returns the five chaining words.
+ *
+ * This only describes the whole state at a block boundary, for example
+ * right after resetHMAC().  It is the compact alternative to snapshot()
+ * for keeping HMAC midstates on small devices: 20 bytes each instead of
+ * a whole SHA1 object.
+ *
+ * \sa setMidstate()
+ */
+void SHA1::getMidstate(uint32_t h[5]) const
+{
+    memcpy(h, state.h, sizeof(state.h));
+}
+
+/**
+ * \brief Resumes a hashing process from a chaining state.
+ *
+ * \param h The five chaining words from getMidstate().
+ * \param blocks The number of 64-byte blocks that were hashed to reach
+ * \a h, which is 1 for a HMAC midstate.
+ *
+ * \sa getMidstate()
+ */
+void SHA1::setMidstate(const uint32_t h[5], uint64_t blocks)
+{
+    memcpy(state.h, h, sizeof(state.h));
+    state.length = blocks * 512;
+    state.chunkSize = 0;
+}
+
+/**
+ * \brief Processes the 512-bit chunk in state.w.
  */
 void SHA1::processChunk()
 {
-    uint8_t index;
+    processBlocks((const uint8_t *)state.w, 1);
+}
 
-    // Convert the first 16 words from big endian to host byte order.
-    for (index = 0; index < 16; ++index)
-        state.w[index] = be32toh(state.w[index]);
-
-    // Initialize the hash value for this chunk.
-    uint32_t a = state.h[0];
-    uint32_t b = state.h[1];
-    uint32_t c = state.h[2];
-    uint32_t d = state.h[3];
-    uint32_t e = state.h[4];
-
-    // Perform the first 16 rounds of the compression function main loop.
-    uint32_t temp;
-    for (index = 0; index < 16; ++index) {
-        temp = leftRotate5(a) + ((b & c) | ((~b) & d)) + e + 0x5A827999 + state.w[index];
-        e = d;
-        d = c;
-        c = leftRotate30(b);
-        b = a;
-        a = temp;
+/**
+ * \brief Processes a run of 512-bit chunks with the core SHA-1 algorithm.
+ *
+ * \param data Points to the chunks in big-endian byte order, with any
+ * alignment.  This may be state.w itself.
+ * \param blocks Number of chunks to process.
+ *
+ * Uses the CPU's SHA instructions instead when they are available.
+ *
+ * The chaining value stays in local variables across the whole run and
+ * state.w is used as the message schedule workspace, so whole chunks from
+ * update() are never copied into state.w first.
+ *
+ * Reference: http://en.wikipedia.org/wiki/SHA-1
+ */
+void SHA1::processBlocks(const uint8_t *data, size_t blocks)
+{
+#if CRYPTO_SHA_HW
+    if (sha1HardwareAvailable()) {
+        sha1HardwareCompress(state.h, data, blocks);
+        return;
     }
+#endif
 
-    // Perform the 64 remaining rounds.  We expand the first 16 words to
-    // 80 in-place in the "w" array.  This saves 256 bytes of memory
-    // that would have otherwise need to be allocated to the "w" array.
-    for (; index < 20; ++index) {
-        temp = state.w[index & 0x0F] = leftRotate1
-            (state.w[(index - 3) & 0x0F] ^ state.w[(index - 8) & 0x0F] ^
-             state.w[(index - 14) & 0x0F] ^ state.w[(index - 16) & 0x0F]);
-        temp = leftRotate5(a) + ((b & c) | ((~b) & d)) + e + 0x5A827999 + temp;
-        e = d;
-        d = c;
-        c = leftRotate30(b);
-        b = a;
-        a = temp;
-    }
-    for (; index < 40; ++index) {
-        temp = state.w[index & 0x0F] = leftRotate1
-            (state.w[(index - 3) & 0x0F] ^ state.w[(index - 8) & 0x0F] ^
-             state.w[(index - 14) & 0x0F] ^ state.w[(index - 16) & 0x0F]);
-        temp = leftRotate5(a) + (b ^ c ^ d) + e + 0x6ED9EBA1 + temp;
-        e = d;
-        d = c;
-        c = leftRotate30(b);
-        b = a;
-        a = temp;
-    }
-    for (; index < 60; ++index) {
-        temp = state.w[index & 0x0F] = leftRotate1
-            (state.w[(index - 3) & 0x0F] ^ state.w[(index - 8) & 0x0F] ^
-             state.w[(index - 14) & 0x0F] ^ state.w[(index - 16) & 0x0F]);
-        temp = leftRotate5(a) + ((b & c) | (b & d) | (c & d)) + e + 0x8F1BBCDC + temp;
-        e = d;
-        d = c;
-        c = leftRotate30(b);
-        b = a;
-        a = temp;
-    }
-    for (; index < 80; ++index) {
-        temp = state.w[index & 0x0F] = leftRotate1
-            (state.w[(index - 3) & 0x0F] ^ state.w[(index - 8) & 0x0F] ^
-             state.w[(index - 14) & 0x0F] ^ state.w[(index - 16) & 0x0F]);
-        temp = leftRotate5(a) + (b ^ c ^ d) + e + 0xCA62C1D6 + temp;
-        e = d;
-        d = c;
-        c = leftRotate30(b);
-        b = a;
-        a = temp;
-    }
+    uint8_t index;
+    uint32_t hv[5];
+    for (index = 0; index < 5; ++index)
+        hv[index] = state.h[index];
+
+    while (blocks-- > 0) {
+        // Load the next 16 words in host byte order.  When called from
+        // processChunk() this converts state.w in place.
+        for (index = 0; index < 16; ++index, data += 4)
+            state.w[index] = loadBE32(data);
+
+        // Initialize the hash value for this chunk.
+        uint32_t a = hv[0];
+        uint32_t b = hv[1];
+        uint32_t c = hv[2];
+        uint32_t d = hv[3];
+        uint32_t e = hv[4];
+
+        // Perform the first 16 rounds of the compression function main loop.
+        uint32_t temp;
+        for (index = 0; index < 16; ++index) {
+            temp = leftRotate5(a) + ((b & c) | ((~b) & d)) + e + 0x5A827999 + state.w[index];
+            e = d;
+            d = c;
+            c = leftRotate30(b);
+            b = a;
+            a = temp;
+        }
+
+        // Perform the 64 remaining rounds.  We expand the first 16 words to
+        // 80 in-place in the "w" array.  This saves 256 bytes of memory
+        // that would have otherwise need to be allocated to the "w" array.
+        for (; index < 20; ++index) {
+            temp = state.w[index & 0x0F] = leftRotate1
+                (state.w[(index - 3) & 0x0F] ^ state.w[(index - 8) & 0x0F] ^
+                 state.w[(index - 14) & 0x0F] ^ state.w[(index - 16) & 0x0F]);
+            temp = leftRotate5(a) + ((b & c) | ((~b) & d)) + e + 0x5A827999 + temp;
+            e = d;
+            d = c;
+            c = leftRotate30(b);
+            b = a;
+            a = temp;
+        }
+        for (; index < 40; ++index) {
+            temp = state.w[index & 0x0F] = leftRotate1
+                (state.w[(index - 3) & 0x0F] ^ state.w[(index - 8) & 0x0F] ^
+                 state.w[(index - 14) & 0x0F] ^ state.w[(index - 16) & 0x0F]);
+            temp = leftRotate5(a) + (b ^ c ^ d) + e + 0x6ED9EBA1 + temp;
+            e = d;
+            d = c;
+            c = leftRotate30(b);
+            b = a;
+            a = temp;
+        }
+        for (; index < 60; ++index) {
+            temp = state.w[index & 0x0F] = leftRotate1
+                (state.w[(index - 3) & 0x0F] ^ state.w[(index - 8) & 0x0F] ^
+                 state.w[(index - 14) & 0x0F] ^ state.w[(index - 16) & 0x0F]);
+            temp = leftRotate5(a) + ((b & c) | (b & d) | (c & d)) + e + 0x8F1BBCDC + temp;
+            e = d;
+            d = c;
+            c = leftRotate30(b);
+            b = a;
+            a = temp;
+        }
+        for (; index < 80; ++index) {
+            temp = state.w[index & 0x0F] = leftRotate1
+                (state.w[(index - 3) & 0x0F] ^ state.w[(index - 8) & 0x0F] ^
+                 state.w[(index - 14) & 0x0F] ^ state.w[(index - 16) & 0x0F]);
+            temp = leftRotate5(a) + (b ^ c ^ d) + e + 0xCA62C1D6 + temp;
+            e = d;
+            d = c;
+            c = leftRotate30(b);
+            b = a;
+            a = temp;
+        }
 
-    // Add this chunk's hash to the result so far.
-    state.h[0] += a;
-    state.h[1] += b;
-    state.h[2] += c;
-    state.h[3] += d;
-    state.h[4] += e;
+        // Add this chunk's hash to the result so far.
+        hv[0] += a;
+        hv[1] += b;
+        hv[2] += c;
+        hv[3] += d;
+        hv[4] += e;
+
+        // Attempt to clean up the stack.
+        a = b = c = d = e = temp = 0;
+    }
 
-    // Attempt to clean up the stack.
-    a = b = c = d = e = temp = 0;
+    for (index = 0; index < 5; ++index)
+        state.h[index] = hv[index];
+    clean(hv);
 }
@@ -43,8 +43,16 @@ public:
     void resetHMAC(const void *key, size_t keyLen);
     void finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen);
 
+    size_t snapshotSize() const;
+    void snapshot(void *blob) const;
+    bool restore(const void *blob, size_t len);
+
+    void getMidstate(uint32_t h[5]) const;
+    void setMidstate(const uint32_t h[5], uint64_t blocks);
+
     static const size_t HASH_SIZE  = 20;
     static const size_t BLOCK_SIZE = 64;
+    static const size_t SNAPSHOT_SIZE = 96;
 
 private:
     struct {
@@ -55,6 +63,7 @@ private:
     } state;
 
     void processChunk();
+    void processBlocks(const uint8_t *data, size_t blocks);
 };
 
 #endif
@@ -24,6 +24,8 @@
 #include "Crypto.h"
 #include "utility/RotateUtil.h"
 #include "utility/EndianUtil.h"
+#include "utility/SHAHardwareUtil.h"
+#include "utility/SHAMultiBufferUtil.h"
 #include "utility/ProgMemUtil.h"
 #include <string.h>
 
@@ -92,9 +94,9 @@ void SHA256::update(const void *data, size_t len)
     // Update the total length (in bits, not bytes).
     state.length += ((uint64_t)len) << 3;
 
-    // Break the input up into 512-bit chunks and process each in turn.
+    // Top up a partially filled chunk first.
     const uint8_t *d = (const uint8_t *)data;
-    while (len > 0) {
+    if (state.chunkSize) {
         uint8_t size = 64 - state.chunkSize;
         if (size > len)
             size = len;
@@ -107,6 +109,20 @@ void SHA256::update(const void *data, size_t len)
             state.chunkSize = 0;
         }
     }
+
+    // Compress whole chunks straight from the caller's buffer.
+    if (len >= 64) {
+        size_t blocks = len / 64;
+        processBlocks(d, blocks);
+        d += blocks * 64;
+        len -= blocks * 64;
+    }
+
+    // Buffer the remainder until the next update() or finalize().
+    if (len > 0) {
+        memcpy(state.w, d, len);
+        state.chunkSize = len;
+    }
 }
 
 void SHA256::finalize(void *hash, size_t len)
@@ -157,22 +173,255 @@ void SHA256::resetHMAC(const void *key, size_t keyLen)
 void SHA256::finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen)
 {
     uint8_t temp[32];
-    finalize(temp, sizeof(temp));
+    SHA256::finalize(temp, sizeof(temp));
     formatHMACKey(state.w, key, keyLen, 0x5C);
     state.length += 64 * 8;
     processChunk();
-    update(temp, hashSize());
-    finalize(hash, hashLen);
+    SHA256::update(temp, hashSize());
+    SHA256::finalize(hash, hashLen);
     clean(temp);
 }
 
 /**
- * \brief Processes a single 512-bit chunk with the core SHA-256 algorithm.
+ * \brief Size of the snapshot blob, always SNAPSHOT_SIZE.
+ */
+size_t SHA256::snapshotSize() const
+{
+    return SNAPSHOT_SIZE;
+}
+
+/**
+ * \brief Writes the current state of the hashing process to a blob.
  *
- * Reference: http://en.wikipedia.org/wiki/SHA-2
+ * \param blob Points to SNAPSHOT_SIZE bytes to receive the snapshot.
+ *
+ * \sa restore(), snapshotSize()
+ */
+void SHA256::snapshot(void *blob) const
+{
+    uint8_t *b = (uint8_t *)blob;
+    b[0] = (hashSize() == 28) ? SnapshotSHA224 : SnapshotSHA256;
+    b[1] = SnapshotVersion;
+    b[2] = state.chunkSize;
+    b[3] = 0;
+    b += SnapshotHeaderSize;
+    for (uint8_t posn = 0; posn < 8; ++posn, b += 4)
+        storeLE32(b, state.h[posn]);
+    storeLE64(b, state.length);
+    b += 8;
+    memcpy(b, state.w, state.chunkSize);
+    memset(b + state.chunkSize, 0, 64 - state.chunkSize);
+}
+
+/**
+ * \brief Restores the state of a hashing process from a snapshot blob.
+ *
+ * \param blob Points to the blob that was written by snapshot().
+ * \param len Length of the \a blob, which must be SNAPSHOT_SIZE.
+ *
+ * \return Returns false if the blob is not a valid snapshot for this
+ * algorithm.  SHA-224 and SHA-256 snapshots are not interchangeable.
+ *
+ * \sa snapshot()
+ */
+bool SHA256::restore(const void *blob, size_t len)
+{
+    const uint8_t *b = (const uint8_t *)blob;
+    uint8_t tag = (hashSize() == 28) ? SnapshotSHA224 : SnapshotSHA256;
+    if (len != SNAPSHOT_SIZE || b[0] != tag ||
+            b[1] != SnapshotVersion || b[2] >= 64 || b[3] != 0)
+        return false;
+    state.chunkSize = b[2];
+    b += SnapshotHeaderSize;
+    for (uint8_t posn = 0; posn < 8; ++posn, b += 4)
+        state.h[posn] = loadLE32(b);
+    state.length = loadLE64(b);
+    b += 8;
+    memcpy(state.w, b, 64);
+    return true;
+}
+
+// Number of messages that updateBatch() and finalizeBatch() hand to the
+// multi-buffer engine at a time.  More than the lane count keeps the
+// lanes busy when the messages differ in length.
+#define SHA256_BATCH_JOBS 32
+
+/**
+ * \brief Updates several independent SHA-256 hashing processes at once.
+ *
+ * \param hashes Points to \a count distinct SHA256 (or SHA224) objects.
+ * \param data Points to the data for each hash object.
+ * \param len Points to the length of the data for each hash object.
+ * \param count Number of hash objects.
+ *
+ * On hosts with SIMD support the whole blocks of the messages are
+ * compressed side by side, 8 at a time with AVX2 and 4 with SSE2 or NEON.
+ * Elsewhere, and on CPUs with SHA-256 instructions (which are faster
+ * than the lanes), this is the same as calling update() on each object.
+ *
+ * \sa finalizeBatch(SHA256 *const[], void *const[], size_t, size_t)
+ */
+void updateBatch(SHA256 *const hashes[], const void *const data[],
+                 const size_t len[], size_t count)
+{
+#if CRYPTO_SHA_MB
+    if (count > 1 && sha256MultiBufferLanes() > 1) {
+        SHA256MultiBufferJob jobs[SHA256_BATCH_JOBS];
+        const uint8_t *tail[SHA256_BATCH_JOBS];
+        size_t tailLen[SHA256_BATCH_JOBS];
+        while (count > 0) {
+            size_t n = (count < SHA256_BATCH_JOBS) ? count : SHA256_BATCH_JOBS;
+            for (size_t posn = 0; posn < n; ++posn) {
+                SHA256 *hash = hashes[posn];
+                const uint8_t *d = (const uint8_t *)(data[posn]);
+                size_t size = len[posn];
+                SHA256MultiBufferJob *job = &jobs[posn];
+                hash->state.length += ((uint64_t)size) << 3;
+                job->h = hash->state.h;
+                job->first = 0;
+                job->last = 0;
+
+                // Top up a partially filled chunk, as in SHA256::update().
+                if (hash->state.chunkSize) {
+                    uint8_t fill = 64 - hash->state.chunkSize;
+                    if (fill > size)
+                        fill = size;
+                    memcpy(((uint8_t *)hash->state.w) + hash->state.chunkSize, d, fill);
+                    hash->state.chunkSize += fill;
+                    size -= fill;
+                    d += fill;
+                    if (hash->state.chunkSize == 64) {
+                        job->first = (const uint8_t *)hash->state.w;
+                        hash->state.chunkSize = 0;
+                    }
+                }
+
+                // The remainder is buffered after the compression because
+                // it overwrites state.w, which may be the first block.
+                job->data = d;
+                job->blocks = size / 64;
+                tail[posn] = d + job->blocks * 64;
+                tailLen[posn] = size % 64;
+            }
+            sha256MultiBufferCompress(jobs, n);
+            for (size_t posn = 0; posn < n; ++posn) {
+                if (tailLen[posn]) {
+                    memcpy(hashes[posn]->state.w, tail[posn], tailLen[posn]);
+                    hashes[posn]->state.chunkSize = tailLen[posn];
+                }
+            }
+            hashes += n;
+            data += n;
+            len += n;
+            count -= n;
+        }
+        return;
+    }
+#endif
+    for (size_t posn = 0; posn < count; ++posn)
+        hashes[posn]->update(data[posn], len[posn]);
+}
+
+/**
+ * \brief Finalizes several independent SHA-256 hashing processes at once.
+ *
+ * \param hashes Points to \a count distinct SHA256 (or SHA224) objects.
+ * \param hash Points to the buffers to return each hash value in.
+ * \param len The length of each \a hash buffer, normally hashSize().
+ * \param count Number of hash objects.
+ *
+ * \sa updateBatch(SHA256 *const[], const void *const[], const size_t[], size_t)
+ */
+void finalizeBatch(SHA256 *const hashes[], void *const hash[],
+                   size_t len, size_t count)
+{
+#if CRYPTO_SHA_MB
+    if (count > 1 && sha256MultiBufferLanes() > 1) {
+        SHA256MultiBufferJob jobs[SHA256_BATCH_JOBS];
+        uint32_t extra[SHA256_BATCH_JOBS][16];
+        while (count > 0) {
+            size_t n = (count < SHA256_BATCH_JOBS) ? count : SHA256_BATCH_JOBS;
+            for (size_t posn = 0; posn < n; ++posn) {
+                SHA256 *h = hashes[posn];
+                uint8_t *wbytes = (uint8_t *)h->state.w;
+                uint8_t chunkSize = h->state.chunkSize;
+                SHA256MultiBufferJob *job = &jobs[posn];
+                job->h = h->state.h;
+                job->first = wbytes;
+                job->data = 0;
+                job->blocks = 0;
+
+                // Pad the last chunk, with a second padding chunk if there
+                // isn't enough room in the first for the length.
+                wbytes[chunkSize] = 0x80;
+                if (chunkSize <= (64 - 9)) {
+                    memset(wbytes + chunkSize + 1, 0x00, 64 - 8 - (chunkSize + 1));
+                    h->state.w[14] = htobe32((uint32_t)(h->state.length >> 32));
+                    h->state.w[15] = htobe32((uint32_t)h->state.length);
+                    job->last = 0;
+                } else {
+                    uint32_t *ew = extra[posn];
+                    memset(wbytes + chunkSize + 1, 0x00, 64 - (chunkSize + 1));
+                    memset(ew, 0x00, 64 - 8);
+                    ew[14] = htobe32((uint32_t)(h->state.length >> 32));
+                    ew[15] = htobe32((uint32_t)h->state.length);
+                    job->last = (const uint8_t *)ew;
+                }
+            }
+            sha256MultiBufferCompress(jobs, n);
+            for (size_t posn = 0; posn < n; ++posn) {
+                SHA256 *h = hashes[posn];
+                for (uint8_t word = 0; word < 8; ++word)
+                    h->state.w[word] = htobe32(h->state.h[word]);
+                size_t size = h->hashSize();
+                if (size > len)
+                    size = len;
+                memcpy(hash[posn], h->state.w, size);
+            }
+            hashes += n;
+            hash += n;
+            count -= n;
+        }
+        clean(extra, sizeof(extra));
+        return;
+    }
+#endif
+    for (size_t posn = 0; posn < count; ++posn)
+        hashes[posn]->finalize(hash[posn], len);
+}
+
+/**
+ * \brief Processes the 512-bit chunk in state.w.
  */
 void SHA256::processChunk()
 {
+    processBlocks((const uint8_t *)state.w, 1);
+}
+
+/**
+ * \brief Processes a run of 512-bit chunks with the core SHA-256 algorithm.
+ *
+ * \param data Points to the chunks in big-endian byte order, with any
+ * alignment.  This may be state.w itself.
+ * \param blocks Number of chunks to process.
+ *
+ * Uses the CPU's SHA instructions instead when they are available.
+ *
+ * The chaining value stays in local variables across the whole run and
+ * state.w is used as the message schedule workspace, so whole chunks from
+ * update() are never copied into state.w first.
+ *
+ * Reference: http://en.wikipedia.org/wiki/SHA-2
+ */
+void SHA256::processBlocks(const uint8_t *data, size_t blocks)
+{
+#if CRYPTO_SHA_HW
+    if (sha256HardwareAvailable()) {
+        sha256HardwareCompress(state.h, data, blocks);
+        return;
+    }
+#endif
+
     // Round constants for SHA-256.
     static uint32_t const k[64] PROGMEM = {
         0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
@@ -193,77 +442,88 @@ void SHA256::processChunk()
         0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
     };
 
-    // Convert the first 16 words from big endian to host byte order.
     uint8_t index;
-    for (index = 0; index < 16; ++index)
-        state.w[index] = be32toh(state.w[index]);
-
-    // Initialise working variables to the current hash value.
-    uint32_t a = state.h[0];
-    uint32_t b = state.h[1];
-    uint32_t c = state.h[2];
-    uint32_t d = state.h[3];
-    uint32_t e = state.h[4];
-    uint32_t f = state.h[5];
-    uint32_t g = state.h[6];
-    uint32_t h = state.h[7];
-
-    // Perform the first 16 rounds of the compression function main loop.
-    uint32_t temp1, temp2;
-    for (index = 0; index < 16; ++index) {
-        temp1 = h + pgm_read_dword(k + index) + state.w[index] +
-                (rightRotate6(e) ^ rightRotate11(e) ^ rightRotate25(e)) +
-                ((e & f) ^ ((~e) & g));
-        temp2 = (rightRotate2(a) ^ rightRotate13(a) ^ rightRotate22(a)) +
-                ((a & b) ^ (a & c) ^ (b & c));
-        h = g;
-        g = f;
-        f = e;
-        e = d + temp1;
-        d = c;
-        c = b;
-        b = a;
-        a = temp1 + temp2;
-    }
+    uint32_t hv[8];
+    for (index = 0; index < 8; ++index)
+        hv[index] = state.h[index];
+
+    while (blocks-- > 0) {
+        // Load the next 16 words in host byte order.  When called from
+        // processChunk() this converts state.w in place.
+        for (index = 0; index < 16; ++index, data += 4)
+            state.w[index] = loadBE32(data);
+
+        // Initialise working variables to the current hash value.
+        uint32_t a = hv[0];
+        uint32_t b = hv[1];
+        uint32_t c = hv[2];
+        uint32_t d = hv[3];
+        uint32_t e = hv[4];
+        uint32_t f = hv[5];
+        uint32_t g = hv[6];
+        uint32_t h = hv[7];
+
+        // Perform the first 16 rounds of the compression function main loop.
+        uint32_t temp1, temp2;
+        for (index = 0; index < 16; ++index) {
+            temp1 = h + pgm_read_dword(k + index) + state.w[index] +
+                    (rightRotate6(e) ^ rightRotate11(e) ^ rightRotate25(e)) +
+                    ((e & f) ^ ((~e) & g));
+            temp2 = (rightRotate2(a) ^ rightRotate13(a) ^ rightRotate22(a)) +
+                    ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        // Perform the 48 remaining rounds.  We expand the first 16 words to
+        // 64 in-place in the "w" array.  This saves 192 bytes of memory
+        // that would have otherwise need to be allocated to the "w" array.
+        for (; index < 64; ++index) {
+            // Expand the next word.
+            temp1 = state.w[(index - 15) & 0x0F];
+            temp2 = state.w[(index - 2) & 0x0F];
+            temp1 = state.w[index & 0x0F] =
+                state.w[(index - 16) & 0x0F] + state.w[(index - 7) & 0x0F] +
+                    (rightRotate7(temp1) ^ rightRotate18(temp1) ^ (temp1 >> 3)) +
+                    (rightRotate17(temp2) ^ rightRotate19(temp2) ^ (temp2 >> 10));
+
+            // Perform the round.
+            temp1 = h + pgm_read_dword(k + index) + temp1 +
+                    (rightRotate6(e) ^ rightRotate11(e) ^ rightRotate25(e)) +
+                    ((e & f) ^ ((~e) & g));
+            temp2 = (rightRotate2(a) ^ rightRotate13(a) ^ rightRotate22(a)) +
+                    ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        // Add the compressed chunk to the current hash value.
+        hv[0] += a;
+        hv[1] += b;
+        hv[2] += c;
+        hv[3] += d;
+        hv[4] += e;
+        hv[5] += f;
+        hv[6] += g;
+        hv[7] += h;
 
-    // Perform the 48 remaining rounds.  We expand the first 16 words to
-    // 64 in-place in the "w" array.  This saves 192 bytes of memory
-    // that would have otherwise need to be allocated to the "w" array.
-    for (; index < 64; ++index) {
-        // Expand the next word.
-        temp1 = state.w[(index - 15) & 0x0F];
-        temp2 = state.w[(index - 2) & 0x0F];
-        temp1 = state.w[index & 0x0F] =
-            state.w[(index - 16) & 0x0F] + state.w[(index - 7) & 0x0F] +
-                (rightRotate7(temp1) ^ rightRotate18(temp1) ^ (temp1 >> 3)) +
-                (rightRotate17(temp2) ^ rightRotate19(temp2) ^ (temp2 >> 10));
-
-        // Perform the round.
-        temp1 = h + pgm_read_dword(k + index) + temp1 +
-                (rightRotate6(e) ^ rightRotate11(e) ^ rightRotate25(e)) +
-                ((e & f) ^ ((~e) & g));
-        temp2 = (rightRotate2(a) ^ rightRotate13(a) ^ rightRotate22(a)) +
-                ((a & b) ^ (a & c) ^ (b & c));
-        h = g;
-        g = f;
-        f = e;
-        e = d + temp1;
-        d = c;
-        c = b;
-        b = a;
-        a = temp1 + temp2;
+        // Attempt to clean up the stack.
+        a = b = c = d = e = f = g = h = temp1 = temp2 = 0;
     }
 
-    // Add the compressed chunk to the current hash value.
-    state.h[0] += a;
-    state.h[1] += b;
-    state.h[2] += c;
-    state.h[3] += d;
-    state.h[4] += e;
-    state.h[5] += f;
-    state.h[6] += g;
-    state.h[7] += h;
-
-    // Attempt to clean up the stack.
-    a = b = c = d = e = f = g = h = temp1 = temp2 = 0;
+    for (index = 0; index < 8; ++index)
+        state.h[index] = hv[index];
+    clean(hv);
 }
@@ -43,8 +43,13 @@ public:
     void resetHMAC(const void *key, size_t keyLen);
     void finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen);
 
+    size_t snapshotSize() const;
+    void snapshot(void *blob) const;
+    bool restore(const void *blob, size_t len);
+
     static const size_t HASH_SIZE  = 32;
     static const size_t BLOCK_SIZE = 64;
+    static const size_t SNAPSHOT_SIZE = 108;
 
 protected:
     struct {
@@ -55,6 +60,17 @@ protected:
     } state;
 
     void processChunk();
+    void processBlocks(const uint8_t *data, size_t blocks);
+
+    friend void updateBatch(SHA256 *const hashes[], const void *const data[],
+                            const size_t len[], size_t count);
+    friend void finalizeBatch(SHA256 *const hashes[], void *const hash[],
+                              size_t len, size_t count);
 };
 
+void updateBatch(SHA256 *const hashes[], const void *const data[],
+                 const size_t len[], size_t count);
+void finalizeBatch(SHA256 *const hashes[], void *const hash[],
+                   size_t len, size_t count);
+
 #endif
@@ -0,0 +1,246 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "utility/SHAMultiBufferUtil.h"
+#include "utility/SHAHardwareUtil.h"
+#include "utility/EndianUtil.h"
+#include "Crypto.h"
+#include <string.h>
+
+// Multi-buffer SHA-256 for host builds.  See utility/SHAMultiBufferUtil.h
+// for when this is compiled in.
+
+#if CRYPTO_SHA_MB
+
+// Round constants for SHA-256.
+static const uint32_t sha256MultiBufferK[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// Block fed to lanes that have run out of work.
+static const uint8_t sha256MultiBufferIdle[64] = {0};
+
+typedef uint32_t sha256x4 __attribute__((vector_size(16)));
+#if defined(__x86_64__)
+typedef uint32_t sha256x8 __attribute__((vector_size(32)));
+#endif
+
+#define MB_INLINE inline __attribute__((always_inline))
+#define MB_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+// Compresses one block in each of the L lanes.  H holds the chaining
+// values transposed, word-major, so each row loads as one vector.
+template <typename V, int L>
+static MB_INLINE void sha256Lanes(uint32_t (*H)[L], const uint8_t *const *p)
+{
+    V w[16];
+    uint32_t column[L] __attribute__((aligned(sizeof(V))));
+    int t, lane;
+
+    // Gather word t of every lane's block into w[t].
+    for (t = 0; t < 16; ++t) {
+        for (lane = 0; lane < L; ++lane)
+            column[lane] = loadBE32(p[lane] + t * 4);
+        memcpy(&w[t], column, sizeof(V));
+    }
+
+    V a, b, c, d, e, f, g, h;
+    memcpy(&a, H[0], sizeof(V));
+    memcpy(&b, H[1], sizeof(V));
+    memcpy(&c, H[2], sizeof(V));
+    memcpy(&d, H[3], sizeof(V));
+    memcpy(&e, H[4], sizeof(V));
+    memcpy(&f, H[5], sizeof(V));
+    memcpy(&g, H[6], sizeof(V));
+    memcpy(&h, H[7], sizeof(V));
+
+#pragma GCC unroll 64
+    for (t = 0; t < 64; ++t) {
+        V wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            V x = w[(t - 15) & 15];
+            V y = w[(t - 2) & 15];
+            wt = w[t & 15] = w[t & 15] + w[(t - 7) & 15] +
+                (MB_ROTR(x, 7) ^ MB_ROTR(x, 18) ^ (x >> 3)) +
+                (MB_ROTR(y, 17) ^ MB_ROTR(y, 19) ^ (y >> 10));
+        }
+        V temp1 = h + sha256MultiBufferK[t] + wt +
+                  (MB_ROTR(e, 6) ^ MB_ROTR(e, 11) ^ MB_ROTR(e, 25)) +
+                  ((e & f) ^ (~e & g));
+        V temp2 = (MB_ROTR(a, 2) ^ MB_ROTR(a, 13) ^ MB_ROTR(a, 22)) +
+                  ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    V s;
+    memcpy(&s, H[0], sizeof(V)); s += a; memcpy(H[0], &s, sizeof(V));
+    memcpy(&s, H[1], sizeof(V)); s += b; memcpy(H[1], &s, sizeof(V));
+    memcpy(&s, H[2], sizeof(V)); s += c; memcpy(H[2], &s, sizeof(V));
+    memcpy(&s, H[3], sizeof(V)); s += d; memcpy(H[3], &s, sizeof(V));
+    memcpy(&s, H[4], sizeof(V)); s += e; memcpy(H[4], &s, sizeof(V));
+    memcpy(&s, H[5], sizeof(V)); s += f; memcpy(H[5], &s, sizeof(V));
+    memcpy(&s, H[6], sizeof(V)); s += g; memcpy(H[6], &s, sizeof(V));
+    memcpy(&s, H[7], sizeof(V)); s += h; memcpy(H[7], &s, sizeof(V));
+    clean(w, sizeof(w));
+}
+
+static inline size_t jobBlocks(const SHA256MultiBufferJob *job)
+{
+    return (job->first ? 1 : 0) + job->blocks + (job->last ? 1 : 0);
+}
+
+static inline const uint8_t *jobBlock(const SHA256MultiBufferJob *job, size_t index)
+{
+    if (job->first) {
+        if (index == 0)
+            return job->first;
+        --index;
+    }
+    if (index < job->blocks)
+        return job->data + index * 64;
+    return job->last;
+}
+
+// Feeds the job queue through L lanes.  A lane whose job finishes takes
+// the next one from the queue straight away, so messages of different
+// lengths keep the lanes busy until the queue runs dry.
+template <typename V, int L>
+static MB_INLINE void sha256RunLanes(SHA256MultiBufferJob *jobs, size_t count)
+{
+    uint32_t H[8][L] __attribute__((aligned(sizeof(V))));
+    SHA256MultiBufferJob *current[L];
+    size_t posn[L];
+    size_t total[L];
+    const uint8_t *p[L];
+    size_t next = 0;
+    int active = 0;
+    int lane, word;
+
+    for (lane = 0; lane < L; ++lane)
+        current[lane] = 0;
+    for (;;) {
+        for (lane = 0; lane < L; ++lane) {
+            while (!current[lane] && next < count) {
+                SHA256MultiBufferJob *job = &jobs[next++];
+                total[lane] = jobBlocks(job);
+                if (!total[lane])
+                    continue;
+                current[lane] = job;
+                posn[lane] = 0;
+                for (word = 0; word < 8; ++word)
+                    H[word][lane] = job->h[word];
+                ++active;
+            }
+        }
+        if (!active)
+            break;
+
+        for (lane = 0; lane < L; ++lane) {
+            if (current[lane])
+                p[lane] = jobBlock(current[lane], posn[lane]);
+            else
+                p[lane] = sha256MultiBufferIdle;
+        }
+        sha256Lanes<V, L>(H, p);
+
+        for (lane = 0; lane < L; ++lane) {
+            if (current[lane] && ++posn[lane] == total[lane]) {
+                for (word = 0; word < 8; ++word)
+                    current[lane]->h[word] = H[word][lane];
+                current[lane] = 0;
+                --active;
+            }
+        }
+    }
+    clean(H, sizeof(H));
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2")))
+static void sha256RunLanesAVX2(SHA256MultiBufferJob *jobs, size_t count)
+{
+    sha256RunLanes<sha256x8, 8>(jobs, count);
+}
+
+static bool detectAVX2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+static bool haveAVX2()
+{
+    static const bool available = detectAVX2();
+    return available;
+}
+
+#endif
+
+size_t sha256MultiBufferLanes()
+{
+#if CRYPTO_SHA_HW
+    if (sha256HardwareAvailable())
+        return 1;
+#endif
+#if defined(__x86_64__)
+    if (haveAVX2())
+        return 8;
+#endif
+    return 4;
+}
+
+void sha256MultiBufferCompress(SHA256MultiBufferJob *jobs, size_t count)
+{
+#if defined(__x86_64__)
+    if (haveAVX2()) {
+        sha256RunLanesAVX2(jobs, count);
+        return;
+    }
+#endif
+    sha256RunLanes<sha256x4, 4>(jobs, count);
+}
+
+#endif // CRYPTO_SHA_MB
@@ -98,13 +98,114 @@ void SHA3_256::resetHMAC(const void *key, size_t keyLen)
 void SHA3_256::finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen)
 {
     uint8_t temp[32];
-    finalize(temp, sizeof(temp));
+    SHA3_256::finalize(temp, sizeof(temp));
     core.setHMACKey(key, keyLen, 0x5C, 32);
     core.update(temp, sizeof(temp));
-    finalize(hash, hashLen);
+    SHA3_256::finalize(hash, hashLen);
     clean(temp);
 }
 
+/**
+ * \brief Size of the snapshot blob, always SNAPSHOT_SIZE.
+ */
+size_t SHA3_256::snapshotSize() const
+{
+    return SNAPSHOT_SIZE;
+}
+
+/**
+ * \brief Writes the current state of the hashing process to a blob.
+ *
+ * \param blob Points to SNAPSHOT_SIZE bytes to receive the snapshot.
+ *
+ * \sa restore(), snapshotSize()
+ */
+void SHA3_256::snapshot(void *blob) const
+{
+    uint8_t *b = (uint8_t *)blob;
+    b[0] = SnapshotSHA3_256;
+    b[1] = SnapshotVersion;
+    core.snapshot(b + 2);
+}
+
+/**
+ * \brief Restores the state of a hashing process from a snapshot blob.
+ *
+ * \param blob Points to the blob that was written by snapshot().
+ * \param len Length of the \a blob, which must be SNAPSHOT_SIZE.
+ *
+ * \return Returns false if the blob is not a valid SHA3-256 snapshot.
+ *
+ * \sa snapshot()
+ */
+bool SHA3_256::restore(const void *blob, size_t len)
+{
+    const uint8_t *b = (const uint8_t *)blob;
+    if (len != SNAPSHOT_SIZE || b[0] != SnapshotSHA3_256 ||
+            b[1] != SnapshotVersion)
+        return false;
+    return core.restore(b + 2);
+}
+
+// Number of objects whose sponge states are handed to KeccakCore's batch
+// functions at a time.
+#define SHA3_BATCH_SIZE 32
+
+/**
+ * \brief Updates several independent SHA3-256 hashing processes at once.
+ *
+ * \param hashes Points to \a count distinct SHA3_256 objects.
+ * \param data Points to the data for each hash object.
+ * \param len Points to the length of the data for each hash object.
+ * \param count Number of hash objects.
+ *
+ * On 64-bit hosts with SIMD support the whole blocks of the messages are
+ * absorbed side by side; see KeccakCore::updateBatch().
+ *
+ * \sa finalizeBatch(SHA3_256 *const[], void *const[], size_t, size_t)
+ */
+void updateBatch(SHA3_256 *const hashes[], const void *const data[],
+                 const size_t len[], size_t count)
+{
+    KeccakCore *cores[SHA3_BATCH_SIZE];
+    while (count > 0) {
+        size_t n = (count < SHA3_BATCH_SIZE) ? count : SHA3_BATCH_SIZE;
+        for (size_t posn = 0; posn < n; ++posn)
+            cores[posn] = &(hashes[posn]->core);
+        KeccakCore::updateBatch(cores, data, len, n);
+        hashes += n;
+        data += n;
+        len += n;
+        count -= n;
+    }
+}
+
+/**
+ * \brief Finalizes several independent SHA3-256 hashing processes at once.
+ *
+ * \param hashes Points to \a count distinct SHA3_256 objects.
+ * \param hash Points to the buffers to return each hash value in.
+ * \param len The length of each \a hash buffer, normally hashSize().
+ * \param count Number of hash objects.
+ *
+ * \sa updateBatch(SHA3_256 *const[], const void *const[], const size_t[], size_t)
+ */
+void finalizeBatch(SHA3_256 *const hashes[], void *const hash[],
+                   size_t len, size_t count)
+{
+    KeccakCore *cores[SHA3_BATCH_SIZE];
+    while (count > 0) {
+        size_t n = (count < SHA3_BATCH_SIZE) ? count : SHA3_BATCH_SIZE;
+        for (size_t posn = 0; posn < n; ++posn)
+            cores[posn] = &(hashes[posn]->core);
+        KeccakCore::padBatch(cores, 0x06, n);
+        KeccakCore::extractBatch(cores, hash, len, n);
+        hashes += n;
+        hash += n;
+        count -= n;
+    }
+}
+
 /**
  * \class SHA3_512 SHA3.h <SHA3.h>
  * \brief SHA3-512 hash algorithm.
@@ -180,9 +281,106 @@ void SHA3_512::resetHMAC(const void *key, size_t keyLen)
 void SHA3_512::finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen)
 {
     uint8_t temp[64];
-    finalize(temp, sizeof(temp));
+    SHA3_512::finalize(temp, sizeof(temp));
     core.setHMACKey(key, keyLen, 0x5C, 64);
     core.update(temp, sizeof(temp));
-    finalize(hash, hashLen);
+    SHA3_512::finalize(hash, hashLen);
     clean(temp);
 }
+
+/**
+ * \brief Size of the snapshot blob, always SNAPSHOT_SIZE.
+ */
+size_t SHA3_512::snapshotSize() const
+{
+    return SNAPSHOT_SIZE;
+}
+
+/**
+ * \brief Writes the current state of the hashing process to a blob.
+ *
+ * \param blob Points to SNAPSHOT_SIZE bytes to receive the snapshot.
+ *
+ * \sa restore(), snapshotSize()
+ */
+void SHA3_512::snapshot(void *blob) const
+{
+    uint8_t *b = (uint8_t *)blob;
+    b[0] = SnapshotSHA3_512;
+    b[1] = SnapshotVersion;
+    core.snapshot(b + 2);
+}
+
+/**
+ * \brief Restores the state of a hashing process from a snapshot blob.
+ *
+ * \param blob Points to the blob that was written by snapshot().
+ * \param len Length of the \a blob, which must be SNAPSHOT_SIZE.
+ *
+ * \return Returns false if the blob is not a valid SHA3-512 snapshot.
+ *
+ * \sa snapshot()
+ */
+bool SHA3_512::restore(const void *blob, size_t len)
+{
+    const uint8_t *b = (const uint8_t *)blob;
+    if (len != SNAPSHOT_SIZE || b[0] != SnapshotSHA3_512 ||
+            b[1] != SnapshotVersion)
+        return false;
+    return core.restore(b + 2);
+}
+
+/**
+ * \brief Updates several independent SHA3-512 hashing processes at once.
+ *
+ * \param hashes Points to \a count distinct SHA3_512 objects.
+ * \param data Points to the data for each hash object.
+ * \param len Points to the length of the data for each hash object.
+ * \param count Number of hash objects.
+ *
+ * On 64-bit hosts with SIMD support the whole blocks of the messages are
+ * absorbed side by side; see KeccakCore::updateBatch().
+ *
+ * \sa finalizeBatch(SHA3_512 *const[], void *const[], size_t, size_t)
+ */
+void updateBatch(SHA3_512 *const hashes[], const void *const data[],
+                 const size_t len[], size_t count)
+{
+    KeccakCore *cores[SHA3_BATCH_SIZE];
+    while (count > 0) {
+        size_t n = (count < SHA3_BATCH_SIZE) ? count : SHA3_BATCH_SIZE;
+        for (size_t posn = 0; posn < n; ++posn)
+            cores[posn] = &(hashes[posn]->core);
+        KeccakCore::updateBatch(cores, data, len, n);
+        hashes += n;
+        data += n;
+        len += n;
+        count -= n;
+    }
+}
+
+/**
+ * \brief Finalizes several independent SHA3-512 hashing processes at once.
+ *
+ * \param hashes Points to \a count distinct SHA3_512 objects.
+ * \param hash Points to the buffers to return each hash value in.
+ * \param len The length of each \a hash buffer, normally hashSize().
+ * \param count Number of hash objects.
+ *
+ * \sa updateBatch(SHA3_512 *const[], const void *const[], const size_t[], size_t)
+ */
+void finalizeBatch(SHA3_512 *const hashes[], void *const hash[],
+                   size_t len, size_t count)
+{
+    KeccakCore *cores[SHA3_BATCH_SIZE];
+    while (count > 0) {
+        size_t n = (count < SHA3_BATCH_SIZE) ? count : SHA3_BATCH_SIZE;
+        for (size_t posn = 0; posn < n; ++posn)
+            cores[posn] = &(hashes[posn]->core);
+        KeccakCore::padBatch(cores, 0x06, n);
+        KeccakCore::extractBatch(cores, hash, len, n);
+        hashes += n;
+        hash += n;
+        count -= n;
+    }
+}
@@ -44,13 +44,28 @@ public:
     void resetHMAC(const void *key, size_t keyLen);
     void finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen);
 
+    size_t snapshotSize() const;
+    void snapshot(void *blob) const;
+    bool restore(const void *blob, size_t len);
+
     static const size_t HASH_SIZE  = 32;
     static const size_t BLOCK_SIZE = 136;
+    static const size_t SNAPSHOT_SIZE = KeccakCore::SNAPSHOT_SIZE + 2;
 
 private:
     KeccakCore core;
+
+    friend void updateBatch(SHA3_256 *const hashes[], const void *const data[],
+                            const size_t len[], size_t count);
+    friend void finalizeBatch(SHA3_256 *const hashes[], void *const hash[],
+                              size_t len, size_t count);
 };
 
+void updateBatch(SHA3_256 *const hashes[], const void *const data[],
+                 const size_t len[], size_t count);
+void finalizeBatch(SHA3_256 *const hashes[], void *const hash[],
+                   size_t len, size_t count);
+
 class SHA3_512 : public Hash
 {
 public:
@@ -69,11 +84,26 @@ public:
     void resetHMAC(const void *key, size_t keyLen);
     void finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen);
 
+    size_t snapshotSize() const;
+    void snapshot(void *blob) const;
+    bool restore(const void *blob, size_t len);
+
     static const size_t HASH_SIZE  = 64;
     static const size_t BLOCK_SIZE = 72;
+    static const size_t SNAPSHOT_SIZE = KeccakCore::SNAPSHOT_SIZE + 2;
 
 private:
     KeccakCore core;
+
+    friend void updateBatch(SHA3_512 *const hashes[], const void *const data[],
+                            const size_t len[], size_t count);
+    friend void finalizeBatch(SHA3_512 *const hashes[], void *const hash[],
+                              size_t len, size_t count);
 };
 
+void updateBatch(SHA3_512 *const hashes[], const void *const data[],
+                 const size_t len[], size_t count);
+void finalizeBatch(SHA3_512 *const hashes[], void *const hash[],
+                   size_t len, size_t count);
+
 #endif
@@ -24,6 +24,7 @@
 #include "Crypto.h"
 #include "utility/RotateUtil.h"
 #include "utility/EndianUtil.h"
+#include "utility/SHA512VectorUtil.h"
 #include "utility/ProgMemUtil.h"
 #include <string.h>
 
@@ -95,9 +96,9 @@ void SHA512::update(const void *data, size_t len)
     if (state.lengthLow < temp)
         ++state.lengthHigh;
 
-    // Break the input up into 1024-bit chunks and process each in turn.
+    // Top up a partially filled chunk first.
     const uint8_t *d = (const uint8_t *)data;
-    while (len > 0) {
+    if (state.chunkSize) {
         uint8_t size = 128 - state.chunkSize;
         if (size > len)
             size = len;
@@ -110,6 +111,20 @@ void SHA512::update(const void *data, size_t len)
             state.chunkSize = 0;
         }
     }
+
+    // Compress whole chunks straight from the caller's buffer.
+    if (len >= 128) {
+        size_t blocks = len / 128;
+        processBlocks(d, blocks);
+        d += blocks * 128;
+        len -= blocks * 128;
+    }
+
+    // Buffer the remainder until the next update() or finalize().
+    if (len > 0) {
+        memcpy(state.w, d, len);
+        state.chunkSize = len;
+    }
 }
 
 void SHA512::finalize(void *hash, size_t len)
@@ -160,22 +175,104 @@ void SHA512::resetHMAC(const void *key, size_t keyLen)
 void SHA512::finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen)
 {
     uint8_t temp[64];
-    finalize(temp, sizeof(temp));
+    SHA512::finalize(temp, sizeof(temp));
     formatHMACKey(state.w, key, keyLen, 0x5C);
     state.lengthLow += 128 * 8;
     processChunk();
-    update(temp, hashSize());
-    finalize(hash, hashLen);
+    SHA512::update(temp, hashSize());
+    SHA512::finalize(hash, hashLen);
     clean(temp);
 }
 
 /**
- * \brief Processes a single 1024-bit chunk with the core SHA-512 algorithm.
+ * \brief Size of the snapshot blob, always SNAPSHOT_SIZE.
+ */
+size_t SHA512::snapshotSize() const
+{
+    return SNAPSHOT_SIZE;
+}
+
+/**
+ * \brief Writes the current state of the hashing process to a blob.
  *
- * Reference: http://en.wikipedia.org/wiki/SHA-2
+ * \param blob Points to SNAPSHOT_SIZE bytes to receive the snapshot.
+ *
+ * \sa restore(), snapshotSize()
+ */
+void SHA512::snapshot(void *blob) const
+{
+    uint8_t *b = (uint8_t *)blob;
+    b[0] = (hashSize() == 48) ? SnapshotSHA384 : SnapshotSHA512;
+    b[1] = SnapshotVersion;
+    b[2] = state.chunkSize;
+    b[3] = 0;
+    b += SnapshotHeaderSize;
+    for (uint8_t posn = 0; posn < 8; ++posn, b += 8)
+        storeLE64(b, state.h[posn]);
+    storeLE64(b, state.lengthLow);
+    storeLE64(b + 8, state.lengthHigh);
+    b += 16;
+    memcpy(b, state.w, state.chunkSize);
+    memset(b + state.chunkSize, 0, 128 - state.chunkSize);
+}
+
+/**
+ * \brief Restores the state of a hashing process from a snapshot blob.
+ *
+ * \param blob Points to the blob that was written by snapshot().
+ * \param len Length of the \a blob, which must be SNAPSHOT_SIZE.
+ *
+ * \return Returns false if the blob is not a valid snapshot for this
+ * algorithm.  SHA-384 and SHA-512 snapshots are not interchangeable.
+ *
+ * \sa snapshot()
+ */
+bool SHA512::restore(const void *blob, size_t len)
+{
+    const uint8_t *b = (const uint8_t *)blob;
+    uint8_t tag = (hashSize() == 48) ? SnapshotSHA384 : SnapshotSHA512;
+    if (len != SNAPSHOT_SIZE || b[0] != tag ||
+            b[1] != SnapshotVersion || b[2] >= 128 || b[3] != 0)
+        return false;
+    state.chunkSize = b[2];
+    b += SnapshotHeaderSize;
+    for (uint8_t posn = 0; posn < 8; ++posn, b += 8)
+        state.h[posn] = loadLE64(b);
+    state.lengthLow = loadLE64(b);
+    state.lengthHigh = loadLE64(b + 8);
+    b += 16;
+    memcpy(state.w, b, 128);
+    return true;
+}
+
+/**
+ * \brief Processes the 1024-bit chunk in state.w.
  */
 void SHA512::processChunk()
 {
+    processBlocks((const uint8_t *)state.w, 1);
+}
+
+/**
+ * \brief Processes a run of 1024-bit chunks with the core SHA-512 algorithm.
+ *
+ * \param data Points to the chunks in big-endian byte order, with any
+ * alignment.  This may be state.w itself.
+ * \param blocks Number of chunks to process.
+ *
+ * The chaining value stays in local variables across the whole run and
+ * state.w is used as the message schedule workspace, so whole chunks from
+ * update() are never copied into state.w first.
+ *
+ * Reference: http://en.wikipedia.org/wiki/SHA-2
+ */
+void SHA512::processBlocks(const uint8_t *data, size_t blocks)
+{
+#if CRYPTO_SHA512_VEC
+    sha512VectorCompress(state.h, data, blocks);
+    return;
+#endif
+
     // Round constants for SHA-512.
     static uint64_t const k[80] PROGMEM = {
         0x428A2F98D728AE22ULL, 0x7137449123EF65CDULL, 0xB5C0FBCFEC4D3B2FULL,
@@ -207,79 +304,90 @@ void SHA512::processChunk()
         0x5FCB6FAB3AD6FAECULL, 0x6C44198C4A475817ULL
     };
 
-    // Convert the first 16 words from big endian to host byte order.
     uint8_t index;
-    for (index = 0; index < 16; ++index)
-        state.w[index] = be64toh(state.w[index]);
-
-    // Initialise working variables to the current hash value.
-    uint64_t a = state.h[0];
-    uint64_t b = state.h[1];
-    uint64_t c = state.h[2];
-    uint64_t d = state.h[3];
-    uint64_t e = state.h[4];
-    uint64_t f = state.h[5];
-    uint64_t g = state.h[6];
-    uint64_t h = state.h[7];
-
-    // Perform the first 16 rounds of the compression function main loop.
-    uint64_t temp1, temp2;
-    for (index = 0; index < 16; ++index) {
-        temp1 = h + pgm_read_qword(k + index) + state.w[index] +
-                (rightRotate14_64(e) ^ rightRotate18_64(e) ^
-                 rightRotate41_64(e)) + ((e & f) ^ ((~e) & g));
-        temp2 = (rightRotate28_64(a) ^ rightRotate34_64(a) ^
-                 rightRotate39_64(a)) + ((a & b) ^ (a & c) ^ (b & c));
-        h = g;
-        g = f;
-        f = e;
-        e = d + temp1;
-        d = c;
-        c = b;
-        b = a;
-        a = temp1 + temp2;
-    }
+    uint64_t hv[8];
+    for (index = 0; index < 8; ++index)
+        hv[index] = state.h[index];
+
+    while (blocks-- > 0) {
+        // Load the next 16 words in host byte order.  When called from
+        // processChunk() this converts state.w in place.
+        for (index = 0; index < 16; ++index, data += 8)
+            state.w[index] = loadBE64(data);
+
+        // Initialise working variables to the current hash value.
+        uint64_t a = hv[0];
+        uint64_t b = hv[1];
+        uint64_t c = hv[2];
+        uint64_t d = hv[3];
+        uint64_t e = hv[4];
+        uint64_t f = hv[5];
+        uint64_t g = hv[6];
+        uint64_t h = hv[7];
+
+        // Perform the first 16 rounds of the compression function main loop.
+        uint64_t temp1, temp2;
+        for (index = 0; index < 16; ++index) {
+            temp1 = h + pgm_read_qword(k + index) + state.w[index] +
+                    (rightRotate14_64(e) ^ rightRotate18_64(e) ^
+                     rightRotate41_64(e)) + ((e & f) ^ ((~e) & g));
+            temp2 = (rightRotate28_64(a) ^ rightRotate34_64(a) ^
+                     rightRotate39_64(a)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        // Perform the 64 remaining rounds.  We expand the first 16 words to
+        // 80 in-place in the "w" array.  This saves 512 bytes of memory
+        // that would have otherwise need to be allocated to the "w" array.
+        for (; index < 80; ++index) {
+            // Expand the next word.
+            temp1 = state.w[(index - 15) & 0x0F];
+            temp2 = state.w[(index - 2) & 0x0F];
+            temp1 = state.w[index & 0x0F] =
+                state.w[(index - 16) & 0x0F] + state.w[(index - 7) & 0x0F] +
+                    (rightRotate1_64(temp1) ^ rightRotate8_64(temp1) ^
+                     (temp1 >> 7)) +
+                    (rightRotate19_64(temp2) ^ rightRotate61_64(temp2) ^
+                     (temp2 >> 6));
+
+            // Perform the round.
+            temp1 = h + pgm_read_qword(k + index) + temp1 +
+                    (rightRotate14_64(e) ^ rightRotate18_64(e) ^
+                     rightRotate41_64(e)) + ((e & f) ^ ((~e) & g));
+            temp2 = (rightRotate28_64(a) ^ rightRotate34_64(a) ^
+                     rightRotate39_64(a)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        // Add the compressed chunk to the current hash value.
+        hv[0] += a;
+        hv[1] += b;
+        hv[2] += c;
+        hv[3] += d;
+        hv[4] += e;
+        hv[5] += f;
+        hv[6] += g;
+        hv[7] += h;
 
-    // Perform the 64 remaining rounds.  We expand the first 16 words to
-    // 80 in-place in the "w" array.  This saves 512 bytes of memory
-    // that would have otherwise need to be allocated to the "w" array.
-    for (; index < 80; ++index) {
-        // Expand the next word.
-        temp1 = state.w[(index - 15) & 0x0F];
-        temp2 = state.w[(index - 2) & 0x0F];
-        temp1 = state.w[index & 0x0F] =
-            state.w[(index - 16) & 0x0F] + state.w[(index - 7) & 0x0F] +
-                (rightRotate1_64(temp1) ^ rightRotate8_64(temp1) ^
-                 (temp1 >> 7)) +
-                (rightRotate19_64(temp2) ^ rightRotate61_64(temp2) ^
-                 (temp2 >> 6));
-
-        // Perform the round.
-        temp1 = h + pgm_read_qword(k + index) + temp1 +
-                (rightRotate14_64(e) ^ rightRotate18_64(e) ^
-                 rightRotate41_64(e)) + ((e & f) ^ ((~e) & g));
-        temp2 = (rightRotate28_64(a) ^ rightRotate34_64(a) ^
-                 rightRotate39_64(a)) + ((a & b) ^ (a & c) ^ (b & c));
-        h = g;
-        g = f;
-        f = e;
-        e = d + temp1;
-        d = c;
-        c = b;
-        b = a;
-        a = temp1 + temp2;
+        // Attempt to clean up the stack.
+        a = b = c = d = e = f = g = h = temp1 = temp2 = 0;
     }
 
-    // Add the compressed chunk to the current hash value.
-    state.h[0] += a;
-    state.h[1] += b;
-    state.h[2] += c;
-    state.h[3] += d;
-    state.h[4] += e;
-    state.h[5] += f;
-    state.h[6] += g;
-    state.h[7] += h;
-
-    // Attempt to clean up the stack.
-    a = b = c = d = e = f = g = h = temp1 = temp2 = 0;
+    for (index = 0; index < 8; ++index)
+        state.h[index] = hv[index];
+    clean(hv);
 }
@@ -45,8 +45,13 @@ public:
     void resetHMAC(const void *key, size_t keyLen);
     void finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen);
 
+    size_t snapshotSize() const;
+    void snapshot(void *blob) const;
+    bool restore(const void *blob, size_t len);
+
     static const size_t HASH_SIZE  = 64;
     static const size_t BLOCK_SIZE = 128;
+    static const size_t SNAPSHOT_SIZE = 212;
 
 protected:
     struct {
@@ -58,6 +63,7 @@ protected:
     } state;
 
     void processChunk();
+    void processBlocks(const uint8_t *data, size_t blocks);
 
     friend class Ed25519;
 };
@@ -0,0 +1,180 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "utility/SHA512VectorUtil.h"
+#include "utility/EndianUtil.h"
+#include "Crypto.h"
+#include <string.h>
+
+// SHA-512 compression for 64-bit hosts.  See utility/SHA512VectorUtil.h
+// for when this is compiled in.
+
+#if CRYPTO_SHA512_VEC
+
+// Round constants for SHA-512.
+static const uint64_t sha512VectorK[80] __attribute__((aligned(16))) = {
+    0x428A2F98D728AE22ULL, 0x7137449123EF65CDULL, 0xB5C0FBCFEC4D3B2FULL,
+    0xE9B5DBA58189DBBCULL, 0x3956C25BF348B538ULL, 0x59F111F1B605D019ULL,
+    0x923F82A4AF194F9BULL, 0xAB1C5ED5DA6D8118ULL, 0xD807AA98A3030242ULL,
+    0x12835B0145706FBEULL, 0x243185BE4EE4B28CULL, 0x550C7DC3D5FFB4E2ULL,
+    0x72BE5D74F27B896FULL, 0x80DEB1FE3B1696B1ULL, 0x9BDC06A725C71235ULL,
+    0xC19BF174CF692694ULL, 0xE49B69C19EF14AD2ULL, 0xEFBE4786384F25E3ULL,
+    0x0FC19DC68B8CD5B5ULL, 0x240CA1CC77AC9C65ULL, 0x2DE92C6F592B0275ULL,
+    0x4A7484AA6EA6E483ULL, 0x5CB0A9DCBD41FBD4ULL, 0x76F988DA831153B5ULL,
+    0x983E5152EE66DFABULL, 0xA831C66D2DB43210ULL, 0xB00327C898FB213FULL,
+    0xBF597FC7BEEF0EE4ULL, 0xC6E00BF33DA88FC2ULL, 0xD5A79147930AA725ULL,
+    0x06CA6351E003826FULL, 0x142929670A0E6E70ULL, 0x27B70A8546D22FFCULL,
+    0x2E1B21385C26C926ULL, 0x4D2C6DFC5AC42AEDULL, 0x53380D139D95B3DFULL,
+    0x650A73548BAF63DEULL, 0x766A0ABB3C77B2A8ULL, 0x81C2C92E47EDAEE6ULL,
+    0x92722C851482353BULL, 0xA2BFE8A14CF10364ULL, 0xA81A664BBC423001ULL,
+    0xC24B8B70D0F89791ULL, 0xC76C51A30654BE30ULL, 0xD192E819D6EF5218ULL,
+    0xD69906245565A910ULL, 0xF40E35855771202AULL, 0x106AA07032BBD1B8ULL,
+    0x19A4C116B8D2D0C8ULL, 0x1E376C085141AB53ULL, 0x2748774CDF8EEB99ULL,
+    0x34B0BCB5E19B48A8ULL, 0x391C0CB3C5C95A63ULL, 0x4ED8AA4AE3418ACBULL,
+    0x5B9CCA4F7763E373ULL, 0x682E6FF3D6B2B8A3ULL, 0x748F82EE5DEFB2FCULL,
+    0x78A5636F43172F60ULL, 0x84C87814A1F0AB72ULL, 0x8CC702081A6439ECULL,
+    0x90BEFFFA23631E28ULL, 0xA4506CEBDE82BDE9ULL, 0xBEF9A3F7B2C67915ULL,
+    0xC67178F2E372532BULL, 0xCA273ECEEA26619CULL, 0xD186B8C721C0C207ULL,
+    0xEADA7DD6CDE0EB1EULL, 0xF57D4F7FEE6ED178ULL, 0x06F067AA72176FBAULL,
+    0x0A637DC5A2C898A6ULL, 0x113F9804BEF90DAEULL, 0x1B710B35131C471BULL,
+    0x28DB77F523047D84ULL, 0x32CAAB7B40C72493ULL, 0x3C9EBE0A15C9BEBCULL,
+    0x431D67C49C100D4CULL, 0x4CC5D4BECB3E42B6ULL, 0x597F299CFC657E2AULL,
+    0x5FCB6FAB3AD6FAECULL, 0x6C44198C4A475817ULL
+};
+
+typedef uint64_t sha512x2 __attribute__((vector_size(16)));
+
+#define VEC_INLINE inline __attribute__((always_inline))
+#define VEC_ROTR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+static VEC_INLINE uint64_t rotr64(uint64_t x, int n)
+{
+    return (x >> n) | (x << (64 - n));
+}
+
+// Produces W[t] + K[t] and W[t+1] + K[t+1] for an even t.  w[i] holds
+// W[2i] and W[2i+1] of the last 16 words of the message schedule.  The
+// two words do not depend on each other, so one vector computes both.
+#define SCHEDULE(t) \
+    do { \
+        sha512x2 &out = w[((t) / 2) & 7]; \
+        if ((t) < 16) { \
+            out = (sha512x2){loadBE64(data + (t) * 8), \
+                             loadBE64(data + (t) * 8 + 8)}; \
+        } else { \
+            sha512x2 x = __builtin_shuffle(w[(((t) - 16) / 2) & 7], \
+                                           w[(((t) - 14) / 2) & 7], \
+                                           (sha512x2){1, 2}); \
+            sha512x2 y = __builtin_shuffle(w[(((t) - 8) / 2) & 7], \
+                                           w[(((t) - 6) / 2) & 7], \
+                                           (sha512x2){1, 2}); \
+            sha512x2 z = w[(((t) - 2) / 2) & 7]; \
+            out += y + (VEC_ROTR(x, 1) ^ VEC_ROTR(x, 8) ^ (x >> 7)) + \
+                       (VEC_ROTR(z, 19) ^ VEC_ROTR(z, 61) ^ (z >> 6)); \
+        } \
+        sha512x2 k; \
+        memcpy(&k, sha512VectorK + (t), sizeof(k)); \
+        k += out; \
+        wk0 = k[0]; \
+        wk1 = k[1]; \
+    } while (0)
+
+#define ROUND(a, b, c, d, e, f, g, h, wk) \
+    do { \
+        uint64_t temp1 = (h) + (wk) + \
+            (rotr64((e), 14) ^ rotr64((e), 18) ^ rotr64((e), 41)) + \
+            (((e) & (f)) ^ (~(e) & (g))); \
+        uint64_t temp2 = (rotr64((a), 28) ^ rotr64((a), 34) ^ rotr64((a), 39)) + \
+            (((a) & (b)) ^ ((a) & (c)) ^ ((b) & (c))); \
+        (d) += temp1; \
+        (h) = temp1 + temp2; \
+    } while (0)
+
+static VEC_INLINE void sha512Blocks(uint64_t h[8], const uint8_t *data, size_t blocks)
+{
+    sha512x2 w[8];
+    uint64_t wk0, wk1;
+    uint64_t a = h[0], b = h[1], c = h[2], d = h[3];
+    uint64_t e = h[4], f = h[5], g = h[6], hh = h[7];
+    int t;
+
+    while (blocks-- > 0) {
+        // The schedule for the next two rounds is computed in a vector
+        // while the scalar rounds run.  The working variables rotate
+        // through the macro arguments rather than being shifted along.
+#pragma GCC unroll 10
+        for (t = 0; t < 80; t += 8) {
+            SCHEDULE(t);
+            ROUND(a, b, c, d, e, f, g, hh, wk0);
+            ROUND(hh, a, b, c, d, e, f, g, wk1);
+            SCHEDULE(t + 2);
+            ROUND(g, hh, a, b, c, d, e, f, wk0);
+            ROUND(f, g, hh, a, b, c, d, e, wk1);
+            SCHEDULE(t + 4);
+            ROUND(e, f, g, hh, a, b, c, d, wk0);
+            ROUND(d, e, f, g, hh, a, b, c, wk1);
+            SCHEDULE(t + 6);
+            ROUND(c, d, e, f, g, hh, a, b, wk0);
+            ROUND(b, c, d, e, f, g, hh, a, wk1);
+        }
+        data += 128;
+
+        a = (h[0] += a);
+        b = (h[1] += b);
+        c = (h[2] += c);
+        d = (h[3] += d);
+        e = (h[4] += e);
+        f = (h[5] += f);
+        g = (h[6] += g);
+        hh = (h[7] += hh);
+    }
+    clean(w, sizeof(w));
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2,bmi2")))
+static void sha512BlocksAVX2(uint64_t h[8], const uint8_t *data, size_t blocks)
+{
+    sha512Blocks(h, data, blocks);
+}
+
+static bool detectAVX2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+}
+
+#endif
+
+void sha512VectorCompress(uint64_t h[8], const uint8_t *data, size_t blocks)
+{
+#if defined(__x86_64__)
+    static const bool avx2 = detectAVX2();
+    if (avx2) {
+        sha512BlocksAVX2(h, data, blocks);
+        return;
+    }
+#endif
+    sha512Blocks(h, data, blocks);
+}
+
+#endif // CRYPTO_SHA512_VEC
@@ -0,0 +1,307 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "utility/SHAHardwareUtil.h"
+
+// Hardware SHA-1 and SHA-256 compression for host builds.  See
+// utility/SHAHardwareUtil.h for when these are compiled in and used.
+
+#if CRYPTO_SHA_HW
+
+// SHA-256 round constants, four per group of rounds.
+static const uint32_t sha256HardwareK[64] __attribute__((aligned(16))) = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#if defined(CRYPTO_SHA_HW_X86)
+
+#include <immintrin.h>
+#include <cpuid.h>
+
+#define SHA_HW_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+// SHA-NI is CPUID.(EAX=7,ECX=0):EBX bit 29; the shuffles and blends
+// below also need SSSE3 and SSE4.1 (CPUID.1:ECX bits 9 and 19).
+static bool detectSHAExtensions()
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+    if ((ecx & (1U << 9)) == 0 || (ecx & (1U << 19)) == 0)
+        return false;
+    if (__get_cpuid_max(0, 0) < 7)
+        return false;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & (1U << 29)) != 0;
+}
+
+bool sha1HardwareAvailable()
+{
+    static const bool available = detectSHAExtensions();
+    return available;
+}
+
+bool sha256HardwareAvailable()
+{
+    return sha1HardwareAvailable();
+}
+
+SHA_HW_TARGET
+void sha1HardwareCompress(uint32_t h[5], const uint8_t *data, size_t blocks)
+{
+    const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)h), 0x1B);
+    __m128i e0 = _mm_set_epi32((int)h[4], 0, 0, 0);
+    __m128i e1;
+    __m128i m[4];
+
+    while (blocks-- > 0) {
+        __m128i abcdSave = abcd;
+        __m128i e0Save = e0;
+
+        // 20 groups of 4 rounds.  m[] holds the last four groups of the
+        // message schedule, which is expanded in place one group ahead.
+#pragma GCC unroll 20
+        for (int g = 0; g < 20; ++g) {
+            if (g < 4) {
+                m[g] = _mm_shuffle_epi8
+                    (_mm_loadu_si128((const __m128i *)(data + g * 16)), mask);
+            }
+            __m128i &x = (g & 1) ? e1 : e0;
+            __m128i &y = (g & 1) ? e0 : e1;
+            if (g == 0)
+                x = _mm_add_epi32(x, m[0]);
+            else
+                x = _mm_sha1nexte_epu32(x, m[g & 3]);
+            y = abcd;
+            if (g >= 3 && g <= 18)
+                m[(g + 1) & 3] = _mm_sha1msg2_epu32(m[(g + 1) & 3], m[g & 3]);
+            switch (g / 5) {
+            case 0:  abcd = _mm_sha1rnds4_epu32(abcd, x, 0); break;
+            case 1:  abcd = _mm_sha1rnds4_epu32(abcd, x, 1); break;
+            case 2:  abcd = _mm_sha1rnds4_epu32(abcd, x, 2); break;
+            default: abcd = _mm_sha1rnds4_epu32(abcd, x, 3); break;
+            }
+            if (g >= 1 && g <= 16)
+                m[(g + 3) & 3] = _mm_sha1msg1_epu32(m[(g + 3) & 3], m[g & 3]);
+            if (g >= 2 && g <= 17)
+                m[(g + 2) & 3] = _mm_xor_si128(m[(g + 2) & 3], m[g & 3]);
+        }
+
+        e0 = _mm_sha1nexte_epu32(e0, e0Save);
+        abcd = _mm_add_epi32(abcd, abcdSave);
+        data += 64;
+    }
+
+    _mm_storeu_si128((__m128i *)h, _mm_shuffle_epi32(abcd, 0x1B));
+    h[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+SHA_HW_TARGET
+void sha256HardwareCompress(uint32_t h[8], const uint8_t *data, size_t blocks)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // The instructions want the state as ABEF and CDGH.
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)h), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(h + 4)), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+    __m128i m[4];
+
+    while (blocks-- > 0) {
+        __m128i abefSave = state0;
+        __m128i cdghSave = state1;
+
+        // 16 groups of 4 rounds with the schedule expanded one group ahead.
+#pragma GCC unroll 16
+        for (int g = 0; g < 16; ++g) {
+            if (g < 4) {
+                m[g] = _mm_shuffle_epi8
+                    (_mm_loadu_si128((const __m128i *)(data + g * 16)), mask);
+            }
+            __m128i msg = _mm_add_epi32
+                (m[g & 3], _mm_load_si128((const __m128i *)(sha256HardwareK + g * 4)));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            if (g >= 3 && g <= 14) {
+                tmp = _mm_alignr_epi8(m[g & 3], m[(g + 3) & 3], 4);
+                m[(g + 1) & 3] = _mm_add_epi32(m[(g + 1) & 3], tmp);
+                m[(g + 1) & 3] = _mm_sha256msg2_epu32(m[(g + 1) & 3], m[g & 3]);
+            }
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+            if (g >= 1 && g <= 12)
+                m[(g + 3) & 3] = _mm_sha256msg1_epu32(m[(g + 3) & 3], m[g & 3]);
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+        data += 64;
+    }
+
+    // Back from ABEF/CDGH to ABCD/EFGH.
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i *)h, state0);
+    _mm_storeu_si128((__m128i *)(h + 4), state1);
+}
+
+#elif defined(CRYPTO_SHA_HW_ARM)
+
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+// The instructions are optional even on ARMv8-A cores, so ask the kernel.
+static bool detectSHAExtension(unsigned long bit)
+{
+#if defined(__linux__)
+    return (getauxval(AT_HWCAP) & bit) != 0;
+#else
+    (void)bit;
+    return true;
+#endif
+}
+
+bool sha1HardwareAvailable()
+{
+#if defined(__linux__)
+    static const bool available = detectSHAExtension(HWCAP_SHA1);
+#else
+    static const bool available = detectSHAExtension(0);
+#endif
+    return available;
+}
+
+bool sha256HardwareAvailable()
+{
+#if defined(__linux__)
+    static const bool available = detectSHAExtension(HWCAP_SHA2);
+#else
+    static const bool available = detectSHAExtension(0);
+#endif
+    return available;
+}
+
+static inline uint32x4_t loadBigEndian(const uint8_t *data)
+{
+    return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data)));
+}
+
+void sha1HardwareCompress(uint32_t h[5], const uint8_t *data, size_t blocks)
+{
+    static const uint32_t k[4] = {0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6};
+    uint32x4_t abcd = vld1q_u32(h);
+    uint32_t e = h[4];
+    uint32x4_t m[4];
+
+    while (blocks-- > 0) {
+        uint32x4_t abcdSave = abcd;
+        uint32_t eSave = e;
+
+        for (int g = 0; g < 4; ++g)
+            m[g] = loadBigEndian(data + g * 16);
+
+        // 20 groups of 4 rounds with the schedule expanded one group ahead.
+#pragma GCC unroll 20
+        for (int g = 0; g < 20; ++g) {
+            uint32x4_t w = vaddq_u32(m[g & 3], vdupq_n_u32(k[g / 5]));
+            uint32_t next = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+            if (g < 5)
+                abcd = vsha1cq_u32(abcd, e, w);
+            else if (g < 10 || g >= 15)
+                abcd = vsha1pq_u32(abcd, e, w);
+            else
+                abcd = vsha1mq_u32(abcd, e, w);
+            e = next;
+            if (g >= 3 && g <= 18) {
+                m[(g + 1) & 3] = vsha1su1q_u32
+                    (vsha1su0q_u32(m[(g + 1) & 3], m[(g + 2) & 3], m[(g + 3) & 3]),
+                     m[g & 3]);
+            }
+        }
+
+        abcd = vaddq_u32(abcd, abcdSave);
+        e += eSave;
+        data += 64;
+    }
+
+    vst1q_u32(h, abcd);
+    h[4] = e;
+}
+
+void sha256HardwareCompress(uint32_t h[8], const uint8_t *data, size_t blocks)
+{
+    uint32x4_t state0 = vld1q_u32(h);
+    uint32x4_t state1 = vld1q_u32(h + 4);
+    uint32x4_t m[4];
+
+    while (blocks-- > 0) {
+        uint32x4_t abcdSave = state0;
+        uint32x4_t efghSave = state1;
+
+        for (int g = 0; g < 4; ++g)
+            m[g] = loadBigEndian(data + g * 16);
+
+        // 16 groups of 4 rounds with the schedule expanded four groups ahead.
+#pragma GCC unroll 16
+        for (int g = 0; g < 16; ++g) {
+            uint32x4_t w = vaddq_u32(m[g & 3], vld1q_u32(sha256HardwareK + g * 4));
+            uint32x4_t tmp = state0;
+            if (g < 12)
+                m[g & 3] = vsha256su0q_u32(m[g & 3], m[(g + 1) & 3]);
+            state0 = vsha256hq_u32(state0, state1, w);
+            state1 = vsha256h2q_u32(state1, tmp, w);
+            if (g < 12)
+                m[g & 3] = vsha256su1q_u32(m[g & 3], m[(g + 2) & 3], m[(g + 3) & 3]);
+        }
+
+        state0 = vaddq_u32(state0, abcdSave);
+        state1 = vaddq_u32(state1, efghSave);
+        data += 64;
+    }
+
+    vst1q_u32(h, state0);
+    vst1q_u32(h + 4, state1);
+}
+
+#endif // CRYPTO_SHA_HW_ARM
+
+#endif // CRYPTO_SHA_HW
@@ -47,8 +47,18 @@ protected:
 private:
     KeccakCore core;
     bool finalized;
+
+    friend void updateBatch(SHAKE *const xofs[], const void *const data[],
+                            const size_t len[], size_t count);
+    friend void extendBatch(SHAKE *const xofs[], uint8_t *const data[],
+                            size_t len, size_t count);
 };
 
+void updateBatch(SHAKE *const xofs[], const void *const data[],
+                 const size_t len[], size_t count);
+void extendBatch(SHAKE *const xofs[], uint8_t *const data[],
+                 size_t len, size_t count);
+
 class SHAKE128 : public SHAKE
 {
 public:
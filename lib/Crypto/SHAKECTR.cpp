@@ -0,0 +1,399 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "SHAKECTR.h"
+#include "Crypto.h"
+#include <string.h>
+
+/**
+ * \class SHAKECTR SHAKECTR.h <SHAKECTR.h>
+ * \brief Abstract base class for stream ciphers built from SHAKE in
+ * counter mode.
+ *
+ * SHAKE::encrypt() produces its keystream by squeezing one sponge from
+ * the start, so reaching byte N means generating every byte before it.
+ * This class instead derives every block of the keystream separately,
+ * which lets any part of a message be encrypted or decrypted on its own.
+ *
+ * The key and IV are formatted into a prefix block of blockSize() bytes:
+ * the key length, the key, the IV length and the IV, padded with zeroes.
+ * Block i of the keystream is the first blockSize() bytes of SHAKE applied
+ * to the prefix block followed by i as a 64-bit little-endian value.
+ * The sponge state after the prefix block is computed once, when the key
+ * or IV is set, so each keystream block costs one permutation, the same
+ * as sequential squeezing.  On hosts with SIMD support neighbouring blocks
+ * are generated side by side with KeccakCore::updateBatch() and friends.
+ *
+ * encrypt() and decrypt() work through the keystream in order from
+ * position(), which seek() moves.  encryptAt() and decryptAt() take the
+ * offset explicitly and do not modify the object, so several threads can
+ * share one keyed object, or hand a ThreadPool to spread a large buffer
+ * over its workers.  Never reuse a key and IV pair for two messages.
+ *
+ * \sa SHAKE128CTR, SHAKE256CTR, SHAKE
+ */
+
+/**
+ * \class SHAKE128CTR SHAKECTR.h <SHAKECTR.h>
+ * \brief SHAKE128 in counter mode, with 168-byte keystream blocks.
+ *
+ * \sa SHAKE256CTR
+ */
+
+/**
+ * \class SHAKE256CTR SHAKECTR.h <SHAKECTR.h>
+ * \brief SHAKE256 in counter mode, with 136-byte keystream blocks.
+ *
+ * \sa SHAKE128CTR
+ */
+
+// Keystream blocks generated per call to KeccakCore's batch functions.
+// crypt() needs about 400 bytes of stack per block (a KeccakCore, up to
+// 168 bytes of keystream and the pointers), on every thread that runs it:
+// about 3.3K for the host default of 8, which fills the widest multi-buffer
+// Keccak.  Arduino builds do one block at a time.
+#if !defined(SHAKECTR_BATCH)
+#if defined(ARDUINO) || defined(__AVR__)
+#define SHAKECTR_BATCH 1
+#else
+#define SHAKECTR_BATCH 8
+#endif
+#endif
+
+// Bytes of the message handed to each thread pool task by encryptAt().
+#define SHAKECTR_CHUNK_SIZE 65536
+
+/**
+ * \brief Constructs a SHAKE counter mode cipher.
+ *
+ * \param capacity The capacity of the Keccak sponge function in bits,
+ * 256 for SHAKE128 or 512 for SHAKE256.
+ */
+SHAKECTR::SHAKECTR(size_t capacity)
+    : posn(0)
+    , streamBlock(0)
+    , keyLen(0)
+    , ivLen(0)
+    , streamValid(false)
+{
+    prefix.setCapacity(capacity);
+    rekey();
+}
+
+/**
+ * \brief Destroys this cipher object after clearing sensitive information.
+ */
+SHAKECTR::~SHAKECTR()
+{
+    clean(key);
+    clean(iv);
+    clean(stream);
+}
+
+/**
+ * \brief Returns the recommended key size, 16 bytes for SHAKE128CTR and
+ * 32 bytes for SHAKE256CTR.
+ *
+ * Any key of up to MAX_KEY_SIZE bytes is accepted by setKey().
+ */
+size_t SHAKECTR::keySize() const
+{
+    return prefix.capacity() / 16;
+}
+
+/**
+ * \brief Returns the recommended IV size of 16 bytes.
+ *
+ * Any IV of up to MAX_IV_SIZE bytes is accepted by setIV().
+ */
+size_t SHAKECTR::ivSize() const
+{
+    return 16;
+}
+
+/**
+ * \brief Sets the key to use for future encryption and decryption
+ * operations.
+ *
+ * \param key The key to use.
+ * \param len The length of the key in bytes, up to MAX_KEY_SIZE.
+ * \return Returns false if \a len is too long.
+ *
+ * The IV is kept and the position is reset to the start of the stream.
+ *
+ * \sa setIV()
+ */
+bool SHAKECTR::setKey(const uint8_t *key, size_t len)
+{
+    if (len > MAX_KEY_SIZE)
+        return false;
+    memcpy(this->key, key, len);
+    keyLen = len;
+    rekey();
+    return true;
+}
+
+/**
+ * \brief Sets the IV to use for future encryption and decryption
+ * operations.
+ *
+ * \param iv The IV to use.
+ * \param len The length of the IV in bytes, up to MAX_IV_SIZE.
+ * \return Returns false if \a len is too long.
+ *
+ * The position is reset to the start of the stream.
+ *
+ * \sa setKey(), seek()
+ */
+bool SHAKECTR::setIV(const uint8_t *iv, size_t len)
+{
+    if (len > MAX_IV_SIZE)
+        return false;
+    memcpy(this->iv, iv, len);
+    ivLen = len;
+    rekey();
+    return true;
+}
+
+/**
+ * \brief Moves the position in the keystream for encrypt() and decrypt().
+ *
+ * \param offset The byte offset from the start of the stream.
+ *
+ * \sa position(), encryptAt()
+ */
+void SHAKECTR::seek(uint64_t offset)
+{
+    posn = offset;
+}
+
+/**
+ * \fn uint64_t SHAKECTR::position() const
+ * \brief Returns the byte offset in the keystream that the next call to
+ * encrypt() or decrypt() will start at.
+ *
+ * \sa seek()
+ */
+
+void SHAKECTR::encrypt(uint8_t *output, const uint8_t *input, size_t len)
+{
+    size_t rate = prefix.blockSize();
+    while (len > 0) {
+        uint64_t block = posn / rate;
+        size_t skip = (size_t)(posn % rate);
+        size_t size;
+        if (!skip && len >= rate) {
+            // Whole blocks are generated in batches.
+            size = len - (len % rate);
+            crypt(posn, output, input, size);
+        } else {
+            // Keep the block that is being worked through so that small
+            // requests do not regenerate it.
+            if (!streamValid || streamBlock != block) {
+                crypt(block * rate, stream, 0, rate);
+                streamBlock = block;
+                streamValid = true;
+            }
+            size = rate - skip;
+            if (size > len)
+                size = len;
+            for (size_t index = 0; index < size; ++index)
+                output[index] = input[index] ^ stream[skip + index];
+        }
+        posn += size;
+        output += size;
+        input += size;
+        len -= size;
+    }
+}
+
+void SHAKECTR::decrypt(uint8_t *output, const uint8_t *input, size_t len)
+{
+    encrypt(output, input, len);
+}
+
+/**
+ * \brief Encrypts data starting at a specific offset in the keystream.
+ *
+ * \param offset The byte offset in the keystream of the first byte of
+ * \a input.
+ * \param output The output buffer to write to, which may be the same
+ * buffer as \a input.
+ * \param input The input buffer to read from.
+ * \param len The number of bytes to encrypt.
+ * \param pool Optional thread pool to spread the work over.  Ignored on
+ * platforms without threads.
+ *
+ * This function does not change position() or any other part of the
+ * object, so it may be called from several threads at once.
+ *
+ * \sa decryptAt(), encrypt(), seek()
+ */
+void SHAKECTR::encryptAt(uint64_t offset, uint8_t *output, const uint8_t *input,
+                         size_t len, ThreadPool *pool) const
+{
+#if CRYPTO_THREADS
+    if (pool && pool->size() > 1 && len > SHAKECTR_CHUNK_SIZE) {
+        BulkJob job;
+        size_t rate = prefix.blockSize();
+        job.cipher = this;
+        job.offset = offset;
+        job.output = output;
+        job.input = input;
+        job.len = len;
+        job.chunkSize = (SHAKECTR_CHUNK_SIZE / rate) * rate;
+        pool->run(cryptChunk, &job, (len + job.chunkSize - 1) / job.chunkSize);
+        return;
+    }
+#else
+    (void)pool;
+#endif
+    crypt(offset, output, input, len);
+}
+
+/**
+ * \brief Decrypts data starting at a specific offset in the keystream.
+ *
+ * \param offset The byte offset in the keystream of the first byte of
+ * \a input.
+ * \param output The output buffer to write to, which may be the same
+ * buffer as \a input.
+ * \param input The input buffer to read from.
+ * \param len The number of bytes to decrypt.
+ * \param pool Optional thread pool to spread the work over.
+ *
+ * This is the same as encryptAt().  A single record in the middle of a
+ * large encrypted file can be read by passing its offset, without
+ * generating the keystream before it.
+ *
+ * \sa encryptAt()
+ */
+void SHAKECTR::decryptAt(uint64_t offset, uint8_t *output, const uint8_t *input,
+                         size_t len, ThreadPool *pool) const
+{
+    encryptAt(offset, output, input, len, pool);
+}
+
+void SHAKECTR::clear()
+{
+    prefix.clear();
+    clean(key);
+    clean(iv);
+    clean(stream);
+    keyLen = 0;
+    ivLen = 0;
+    posn = 0;
+    streamValid = false;
+}
+
+/**
+ * \brief Absorbs the prefix block for the current key and IV and
+ * rewinds to the start of the stream.
+ */
+void SHAKECTR::rekey()
+{
+    uint8_t block[168];
+    size_t rate = prefix.blockSize();
+    memset(block, 0, rate);
+    block[0] = keyLen;
+    memcpy(block + 1, key, keyLen);
+    block[1 + keyLen] = ivLen;
+    memcpy(block + 2 + keyLen, iv, ivLen);
+    prefix.reset();
+    prefix.update(block, rate);
+    clean(block);
+    posn = 0;
+    streamValid = false;
+}
+
+/**
+ * \brief XOR's the keystream starting at \a offset with \a input, or
+ * copies the keystream to \a output if \a input is NULL.
+ */
+void SHAKECTR::crypt(uint64_t offset, uint8_t *output, const uint8_t *input,
+                     size_t len) const
+{
+    KeccakCore cores[SHAKECTR_BATCH];
+    KeccakCore *ptrs[SHAKECTR_BATCH];
+    uint8_t counters[SHAKECTR_BATCH][8];
+    const void *data[SHAKECTR_BATCH];
+    size_t counterLen[SHAKECTR_BATCH];
+    void *out[SHAKECTR_BATCH];
+    uint8_t buffer[SHAKECTR_BATCH * 168];
+    size_t rate = prefix.blockSize();
+    uint64_t block = offset / rate;
+    size_t skip = (size_t)(offset % rate);
+    while (len > 0) {
+        // Generate the next run of keystream blocks side by side.
+        size_t blocks = (skip + len + rate - 1) / rate;
+        if (blocks > SHAKECTR_BATCH)
+            blocks = SHAKECTR_BATCH;
+        for (size_t index = 0; index < blocks; ++index) {
+            uint64_t counter = block + index;
+            for (uint8_t posn = 0; posn < 8; ++posn, counter >>= 8)
+                counters[index][posn] = (uint8_t)counter;
+            cores[index] = prefix;
+            ptrs[index] = &cores[index];
+            data[index] = counters[index];
+            counterLen[index] = 8;
+            out[index] = buffer + index * rate;
+        }
+        KeccakCore::updateBatch(ptrs, data, counterLen, blocks);
+        KeccakCore::padBatch(ptrs, 0x1F, blocks);
+        KeccakCore::extractBatch(ptrs, out, rate, blocks);
+
+        // Combine it with the input.
+        size_t size = blocks * rate - skip;
+        if (size > len)
+            size = len;
+        if (input) {
+            for (size_t index = 0; index < size; ++index)
+                output[index] = input[index] ^ buffer[skip + index];
+            input += size;
+        } else {
+            memcpy(output, buffer + skip, size);
+        }
+        block += blocks;
+        skip = 0;
+        output += size;
+        len -= size;
+    }
+    clean(buffer);
+}
+
+void SHAKECTR::cryptChunk(void *arg, size_t index)
+{
+    const BulkJob *job = (const BulkJob *)arg;
+    size_t start = index * job->chunkSize;
+    size_t len = job->len - start;
+    if (len > job->chunkSize)
+        len = job->chunkSize;
+    job->cipher->crypt(job->offset + start, job->output + start,
+                       job->input + start, len);
+}
+
+SHAKE128CTR::~SHAKE128CTR()
+{
+}
+
+SHAKE256CTR::~SHAKE256CTR()
+{
+}
@@ -0,0 +1,100 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_SHAKECTR_h
+#define CRYPTO_SHAKECTR_h
+
+#include "Cipher.h"
+#include "KeccakCore.h"
+#include "ThreadPool.h"
+
+class SHAKECTR : public Cipher
+{
+public:
+    virtual ~SHAKECTR();
+
+    size_t keySize() const;
+    size_t ivSize() const;
+
+    bool setKey(const uint8_t *key, size_t len);
+    bool setIV(const uint8_t *iv, size_t len);
+
+    void seek(uint64_t offset);
+    uint64_t position() const { return posn; }
+
+    void encrypt(uint8_t *output, const uint8_t *input, size_t len);
+    void decrypt(uint8_t *output, const uint8_t *input, size_t len);
+
+    void encryptAt(uint64_t offset, uint8_t *output, const uint8_t *input,
+                   size_t len, ThreadPool *pool = 0) const;
+    void decryptAt(uint64_t offset, uint8_t *output, const uint8_t *input,
+                   size_t len, ThreadPool *pool = 0) const;
+
+    void clear();
+
+    static const size_t MAX_KEY_SIZE = 64;
+    static const size_t MAX_IV_SIZE = 32;
+
+protected:
+    SHAKECTR(size_t capacity);
+
+private:
+    KeccakCore prefix;
+    uint8_t key[MAX_KEY_SIZE];
+    uint8_t iv[MAX_IV_SIZE];
+    uint8_t stream[168];
+    uint64_t posn;
+    uint64_t streamBlock;
+    uint8_t keyLen;
+    uint8_t ivLen;
+    bool streamValid;
+
+    void rekey();
+    void crypt(uint64_t offset, uint8_t *output, const uint8_t *input,
+               size_t len) const;
+
+    struct BulkJob
+    {
+        const SHAKECTR *cipher;
+        uint64_t offset;
+        uint8_t *output;
+        const uint8_t *input;
+        size_t len;
+        size_t chunkSize;
+    };
+    static void cryptChunk(void *arg, size_t index);
+};
+
+class SHAKE128CTR : public SHAKECTR
+{
+public:
+    SHAKE128CTR() : SHAKECTR(256) {}
+    virtual ~SHAKE128CTR();
+};
+
+class SHAKE256CTR : public SHAKECTR
+{
+public:
+    SHAKE256CTR() : SHAKECTR(512) {}
+    virtual ~SHAKE256CTR();
+};
+
+#endif
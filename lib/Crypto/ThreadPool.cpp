@@ -0,0 +1,140 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "ThreadPool.h"
+
+#if CRYPTO_THREADS
+
+/**
+ * \class ThreadPool ThreadPool.h <ThreadPool.h>
+ * \brief Fixed set of worker threads for the bulk hashing functions.
+ *
+ * A pool is created once and passed to functions such as
+ * TreeHash::hash() that split their work into independent tasks.
+ * run() hands out task indices to the workers and to the calling thread,
+ * and returns once every task has finished.
+ *
+ * \code
+ * ThreadPool pool;     // one thread per core
+ * TreeHash<SHA256>::hash(digest, sizeof(digest), image, imageLen, &pool);
+ * \endcode
+ *
+ * Only one run() may be in progress on a pool at a time.  Thread pools
+ * are available on host builds only; see CRYPTO_THREADS in ThreadPool.h.
+ */
+
+/**
+ * \brief Creates a thread pool.
+ *
+ * \param threads Total number of threads to run tasks on, including the
+ * thread that calls run().  Zero means one per core.
+ */
+ThreadPool::ThreadPool(size_t threads)
+    : func(0)
+    , arg(0)
+    , count(0)
+    , next(0)
+    , active(0)
+    , generation(0)
+    , stopping(false)
+{
+    if (!threads)
+        threads = std::thread::hardware_concurrency();
+    for (size_t posn = 1; posn < threads; ++posn)
+        workers.push_back(std::thread(&ThreadPool::worker, this));
+}
+
+/**
+ * \brief Stops and joins the worker threads.
+ */
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (size_t posn = 0; posn < workers.size(); ++posn)
+        workers[posn].join();
+}
+
+/**
+ * \fn size_t ThreadPool::size() const
+ * \brief Returns the number of threads that run tasks, including the
+ * thread that calls run().
+ */
+
+/**
+ * \brief Runs a set of tasks on the pool and waits for them to finish.
+ *
+ * \param func Function to call for each task.
+ * \param arg Argument to pass to \a func.
+ * \param count Number of tasks; \a func is called once with each index
+ * from 0 to \a count - 1, in no particular order and on any thread.
+ */
+void ThreadPool::run(void (*func)(void *arg, size_t index), void *arg, size_t count)
+{
+    if (workers.empty() || count <= 1) {
+        for (size_t index = 0; index < count; ++index)
+            func(arg, index);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->func = func;
+        this->arg = arg;
+        this->count = count;
+        next = 0;
+        active = workers.size();
+        ++generation;
+    }
+    wake.notify_all();
+    work();
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return active == 0; });
+}
+
+void ThreadPool::worker()
+{
+    unsigned long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+        work();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--active == 0)
+            idle.notify_one();
+    }
+}
+
+void ThreadPool::work()
+{
+    size_t index;
+    while ((index = next.fetch_add(1)) < count)
+        func(arg, index);
+}
+
+#endif // CRYPTO_THREADS
@@ -0,0 +1,79 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_THREADPOOL_h
+#define CRYPTO_THREADPOOL_h
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// Worker threads for the bulk hashing functions on host builds.  Arduino
+// builds have no threads; define CRYPTO_THREADS to 0 to leave them out
+// elsewhere too.
+#if !defined(CRYPTO_THREADS)
+#if defined(ARDUINO) || defined(__AVR__)
+#define CRYPTO_THREADS 0
+#else
+#define CRYPTO_THREADS 1
+#endif
+#endif
+
+#if CRYPTO_THREADS
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    size_t size() const { return workers.size() + 1; }
+
+    void run(void (*func)(void *arg, size_t index), void *arg, size_t count);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    void (*func)(void *arg, size_t index);
+    void *arg;
+    size_t count;
+    std::atomic<size_t> next;
+    size_t active;
+    unsigned long generation;
+    bool stopping;
+
+    void worker();
+    void work();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+};
+
+#endif // CRYPTO_THREADS
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "TreeHash.h"
+
+/**
+ * \class TreeHash TreeHash.h <TreeHash.h>
+ * \brief Tree hashing mode that splits a message into fixed-size leaves.
+ *
+ * A plain hash has to process a message one block after another.
+ * TreeHash hashes each leaf of the message independently and combines
+ * the leaf digests in a binary tree, so that the leaves of a large
+ * firmware image or log file can be hashed on several cores at once with
+ * hash().  The incremental update() interface gives the same result and
+ * needs only T plus one digest per level of the tree in memory.
+ *
+ * The template parameter T is the underlying hash algorithm, normally
+ * SHA256, BLAKE2s or BLAKE2b.  With H() as T and a leaf size of L bytes,
+ * the message is split into leaves of L bytes, the last of which may be
+ * shorter, and:
+ *
+ * \li leaf = H(0x00 || leaf data); an empty message has one empty leaf.
+ * \li node = H(0x01 || left || right); for n leaves the left subtree
+ * holds the largest power of two less than n, as in RFC 6962.
+ * \li result = H(0x02 || L as 32-bit little-endian || message length in
+ * bytes as 64-bit little-endian || root), where root is the node at the
+ * top of the tree or the only leaf.
+ *
+ * The result differs from T's own hash of the message and also depends
+ * on the leaf size, so the leaf size is part of the algorithm choice and
+ * must be the same when the value is checked.
+ *
+ * \code
+ * ThreadPool pool;
+ * uint8_t digest[32];
+ * TreeHash<SHA256>::hash(digest, sizeof(digest), image, imageLen, &pool);
+ *
+ * TreeHash<SHA256> hash;
+ * while ((len = readImage(buf, sizeof(buf))) > 0)
+ *     hash.update(buf, len);
+ * hash.finalize(digest, sizeof(digest));
+ * \endcode
+ *
+ * \sa ThreadPool
+ */
+
+/**
+ * \fn TreeHash::TreeHash(size_t leafSize)
+ * \brief Constructs a tree hash object.
+ *
+ * \param leafSize Number of message bytes in each leaf, which defaults
+ * to TREEHASH_LEAF_SIZE (64K).  Zero selects the default.
+ */
+
+/**
+ * \fn TreeHash::~TreeHash()
+ * \brief Destroys this tree hash object after clearing sensitive
+ * information.
+ */
+
+/**
+ * \fn size_t TreeHash::hashSize() const
+ * \brief Returns the size of the result, which is the hash size of T.
+ */
+
+/**
+ * \fn size_t TreeHash::blockSize() const
+ * \brief Returns the block size of T.
+ */
+
+/**
+ * \fn size_t TreeHash::leafSize() const
+ * \brief Returns the number of message bytes in each leaf.
+ */
+
+/**
+ * \fn void TreeHash::reset()
+ * \brief Resets the tree hash ready for a new message.
+ */
+
+/**
+ * \fn void TreeHash::update(const void *data, size_t len)
+ * \brief Adds data to the message being hashed.
+ *
+ * \param data Points to the data.
+ * \param len Number of bytes of \a data.
+ *
+ * Each leaf is finished as soon as it is full, so the object only holds
+ * the part of the current leaf that T has buffered.
+ */
+
+/**
+ * \fn void TreeHash::finalize(void *hash, size_t len)
+ * \brief Finalizes the tree and returns the result.
+ *
+ * \param hash The buffer to return the result in.
+ * \param len The length of the \a hash buffer, normally hashSize().
+ *
+ * reset() must be called before the object is used for another message.
+ */
+
+/**
+ * \fn void TreeHash::clear()
+ * \brief Clears the hash state, removing all sensitive data, and then
+ * resets the tree hash ready for a new message.
+ */
+
+/**
+ * \fn void TreeHash::resetHMAC(const void *key, size_t keyLen)
+ * \brief Resets the tree hash for a new HMAC hashing process.
+ *
+ * \param key Points to the HMAC key.
+ * \param keyLen Length of the \a key in bytes.
+ *
+ * The tree hash is used as the hash function H of HMAC, with a block
+ * size of T::BLOCK_SIZE.
+ */
+
+/**
+ * \fn void TreeHash::finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen)
+ * \brief Finalizes the HMAC hashing process and returns the result.
+ *
+ * \param key Points to the HMAC key.
+ * \param keyLen Length of the \a key in bytes.
+ * \param hash The buffer to return the HMAC value in.
+ * \param hashLen The length of the \a hash buffer.
+ */
+
+/**
+ * \fn void TreeHash::hash(void *out, size_t outLen, const void *data, size_t len, ThreadPool *pool, size_t leafSize)
+ * \brief Computes the tree hash of a message that is already in memory.
+ *
+ * \param out The buffer to return the result in.
+ * \param outLen The length of the \a out buffer, normally T::HASH_SIZE.
+ * \param data Points to the message.
+ * \param len Length of the message in bytes.
+ * \param pool Thread pool to hash the leaves on, or NULL to hash them on
+ * the calling thread.
+ * \param leafSize Number of message bytes in each leaf.
+ *
+ * The result is the same as from update() and finalize() with the same
+ * leaf size.  With a pool, the leaf digests are collected in a temporary
+ * array of T::HASH_SIZE bytes per leaf and then combined on the calling
+ * thread.
+ */
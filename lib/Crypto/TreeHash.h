@@ -0,0 +1,291 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_TREEHASH_h
+#define CRYPTO_TREEHASH_h
+
+#include "Hash.h"
+#include "Crypto.h"
+#include "ThreadPool.h"
+#include <string.h>
+
+// Default number of message bytes in each leaf of the tree.
+#ifndef TREEHASH_LEAF_SIZE
+#define TREEHASH_LEAF_SIZE 65536
+#endif
+
+// Number of subtree digests that can be pending, which limits a message
+// to 2^TREEHASH_MAX_DEPTH - 1 leaves.
+#ifndef TREEHASH_MAX_DEPTH
+#define TREEHASH_MAX_DEPTH 40
+#endif
+
+template <typename T>
+class TreeHash : public Hash
+{
+public:
+    explicit TreeHash(size_t leafSize = TREEHASH_LEAF_SIZE);
+    virtual ~TreeHash();
+
+    size_t hashSize() const { return T::HASH_SIZE; }
+    size_t blockSize() const { return T::BLOCK_SIZE; }
+    size_t leafSize() const { return leafLen; }
+
+    void reset();
+    void update(const void *data, size_t len);
+    void finalize(void *hash, size_t len);
+
+    void clear();
+
+    void resetHMAC(const void *key, size_t keyLen);
+    void finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen);
+
+    static void hash(void *out, size_t outLen, const void *data, size_t len,
+                     ThreadPool *pool = 0, size_t leafSize = TREEHASH_LEAF_SIZE);
+
+    static const size_t HASH_SIZE  = T::HASH_SIZE;
+    static const size_t BLOCK_SIZE = T::BLOCK_SIZE;
+
+private:
+    T leaf;
+    T node;
+    uint8_t stack[TREEHASH_MAX_DEPTH][T::HASH_SIZE];
+    uint64_t length;
+    uint64_t leaves;
+    size_t leafLen;
+    size_t leafPosn;
+    uint8_t depth;
+    bool inLeaf;
+
+    void finishLeaf();
+    void pushLeaf(const uint8_t *digest);
+    void merge();
+
+    struct BulkJob
+    {
+        const uint8_t *data;
+        size_t len;
+        size_t leafSize;
+        uint8_t *digests;
+    };
+    static void hashLeaf(void *arg, size_t index);
+
+    enum
+    {
+        LeafPrefix = 0x00,
+        NodePrefix = 0x01,
+        RootPrefix = 0x02
+    };
+};
+
+template <typename T>
+TreeHash<T>::TreeHash(size_t leafSize)
+    : leafLen(leafSize ? leafSize : TREEHASH_LEAF_SIZE)
+{
+    reset();
+}
+
+template <typename T>
+TreeHash<T>::~TreeHash()
+{
+    ::clean(stack, sizeof(stack));
+}
+
+template <typename T>
+void TreeHash<T>::reset()
+{
+    length = 0;
+    leaves = 0;
+    leafPosn = 0;
+    depth = 0;
+    inLeaf = false;
+}
+
+template <typename T>
+void TreeHash<T>::update(const void *data, size_t len)
+{
+    const uint8_t *d = (const uint8_t *)data;
+    length += len;
+    while (len > 0) {
+        if (!inLeaf) {
+            uint8_t prefix = LeafPrefix;
+            leaf.reset();
+            leaf.update(&prefix, 1);
+            leafPosn = 0;
+            inLeaf = true;
+        }
+        size_t size = leafLen - leafPosn;
+        if (size > len)
+            size = len;
+        leaf.update(d, size);
+        leafPosn += size;
+        d += size;
+        len -= size;
+        if (leafPosn == leafLen)
+            finishLeaf();
+    }
+}
+
+template <typename T>
+void TreeHash<T>::finalize(void *hash, size_t len)
+{
+    // The empty message is a single empty leaf.
+    if (inLeaf || !leaves) {
+        if (!inLeaf) {
+            uint8_t prefix = LeafPrefix;
+            leaf.reset();
+            leaf.update(&prefix, 1);
+        }
+        finishLeaf();
+    }
+
+    // Fold the pending subtrees from the right, which gives the same
+    // left-balanced shape as RFC 6962.
+    while (depth > 1)
+        merge();
+
+    // Bind the leaf size and the message length into the result so that
+    // trees with different shapes cannot collide.
+    uint8_t root[13];
+    root[0] = RootPrefix;
+    for (uint8_t posn = 0; posn < 4; ++posn)
+        root[1 + posn] = (uint8_t)(((uint32_t)leafLen) >> (posn * 8));
+    for (uint8_t posn = 0; posn < 8; ++posn)
+        root[5 + posn] = (uint8_t)(length >> (posn * 8));
+    node.reset();
+    node.update(root, sizeof(root));
+    node.update(stack[0], T::HASH_SIZE);
+    node.finalize(hash, len);
+}
+
+template <typename T>
+void TreeHash<T>::clear()
+{
+    leaf.clear();
+    node.clear();
+    ::clean(stack, sizeof(stack));
+    reset();
+}
+
+template <typename T>
+void TreeHash<T>::resetHMAC(const void *key, size_t keyLen)
+{
+    uint8_t block[T::BLOCK_SIZE];
+    formatHMACKey(block, key, keyLen, 0x36);
+    update(block, sizeof(block));
+    ::clean(block, sizeof(block));
+}
+
+template <typename T>
+void TreeHash<T>::finalizeHMAC(const void *key, size_t keyLen, void *hash, size_t hashLen)
+{
+    uint8_t block[T::BLOCK_SIZE];
+    uint8_t temp[T::HASH_SIZE];
+    finalize(temp, sizeof(temp));
+    formatHMACKey(block, key, keyLen, 0x5C);
+    update(block, sizeof(block));
+    update(temp, sizeof(temp));
+    finalize(hash, hashLen);
+    ::clean(block, sizeof(block));
+    ::clean(temp, sizeof(temp));
+}
+
+template <typename T>
+void TreeHash<T>::hash(void *out, size_t outLen, const void *data, size_t len,
+                       ThreadPool *pool, size_t leafSize)
+{
+    TreeHash<T> context(leafSize);
+#if CRYPTO_THREADS
+    size_t count = (len + context.leafLen - 1) / context.leafLen;
+    if (pool && pool->size() > 1 && count > 1) {
+        BulkJob job;
+        job.data = (const uint8_t *)data;
+        job.len = len;
+        job.leafSize = context.leafLen;
+        job.digests = new uint8_t [count * T::HASH_SIZE];
+        pool->run(hashLeaf, &job, count);
+        for (size_t index = 0; index < count; ++index)
+            context.pushLeaf(job.digests + index * T::HASH_SIZE);
+        context.length = len;
+        ::clean(job.digests, count * T::HASH_SIZE);
+        delete [] job.digests;
+        context.finalize(out, outLen);
+        return;
+    }
+#else
+    (void)pool;
+#endif
+    context.update(data, len);
+    context.finalize(out, outLen);
+}
+
+template <typename T>
+void TreeHash<T>::finishLeaf()
+{
+    uint8_t digest[T::HASH_SIZE];
+    leaf.finalize(digest, sizeof(digest));
+    pushLeaf(digest);
+    inLeaf = false;
+    ::clean(digest, sizeof(digest));
+}
+
+template <typename T>
+void TreeHash<T>::pushLeaf(const uint8_t *digest)
+{
+    // Merge every subtree that the new leaf completes, so that the stack
+    // holds one digest per set bit of the leaf count.
+    memcpy(stack[depth++], digest, T::HASH_SIZE);
+    uint64_t count = ++leaves;
+    while (!(count & 1)) {
+        merge();
+        count >>= 1;
+    }
+}
+
+template <typename T>
+void TreeHash<T>::merge()
+{
+    uint8_t prefix = NodePrefix;
+    node.reset();
+    node.update(&prefix, 1);
+    node.update(stack[depth - 2], T::HASH_SIZE);
+    node.update(stack[depth - 1], T::HASH_SIZE);
+    node.finalize(stack[depth - 2], T::HASH_SIZE);
+    --depth;
+}
+
+template <typename T>
+void TreeHash<T>::hashLeaf(void *arg, size_t index)
+{
+    const BulkJob *job = (const BulkJob *)arg;
+    size_t posn = index * job->leafSize;
+    size_t size = job->len - posn;
+    if (size > job->leafSize)
+        size = job->leafSize;
+    uint8_t prefix = LeafPrefix;
+    T leafHash;
+    leafHash.reset();
+    leafHash.update(&prefix, 1);
+    leafHash.update(job->data + posn, size);
+    leafHash.finalize(job->digests + index * T::HASH_SIZE, T::HASH_SIZE);
+}
+
+#endif
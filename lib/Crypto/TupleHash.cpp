@@ -0,0 +1,125 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "TupleHash.h"
+
+/**
+ * \class TupleHash TupleHash.h <TupleHash.h>
+ * \brief Abstract base class for TupleHash from NIST SP 800-185.
+ *
+ * TupleHash hashes a sequence of byte strings so that the boundaries
+ * between them matter: ("ab", "c") and ("a", "bc") hash differently.
+ * Each call to update() adds one whole string to the tuple.
+ *
+ * The customization block is absorbed once by setCustomization() and
+ * reset() copies the saved state back.  finalize() produces TupleHash
+ * with the output length bound into the result; extend() and encrypt()
+ * produce the variable-length TupleHashXOF instead.
+ *
+ * Reference: https://doi.org/10.6028/NIST.SP.800-185
+ *
+ * \sa TupleHash128, TupleHash256, CSHAKE
+ */
+
+/**
+ * \class TupleHash128 TupleHash.h <TupleHash.h>
+ * \brief TupleHash128 hash function for sequences of byte strings.
+ *
+ * \sa TupleHash256
+ */
+
+/**
+ * \class TupleHash256 TupleHash.h <TupleHash.h>
+ * \brief TupleHash256 hash function for sequences of byte strings.
+ *
+ * \sa TupleHash128
+ */
+
+/**
+ * \brief Constructs a TupleHash object with an empty customization string.
+ *
+ * \param capacity The capacity of the Keccak sponge function in bits,
+ * 256 for TupleHash128 or 512 for TupleHash256.
+ */
+TupleHash::TupleHash(size_t capacity)
+    : CSHAKE(capacity)
+{
+    encodeLength = true;
+    setCustomization(0, 0);
+}
+
+/**
+ * \brief Destroys this TupleHash object after clearing all sensitive
+ * information.
+ */
+TupleHash::~TupleHash()
+{
+}
+
+/**
+ * \brief Sets the customization string.
+ *
+ * \param custom Points to the customization string.
+ * \param customLen Length of the customization string in bytes.
+ */
+void TupleHash::setCustomization(const void *custom, size_t customLen)
+{
+    CSHAKE::setCustomization("TupleHash", 9, custom, customLen);
+}
+
+/**
+ * \brief Adds a string to the tuple.
+ *
+ * \param data Points to the string.
+ * \param len Length of the string in bytes.
+ *
+ * Unlike other hash functions, every call adds a separate string, so
+ * the data cannot be split across several calls.
+ */
+void TupleHash::update(const void *data, size_t len)
+{
+    if (finalized)
+        reset();
+    absorbString(data, len);
+}
+
+/**
+ * \brief Finalizes the hash and returns it.
+ *
+ * \param hash The buffer to return the hash value in.
+ * \param len The length of the hash value in bytes, which is bound into
+ * the result.
+ */
+void TupleHash::finalize(void *hash, size_t len)
+{
+    if (finalized)
+        reset();
+    finish(((uint64_t)len) * 8);
+    CSHAKE::extend((uint8_t *)hash, len);
+}
+
+TupleHash128::~TupleHash128()
+{
+}
+
+TupleHash256::~TupleHash256()
+{
+}
@@ -0,0 +1,55 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_TUPLEHASH_h
+#define CRYPTO_TUPLEHASH_h
+
+#include "CSHAKE.h"
+
+class TupleHash : public CSHAKE
+{
+public:
+    virtual ~TupleHash();
+
+    void setCustomization(const void *custom, size_t customLen);
+
+    void update(const void *data, size_t len);
+    void finalize(void *hash, size_t len);
+
+protected:
+    TupleHash(size_t capacity);
+};
+
+class TupleHash128 : public TupleHash
+{
+public:
+    TupleHash128() : TupleHash(256) {}
+    virtual ~TupleHash128();
+};
+
+class TupleHash256 : public TupleHash
+{
+public:
+    TupleHash256() : TupleHash(512) {}
+    virtual ~TupleHash256();
+};
+
+#endif
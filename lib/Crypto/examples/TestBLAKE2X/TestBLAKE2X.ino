@@ -0,0 +1,326 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+This example runs tests on the BLAKE2Xs and BLAKE2Xb implementations to
+verify correct behaviour.
+*/
+
+#include <Crypto.h>
+#include <BLAKE2Xs.h>
+#include <BLAKE2Xb.h>
+#include <SHAKE.h>
+#include <string.h>
+
+#define MAX_OUTPUT_SIZE 100
+
+struct TestXOFVector
+{
+    const char *name;
+    size_t dataLen;
+    size_t keyLen;
+    uint32_t xofLen;
+    size_t outLen;
+    uint8_t output[MAX_OUTPUT_SIZE];
+};
+
+// The key is the bytes 0, 1, 2, ... up to the key length and the data is
+// the bytes 0, 1, 2, ... modulo 256.  Vectors #2 match the first entries of
+// the BLAKE2X known answer tests from the BLAKE2 reference implementation.
+static TestXOFVector const testVectorBLAKE2Xs_1 = {
+    "BLAKE2Xs #1",
+    0,
+    0,
+    32,
+    32,
+    {0xF4, 0xB3, 0x58, 0x45, 0x7E, 0x55, 0x63, 0xFB,
+     0x54, 0xDF, 0x30, 0x60, 0xAE, 0xC2, 0x6E, 0xA3,
+     0xAA, 0x1C, 0x95, 0x9C, 0xF8, 0x9F, 0x55, 0xA2,
+     0x25, 0x38, 0x11, 0x7E, 0xCF, 0x70, 0x8B, 0xFC}
+};
+static TestXOFVector const testVectorBLAKE2Xs_2 = {
+    "BLAKE2Xs #2",
+    256,
+    32,
+    1,
+    1,
+    {0x0E}
+};
+static TestXOFVector const testVectorBLAKE2Xs_3 = {
+    "BLAKE2Xs #3",
+    256,
+    32,
+    100,
+    100,
+    {0x33, 0x66, 0x86, 0x0C, 0x77, 0x80, 0x4F, 0xE0,
+     0xB4, 0xF3, 0x68, 0xB0, 0x2B, 0xB5, 0xB0, 0xD1,
+     0x50, 0x82, 0x1D, 0x95, 0x7E, 0x3B, 0xA3, 0x78,
+     0x42, 0xDA, 0x9F, 0xC8, 0xD3, 0x36, 0xE9, 0xD7,
+     0x02, 0xC8, 0x44, 0x6E, 0xCA, 0xFB, 0xD1, 0x9D,
+     0x79, 0xB8, 0x68, 0x70, 0x2F, 0x32, 0x40, 0x58,
+     0x53, 0xBC, 0x17, 0x69, 0x58, 0x73, 0xA7, 0x30,
+     0x6E, 0x0C, 0xE4, 0x57, 0x3C, 0xD9, 0xAC, 0x0B,
+     0x7F, 0xC7, 0xDD, 0x35, 0x53, 0x4D, 0x76, 0x35,
+     0x19, 0x8D, 0x15, 0x2A, 0x18, 0x02, 0xF7, 0xD8,
+     0xD6, 0xA4, 0xBB, 0x07, 0x60, 0x0F, 0xCD, 0xAA,
+     0xCF, 0xAA, 0x1C, 0x3F, 0x40, 0xA0, 0x9B, 0xC0,
+     0x2E, 0x97, 0x4C, 0x99}
+};
+static TestXOFVector const testVectorBLAKE2Xs_4 = {
+    "BLAKE2Xs #4",
+    3,
+    0,
+    BLAKE2Xs::UNKNOWN_LENGTH,
+    100,
+    {0x9B, 0xE8, 0x99, 0xB1, 0x01, 0x59, 0x49, 0x2A,
+     0xD8, 0x4A, 0xD9, 0x58, 0xD5, 0x73, 0xD6, 0x50,
+     0x6D, 0xE3, 0x09, 0xCB, 0x03, 0x1D, 0xD7, 0xDD,
+     0x46, 0x21, 0x4C, 0xBD, 0xE5, 0xA3, 0xB6, 0x98,
+     0x50, 0xDC, 0xD2, 0x7E, 0x93, 0xB3, 0x1C, 0x59,
+     0xF5, 0xEE, 0x99, 0x2E, 0x1B, 0x07, 0x11, 0x36,
+     0x41, 0x78, 0x55, 0x10, 0x96, 0x1E, 0x69, 0xFB,
+     0xFE, 0x86, 0x75, 0x94, 0x46, 0xF7, 0x48, 0x0B,
+     0x9E, 0x31, 0x40, 0xE0, 0xC7, 0x47, 0xD2, 0xC5,
+     0x72, 0x69, 0xC7, 0x2F, 0x74, 0x41, 0x70, 0x1C,
+     0x57, 0x2D, 0xC8, 0xB0, 0xE5, 0x95, 0x01, 0x43,
+     0x42, 0x9F, 0x42, 0x05, 0x21, 0x9A, 0x48, 0x1E,
+     0x36, 0xD2, 0x64, 0x12}
+};
+static TestXOFVector const testVectorBLAKE2Xb_1 = {
+    "BLAKE2Xb #1",
+    0,
+    0,
+    64,
+    64,
+    {0xC5, 0xEF, 0x3D, 0x88, 0x45, 0xB9, 0xB2, 0xBA,
+     0x8E, 0xA2, 0x8E, 0x93, 0x26, 0xC9, 0xE4, 0x6E,
+     0x7A, 0x58, 0x43, 0xAD, 0x42, 0xBA, 0xCA, 0xF9,
+     0x27, 0x79, 0x8B, 0xEA, 0xF5, 0x54, 0xA4, 0x3C,
+     0xA0, 0x83, 0x0C, 0xCF, 0x8B, 0xB4, 0xA2, 0x4C,
+     0xE1, 0xB1, 0xD8, 0x2B, 0xD2, 0xDA, 0x97, 0x1A,
+     0xFB, 0x2B, 0xE7, 0x39, 0x19, 0xCC, 0x5F, 0xFF,
+     0x8E, 0x7C, 0x6A, 0x20, 0xF8, 0x72, 0x84, 0xFA}
+};
+static TestXOFVector const testVectorBLAKE2Xb_2 = {
+    "BLAKE2Xb #2",
+    256,
+    64,
+    1,
+    1,
+    {0x64}
+};
+static TestXOFVector const testVectorBLAKE2Xb_3 = {
+    "BLAKE2Xb #3",
+    256,
+    64,
+    100,
+    100,
+    {0xCB, 0x85, 0x9B, 0x35, 0xDC, 0x70, 0xE2, 0x64,
+     0xEF, 0xAA, 0xD2, 0xA8, 0x09, 0xFE, 0xA1, 0xE7,
+     0x1C, 0xD4, 0xA3, 0xF9, 0x24, 0xBE, 0x3B, 0x5A,
+     0x13, 0xF8, 0x68, 0x7A, 0x11, 0x66, 0xB5, 0x38,
+     0xC4, 0x0B, 0x2A, 0xD5, 0x1D, 0x5C, 0x3E, 0x47,
+     0xB0, 0xDE, 0x48, 0x24, 0x97, 0x38, 0x26, 0x73,
+     0x14, 0x0F, 0x54, 0x70, 0x68, 0xFF, 0x0B, 0x3B,
+     0x0F, 0xB7, 0x50, 0x12, 0x09, 0xE1, 0xBF, 0x36,
+     0x08, 0x25, 0x09, 0xAE, 0x85, 0xF6, 0x0B, 0xB9,
+     0x8F, 0xD0, 0x2A, 0xC5, 0x0D, 0x88, 0x3A, 0x1A,
+     0x8D, 0xAA, 0x70, 0x49, 0x52, 0xD8, 0x3C, 0x1F,
+     0x6D, 0xA6, 0x0C, 0x96, 0x24, 0xBC, 0x7C, 0x99,
+     0x91, 0x29, 0x30, 0xBF}
+};
+static TestXOFVector const testVectorBLAKE2Xb_4 = {
+    "BLAKE2Xb #4",
+    3,
+    0,
+    BLAKE2Xb::UNKNOWN_LENGTH,
+    100,
+    {0x99, 0x84, 0xE2, 0x50, 0xDD, 0xD5, 0xC6, 0x37,
+     0x3E, 0xDE, 0xA4, 0xCC, 0xA3, 0xAF, 0x4E, 0xC3,
+     0xC9, 0x10, 0x8C, 0xA0, 0x60, 0xDB, 0x10, 0x92,
+     0x8C, 0x69, 0x88, 0x83, 0x44, 0x92, 0x58, 0x51,
+     0x16, 0xFF, 0x57, 0x87, 0x51, 0xCE, 0xD6, 0x34,
+     0x7A, 0xF8, 0x67, 0x77, 0x8D, 0x2B, 0xAD, 0xF7,
+     0x25, 0xDF, 0x4E, 0x02, 0x27, 0xDB, 0x45, 0xD8,
+     0x50, 0x72, 0x7F, 0xEB, 0x96, 0xF0, 0x02, 0x3B,
+     0xBD, 0x97, 0x20, 0x0F, 0xDF, 0x35, 0x3E, 0xD6,
+     0xCC, 0xB2, 0x4C, 0x9B, 0x44, 0xDF, 0x0F, 0x64,
+     0x90, 0x6C, 0x62, 0x99, 0x06, 0x50, 0x26, 0x47,
+     0xB8, 0x90, 0x67, 0xC3, 0x0B, 0x14, 0x98, 0xF8,
+     0xE1, 0x12, 0xE1, 0x92}
+};
+
+BLAKE2Xs blake2xs;
+BLAKE2Xb blake2xb;
+SHAKE128 shake128;
+SHAKE256 shake256;
+
+byte key[64];
+byte buffer[1024];
+
+void resetXOF(XOF *xof, const struct TestXOFVector *test)
+{
+    if (xof == &blake2xs)
+        blake2xs.reset(key, test->keyLen, (uint16_t)(test->xofLen));
+    else
+        blake2xb.reset(key, test->keyLen, test->xofLen);
+    xof->update(buffer, test->dataLen);
+}
+
+bool testXOF_N(XOF *xof, const struct TestXOFVector *test, size_t inc)
+{
+    size_t size = test->outLen;
+    size_t posn, len;
+    uint8_t value[MAX_OUTPUT_SIZE];
+
+    resetXOF(xof, test);
+    for (posn = 0; posn < size; posn += inc) {
+        len = size - posn;
+        if (len > inc)
+            len = inc;
+        xof->extend(value + posn, len);
+    }
+    if (memcmp(value, test->output, size) != 0)
+        return false;
+
+    return true;
+}
+
+// Seeks into the middle of the output and checks that the tail matches
+// what sequential extension produces.
+bool testXOF_Seek(XOF *xof, const struct TestXOFVector *test, size_t offset)
+{
+    uint8_t value[MAX_OUTPUT_SIZE];
+
+    if (offset > test->outLen)
+        return true;
+    resetXOF(xof, test);
+    if (xof == &blake2xs)
+        blake2xs.seek(offset);
+    else
+        blake2xb.seek(offset);
+    xof->extend(value, test->outLen - offset);
+    if (memcmp(value, test->output + offset, test->outLen - offset) != 0)
+        return false;
+
+    return true;
+}
+
+bool testXOF_Encrypt(XOF *xof, const struct TestXOFVector *test)
+{
+    uint8_t value[MAX_OUTPUT_SIZE];
+
+    resetXOF(xof, test);
+    memset(value, 0xA5, test->outLen);
+    xof->encrypt(value, value, test->outLen);
+    for (size_t posn = 0; posn < test->outLen; ++posn) {
+        if (value[posn] != (test->output[posn] ^ 0xA5))
+            return false;
+    }
+
+    return true;
+}
+
+void testXOF(XOF *xof, const struct TestXOFVector *test)
+{
+    bool ok;
+
+    Serial.print(test->name);
+    Serial.print(" ... ");
+
+    ok  = testXOF_N(xof, test, test->outLen);
+    ok &= testXOF_N(xof, test, 1);
+    ok &= testXOF_N(xof, test, 5);
+    ok &= testXOF_N(xof, test, 32);
+    ok &= testXOF_N(xof, test, 33);
+    ok &= testXOF_Seek(xof, test, 1);
+    ok &= testXOF_Seek(xof, test, 37);
+    ok &= testXOF_Seek(xof, test, 64);
+    ok &= testXOF_Encrypt(xof, test);
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+void perfExtend(XOF *xof, const char *name)
+{
+    unsigned long start;
+    unsigned long elapsed;
+    int count;
+
+    Serial.print(name);
+    Serial.print(" ... ");
+
+    xof->reset();
+    xof->update("abc", 3);
+    start = micros();
+    for (count = 0; count < 250; ++count) {
+        xof->extend(buffer, sizeof(buffer));
+    }
+    elapsed = micros() - start;
+
+    Serial.print(elapsed / (sizeof(buffer) * 250.0));
+    Serial.print("us per byte, ");
+    Serial.print((sizeof(buffer) * 250.0 * 1000000.0) / elapsed);
+    Serial.println(" bytes per second");
+}
+
+void setup()
+{
+    Serial.begin(9600);
+
+    for (size_t posn = 0; posn < sizeof(key); ++posn)
+        key[posn] = (byte)posn;
+    for (size_t posn = 0; posn < sizeof(buffer); ++posn)
+        buffer[posn] = (byte)posn;
+
+    Serial.println();
+
+    Serial.print("State Sizes ... ");
+    Serial.print(sizeof(BLAKE2Xs));
+    Serial.print(", ");
+    Serial.println(sizeof(BLAKE2Xb));
+    Serial.println();
+
+    Serial.println("Test Vectors:");
+    testXOF(&blake2xs, &testVectorBLAKE2Xs_1);
+    testXOF(&blake2xs, &testVectorBLAKE2Xs_2);
+    testXOF(&blake2xs, &testVectorBLAKE2Xs_3);
+    testXOF(&blake2xs, &testVectorBLAKE2Xs_4);
+    testXOF(&blake2xb, &testVectorBLAKE2Xb_1);
+    testXOF(&blake2xb, &testVectorBLAKE2Xb_2);
+    testXOF(&blake2xb, &testVectorBLAKE2Xb_3);
+    testXOF(&blake2xb, &testVectorBLAKE2Xb_4);
+
+    Serial.println();
+
+    Serial.println("Performance Tests:");
+    perfExtend(&blake2xs, "BLAKE2Xs Extending");
+    perfExtend(&blake2xb, "BLAKE2Xb Extending");
+    perfExtend(&shake128, "SHAKE128 Extending");
+    perfExtend(&shake256, "SHAKE256 Extending");
+}
+
+void loop()
+{
+}
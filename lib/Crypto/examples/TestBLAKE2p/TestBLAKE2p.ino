@@ -0,0 +1,276 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+This example runs tests on the BLAKE2sp and BLAKE2bp implementations to
+verify correct behaviour.
+*/
+
+#include <Crypto.h>
+#include <BLAKE2sp.h>
+#include <BLAKE2bp.h>
+#include <string.h>
+
+#define MAX_HASH_SIZE 64
+
+struct TestHashVector
+{
+    const char *name;
+    size_t dataLen;
+    size_t keyLen;
+    uint8_t hash[MAX_HASH_SIZE];
+};
+
+// The key is the bytes 0, 1, 2, ... up to the key length and the data is
+// the bytes 0, 1, 2, ... modulo 256, in the style of the keyed known answer
+// tests from the BLAKE2 reference implementation.
+static TestHashVector const testVectorBLAKE2sp_1 = {
+    "BLAKE2sp #1",
+    0,
+    32,
+    {0x71, 0x5C, 0xB1, 0x38, 0x95, 0xAE, 0xB6, 0x78,
+     0xF6, 0x12, 0x41, 0x60, 0xBF, 0xF2, 0x14, 0x65,
+     0xB3, 0x0F, 0x4F, 0x68, 0x74, 0x19, 0x3F, 0xC8,
+     0x51, 0xB4, 0x62, 0x10, 0x43, 0xF0, 0x9C, 0xC6}
+};
+static TestHashVector const testVectorBLAKE2sp_2 = {
+    "BLAKE2sp #2",
+    1,
+    32,
+    {0x40, 0x57, 0x8F, 0xFA, 0x52, 0xBF, 0x51, 0xAE,
+     0x18, 0x66, 0xF4, 0x28, 0x4D, 0x3A, 0x15, 0x7F,
+     0xC1, 0xBC, 0xD3, 0x6A, 0xC1, 0x3C, 0xBD, 0xCB,
+     0x03, 0x77, 0xE4, 0xD0, 0xCD, 0x0B, 0x66, 0x03}
+};
+static TestHashVector const testVectorBLAKE2sp_3 = {
+    "BLAKE2sp #3",
+    255,
+    32,
+    {0x0C, 0x8A, 0x36, 0x59, 0x7D, 0x74, 0x61, 0xC6,
+     0x3A, 0x94, 0x73, 0x28, 0x21, 0xC9, 0x41, 0x85,
+     0x6C, 0x66, 0x83, 0x76, 0x60, 0x6C, 0x86, 0xA5,
+     0x2D, 0xE0, 0xEE, 0x41, 0x04, 0xC6, 0x15, 0xDB}
+};
+static TestHashVector const testVectorBLAKE2sp_4 = {
+    "BLAKE2sp #4",
+    1000,
+    32,
+    {0x68, 0x6D, 0x69, 0x5F, 0x44, 0x9E, 0x51, 0x56,
+     0xD7, 0x0C, 0x54, 0xCD, 0x7C, 0x3F, 0x74, 0x0C,
+     0x92, 0x33, 0xDC, 0xA1, 0x72, 0xFF, 0xCA, 0xDB,
+     0xA9, 0x48, 0x84, 0x14, 0xDA, 0x9C, 0x14, 0x15}
+};
+static TestHashVector const testVectorBLAKE2bp_1 = {
+    "BLAKE2bp #1",
+    0,
+    64,
+    {0x9D, 0x94, 0x61, 0x07, 0x3E, 0x4E, 0xB6, 0x40,
+     0xA2, 0x55, 0x35, 0x7B, 0x83, 0x9F, 0x39, 0x4B,
+     0x83, 0x8C, 0x6F, 0xF5, 0x7C, 0x9B, 0x68, 0x6A,
+     0x3F, 0x76, 0x10, 0x7C, 0x10, 0x66, 0x72, 0x8F,
+     0x3C, 0x99, 0x56, 0xBD, 0x78, 0x5C, 0xBC, 0x3B,
+     0xF7, 0x9D, 0xC2, 0xAB, 0x57, 0x8C, 0x5A, 0x0C,
+     0x06, 0x3B, 0x9D, 0x9C, 0x40, 0x58, 0x48, 0xDE,
+     0x1D, 0xBE, 0x82, 0x1C, 0xD0, 0x5C, 0x94, 0x0A}
+};
+static TestHashVector const testVectorBLAKE2bp_2 = {
+    "BLAKE2bp #2",
+    1,
+    64,
+    {0xFF, 0x8E, 0x90, 0xA3, 0x7B, 0x94, 0x62, 0x39,
+     0x32, 0xC5, 0x9F, 0x75, 0x59, 0xF2, 0x60, 0x35,
+     0x02, 0x9C, 0x37, 0x67, 0x32, 0xCB, 0x14, 0xD4,
+     0x16, 0x02, 0x00, 0x1C, 0xBB, 0x73, 0xAD, 0xB7,
+     0x92, 0x93, 0xA2, 0xDB, 0xDA, 0x5F, 0x60, 0x70,
+     0x30, 0x25, 0x14, 0x4D, 0x15, 0x8E, 0x27, 0x35,
+     0x52, 0x95, 0x96, 0x25, 0x1C, 0x73, 0xC0, 0x34,
+     0x5C, 0xA6, 0xFC, 0xCB, 0x1F, 0xB1, 0xE9, 0x7E}
+};
+static TestHashVector const testVectorBLAKE2bp_3 = {
+    "BLAKE2bp #3",
+    255,
+    64,
+    {0x96, 0xFB, 0xCB, 0xB6, 0x0B, 0xD3, 0x13, 0xB8,
+     0x84, 0x50, 0x33, 0xE5, 0xBC, 0x05, 0x8A, 0x38,
+     0x02, 0x74, 0x38, 0x57, 0x2D, 0x7E, 0x79, 0x57,
+     0xF3, 0x68, 0x4F, 0x62, 0x68, 0xAA, 0xDD, 0x3A,
+     0xD0, 0x8D, 0x21, 0x76, 0x7E, 0xD6, 0x87, 0x86,
+     0x85, 0x33, 0x1B, 0xA9, 0x85, 0x71, 0x48, 0x7E,
+     0x12, 0x47, 0x0A, 0xAD, 0x66, 0x93, 0x26, 0x71,
+     0x6E, 0x46, 0x66, 0x7F, 0x69, 0xF8, 0xD7, 0xE8}
+};
+static TestHashVector const testVectorBLAKE2bp_4 = {
+    "BLAKE2bp #4",
+    1000,
+    64,
+    {0x10, 0xE1, 0x19, 0x19, 0x1D, 0xA5, 0x96, 0x4A,
+     0xFD, 0xBF, 0x01, 0x71, 0xF5, 0xE0, 0x62, 0xD4,
+     0x12, 0x3E, 0x6C, 0x97, 0xE7, 0x59, 0xD2, 0x0D,
+     0x03, 0x82, 0x5B, 0xE2, 0x2D, 0xEB, 0xC6, 0x94,
+     0x7E, 0xF6, 0xC0, 0x1F, 0x5F, 0xDA, 0xC9, 0xEB,
+     0x36, 0xE3, 0xB0, 0x39, 0x55, 0xFF, 0x28, 0xD6,
+     0x47, 0xCA, 0xF5, 0x64, 0xF2, 0xCB, 0x2F, 0x20,
+     0x3A, 0x0C, 0xBC, 0x90, 0xE0, 0xDD, 0x4D, 0xC3}
+};
+
+BLAKE2sp blake2sp;
+BLAKE2bp blake2bp;
+
+byte key[64];
+byte buffer[1024];
+
+bool testHash_N(Hash *hash, const struct TestHashVector *test, size_t inc)
+{
+    size_t size = test->dataLen;
+    size_t posn, len;
+    uint8_t value[MAX_HASH_SIZE];
+
+    if (hash == &blake2sp)
+        blake2sp.reset(key, test->keyLen);
+    else
+        blake2bp.reset(key, test->keyLen);
+    for (posn = 0; posn < size; posn += inc) {
+        len = size - posn;
+        if (len > inc)
+            len = inc;
+        hash->update(buffer + posn, len);
+    }
+    hash->finalize(value, sizeof(value));
+    if (memcmp(value, test->hash, hash->hashSize()) != 0)
+        return false;
+
+    return true;
+}
+
+void testHash(Hash *hash, const struct TestHashVector *test)
+{
+    bool ok;
+
+    Serial.print(test->name);
+    Serial.print(" ... ");
+
+    ok  = testHash_N(hash, test, test->dataLen + 1);
+    ok &= testHash_N(hash, test, 1);
+    ok &= testHash_N(hash, test, 2);
+    ok &= testHash_N(hash, test, 5);
+    ok &= testHash_N(hash, test, 8);
+    ok &= testHash_N(hash, test, 13);
+    ok &= testHash_N(hash, test, 16);
+    ok &= testHash_N(hash, test, 64);
+    ok &= testHash_N(hash, test, 100);
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+// Checks that the all-in-one hash() function agrees with update().
+void testAllInOne(Hash *hash, const char *name)
+{
+    static size_t const lengths[] = {0, 1, 447, 448, 449, 512, 1000, 1024};
+    uint8_t value1[MAX_HASH_SIZE];
+    uint8_t value2[MAX_HASH_SIZE];
+    bool ok = true;
+
+    Serial.print(name);
+    Serial.print(" ... ");
+
+    for (uint8_t index = 0; index < 8; ++index) {
+        size_t len = lengths[index];
+        hash->reset();
+        hash->update(buffer, len);
+        hash->finalize(value1, sizeof(value1));
+        if (hash == &blake2sp)
+            BLAKE2sp::hash(value2, sizeof(value2), buffer, len);
+        else
+            BLAKE2bp::hash(value2, sizeof(value2), buffer, len);
+        if (memcmp(value1, value2, hash->hashSize()) != 0)
+            ok = false;
+    }
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+void perfHash(Hash *hash, const char *name)
+{
+    unsigned long start;
+    unsigned long elapsed;
+    int count;
+
+    Serial.print(name);
+    Serial.print(" ... ");
+
+    hash->reset();
+    start = micros();
+    for (count = 0; count < 250; ++count) {
+        hash->update(buffer, sizeof(buffer));
+    }
+    elapsed = micros() - start;
+
+    Serial.print(elapsed / (sizeof(buffer) * 250.0));
+    Serial.print("us per byte, ");
+    Serial.print((sizeof(buffer) * 250.0 * 1000000.0) / elapsed);
+    Serial.println(" bytes per second");
+}
+
+void setup()
+{
+    Serial.begin(9600);
+
+    for (size_t posn = 0; posn < sizeof(key); ++posn)
+        key[posn] = (byte)posn;
+    for (size_t posn = 0; posn < sizeof(buffer); ++posn)
+        buffer[posn] = (byte)posn;
+
+    Serial.println();
+
+    Serial.print("State Sizes ... ");
+    Serial.print(sizeof(BLAKE2sp));
+    Serial.print(", ");
+    Serial.println(sizeof(BLAKE2bp));
+    Serial.println();
+
+    Serial.println("Test Vectors:");
+    testHash(&blake2sp, &testVectorBLAKE2sp_1);
+    testHash(&blake2sp, &testVectorBLAKE2sp_2);
+    testHash(&blake2sp, &testVectorBLAKE2sp_3);
+    testHash(&blake2sp, &testVectorBLAKE2sp_4);
+    testHash(&blake2bp, &testVectorBLAKE2bp_1);
+    testHash(&blake2bp, &testVectorBLAKE2bp_2);
+    testHash(&blake2bp, &testVectorBLAKE2bp_3);
+    testHash(&blake2bp, &testVectorBLAKE2bp_4);
+    testAllInOne(&blake2sp, "BLAKE2sp::hash");
+    testAllInOne(&blake2bp, "BLAKE2bp::hash");
+
+    Serial.println();
+
+    Serial.println("Performance Tests:");
+    perfHash(&blake2sp, "BLAKE2sp Hashing");
+    perfHash(&blake2bp, "BLAKE2bp Hashing");
+}
+
+void loop()
+{
+}
@@ -0,0 +1,282 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+This example runs tests on the BLAKE2sMAC class to verify correct behaviour.
+*/
+
+#include <Crypto.h>
+#include <BLAKE2s.h>
+#include <BLAKE2sMAC.h>
+#include <SHA1.h>
+#include <SHA256.h>
+#include <HMAC.h>
+#include <string.h>
+
+struct TestMACVector
+{
+    const char *name;
+    size_t dataLen;
+    size_t keyLen;
+    uint8_t macLen;
+    uint8_t mac[32];
+};
+
+// Generated with Python's hashlib.blake2s(data, key=key, digest_size=macLen)
+// where the key is the bytes 0, 1, 2, ... up to the key length and the
+// data is the bytes 0, 1, 2, ... up to the data length.
+static TestMACVector const testVectorBLAKE2sMAC_1 = {
+    "BLAKE2sMAC #1",
+    0,
+    32,
+    32,
+    {0x48, 0xA8, 0x99, 0x7D, 0xA4, 0x07, 0x87, 0x6B,
+     0x3D, 0x79, 0xC0, 0xD9, 0x23, 0x25, 0xAD, 0x3B,
+     0x89, 0xCB, 0xB7, 0x54, 0xD8, 0x6A, 0xB7, 0x1A,
+     0xEE, 0x04, 0x7A, 0xD3, 0x45, 0xFD, 0x2C, 0x49}
+};
+static TestMACVector const testVectorBLAKE2sMAC_2 = {
+    "BLAKE2sMAC #2",
+    1,
+    32,
+    32,
+    {0x40, 0xD1, 0x5F, 0xEE, 0x7C, 0x32, 0x88, 0x30,
+     0x16, 0x6A, 0xC3, 0xF9, 0x18, 0x65, 0x0F, 0x80,
+     0x7E, 0x7E, 0x01, 0xE1, 0x77, 0x25, 0x8C, 0xDC,
+     0x0A, 0x39, 0xB1, 0x1F, 0x59, 0x80, 0x66, 0xF1}
+};
+static TestMACVector const testVectorBLAKE2sMAC_3 = {
+    "BLAKE2sMAC #3",
+    64,
+    32,
+    32,
+    {0x89, 0x75, 0xB0, 0x57, 0x7F, 0xD3, 0x55, 0x66,
+     0xD7, 0x50, 0xB3, 0x62, 0xB0, 0x89, 0x7A, 0x26,
+     0xC3, 0x99, 0x13, 0x6D, 0xF0, 0x7B, 0xAB, 0xAB,
+     0xBD, 0xE6, 0x20, 0x3F, 0xF2, 0x95, 0x4E, 0xD4}
+};
+static TestMACVector const testVectorBLAKE2sMAC_4 = {
+    "BLAKE2sMAC #4",
+    65,
+    32,
+    32,
+    {0x21, 0xFE, 0x0C, 0xEB, 0x00, 0x52, 0xBE, 0x7F,
+     0xB0, 0xF0, 0x04, 0x18, 0x7C, 0xAC, 0xD7, 0xDE,
+     0x67, 0xFA, 0x6E, 0xB0, 0x93, 0x8D, 0x92, 0x76,
+     0x77, 0xF2, 0x39, 0x8C, 0x13, 0x23, 0x17, 0xA8}
+};
+static TestMACVector const testVectorBLAKE2sMAC_5 = {
+    "BLAKE2sMAC #5",
+    255,
+    32,
+    32,
+    {0x3F, 0xB7, 0x35, 0x06, 0x1A, 0xBC, 0x51, 0x9D,
+     0xFE, 0x97, 0x9E, 0x54, 0xC1, 0xEE, 0x5B, 0xFA,
+     0xD0, 0xA9, 0xD8, 0x58, 0xB3, 0x31, 0x5B, 0xAD,
+     0x34, 0xBD, 0xE9, 0x99, 0xEF, 0xD7, 0x24, 0xDD}
+};
+static TestMACVector const testVectorBLAKE2sMAC_6 = {
+    "BLAKE2sMAC #6",
+    0,
+    16,
+    16,
+    {0xAF, 0x4E, 0x5D, 0x3B, 0xB2, 0x30, 0xE9, 0xFF,
+     0x90, 0x96, 0xCA, 0x6F, 0x7C, 0x50, 0x1F, 0x76}
+};
+static TestMACVector const testVectorBLAKE2sMAC_7 = {
+    "BLAKE2sMAC #7",
+    40,
+    16,
+    16,
+    {0x46, 0x6B, 0x8E, 0x49, 0x17, 0x48, 0x68, 0xCB,
+     0x7B, 0x8B, 0x16, 0x0C, 0xD3, 0xED, 0x32, 0x5E}
+};
+static TestMACVector const testVectorBLAKE2sMAC_8 = {
+    "BLAKE2sMAC #8",
+    40,
+    32,
+    4,
+    {0x75, 0x8F, 0xB2, 0xCA}
+};
+
+byte key[32];
+byte buffer[256];
+
+bool testMAC_N(BLAKE2sMAC *mac, const struct TestMACVector *test, size_t inc)
+{
+    size_t size = test->dataLen;
+    size_t posn, len;
+    uint8_t value[32];
+
+    for (posn = 0; posn < size; posn += inc) {
+        len = size - posn;
+        if (len > inc)
+            len = inc;
+        mac->update(buffer + posn, len);
+    }
+    memset(value, 0xAA, sizeof(value));
+    mac->finalize(value, sizeof(value));
+    if (memcmp(value, test->mac, test->macLen) != 0)
+        return false;
+
+    // Nothing past macSize() may be written.
+    for (posn = test->macLen; posn < sizeof(value); ++posn) {
+        if (value[posn] != 0xAA)
+            return false;
+    }
+    return true;
+}
+
+void testMAC(const struct TestMACVector *test)
+{
+    uint8_t blob[BLAKE2sMAC::KEY_STATE_SIZE];
+    uint8_t value[32];
+    bool ok;
+
+    Serial.print(test->name);
+    Serial.print(" ... ");
+
+    BLAKE2sMAC mac(key, test->keyLen, test->macLen);
+    ok  = (mac.macSize() == test->macLen);
+    ok &= testMAC_N(&mac, test, test->dataLen + 1);
+    ok &= testMAC_N(&mac, test, 1);
+    ok &= testMAC_N(&mac, test, 3);
+    ok &= testMAC_N(&mac, test, 64);
+
+    // Abandoned message followed by a one-shot computation.
+    mac.update("xyz", 3);
+    mac.compute(value, test->macLen, buffer, test->dataLen);
+    ok &= (memcmp(value, test->mac, test->macLen) == 0);
+
+    // Verification, including a wrong value and a wrong length.
+    ok &= mac.verify(test->mac, test->macLen, buffer, test->dataLen);
+    value[0] ^= 0x01;
+    ok &= !mac.verify(value, test->macLen, buffer, test->dataLen);
+    ok &= !mac.verify(test->mac, test->macLen - 1, buffer, test->dataLen);
+
+    // Key state saved and loaded into a fresh object.
+    mac.saveKey(blob);
+    BLAKE2sMAC loaded;
+    ok &= loaded.loadKey(blob, sizeof(blob));
+    ok &= testMAC_N(&loaded, test, 7);
+    blob[BLAKE2s::SNAPSHOT_SIZE] = 0;
+    ok &= !loaded.loadKey(blob, sizeof(blob));
+    ok &= testMAC_N(&loaded, test, 7);
+
+    // Copy of a keyed object.
+    BLAKE2sMAC copy(mac);
+    ok &= testMAC_N(&copy, test, 5);
+
+    // Must agree with BLAKE2s::reset() with a key.
+    BLAKE2s blake;
+    blake.reset(key, test->keyLen, test->macLen);
+    blake.update(buffer, test->dataLen);
+    blake.finalize(value, test->macLen);
+    ok &= (memcmp(value, test->mac, test->macLen) == 0);
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+void perfMAC(size_t len)
+{
+    unsigned long start;
+    unsigned long elapsed;
+    uint8_t value[32];
+    int count;
+
+    Serial.print(len);
+    Serial.print("-byte message: ");
+
+    BLAKE2sMAC mac(key, 16, 16);
+    start = micros();
+    for (count = 0; count < 200; ++count)
+        mac.compute(value, 16, buffer, len);
+    elapsed = micros() - start;
+    Serial.print(elapsed / 200.0);
+    Serial.print("us BLAKE2sMAC, ");
+
+    BLAKE2s blake;
+    start = micros();
+    for (count = 0; count < 200; ++count) {
+        blake.reset(key, 16, 16);
+        blake.update(buffer, len);
+        blake.finalize(value, 16);
+    }
+    elapsed = micros() - start;
+    Serial.print(elapsed / 200.0);
+    Serial.print("us keyed BLAKE2s, ");
+
+    HMAC<SHA1> hmac1(key, 16);
+    start = micros();
+    for (count = 0; count < 200; ++count)
+        hmac1.compute(value, 20, buffer, len);
+    elapsed = micros() - start;
+    Serial.print(elapsed / 200.0);
+    Serial.print("us HMAC-SHA1, ");
+
+    HMAC<SHA256> hmac256(key, 16);
+    start = micros();
+    for (count = 0; count < 200; ++count)
+        hmac256.compute(value, 32, buffer, len);
+    elapsed = micros() - start;
+    Serial.print(elapsed / 200.0);
+    Serial.println("us HMAC-SHA256");
+}
+
+void setup()
+{
+    Serial.begin(9600);
+
+    for (size_t posn = 0; posn < sizeof(key); ++posn)
+        key[posn] = (byte)posn;
+    for (size_t posn = 0; posn < sizeof(buffer); ++posn)
+        buffer[posn] = (byte)posn;
+
+    Serial.println();
+
+    Serial.print("State Size ... ");
+    Serial.println(sizeof(BLAKE2sMAC));
+    Serial.println();
+
+    Serial.println("Test Vectors:");
+    testMAC(&testVectorBLAKE2sMAC_1);
+    testMAC(&testVectorBLAKE2sMAC_2);
+    testMAC(&testVectorBLAKE2sMAC_3);
+    testMAC(&testVectorBLAKE2sMAC_4);
+    testMAC(&testVectorBLAKE2sMAC_5);
+    testMAC(&testVectorBLAKE2sMAC_6);
+    testMAC(&testVectorBLAKE2sMAC_7);
+    testMAC(&testVectorBLAKE2sMAC_8);
+
+    Serial.println();
+
+    Serial.println("Performance Tests:");
+    perfMAC(16);
+    perfMAC(64);
+    perfMAC(128);
+}
+
+void loop()
+{
+}
@@ -123,6 +123,113 @@ void testHKDF(HKDFCommon *hkdf, const TestHKDFVector *test)
         Serial.println("Failed");
 }
 
+// Derives the same vector for several keys at once with hkdfBatch().
+void testHKDFBatch(const TestHKDFVector *test)
+{
+    const void *keys[3];
+    size_t keyLens[3];
+    void *outputs[3];
+    bool ok = true;
+
+    Serial.print(test->name);
+    Serial.print(" Batch ... ");
+
+    for (uint8_t posn = 0; posn < 3; ++posn) {
+        keys[posn] = test->key;
+        keyLens[posn] = test->key_len;
+        outputs[posn] = buffer + posn * 42;
+    }
+    hkdfBatch<SHA256>(outputs, test->out_len, keys, keyLens, test->salt,
+                      test->salt_len, test->info, test->info_len, 3);
+    for (uint8_t posn = 0; posn < 3; ++posn) {
+        if (memcmp(outputs[posn], test->out, test->out_len) != 0)
+            ok = false;
+    }
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+// Expands the vector's info for several outputs from one cached PRK.
+void testHKDFExpand(const TestHKDFVector *test)
+{
+    HKDFExpand<SHA256> expander;
+    const void *infos[3];
+    size_t infoLens[3];
+    void *outputs[3];
+    bool ok = true;
+
+    Serial.print(test->name);
+    Serial.print(" Expand ... ");
+
+    expander.setKey(test->key, test->key_len, test->salt, test->salt_len);
+    for (uint8_t posn = 0; posn < 3; ++posn) {
+        infos[posn] = test->info;
+        infoLens[posn] = test->info_len;
+        outputs[posn] = buffer + posn * 42;
+    }
+    expander.expandBatch(outputs, test->out_len, infos, infoLens, 3);
+    for (uint8_t posn = 0; posn < 3; ++posn) {
+        if (memcmp(outputs[posn], test->out, test->out_len) != 0)
+            ok = false;
+    }
+    memset(buffer, 0, test->out_len);
+    expander.expand(buffer, test->out_len, test->info, test->info_len);
+    if (memcmp(buffer, test->out, test->out_len) != 0)
+        ok = false;
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+// Drives hmacBatchKeys() and hkdfExpandBatch() directly with more
+// outputs than HMAC_BATCH_SIZE on AVR.
+void testHKDFExpandBatch(const TestHKDFVector *test)
+{
+    SHA256 inner[3];
+    SHA256 outer[3];
+    uint8_t prk[32];
+    const void *keys[3];
+    size_t keyLens[3];
+    const SHA256 *in[3];
+    const SHA256 *ou[3];
+    const void *infos[3];
+    size_t infoLens[3];
+    void *outputs[3];
+    bool ok = true;
+
+    Serial.print(test->name);
+    Serial.print(" Expand Batch ... ");
+
+    hmac<SHA256>(prk, sizeof(prk), test->salt, test->salt_len,
+                 test->key, test->key_len);
+    for (uint8_t posn = 0; posn < 3; ++posn) {
+        keys[posn] = prk;
+        keyLens[posn] = sizeof(prk);
+        in[posn] = &inner[posn];
+        ou[posn] = &outer[posn];
+        infos[posn] = test->info;
+        infoLens[posn] = test->info_len;
+        outputs[posn] = buffer + posn * 42;
+    }
+    memset(buffer, 0, sizeof(buffer));
+    hmacBatchKeys(inner, outer, keys, keyLens, 3);
+    hkdfExpandBatch(outputs, test->out_len, in, ou, infos, infoLens, 3);
+    for (uint8_t posn = 0; posn < 3; ++posn) {
+        if (memcmp(outputs[posn], test->out, test->out_len) != 0)
+            ok = false;
+    }
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
 void setup()
 {
     Serial.begin(9600);
@@ -137,6 +244,9 @@ void setup()
 
     Serial.println("Test Vectors:");
     testHKDF(&hkdf_context, &testVectorHKDF_1);
+    testHKDFBatch(&testVectorHKDF_1);
+    testHKDFExpand(&testVectorHKDF_1);
+    testHKDFExpandBatch(&testVectorHKDF_1);
     Serial.println();
 }
 
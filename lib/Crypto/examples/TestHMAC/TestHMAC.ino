@@ -0,0 +1,241 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+This example runs tests on the HMAC class to verify correct behaviour.
+*/
+
+#include <Crypto.h>
+#include <SHA1.h>
+#include <SHA256.h>
+#include <SHA512.h>
+#include <SHA3.h>
+#include <BLAKE2s.h>
+#include <HMAC.h>
+#include <string.h>
+
+typedef struct
+{
+    const char *name;
+    const unsigned char *key;
+    size_t key_len;
+    const char *data;
+    const unsigned char *mac;
+    size_t mac_len;
+
+} TestHMACVector;
+
+/* Test cases from RFC-2202 and RFC-4231, test case 2 and test case 6 */
+static unsigned char const key_jefe[] = {'J', 'e', 'f', 'e'};
+static unsigned char key_long[131];
+static const char data_jefe[] = "what do ya want for nothing?";
+static const char data_long[] = "Test Using Larger Than Block-Size Key - Hash Key First";
+static unsigned char const mac_sha1_jefe[] = {
+    0xef, 0xfc, 0xdf, 0x6a, 0xe5, 0xeb, 0x2f, 0xa2,
+    0xd2, 0x74, 0x16, 0xd5, 0xf1, 0x84, 0xdf, 0x9c,
+    0x25, 0x9a, 0x7c, 0x79
+};
+static unsigned char const mac_sha256_jefe[] = {
+    0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e,
+    0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7,
+    0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83,
+    0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43
+};
+static unsigned char const mac_sha256_long[] = {
+    0x60, 0xe4, 0x31, 0x59, 0x1e, 0xe0, 0xb6, 0x7f,
+    0x0d, 0x8a, 0x26, 0xaa, 0xcb, 0xf5, 0xb7, 0x7f,
+    0x8e, 0x0b, 0xc6, 0x21, 0x37, 0x28, 0xc5, 0x14,
+    0x05, 0x46, 0x04, 0x0f, 0x0e, 0xe3, 0x7f, 0x54
+};
+static unsigned char const mac_sha512_jefe[] = {
+    0x16, 0x4b, 0x7a, 0x7b, 0xfc, 0xf8, 0x19, 0xe2,
+    0xe3, 0x95, 0xfb, 0xe7, 0x3b, 0x56, 0xe0, 0xa3,
+    0x87, 0xbd, 0x64, 0x22, 0x2e, 0x83, 0x1f, 0xd6,
+    0x10, 0x27, 0x0c, 0xd7, 0xea, 0x25, 0x05, 0x54,
+    0x97, 0x58, 0xbf, 0x75, 0xc0, 0x5a, 0x99, 0x4a,
+    0x6d, 0x03, 0x4f, 0x65, 0xf8, 0xf0, 0xe6, 0xfd,
+    0xca, 0xea, 0xb1, 0xa3, 0x4d, 0x4a, 0x6b, 0x4b,
+    0x63, 0x6e, 0x07, 0x0a, 0x38, 0xbc, 0xe7, 0x37
+};
+static unsigned char const mac_sha512_long[] = {
+    0x80, 0xb2, 0x42, 0x63, 0xc7, 0xc1, 0xa3, 0xeb,
+    0xb7, 0x14, 0x93, 0xc1, 0xdd, 0x7b, 0xe8, 0xb4,
+    0x9b, 0x46, 0xd1, 0xf4, 0x1b, 0x4a, 0xee, 0xc1,
+    0x12, 0x1b, 0x01, 0x37, 0x83, 0xf8, 0xf3, 0x52,
+    0x6b, 0x56, 0xd0, 0x37, 0xe0, 0x5f, 0x25, 0x98,
+    0xbd, 0x0f, 0xd2, 0x21, 0x5d, 0x6a, 0x1e, 0x52,
+    0x95, 0xe6, 0x4f, 0x73, 0xf6, 0x3f, 0x0a, 0xec,
+    0x8b, 0x91, 0x5a, 0x98, 0x5d, 0x78, 0x65, 0x98
+};
+static unsigned char const mac_sha3_256_jefe[] = {
+    0xc7, 0xd4, 0x07, 0x2e, 0x78, 0x88, 0x77, 0xae,
+    0x35, 0x96, 0xbb, 0xb0, 0xda, 0x73, 0xb8, 0x87,
+    0xc9, 0x17, 0x1f, 0x93, 0x09, 0x5b, 0x29, 0x4a,
+    0xe8, 0x57, 0xfb, 0xe2, 0x64, 0x5e, 0x1b, 0xa5
+};
+static unsigned char const mac_blake2s_jefe[] = {
+    0x90, 0xb6, 0x28, 0x1e, 0x2f, 0x30, 0x38, 0xc9,
+    0x05, 0x6a, 0xf0, 0xb4, 0xa7, 0xe7, 0x63, 0xca,
+    0xe6, 0xfe, 0x5d, 0x9e, 0xb4, 0x38, 0x6a, 0x0e,
+    0xc9, 0x52, 0x37, 0x89, 0x0c, 0x10, 0x4f, 0xf0
+};
+
+static TestHMACVector const testVectorSHA1 = {
+    "HMAC-SHA1 #2", key_jefe, 4, data_jefe, mac_sha1_jefe, 20
+};
+static TestHMACVector const testVectorSHA256_2 = {
+    "HMAC-SHA256 #2", key_jefe, 4, data_jefe, mac_sha256_jefe, 32
+};
+static TestHMACVector const testVectorSHA256_6 = {
+    "HMAC-SHA256 #6", key_long, 131, data_long, mac_sha256_long, 32
+};
+static TestHMACVector const testVectorSHA512_2 = {
+    "HMAC-SHA512 #2", key_jefe, 4, data_jefe, mac_sha512_jefe, 64
+};
+static TestHMACVector const testVectorSHA512_6 = {
+    "HMAC-SHA512 #6", key_long, 131, data_long, mac_sha512_long, 64
+};
+static TestHMACVector const testVectorSHA3_256 = {
+    "HMAC-SHA3-256 #2", key_jefe, 4, data_jefe, mac_sha3_256_jefe, 32
+};
+static TestHMACVector const testVectorBLAKE2s = {
+    "HMAC-BLAKE2s #2", key_jefe, 4, data_jefe, mac_blake2s_jefe, 32
+};
+
+uint8_t buffer[64];
+
+template <typename T>
+bool testHMAC_N(HMAC<T> *mac, const TestHMACVector *test, size_t inc)
+{
+    size_t size = strlen(test->data);
+    size_t posn, len;
+
+    for (posn = 0; posn < size; posn += inc) {
+        len = size - posn;
+        if (len > inc)
+            len = inc;
+        mac->update(test->data + posn, len);
+    }
+    memset(buffer, 0xAA, sizeof(buffer));
+    mac->finalize(buffer, test->mac_len);
+    return memcmp(buffer, test->mac, test->mac_len) == 0;
+}
+
+template <typename T>
+void testHMAC(const TestHMACVector *test)
+{
+    bool ok;
+
+    Serial.print(test->name);
+    Serial.print(" ... ");
+
+    HMAC<T> mac(test->key, test->key_len);
+    ok  = testHMAC_N(&mac, test, strlen(test->data));
+    ok &= testHMAC_N(&mac, test, 1);
+    ok &= testHMAC_N(&mac, test, 3);
+    ok &= testHMAC_N(&mac, test, 7);
+
+    // Abandoned message followed by a one-shot computation.
+    mac.update("xyz", 3);
+    memset(buffer, 0xAA, sizeof(buffer));
+    mac.compute(buffer, test->mac_len, test->data, strlen(test->data));
+    ok &= (memcmp(buffer, test->mac, test->mac_len) == 0);
+
+    // Copy of a keyed object.
+    HMAC<T> copy(mac);
+    ok &= testHMAC_N(&copy, test, 5);
+
+    // Must agree with Hash::resetHMAC() and Hash::finalizeHMAC().
+    T hash;
+    hash.resetHMAC(test->key, test->key_len);
+    hash.update(test->data, strlen(test->data));
+    memset(buffer, 0xAA, sizeof(buffer));
+    hash.finalizeHMAC(test->key, test->key_len, buffer, test->mac_len);
+    ok &= (memcmp(buffer, test->mac, test->mac_len) == 0);
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+template <typename T>
+void perfHMAC(const char *name)
+{
+    unsigned long start;
+    unsigned long elapsed;
+    int count;
+
+    Serial.print(name);
+    Serial.print(" ... ");
+
+    HMAC<T> mac(key_jefe, sizeof(key_jefe));
+    start = micros();
+    for (count = 0; count < 200; ++count)
+        mac.compute(buffer, mac.macSize(), buffer, 8);
+    elapsed = micros() - start;
+    Serial.print(elapsed / 200.0);
+    Serial.print("us per 8-byte message, ");
+
+    T hash;
+    start = micros();
+    for (count = 0; count < 200; ++count) {
+        hash.resetHMAC(key_jefe, sizeof(key_jefe));
+        hash.update(buffer, 8);
+        hash.finalizeHMAC(key_jefe, sizeof(key_jefe), buffer, hash.hashSize());
+    }
+    elapsed = micros() - start;
+    Serial.print(elapsed / 200.0);
+    Serial.println("us with resetHMAC()");
+}
+
+void setup()
+{
+    Serial.begin(9600);
+
+    Serial.println();
+
+    memset(key_long, 0xAA, sizeof(key_long));
+
+    Serial.print("State Size ... ");
+    Serial.println(sizeof(HMAC<SHA256>));
+    Serial.println();
+
+    Serial.println("Test Vectors:");
+    testHMAC<SHA1>(&testVectorSHA1);
+    testHMAC<SHA256>(&testVectorSHA256_2);
+    testHMAC<SHA256>(&testVectorSHA256_6);
+    testHMAC<SHA512>(&testVectorSHA512_2);
+    testHMAC<SHA512>(&testVectorSHA512_6);
+    testHMAC<SHA3_256>(&testVectorSHA3_256);
+    testHMAC<BLAKE2s>(&testVectorBLAKE2s);
+
+    Serial.println();
+
+    Serial.println("Performance Tests:");
+    perfHMAC<SHA1>("HMAC-SHA1");
+    perfHMAC<SHA256>("HMAC-SHA256");
+    perfHMAC<SHA512>("HMAC-SHA512");
+}
+
+void loop()
+{
+}
@@ -0,0 +1,163 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+This example runs tests on the HashPipeline class to verify that files
+and pipes hash to the same values as one-shot SHA256 and BLAKE2s.
+*/
+
+#include <Crypto.h>
+#include <SHA256.h>
+#include <BLAKE2s.h>
+#include <HashPipeline.h>
+#include <ThreadPool.h>
+#include <string.h>
+
+#if CRYPTO_HASH_PIPELINE
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <thread>
+
+// Smallest window, so that the larger inputs span several mapped windows
+// and several reader buffers.
+#define TEST_BUFFER_SIZE 0x10000
+
+static const size_t testSizes[] = {0, 1, 1000, 3 * TEST_BUFFER_SIZE + 12345};
+
+uint8_t *data;
+uint8_t expected256[32];
+uint8_t expected2s[32];
+
+// Feeds the data to the pipe in odd-sized pieces, as a producer would.
+static void pipeWriter(int fd, size_t len)
+{
+    size_t posn = 0;
+    while (posn < len) {
+        size_t size = len - posn;
+        if (size > 4093)
+            size = 4093;
+        ssize_t n = write(fd, data + posn, size);
+        if (n <= 0)
+            break;
+        posn += (size_t)n;
+    }
+    close(fd);
+}
+
+bool testPipeline(size_t len, bool usePipe, ThreadPool *pool)
+{
+    SHA256 sha256;
+    BLAKE2s blake2s;
+    HashPipeline pipeline(TEST_BUFFER_SIZE);
+    uint8_t value[32];
+    bool ok;
+
+    pipeline.addHash(&sha256);
+    pipeline.addHash(&blake2s);
+    pipeline.setThreadPool(pool);
+
+    if (usePipe) {
+        int fds[2];
+        if (pipe(fds) != 0)
+            return false;
+        std::thread writer(pipeWriter, fds[1], len);
+        ok = pipeline.hashDescriptor(fds[0]);
+        writer.join();
+        close(fds[0]);
+    } else {
+        char path[] = "/tmp/TestHashPipelineXXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0)
+            return false;
+        ok = write(fd, data, len) == (ssize_t)len;
+        close(fd);
+        ok = ok && pipeline.hashFile(path);
+        unlink(path);
+    }
+    if (!ok || pipeline.length() != len)
+        return false;
+
+    sha256.finalize(value, sizeof(value));
+    if (memcmp(value, expected256, sizeof(value)) != 0)
+        return false;
+    blake2s.finalize(value, sizeof(value));
+    if (memcmp(value, expected2s, sizeof(value)) != 0)
+        return false;
+    return true;
+}
+
+void testHashPipeline(size_t len, ThreadPool *pool)
+{
+    SHA256 sha256;
+    BLAKE2s blake2s;
+    bool ok;
+
+    Serial.print(len);
+    Serial.print(" bytes");
+    if (pool)
+        Serial.print(", thread pool");
+    Serial.print(" ... ");
+
+    sha256.update(data, len);
+    sha256.finalize(expected256, sizeof(expected256));
+    blake2s.update(data, len);
+    blake2s.finalize(expected2s, sizeof(expected2s));
+
+    ok  = testPipeline(len, false, pool);
+    ok &= testPipeline(len, true, pool);
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+#endif // CRYPTO_HASH_PIPELINE
+
+void setup()
+{
+    Serial.begin(9600);
+
+    Serial.println();
+
+#if CRYPTO_HASH_PIPELINE
+    size_t maxSize = testSizes[sizeof(testSizes) / sizeof(testSizes[0]) - 1];
+    data = new uint8_t [maxSize];
+    for (size_t posn = 0; posn < maxSize; ++posn)
+        data[posn] = (uint8_t)(posn * 7 + (posn >> 8));
+
+    Serial.println("Files and Pipes:");
+    for (size_t index = 0; index < sizeof(testSizes) / sizeof(testSizes[0]); ++index)
+        testHashPipeline(testSizes[index], 0);
+    ThreadPool pool(4);
+    for (size_t index = 0; index < sizeof(testSizes) / sizeof(testSizes[0]); ++index)
+        testHashPipeline(testSizes[index], &pool);
+
+    delete [] data;
+#else
+    Serial.println("HashPipeline is not available on this platform");
+#endif
+}
+
+void loop()
+{
+}
@@ -0,0 +1,200 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+This example runs tests on the KMAC and TupleHash implementations to verify
+correct behaviour.
+*/
+
+#include <Crypto.h>
+#include <KMAC.h>
+#include <TupleHash.h>
+#include <string.h>
+
+#define MAX_MAC_SIZE 64
+
+// Sample vectors from NIST SP 800-185.  The key is 0x40..0x5F and the
+// data is dataLen bytes counting up from 0x00.
+struct TestVector
+{
+    const char *name;
+    const char *custom;
+    size_t dataLen;
+    byte mac[MAX_MAC_SIZE];
+    size_t macLen;
+};
+
+static TestVector const testVectorKMAC128_1 = {
+    .name       = "KMAC128 #1",
+    .custom     = "",
+    .dataLen    = 4,
+    .mac        = {0xE5, 0x78, 0x0B, 0x0D, 0x3E, 0xA6, 0xF7, 0xD3,
+                   0xA4, 0x29, 0xC5, 0x70, 0x6A, 0xA4, 0x3A, 0x00,
+                   0xFA, 0xDB, 0xD7, 0xD4, 0x96, 0x28, 0x83, 0x9E,
+                   0x31, 0x87, 0x24, 0x3F, 0x45, 0x6E, 0xE1, 0x4E},
+    .macLen     = 32
+};
+static TestVector const testVectorKMAC128_2 = {
+    .name       = "KMAC128 #2",
+    .custom     = "My Tagged Application",
+    .dataLen    = 4,
+    .mac        = {0x3B, 0x1F, 0xBA, 0x96, 0x3C, 0xD8, 0xB0, 0xB5,
+                   0x9E, 0x8C, 0x1A, 0x6D, 0x71, 0x88, 0x8B, 0x71,
+                   0x43, 0x65, 0x1A, 0xF8, 0xBA, 0x0A, 0x70, 0x70,
+                   0xC0, 0x97, 0x9E, 0x28, 0x11, 0x32, 0x4A, 0xA5},
+    .macLen     = 32
+};
+static TestVector const testVectorKMAC256_1 = {
+    .name       = "KMAC256 #1",
+    .custom     = "My Tagged Application",
+    .dataLen    = 200,
+    .mac        = {0xB5, 0x86, 0x18, 0xF7, 0x1F, 0x92, 0xE1, 0xD5,
+                   0x6C, 0x1B, 0x8C, 0x55, 0xDD, 0xD7, 0xCD, 0x18,
+                   0x8B, 0x97, 0xB4, 0xCA, 0x4D, 0x99, 0x83, 0x1E,
+                   0xB2, 0x69, 0x9A, 0x83, 0x7D, 0xA2, 0xE4, 0xD9,
+                   0x70, 0xFB, 0xAC, 0xFD, 0xE5, 0x00, 0x33, 0xAE,
+                   0xA5, 0x85, 0xF1, 0xA2, 0x70, 0x85, 0x10, 0xC3,
+                   0x2D, 0x07, 0x88, 0x08, 0x01, 0xBD, 0x18, 0x28,
+                   0x98, 0xFE, 0x47, 0x68, 0x76, 0xFC, 0x89, 0x65},
+    .macLen     = 64
+};
+
+// TupleHash128 sample #2: ("00 01 02", "10 .. 15", "20 .. 28").
+static byte const tupleHash128Expected[32] = {
+    0xE6, 0x0F, 0x20, 0x2C, 0x89, 0xA2, 0x63, 0x1E,
+    0xDA, 0x8D, 0x4C, 0x58, 0x8C, 0xA5, 0xFD, 0x07,
+    0xF3, 0x9E, 0x51, 0x51, 0x99, 0x8D, 0xEC, 0xCF,
+    0x97, 0x3A, 0xDB, 0x38, 0x04, 0xBB, 0x6E, 0x84
+};
+
+KMAC128 kmac128;
+KMAC256 kmac256;
+TupleHash128 tupleHash128;
+
+byte key[32];
+byte buffer[200];
+
+bool testKMAC_N(KMAC *kmac, const struct TestVector *test, size_t inc)
+{
+    byte mac[MAX_MAC_SIZE];
+    size_t posn, len;
+
+    kmac->reset();
+    for (posn = 0; posn < test->dataLen; posn += inc) {
+        len = test->dataLen - posn;
+        if (len > inc)
+            len = inc;
+        kmac->update(buffer + posn, len);
+    }
+    memset(mac, 0xBA, sizeof(mac));
+    kmac->finalize(mac, test->macLen);
+    return memcmp(mac, test->mac, test->macLen) == 0;
+}
+
+void testKMAC(KMAC *kmac, const struct TestVector *test)
+{
+    bool ok;
+
+    Serial.print(test->name);
+    Serial.print(" ... ");
+
+    kmac->setKey(key, sizeof(key), test->custom, strlen(test->custom));
+    ok  = testKMAC_N(kmac, test, test->dataLen);
+    ok &= testKMAC_N(kmac, test, 1);
+    ok &= testKMAC_N(kmac, test, 3);
+    ok &= testKMAC_N(kmac, test, 17);
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+void testTupleHash()
+{
+    byte hash[32];
+
+    Serial.print("TupleHash128 #1 ... ");
+
+    tupleHash128.setCustomization("My Tuple App", 12);
+    tupleHash128.update(buffer, 3);
+    tupleHash128.update(buffer + 0x10, 6);
+    tupleHash128.update(buffer + 0x20, 9);
+    tupleHash128.finalize(hash, sizeof(hash));
+
+    if (memcmp(hash, tupleHash128Expected, sizeof(hash)) == 0)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+void perfKMAC(const char *name, KMAC *kmac)
+{
+    unsigned long start;
+    unsigned long elapsed;
+    byte mac[32];
+    int count;
+
+    Serial.print(name);
+    Serial.print(" ... ");
+
+    kmac->setKey(key, sizeof(key));
+    start = micros();
+    for (count = 0; count < 500; ++count) {
+        kmac->reset();
+        kmac->update(buffer, 64);
+        kmac->finalize(mac, sizeof(mac));
+    }
+    elapsed = micros() - start;
+
+    Serial.print(elapsed / 500.0);
+    Serial.println("us per 64-byte message");
+}
+
+void setup()
+{
+    size_t posn;
+
+    Serial.begin(9600);
+
+    for (posn = 0; posn < sizeof(key); ++posn)
+        key[posn] = 0x40 + posn;
+    for (posn = 0; posn < sizeof(buffer); ++posn)
+        buffer[posn] = (byte)posn;
+
+    Serial.println();
+
+    Serial.println("Test Vectors:");
+    testKMAC(&kmac128, &testVectorKMAC128_1);
+    testKMAC(&kmac128, &testVectorKMAC128_2);
+    testKMAC(&kmac256, &testVectorKMAC256_1);
+    testTupleHash();
+
+    Serial.println();
+
+    Serial.println("Performance Tests:");
+    perfKMAC("KMAC128", &kmac128);
+    perfKMAC("KMAC256", &kmac256);
+}
+
+void loop()
+{
+}
@@ -124,6 +124,42 @@ void testHash(Hash *hash, const struct TestHashVector *test)
         Serial.println("Failed");
 }
 
+// Snapshot the state part-way through and finish in a fresh object.
+void testSnapshot(SHA256 *hash, const struct TestHashVector *test)
+{
+    size_t size = strlen(test->data);
+    uint8_t blob[SHA256::SNAPSHOT_SIZE];
+    uint8_t value[HASH_SIZE];
+    bool ok = true;
+
+    Serial.print(test->name);
+    Serial.print(" Snapshot ... ");
+
+    for (size_t split = 0; split <= size; ++split) {
+        hash->reset();
+        hash->update(test->data, split);
+        hash->snapshot(blob);
+        SHA256 resumed;
+        resumed.update("x", 1);
+        if (!resumed.restore(blob, sizeof(blob))) {
+            ok = false;
+            break;
+        }
+        resumed.update(test->data + split, size - split);
+        resumed.finalize(value, sizeof(value));
+        if (memcmp(value, test->hash, sizeof(value)) != 0)
+            ok = false;
+    }
+    blob[0] ^= 0xFF;
+    if (hash->restore(blob, sizeof(blob)))
+        ok = false;
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
 // Very simple method for hashing a HMAC inner or outer key.
 void hashKey(Hash *hash, const uint8_t *key, size_t keyLen, uint8_t pad)
 {
@@ -308,6 +344,7 @@ void setup()
     Serial.println("Test Vectors:");
     testHash(&sha256, &testVectorSHA256_1);
     testHash(&sha256, &testVectorSHA256_2);
+    testSnapshot(&sha256, &testVectorSHA256_2);
     testHMAC(&sha256, &testVectorHMAC_SHA256_1);
     testHMAC(&sha256, &testVectorHMAC_SHA256_2);
     testHMAC(&sha256, (size_t)0);
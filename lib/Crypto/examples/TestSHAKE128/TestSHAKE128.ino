@@ -264,6 +264,49 @@ void testSHAKE(SHAKE *shake, const struct TestHashVectorSHAKE *test)
         Serial.println("Failed");
 }
 
+// Runs all three test vectors through updateBatch() and extendBatch().
+void testSHAKEBatch()
+{
+    static TestHashVectorSHAKE const *const tests[3] = {
+        &testVectorSHAKE128_1, &testVectorSHAKE128_2, &testVectorSHAKE128_3
+    };
+    static TestHashVectorSHAKE vectors[3];
+    static uint8_t outputs[3][MAX_SHAKE_OUTPUT];
+    SHAKE128 others[2];
+    SHAKE *xofs[3] = {&shake128, &others[0], &others[1]};
+    const void *data[3];
+    size_t dataLen[3];
+    uint8_t *out[3];
+    uint8_t posn;
+    bool ok = true;
+
+    Serial.print("SHAKE128 batch ... ");
+
+    for (posn = 0; posn < 3; ++posn) {
+        memcpy_P(&vectors[posn], tests[posn], sizeof(TestHashVectorSHAKE));
+        data[posn] = vectors[posn].data;
+        dataLen[posn] = vectors[posn].dataLen;
+        out[posn] = outputs[posn];
+        xofs[posn]->reset();
+    }
+    updateBatch(xofs, data, dataLen, 3);
+
+    // Extend in two pieces so that the second starts part way into a block.
+    extendBatch(xofs, out, 100, 3);
+    for (posn = 0; posn < 3; ++posn)
+        out[posn] += 100;
+    extendBatch(xofs, out, MAX_SHAKE_OUTPUT - 100, 3);
+    for (posn = 0; posn < 3; ++posn) {
+        if (memcmp(outputs[posn], vectors[posn].hash, MAX_SHAKE_OUTPUT) != 0)
+            ok = false;
+    }
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
 void perfUpdate(SHAKE *shake)
 {
     unsigned long start;
@@ -355,6 +398,7 @@ void setup()
     testSHAKE(&shake128, &testVectorSHAKE128_1);
     testSHAKE(&shake128, &testVectorSHAKE128_2);
     testSHAKE(&shake128, &testVectorSHAKE128_3);
+    testSHAKEBatch();
 
     Serial.println();
 
@@ -0,0 +1,228 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+This example runs tests on the SHAKE counter mode implementation to verify
+correct behaviour.
+*/
+
+#include <Crypto.h>
+#include <SHAKECTR.h>
+#include <string.h>
+
+#define MAX_PLAINTEXT_SIZE  36
+#define MAX_CIPHERTEXT_SIZE 36
+
+struct TestVector
+{
+    const char *name;
+    byte key[32];
+    size_t keyLen;
+    byte iv[16];
+    uint32_t offset;
+    byte plaintext[MAX_PLAINTEXT_SIZE];
+    byte ciphertext[MAX_CIPHERTEXT_SIZE];
+    size_t size;
+};
+
+// Generated with Python's hashlib from the construction described in
+// SHAKECTR.cpp.
+static TestVector const testVectorSHAKE128CTR1 = {
+    .name        = "SHAKE128CTR #1",
+    .key         = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F},
+    .keyLen      = 16,
+    .iv          = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+                    0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF},
+    .offset      = 0,
+    .plaintext   = {'T', 'h', 'e', ' ', 'q', 'u', 'i', 'c',
+                    'k', ' ', 'b', 'r', 'o', 'w', 'n', ' ',
+                    'f', 'o', 'x', ' ', 'j', 'u', 'm', 'p',
+                    's', ' ', 'o', 'v', 'e', 'r', ' ', 't',
+                    'h', 'e', ' ', 'l'},
+    .ciphertext  = {0xDE, 0x83, 0x48, 0x7C, 0x5E, 0xA6, 0x1A, 0x99,
+                    0xE9, 0x45, 0x6B, 0x49, 0xF3, 0xA8, 0x3D, 0x46,
+                    0x5B, 0xED, 0x9A, 0xA2, 0xC2, 0xA3, 0x4E, 0xD5,
+                    0xE8, 0xB6, 0x52, 0x9B, 0xDE, 0x24, 0x56, 0x7B,
+                    0x0D, 0xA8, 0xEE, 0x3E},
+    .size        = 36
+};
+static TestVector const testVectorSHAKE128CTR2 = {
+    .name        = "SHAKE128CTR #2",
+    .key         = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F},
+    .keyLen      = 16,
+    .iv          = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+                    0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF},
+    .offset      = 1000,
+    .plaintext   = {'T', 'h', 'e', ' ', 'q', 'u', 'i', 'c',
+                    'k', ' ', 'b', 'r', 'o', 'w', 'n', ' ',
+                    'f', 'o', 'x', ' ', 'j', 'u', 'm', 'p',
+                    's', ' ', 'o', 'v', 'e', 'r', ' ', 't',
+                    'h', 'e', ' ', 'l'},
+    .ciphertext  = {0x9C, 0xD1, 0x35, 0x48, 0xD4, 0xD2, 0xB8, 0xB0,
+                    0xE9, 0xB9, 0x2A, 0x7B, 0xCE, 0xE4, 0xC0, 0x08,
+                    0x22, 0x99, 0x7C, 0xC8, 0xA8, 0xD0, 0xB7, 0xFA,
+                    0x23, 0x2B, 0x8C, 0x9C, 0x5A, 0x9A, 0x08, 0xD3,
+                    0x36, 0x9B, 0xB4, 0x3B},
+    .size        = 36
+};
+static TestVector const testVectorSHAKE256CTR1 = {
+    .name        = "SHAKE256CTR #1",
+    .key         = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+                    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+                    0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F},
+    .keyLen      = 32,
+    .iv          = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+                    0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF},
+    .offset      = 130,
+    .plaintext   = {'T', 'h', 'e', ' ', 'q', 'u', 'i', 'c',
+                    'k', ' ', 'b', 'r', 'o', 'w', 'n', ' ',
+                    'f', 'o', 'x', ' ', 'j', 'u', 'm', 'p',
+                    's', ' ', 'o', 'v', 'e', 'r', ' ', 't',
+                    'h', 'e', ' ', 'l'},
+    .ciphertext  = {0x9A, 0x6E, 0x61, 0x9E, 0x8C, 0x78, 0x6E, 0x0D,
+                    0x77, 0x27, 0xF4, 0x80, 0xA0, 0xD8, 0xD3, 0x30,
+                    0x1E, 0x7C, 0xE4, 0x8E, 0x76, 0x51, 0x51, 0x7C,
+                    0x2E, 0xA8, 0x84, 0x3C, 0xF0, 0x65, 0x79, 0x4F,
+                    0xB8, 0x6B, 0xB6, 0x5F},
+    .size        = 36
+};
+
+SHAKE128CTR shake128ctr;
+SHAKE256CTR shake256ctr;
+
+byte buffer[128];
+
+bool testCipher_N(SHAKECTR *cipher, const struct TestVector *test, size_t inc)
+{
+    byte output[MAX_CIPHERTEXT_SIZE];
+    size_t posn, len;
+
+    cipher->clear();
+    if (!cipher->setKey(test->key, test->keyLen)) {
+        Serial.print("setKey ");
+        return false;
+    }
+    if (!cipher->setIV(test->iv, cipher->ivSize())) {
+        Serial.print("setIV ");
+        return false;
+    }
+
+    // Sequential encryption after seeking to the offset.
+    memset(output, 0xBA, sizeof(output));
+    cipher->seek(test->offset);
+    for (posn = 0; posn < test->size; posn += inc) {
+        len = test->size - posn;
+        if (len > inc)
+            len = inc;
+        cipher->encrypt(output + posn, test->plaintext + posn, len);
+    }
+    if (memcmp(output, test->ciphertext, test->size) != 0) {
+        Serial.print(output[0], HEX);
+        Serial.print("->");
+        Serial.print(test->ciphertext[0], HEX);
+        return false;
+    }
+    if (cipher->position() != test->offset + test->size)
+        return false;
+
+    // Random access decryption of each piece.
+    memset(output, 0xBA, sizeof(output));
+    for (posn = 0; posn < test->size; posn += inc) {
+        len = test->size - posn;
+        if (len > inc)
+            len = inc;
+        cipher->decryptAt(test->offset + posn, output + posn,
+                          test->ciphertext + posn, len);
+    }
+    if (memcmp(output, test->plaintext, test->size) != 0)
+        return false;
+
+    return true;
+}
+
+void testCipher(SHAKECTR *cipher, const struct TestVector *test)
+{
+    bool ok;
+
+    Serial.print(test->name);
+    Serial.print(" ... ");
+
+    ok  = testCipher_N(cipher, test, test->size);
+    ok &= testCipher_N(cipher, test, 1);
+    ok &= testCipher_N(cipher, test, 2);
+    ok &= testCipher_N(cipher, test, 5);
+    ok &= testCipher_N(cipher, test, 8);
+    ok &= testCipher_N(cipher, test, 13);
+    ok &= testCipher_N(cipher, test, 16);
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+void perfCipherEncrypt(const char *name, SHAKECTR *cipher, const struct TestVector *test)
+{
+    unsigned long start;
+    unsigned long elapsed;
+    int count;
+
+    Serial.print(name);
+    Serial.print(" ... ");
+
+    cipher->setKey(test->key, test->keyLen);
+    cipher->setIV(test->iv, cipher->ivSize());
+    start = micros();
+    for (count = 0; count < 500; ++count) {
+        cipher->encrypt(buffer, buffer, sizeof(buffer));
+    }
+    elapsed = micros() - start;
+
+    Serial.print(elapsed / (sizeof(buffer) * 500.0));
+    Serial.print("us per byte, ");
+    Serial.print((sizeof(buffer) * 500.0 * 1000000.0) / elapsed);
+    Serial.println(" bytes per second");
+}
+
+void setup()
+{
+    Serial.begin(9600);
+
+    Serial.println();
+
+    Serial.println("Test Vectors:");
+    testCipher(&shake128ctr, &testVectorSHAKE128CTR1);
+    testCipher(&shake128ctr, &testVectorSHAKE128CTR2);
+    testCipher(&shake256ctr, &testVectorSHAKE256CTR1);
+
+    Serial.println();
+
+    Serial.println("Performance Tests:");
+    perfCipherEncrypt("SHAKE128CTR Encrypt", &shake128ctr, &testVectorSHAKE128CTR1);
+    perfCipherEncrypt("SHAKE256CTR Encrypt", &shake256ctr, &testVectorSHAKE256CTR1);
+}
+
+void loop()
+{
+}
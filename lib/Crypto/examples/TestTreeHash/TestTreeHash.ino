@@ -0,0 +1,207 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+This example runs tests on the TreeHash implementation to verify correct
+behaviour.
+*/
+
+#include <Crypto.h>
+#include <SHA256.h>
+#include <TreeHash.h>
+#include <ThreadPool.h>
+#include <string.h>
+
+#define HASH_SIZE 32
+
+struct TestTreeVector
+{
+    const char *name;
+    size_t dataLen;
+    size_t leafSize;
+    uint8_t hash[HASH_SIZE];
+};
+
+// TreeHash<SHA256> of the bytes 0, 1, 2, ... modulo 256, generated with
+// Python's hashlib from the construction described in TreeHash.cpp.
+// #3 is exactly one leaf, #4 one leaf plus a byte, and #5 and #6 have
+// 5 and 16 leaves, which exercises unbalanced and balanced trees.
+static TestTreeVector const testVectorTreeHash_1 = {
+    "TreeHash #1",
+    0,
+    64,
+    {0xA5, 0xAD, 0xA3, 0x11, 0xBC, 0xAC, 0xE3, 0x81,
+     0xFC, 0x16, 0xF9, 0xB4, 0xB7, 0x64, 0x99, 0x39,
+     0x0D, 0x56, 0x64, 0x4C, 0x75, 0x4A, 0x65, 0xEC,
+     0x34, 0x8F, 0x52, 0x8A, 0xF8, 0x9B, 0x1C, 0xE6}
+};
+static TestTreeVector const testVectorTreeHash_2 = {
+    "TreeHash #2",
+    1,
+    64,
+    {0x33, 0xF1, 0x75, 0x16, 0x77, 0xEE, 0x10, 0xC6,
+     0x1A, 0xD5, 0x2D, 0xEE, 0xE9, 0xA8, 0x44, 0xA4,
+     0x16, 0x21, 0x62, 0x54, 0x8C, 0x2F, 0x3E, 0x84,
+     0x97, 0xDF, 0x04, 0x21, 0x9A, 0xF4, 0x48, 0x9B}
+};
+static TestTreeVector const testVectorTreeHash_3 = {
+    "TreeHash #3",
+    64,
+    64,
+    {0xC8, 0x9B, 0xCE, 0x17, 0xE6, 0xB6, 0x8A, 0x5D,
+     0x0B, 0xFC, 0xFD, 0x0F, 0x56, 0x85, 0x4A, 0x65,
+     0x0B, 0x67, 0x88, 0xEC, 0xD5, 0x73, 0x11, 0x5D,
+     0x7D, 0x83, 0xB1, 0x4C, 0x0D, 0x71, 0x9A, 0x5D}
+};
+static TestTreeVector const testVectorTreeHash_4 = {
+    "TreeHash #4",
+    65,
+    64,
+    {0x76, 0x32, 0x17, 0x73, 0x79, 0xEC, 0x12, 0xD0,
+     0x83, 0xF5, 0x45, 0x85, 0x32, 0x60, 0x9B, 0x7D,
+     0x7A, 0x69, 0xC9, 0x57, 0x88, 0xEA, 0x91, 0x1C,
+     0x35, 0x7C, 0x67, 0x54, 0x55, 0xBA, 0xB8, 0xE4}
+};
+static TestTreeVector const testVectorTreeHash_5 = {
+    "TreeHash #5",
+    300,
+    64,
+    {0x08, 0x68, 0x34, 0xD6, 0x74, 0x7D, 0xD7, 0xCC,
+     0xB6, 0xFB, 0x60, 0x90, 0xE7, 0xB1, 0x20, 0x3C,
+     0x14, 0xAA, 0x08, 0xC3, 0x1F, 0xAA, 0xD4, 0x66,
+     0x37, 0x1F, 0xE7, 0x6D, 0xD5, 0xCF, 0x77, 0x26}
+};
+static TestTreeVector const testVectorTreeHash_6 = {
+    "TreeHash #6",
+    1000,
+    64,
+    {0x7D, 0xB9, 0xEE, 0x32, 0x0C, 0x6E, 0xF0, 0x26,
+     0x33, 0x21, 0xFF, 0xF1, 0xB0, 0xB0, 0x0B, 0x2A,
+     0xC7, 0x49, 0x9B, 0x4F, 0xA1, 0xFD, 0xA1, 0x2E,
+     0x2A, 0x4C, 0x78, 0x72, 0x1E, 0xFF, 0xFC, 0x40}
+};
+static TestTreeVector const testVectorTreeHash_7 = {
+    "TreeHash #7",
+    1000,
+    65536,
+    {0xFA, 0x7B, 0x23, 0xEF, 0x78, 0xDD, 0xE3, 0xD8,
+     0x9F, 0x21, 0x51, 0xEE, 0x5F, 0xB0, 0x61, 0xF2,
+     0x83, 0x47, 0x05, 0x7D, 0x92, 0x5F, 0x68, 0x80,
+     0xEF, 0x1C, 0x73, 0x7C, 0xBC, 0x81, 0xE4, 0x8A}
+};
+
+// The test data repeats every 256 bytes, so it is streamed from this.
+byte buffer[256];
+
+bool testTreeHash_N(const struct TestTreeVector *test, size_t inc)
+{
+    TreeHash<SHA256> hash(test->leafSize);
+    size_t size = test->dataLen;
+    size_t posn, len;
+    uint8_t value[HASH_SIZE];
+
+    for (posn = 0; posn < size; posn += len) {
+        len = size - posn;
+        if (len > inc)
+            len = inc;
+        if (len > sizeof(buffer) - (posn % sizeof(buffer)))
+            len = sizeof(buffer) - (posn % sizeof(buffer));
+        hash.update(buffer + (posn % sizeof(buffer)), len);
+    }
+    hash.finalize(value, sizeof(value));
+    if (memcmp(value, test->hash, sizeof(value)) != 0)
+        return false;
+
+    return true;
+}
+
+// Checks the all-in-one hash() function against the vector, with and
+// without a thread pool where threads are available.
+bool testTreeHash_AllInOne(const struct TestTreeVector *test)
+{
+    uint8_t *data = new uint8_t [test->dataLen + 1];
+    uint8_t value[HASH_SIZE];
+    bool ok = true;
+
+    for (size_t posn = 0; posn < test->dataLen; ++posn)
+        data[posn] = buffer[posn % sizeof(buffer)];
+    TreeHash<SHA256>::hash(value, sizeof(value), data, test->dataLen,
+                           0, test->leafSize);
+    if (memcmp(value, test->hash, sizeof(value)) != 0)
+        ok = false;
+#if CRYPTO_THREADS
+    ThreadPool pool(4);
+    TreeHash<SHA256>::hash(value, sizeof(value), data, test->dataLen,
+                           &pool, test->leafSize);
+    if (memcmp(value, test->hash, sizeof(value)) != 0)
+        ok = false;
+#endif
+    delete [] data;
+    return ok;
+}
+
+void testTreeHash(const struct TestTreeVector *test)
+{
+    bool ok;
+
+    Serial.print(test->name);
+    Serial.print(" ... ");
+
+    ok  = testTreeHash_N(test, test->dataLen + 1);
+    ok &= testTreeHash_N(test, 1);
+    ok &= testTreeHash_N(test, 13);
+    ok &= testTreeHash_N(test, 63);
+    ok &= testTreeHash_N(test, 64);
+    ok &= testTreeHash_N(test, 65);
+    ok &= testTreeHash_AllInOne(test);
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+void setup()
+{
+    Serial.begin(9600);
+
+    for (size_t posn = 0; posn < sizeof(buffer); ++posn)
+        buffer[posn] = (byte)posn;
+
+    Serial.println();
+
+    Serial.print("State Size ... ");
+    Serial.println(sizeof(TreeHash<SHA256>));
+    Serial.println();
+
+    Serial.println("Test Vectors:");
+    testTreeHash(&testVectorTreeHash_1);
+    testTreeHash(&testVectorTreeHash_2);
+    testTreeHash(&testVectorTreeHash_3);
+    testTreeHash(&testVectorTreeHash_4);
+    testTreeHash(&testVectorTreeHash_5);
+    testTreeHash(&testVectorTreeHash_6);
+    testTreeHash(&testVectorTreeHash_7);
+}
+
+void loop()
+{
+}
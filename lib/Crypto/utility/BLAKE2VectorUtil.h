@@ -0,0 +1,78 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_BLAKE2VECTORUTIL_H
+#define CRYPTO_BLAKE2VECTORUTIL_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// BLAKE2s and BLAKE2b compression for 64-bit hosts.  The 4x4 working
+// state is held as four row vectors so that each half round is four
+// vector G functions, with the diagonal step done by rotating the lanes
+// of three rows.  BLAKE2s rows are 128-bit (SSE or NEON) and BLAKE2b rows
+// are 256-bit, which is one AVX2 register or a pair of SSE/NEON ones.  On
+// x86 copies built for SSE4.1 and AVX2 are picked at runtime when the CPU
+// has them.  The leaves of BLAKE2sp and BLAKE2bp run the other way around,
+// with one leaf per lane.  Define CRYPTO_BLAKE2_VEC to 0 to use the
+// portable rounds in BLAKE2s.cpp and BLAKE2b.cpp instead.
+
+#if !defined(CRYPTO_BLAKE2_VEC)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+#define CRYPTO_BLAKE2_VEC 1
+#else
+#define CRYPTO_BLAKE2_VEC 0
+#endif
+#endif
+
+#if CRYPTO_BLAKE2_VEC
+
+// Compress "blocks" consecutive 64-byte message blocks from "data" (any
+// alignment) into "h".  "t" is the byte counter for the first block, which
+// includes that block, and goes up by 64 for each block after it.  "f0"
+// and "f1" are the finalization and last node flags for every block, so
+// the last block of a message is compressed on its own.
+void blake2sVectorCompress(uint32_t h[8], const uint8_t *data, size_t blocks,
+                           uint64_t t, uint32_t f0, uint32_t f1);
+
+// Same for BLAKE2b with 128-byte blocks and a 128-bit counter "t0:t1".
+void blake2bVectorCompress(uint64_t h[8], const uint8_t *data, size_t blocks,
+                           uint64_t t0, uint64_t t1, uint64_t f0, uint64_t f1);
+
+// Compresses "blocks" blocks into each of "leaves" independent BLAKE2s
+// chaining values side by side in SIMD lanes, 8 at a time with AVX2 and 4
+// with SSE or NEON.  Block k of leaf j is at data + j * 64 + k * stride
+// and every leaf is at the same counter "t" and finalization flag "f0".
+// This is the leaf layer of BLAKE2sp and the output layer of BLAKE2Xs.
+void blake2sLanesCompress(uint32_t (*h)[8], size_t leaves,
+                          const uint8_t *data, size_t stride, size_t blocks,
+                          uint64_t t, uint32_t f0);
+
+// Same for BLAKE2b with 128-byte blocks, 4 lanes with AVX2 and 2 with SSE
+// or NEON.  This is the leaf layer of BLAKE2bp and the output layer of
+// BLAKE2Xb.
+void blake2bLanesCompress(uint64_t (*h)[8], size_t leaves,
+                          const uint8_t *data, size_t stride, size_t blocks,
+                          uint64_t t, uint64_t f0);
+
+#endif // CRYPTO_BLAKE2_VEC
+
+#endif
@@ -74,4 +74,43 @@
 
 #endif // HOST_BUILD
 
+// Big-endian loads from a byte buffer of any alignment.  Also safe when
+// the buffer is the word being written, for in-place conversion.
+static inline uint32_t loadBE32(const uint8_t *p)
+{
+    return (((uint32_t)p[0]) << 24) | (((uint32_t)p[1]) << 16) |
+           (((uint32_t)p[2]) << 8) | ((uint32_t)p[3]);
+}
+
+static inline uint64_t loadBE64(const uint8_t *p)
+{
+    return (((uint64_t)loadBE32(p)) << 32) | loadBE32(p + 4);
+}
+
+// Little-endian loads and stores for portable serialized formats.
+static inline uint32_t loadLE32(const uint8_t *p)
+{
+    return ((uint32_t)p[0]) | (((uint32_t)p[1]) << 8) |
+           (((uint32_t)p[2]) << 16) | (((uint32_t)p[3]) << 24);
+}
+
+static inline uint64_t loadLE64(const uint8_t *p)
+{
+    return ((uint64_t)loadLE32(p)) | (((uint64_t)loadLE32(p + 4)) << 32);
+}
+
+static inline void storeLE32(uint8_t *p, uint32_t x)
+{
+    p[0] = (uint8_t)x;
+    p[1] = (uint8_t)(x >> 8);
+    p[2] = (uint8_t)(x >> 16);
+    p[3] = (uint8_t)(x >> 24);
+}
+
+static inline void storeLE64(uint8_t *p, uint64_t x)
+{
+    storeLE32(p, (uint32_t)x);
+    storeLE32(p + 4, (uint32_t)(x >> 32));
+}
+
 #endif
@@ -0,0 +1,69 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_KECCAKMULTIBUFFERUTIL_H
+#define CRYPTO_KECCAKMULTIBUFFERUTIL_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// Multi-buffer Keccak-p[1600] for host builds: independent sponge states
+// run through the permutation side by side, one state per 64-bit SIMD
+// lane, 8 with AVX-512, 4 with AVX2 and 2 with SSE2 or NEON.  The states
+// are transposed while they are permuted, so the same Keccak lane of every
+// state loads as one vector.  The rounds then only need 64-bit XOR,
+// AND-NOT and shifts, which all of those instruction sets have.  Define
+// CRYPTO_KECCAK_MB to 0 to leave them out.
+
+#if !defined(CRYPTO_KECCAK_MB)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+#define CRYPTO_KECCAK_MB 1
+#else
+#define CRYPTO_KECCAK_MB 0
+#endif
+#endif
+
+#if CRYPTO_KECCAK_MB
+
+// One state's worth of work: "blocks" permutations of the 25 lanes at "A".
+// If "input" is set, block i of it is XOR'ed into the first "rate" bytes of
+// the state before permutation i.  If "output" is set, the first "rate"
+// bytes of the state are copied to block i of it after permutation i.
+// The rate must be a multiple of 8.
+struct KeccakMultiBufferJob
+{
+    uint64_t *A;
+    const uint8_t *input;
+    uint8_t *output;
+    size_t blocks;
+    size_t rate;
+};
+
+// Number of lanes the CPU runs at once.  Even 2 lanes beat the portable
+// scalar permutation in KeccakCore.cpp.
+size_t keccakMultiBufferLanes();
+
+// Runs all of the jobs, refilling each lane from the queue as it drains.
+void keccakMultiBufferPermute(KeccakMultiBufferJob *jobs, size_t count);
+
+#endif // CRYPTO_KECCAK_MB
+
+#endif
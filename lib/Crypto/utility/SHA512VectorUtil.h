@@ -0,0 +1,52 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_SHA512VECTORUTIL_H
+#define CRYPTO_SHA512VECTORUTIL_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// SHA-512 compression for 64-bit hosts.  The message schedule is expanded
+// two words at a time in 128-bit vectors (SSE2 or NEON), interleaved with
+// fully unrolled scalar rounds that keep the working variables in
+// registers.  On x86 a second copy built for AVX2 and BMI2, which gives
+// VEX encodings and the non-destructive rorx rotate, is picked at runtime
+// when the CPU has them.  Define CRYPTO_SHA512_VEC to 0 to use the
+// portable rounds in SHA512.cpp instead.
+
+#if !defined(CRYPTO_SHA512_VEC)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+#define CRYPTO_SHA512_VEC 1
+#else
+#define CRYPTO_SHA512_VEC 0
+#endif
+#endif
+
+#if CRYPTO_SHA512_VEC
+
+// Compress "blocks" consecutive 128-byte big-endian message blocks from
+// "data" (any alignment) into the host-order chaining value "h".
+void sha512VectorCompress(uint64_t h[8], const uint8_t *data, size_t blocks);
+
+#endif // CRYPTO_SHA512_VEC
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_SHAHARDWAREUTIL_H
+#define CRYPTO_SHAHARDWAREUTIL_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// Hardware SHA-1 and SHA-256 compression on host CPUs: the x86 SHA
+// extensions (SHA-NI) and the ARMv8 SHA1/SHA2 crypto extensions.  The
+// instructions are compiled in wherever the compiler can emit them and
+// used only if the CPU reports them at runtime, with the portable C
+// rounds as the fallback.  Define CRYPTO_SHA_HW to 0 to leave them out.
+//
+// x86 needs GCC or Clang (the code is built with a target attribute, so
+// no -msha is required).  On AArch64 the compiler must already target the
+// crypto extensions, e.g. -march=armv8-a+crypto; the Raspberry Pi 4's
+// BCM2711 does not implement them and always takes the C path.
+
+#if !defined(CRYPTO_SHA_HW)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRYPTO_SHA_HW 1
+#define CRYPTO_SHA_HW_X86 1
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) || \
+                               (defined(__ARM_FEATURE_SHA2) && defined(__ARM_FEATURE_SHA1)))
+#define CRYPTO_SHA_HW 1
+#define CRYPTO_SHA_HW_ARM 1
+#else
+#define CRYPTO_SHA_HW 0
+#endif
+#elif CRYPTO_SHA_HW
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRYPTO_SHA_HW_X86 1
+#elif defined(__aarch64__)
+#define CRYPTO_SHA_HW_ARM 1
+#else
+#error "CRYPTO_SHA_HW requires an x86 or AArch64 host"
+#endif
+#endif
+
+#if CRYPTO_SHA_HW
+
+// Runtime checks; the result is determined once and cached.
+bool sha1HardwareAvailable();
+bool sha256HardwareAvailable();
+
+// Compress "blocks" consecutive 64-byte big-endian message blocks from
+// "data" (any alignment) into the host-order chaining value "h".
+void sha1HardwareCompress(uint32_t h[5], const uint8_t *data, size_t blocks);
+void sha256HardwareCompress(uint32_t h[8], const uint8_t *data, size_t blocks);
+
+#endif // CRYPTO_SHA_HW
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CRYPTO_SHAMULTIBUFFERUTIL_H
+#define CRYPTO_SHAMULTIBUFFERUTIL_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// Multi-buffer SHA-256 for host builds: independent messages run through
+// the compression function side by side in SIMD lanes, 8 with AVX2 and 4
+// with SSE2 or NEON.  The lanes are written with GCC vector extensions so
+// one implementation serves every instruction set.  Define CRYPTO_SHA_MB
+// to 0 to leave them out.
+
+#if !defined(CRYPTO_SHA_MB)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__ARM_NEON))
+#define CRYPTO_SHA_MB 1
+#else
+#define CRYPTO_SHA_MB 0
+#endif
+#endif
+
+#if CRYPTO_SHA_MB
+
+// One message's worth of work: an optional block from "first", then
+// "blocks" consecutive blocks from "data", then an optional block from
+// "last", all compressed into the host-order chaining value "h".
+struct SHA256MultiBufferJob
+{
+    uint32_t *h;
+    const uint8_t *first;
+    const uint8_t *data;
+    size_t blocks;
+    const uint8_t *last;
+};
+
+// Number of lanes the CPU runs at once, or 1 if batching does not pay off
+// because single-stream hardware SHA-256 is faster.
+size_t sha256MultiBufferLanes();
+
+// Runs all of the jobs, refilling each lane from the queue as it drains.
+void sha256MultiBufferCompress(SHA256MultiBufferJob *jobs, size_t count);
+
+#endif // CRYPTO_SHA_MB
+
+#endif
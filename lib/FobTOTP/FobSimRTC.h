@@ -0,0 +1,53 @@
+#ifndef FOB_SIM_RTC_H
+#define FOB_SIM_RTC_H
+
+#include "FobTOTP.h"
+
+// --- SIMULATED RTC ---
+// Host-side model of the ATtiny1616 RTC as the firmware uses it: a 16-bit
+// RTC.CNT counting at 1024 Hz and an overflow ISR that adds 64 seconds to
+// totalSeconds.  Time is advanced in raw ticks so that oscillator error and
+// calibration can be applied by the caller.
+class FobSimRTC
+{
+public:
+    FobSimRTC() : totalSeconds(0), count(0), overflows(0) {}
+
+    void reset()
+    {
+        totalSeconds = 0;
+        count = 0;
+        overflows = 0;
+    }
+
+    // Equivalent of ISR(RTC_CNT_vect).
+    void overflowISR()
+    {
+        totalSeconds += FOB_RTC_OVERFLOW_SECONDS;
+        ++overflows;
+    }
+
+    // Advance the counter, running the ISR once per 16-bit wrap.
+    void advance(uint64_t ticks)
+    {
+        while (ticks > 0) {
+            uint32_t room = 0x10000UL - count;
+            if (ticks < room) {
+                count += (uint16_t)ticks;
+                return;
+            }
+            ticks -= room;
+            count = 0;
+            overflowISR();
+        }
+    }
+
+    // Equivalent of getRTCSeconds().
+    uint32_t seconds() const { return fobRTCSeconds(totalSeconds, count); }
+
+    uint32_t totalSeconds;
+    uint16_t count;
+    uint64_t overflows;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "FobTOTP.h"
+#include <Crypto.h>
+#include <string.h>
+
+FobTOTP::FobTOTP()
+    : timestep(FOB_TOTP_TIMESTEP)
+{
+    setKey("", 0);
+}
+
+// --- HMAC PREPARATION ---
+void FobTOTP::setKey(const void *key, size_t len)
+{
+    uint8_t block[64];
+    if (len > 64)
+        len = 64;
+    memcpy(block, key, len);
+    memset(block + len, 0, 64 - len);
+
+    // resetHMAC() XORs the inner pad into a full-block key; pre-XORing the
+    // difference of the two pads gives the outer state the same way.
+    hash.resetHMAC(block, 64);
+    hash.getMidstate(innerState);
+    for (uint8_t i = 0; i < 64; i++)
+        block[i] ^= (0x36 ^ 0x5C);
+    hash.resetHMAC(block, 64);
+    hash.getMidstate(outerState);
+    clean(block, sizeof(block));
+}
+
+// --- TOTP GENERATION ---
+uint32_t FobTOTP::generate(uint32_t time)
+{
+    return generateCounter(time / timestep);
+}
+
+uint32_t FobTOTP::generateCounter(uint64_t counter)
+{
+    uint8_t counterBytes[8];
+    for (int i = 7; i >= 0; --i) {
+        counterBytes[i] = counter & 0xFF;
+        counter >>= 8;
+    }
+
+    uint8_t tempHash[20];
+    hash.setMidstate(innerState, 1);
+    hash.update(counterBytes, sizeof(counterBytes));
+    hash.finalize(tempHash, sizeof(tempHash));
+
+    uint8_t finalHash[20];
+    hash.setMidstate(outerState, 1);
+    hash.update(tempHash, sizeof(tempHash));
+    hash.finalize(finalHash, sizeof(finalHash));
+
+    return truncate(finalHash);
+}
+
+// --- DYNAMIC TRUNCATION ---
+uint32_t FobTOTP::truncate(const uint8_t *hmac)
+{
+    int offset = hmac[19] & 0x0F;
+
+    uint32_t binary =
+        ((uint32_t)(hmac[offset]     & 0x7F) << 24) |
+        ((uint32_t)(hmac[offset + 1] & 0xFF) << 16) |
+        ((uint32_t)(hmac[offset + 2] & 0xFF) << 8)  |
+        ((uint32_t)(hmac[offset + 3] & 0xFF));
+
+    return binary % FOB_TOTP_MODULUS;
+}
@@ -0,0 +1,53 @@
+#ifndef FOB_TOTP_H
+#define FOB_TOTP_H
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <SHA1.h>
+
+// --- TIMEBASE ---
+// The RTC is clocked from the 32.768kHz internal oscillator through a
+// DIV32 prescaler, so RTC.CNT counts at 1024 Hz and the 16-bit counter
+// overflows every 64 seconds.
+#define FOB_RTC_TICKS_PER_SECOND 1024
+#define FOB_RTC_OVERFLOW_SECONDS 64
+
+// Seconds since boot from the overflow total kept by the ISR and the
+// current RTC count.  Shared by the firmware and the host-side tools.
+inline uint32_t fobRTCSeconds(uint32_t totalSeconds, uint16_t count)
+{
+    return totalSeconds + (count / FOB_RTC_TICKS_PER_SECOND);
+}
+
+// --- TOTP CONFIG ---
+#define FOB_TOTP_TIMESTEP 30
+#define FOB_TOTP_MODULUS  1000000UL
+
+// --- TOTP ENGINE ---
+// HMAC-SHA1 TOTP (RFC 6238) with the inner and outer HMAC states prepared
+// once in setKey(), so each code costs two SHA-1 blocks instead of four.
+// Only the two 20-byte chaining states are kept between codes, not the key
+// pads or a hash object per state, to save RAM on the fob.
+// Keys are limited to one SHA-1 block (64 bytes), as on the fob.
+class FobTOTP
+{
+public:
+    FobTOTP();
+
+    void setKey(const void *key, size_t len);
+    void setTimestep(uint32_t step) { timestep = step; }
+    uint32_t getTimestep() const { return timestep; }
+
+    uint32_t generate(uint32_t time);
+    uint32_t generateCounter(uint64_t counter);
+
+    static uint32_t truncate(const uint8_t *hmac);
+
+private:
+    SHA1 hash;
+    uint32_t innerState[5];
+    uint32_t outerState[5];
+    uint32_t timestep;
+};
+
+#endif
@@ -0,0 +1,314 @@
+"""
+Benchmark-driven selection of the lib/Crypto implementation variants.
+
+lib/Crypto carries several implementations of some primitives and picks one
+per platform at compile time:
+
+    aes128      full / small / tiny     CRYPTO_AES128_VARIANT (AESSelected128)
+    keccak      asm / c                 CRYPTO_KECCAK_AVR_ASM
+    gf128       asm / c                 CRYPTO_GF128_AVR_ASM
+    bignumber   8 / 16 / 32 / 64        BIGNUMBER_LIMB_<n>BIT
+
+As a PlatformIO pre script it reads per-variant timings and flash costs for
+the target from a benchmark file (bench/<env>.json unless
+custom_crypto_benchmarks says otherwise), picks the fastest combination that
+fits custom_crypto_flash_budget and adds the matching defines to the build.
+Without a benchmark file the library defaults are left alone.
+
+    [env:attiny1616]
+    extra_scripts = pre:scripts/crypto_select.py
+    custom_crypto_flash_budget = 6144
+    custom_crypto_weights = aes128=1, keccak=0      ; optional, default 1 each
+    custom_crypto_variants = bignumber=8            ; optional, pin a variant
+
+Benchmark file format:
+
+    {"target": "attiny1616",
+     "components": {"aes128": {"full": {"time": 310.0, "flash": 2410}, ...},
+                    "keccak": {"asm": {...}, "c": {...}}, ...}}
+
+"time" is microseconds per operation as printed by src/crypto_bench.cpp and
+"flash" is bytes.  The file is built up from bench runs with --merge:
+
+    python scripts/crypto_select.py --merge bench.txt \
+        --size-report .pio/build/<env>/size_report.json --out bench/<target>.json
+
+and the selection can be tried without a build:
+
+    python scripts/crypto_select.py --bench bench/attiny1616.json --budget 6144
+"""
+
+import argparse
+import itertools
+import json
+import os
+import re
+import sys
+
+BENCH_DIR = "bench"
+
+# Component -> variant -> preprocessor defines that select it.
+VARIANTS = {
+    "aes128": {
+        "full": [("CRYPTO_AES128_VARIANT", 0)],
+        "small": [("CRYPTO_AES128_VARIANT", 1)],
+        "tiny": [("CRYPTO_AES128_VARIANT", 2)],
+    },
+    "keccak": {
+        "asm": [("CRYPTO_KECCAK_AVR_ASM", 1)],
+        "c": [("CRYPTO_KECCAK_AVR_ASM", 0)],
+    },
+    "gf128": {
+        "asm": [("CRYPTO_GF128_AVR_ASM", 1)],
+        "c": [("CRYPTO_GF128_AVR_ASM", 0)],
+    },
+    "bignumber": {
+        "8": [("BIGNUMBER_LIMB_8BIT", 1)],
+        "16": [("BIGNUMBER_LIMB_16BIT", 1)],
+        "32": [("BIGNUMBER_LIMB_32BIT", 1)],
+        "64": [("BIGNUMBER_LIMB_64BIT", 1)],
+    },
+}
+
+# Where each variant's code lives in size_report.json, for --merge.  AES
+# variants share AES128.cpp, so they are told apart by the length-prefixed
+# class name in the mangled symbols; the others are one object per build.
+FLASH_SYMBOLS = {
+    ("aes128", "full"): ["6AES128", "10AESCommon"],
+    ("aes128", "small"): ["11AESSmall128", "10AESCommon"],
+    ("aes128", "tiny"): ["10AESTiny128"],
+}
+FLASH_OBJECTS = {
+    "keccak": "KeccakCore.cpp",
+    "gf128": "GF128.cpp",
+    "bignumber": "BigNumberUtil.cpp",
+}
+
+
+# --- SELECTION ---
+def parse_pairs(text):
+    """Parses "a=1, b=2" (commas or newlines) into a dict of strings."""
+    pairs = {}
+    for item in re.split(r"[,\n]", text or ""):
+        item = item.strip()
+        if not item:
+            continue
+        if "=" not in item:
+            raise ValueError("expected name=value, got %r" % item)
+        key, value = item.split("=", 1)
+        pairs[key.strip()] = value.strip()
+    return pairs
+
+
+def candidates(bench, pinned):
+    """Returns [(component, [(variant, time, flash), ...]), ...]."""
+    result = []
+    for component, variants in sorted(bench.get("components", {}).items()):
+        if component not in VARIANTS:
+            print("crypto_select: ignoring unknown component %r" % component)
+            continue
+        options = []
+        for variant, data in sorted(variants.items()):
+            if variant not in VARIANTS[component]:
+                print("crypto_select: ignoring unknown variant %s=%s" % (component, variant))
+                continue
+            if component in pinned and pinned[component] != variant:
+                continue
+            options.append((variant, float(data.get("time", 0)), int(data.get("flash", 0))))
+        if component in pinned and not options:
+            raise ValueError("pinned variant %s=%s has no benchmark data"
+                             % (component, pinned[component]))
+        if options:
+            result.append((component, options))
+    return result
+
+
+def select(bench, budget=0, weights=None, pinned=None):
+    """
+    Picks one variant per component, minimizing the weighted sum of each
+    component's time relative to its fastest variant, subject to the total
+    flash fitting the budget (0 = no budget).  Returns (choice, flash, fits)
+    where choice maps component -> variant.
+    """
+    weights = weights or {}
+    table = candidates(bench, pinned or {})
+    if not table:
+        return {}, 0, True
+
+    def cost(combo):
+        total = 0.0
+        for (component, options), (variant, time, flash) in zip(table, combo):
+            fastest = min(t for _, t, _ in options) or 1.0
+            total += float(weights.get(component, 1)) * time / fastest
+        return total
+
+    best = None
+    smallest = None
+    for combo in itertools.product(*[options for _, options in table]):
+        flash = sum(option[2] for option in combo)
+        if smallest is None or flash < smallest[1]:
+            smallest = (combo, flash)
+        if budget and flash > budget:
+            continue
+        key = (cost(combo), flash)
+        if best is None or key < best[0]:
+            best = (key, combo, flash)
+
+    if best is None:
+        combo, flash = smallest
+        fits = False
+    else:
+        combo, flash = best[1], best[2]
+        fits = True
+    choice = dict((component, option[0]) for (component, _), option in zip(table, combo))
+    return choice, flash, fits
+
+
+def defines_for(choice):
+    defines = []
+    for component in sorted(choice):
+        defines.extend(VARIANTS[component][choice[component]])
+    return defines
+
+
+def print_selection(target, choice, flash, fits, budget):
+    print("Crypto variants for %s:" % target)
+    for component in sorted(choice):
+        print("  %-10s %s" % (component, choice[component]))
+    if budget:
+        print("  flash      %d of %d bytes" % (flash, budget))
+    else:
+        print("  flash      %d bytes" % flash)
+    if not fits:
+        print("CRYPTO WARNING: no combination fits the %d byte budget, "
+              "using the smallest (%d bytes)" % (budget, flash))
+
+
+# --- MERGING BENCH RUNS ---
+def parse_bench_output(path):
+    """Reads "BENCH <component> <variant> <us>" lines from crypto_bench."""
+    results = {}
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) != 4 or parts[0] != "BENCH":
+                continue
+            try:
+                results[(parts[1], parts[2])] = float(parts[3])
+            except ValueError:
+                continue
+    return results
+
+
+def flash_of(component, variant, size_report):
+    """Flash bytes for a variant from a size_report.json, or None."""
+    if size_report is None:
+        return None
+    if (component, variant) in FLASH_SYMBOLS:
+        tokens = FLASH_SYMBOLS[(component, variant)]
+        total = sum(s["flash"] for s in size_report.get("symbols", [])
+                    if any(token in s["symbol"] for token in tokens))
+        return total
+    name = FLASH_OBJECTS.get(component)
+    for key, sizes in size_report.get("objects", {}).items():
+        if name and (name + ".o") in key:
+            return sizes["flash"]
+    return None
+
+
+def merge(bench_path, size_report_path, out_path, target):
+    if os.path.isfile(out_path):
+        with open(out_path, "r") as f:
+            data = json.load(f)
+    else:
+        data = {"target": target, "components": {}}
+    if target:
+        data["target"] = target
+    size_report = None
+    if size_report_path:
+        with open(size_report_path, "r") as f:
+            size_report = json.load(f)
+
+    results = parse_bench_output(bench_path)
+    if not results:
+        raise ValueError("no BENCH lines in %s" % bench_path)
+    for (component, variant), time in sorted(results.items()):
+        if variant not in VARIANTS.get(component, {}):
+            continue
+        entry = data["components"].setdefault(component, {}).setdefault(variant, {})
+        entry["time"] = time
+        flash = flash_of(component, variant, size_report)
+        if flash is not None:
+            entry["flash"] = flash
+        elif "flash" not in entry:
+            print("crypto_select: no flash size for %s=%s" % (component, variant))
+        print("  %-10s %-6s %10.3f us  %s bytes"
+              % (component, variant, time, entry.get("flash", "?")))
+
+    os.makedirs(os.path.dirname(out_path) or ".", exist_ok=True)
+    with open(out_path, "w") as f:
+        json.dump(data, f, indent=2, sort_keys=True)
+        f.write("\n")
+    print("Merged %d results into %s" % (len(results), out_path))
+
+
+# --- PLATFORMIO INTEGRATION ---
+def _setup_platformio(env):
+    project_dir = env.subst("$PROJECT_DIR")
+    env_name = env.subst("$PIOENV")
+
+    def option(name, default):
+        return env.GetProjectOption(name, default)
+
+    path = option("custom_crypto_benchmarks", os.path.join(BENCH_DIR, env_name + ".json"))
+    if not os.path.isabs(path):
+        path = os.path.join(project_dir, path)
+    if not os.path.isfile(path):
+        print("crypto_select: no benchmarks at %s, using the library defaults" % path)
+        return
+
+    with open(path, "r") as f:
+        bench = json.load(f)
+    budget = int(option("custom_crypto_flash_budget", 0))
+    weights = parse_pairs(option("custom_crypto_weights", ""))
+    pinned = parse_pairs(option("custom_crypto_variants", ""))
+
+    choice, flash, fits = select(bench, budget, weights, pinned)
+    print_selection(bench.get("target", env_name), choice, flash, fits, budget)
+    env.Append(CPPDEFINES=defines_for(choice))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Crypto variant selection from benchmarks")
+    parser.add_argument("--bench", help="benchmark JSON file to select from")
+    parser.add_argument("--budget", type=int, default=0, help="crypto flash budget in bytes")
+    parser.add_argument("--weights", default="", help='e.g. "aes128=2, keccak=0"')
+    parser.add_argument("--variants", default="", help='pinned variants, e.g. "bignumber=8"')
+    parser.add_argument("--merge", help="crypto_bench output to merge into --out")
+    parser.add_argument("--size-report", help="size_report.json from the bench build")
+    parser.add_argument("--out", help="benchmark JSON file written by --merge")
+    parser.add_argument("--target", help="target name recorded by --merge")
+    args = parser.parse_args()
+
+    if args.merge:
+        if not args.out:
+            parser.error("--merge needs --out")
+        merge(args.merge, args.size_report, args.out, args.target)
+        return 0
+    if not args.bench:
+        parser.error("one of --bench or --merge is required")
+
+    with open(args.bench, "r") as f:
+        bench = json.load(f)
+    choice, flash, fits = select(bench, args.budget, parse_pairs(args.weights),
+                                 parse_pairs(args.variants))
+    print_selection(bench.get("target", args.bench), choice, flash, fits, args.budget)
+    print("  defines    %s" % " ".join("-D%s=%s" % d for d in defines_for(choice)))
+    return 0 if fits else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
+else:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    _setup_platformio(env)  # noqa: F821
@@ -0,0 +1,355 @@
+"""
+Flash/RAM footprint report for a linked firmware image.
+
+Breaks the image down by library (Crypto, U8g2, core, app, toolchain),
+object file and symbol using the linker map, checks the totals against the
+board budget and flags growth against a stored baseline.
+
+As a PlatformIO extra script (see platformio.ini) it adds -Wl,-Map to the
+link, prints the report after every build and adds two targets:
+
+    pio run -e attiny1616                     # build + report
+    pio run -e attiny1616 -t size_baseline    # store the current sizes as baseline
+
+It can also be run on its own against an existing map file:
+
+    python scripts/size_report.py --map firmware.map --env attiny1616 \
+        --flash-budget 16384 --ram-budget 2048
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+
+BASELINE_DIR = "size_baseline"
+TOP_OBJECTS = 15
+TOP_SYMBOLS = 20
+
+# Output sections and the memories they occupy.  .data is stored in flash
+# and copied to RAM at startup; .rodata only exists as its own output
+# section on parts with memory-mapped flash (megaAVR/tinyAVR 0/1).
+FLASH_SECTIONS = (".text", ".rodata", ".progmem", ".init", ".fini", ".vectors")
+RAM_SECTIONS = (".bss", ".noinit")
+BOTH_SECTIONS = (".data",)
+
+
+# --- MAP PARSING ---
+def _memory_of(output_section):
+    """Returns (flash, ram) flags for an output section name."""
+    for name in BOTH_SECTIONS:
+        if output_section.startswith(name):
+            return True, True
+    for name in RAM_SECTIONS:
+        if output_section.startswith(name):
+            return False, True
+    for name in FLASH_SECTIONS:
+        if output_section.startswith(name):
+            return True, False
+    return False, False
+
+
+def library_of(path):
+    """Maps an input file from the map to a library bucket."""
+    base = os.path.basename(path)
+    archive = re.match(r"(.*?)\.a(\(.*\))?$", base)
+    if archive:
+        name = archive.group(1)
+        if name.startswith("lib"):
+            name = name[3:]
+        if name in ("gcc", "c", "m", "stdc++", "supc++", "atmega", "printf_flt") or \
+                "toolchain" in path:
+            return "toolchain"
+        if name.startswith("Framework"):
+            return "core"
+        return name
+    if "/src/" in path.replace("\\", "/") or path.startswith("src"):
+        return "app"
+    if "toolchain" in path or base.startswith("crt"):
+        return "toolchain"
+    return "other"
+
+
+def object_of(path):
+    """Short object name: "libCrypto.a(SHA1.cpp.o)" or "src/main.cpp.o"."""
+    norm = path.replace("\\", "/")
+    if "(" in norm:
+        return os.path.basename(norm)
+    parts = norm.split("/")
+    return "/".join(parts[-2:])
+
+
+def symbol_of(input_section):
+    """Symbol name encoded in a -ffunction-sections/-fdata-sections name."""
+    for prefix in (".text.", ".rodata.", ".data.", ".bss.", ".progmem.data.",
+                   ".progmem.gcc_sw_table.", ".progmem."):
+        if input_section.startswith(prefix):
+            return input_section[len(prefix):]
+    return None
+
+
+def parse_map(path):
+    """
+    Returns a list of (library, object, symbol, flash, ram) entries, one per
+    input section that contributes to the image.
+    """
+    entries = []
+    output_section = None
+    pending = None
+    in_memory_map = False
+    line_re = re.compile(r"^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S.*)$")
+
+    with open(path, "r", errors="replace") as f:
+        for raw in f:
+            line = raw.rstrip("\n")
+            if not in_memory_map:
+                if line.startswith("Linker script and memory map"):
+                    in_memory_map = True
+                continue
+            if line.startswith("/DISCARD/"):
+                break
+
+            # Output section header at column 0.
+            m = re.match(r"^(\.\S+)", line)
+            if m:
+                output_section = m.group(1)
+                pending = None
+                continue
+
+            # Input section, either on one line or wrapped after a long name.
+            m = re.match(r"^ (\.\S+|COMMON)\s*$", line)
+            if m:
+                pending = m.group(1)
+                continue
+            m = re.match(r"^ (\.\S+|COMMON)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S.*)$", line)
+            if m:
+                name, size, source = m.group(1), int(m.group(3), 16), m.group(4)
+            else:
+                m = line_re.match(line)
+                if not (m and pending):
+                    pending = None
+                    continue
+                name, size, source = pending, int(m.group(2), 16), m.group(3)
+            pending = None
+
+            if size == 0 or output_section is None:
+                continue
+            flash, ram = _memory_of(output_section)
+            if not (flash or ram):
+                continue
+            source = source.strip()
+            entries.append((library_of(source), object_of(source),
+                            symbol_of(name) or name,
+                            size if flash else 0, size if ram else 0))
+    return entries
+
+
+def demangle(names):
+    """Demangles C++ symbol names with c++filt when it is available."""
+    names = list(names)
+    try:
+        out = subprocess.run(["c++filt"], input="\n".join(names), capture_output=True,
+                             text=True, check=True).stdout.split("\n")
+        if len(out) >= len(names):
+            return dict(zip(names, out))
+    except (OSError, subprocess.CalledProcessError):
+        pass
+    return dict((n, n) for n in names)
+
+
+# --- REPORT ---
+def summarize(entries):
+    """Aggregates the entries by library, object and symbol."""
+    def add(table, key, flash, ram):
+        row = table.setdefault(key, [0, 0])
+        row[0] += flash
+        row[1] += ram
+
+    libraries, objects, symbols = {}, {}, {}
+    total = [0, 0]
+    for library, obj, symbol, flash, ram in entries:
+        add(libraries, library, flash, ram)
+        add(objects, "%s: %s" % (library, obj), flash, ram)
+        add(symbols, (library, symbol), flash, ram)
+        total[0] += flash
+        total[1] += ram
+    return {
+        "total": {"flash": total[0], "ram": total[1]},
+        "libraries": dict((k, {"flash": v[0], "ram": v[1]}) for k, v in libraries.items()),
+        "objects": dict((k, {"flash": v[0], "ram": v[1]}) for k, v in objects.items()),
+        "symbols": [{"library": k[0], "symbol": k[1], "flash": v[0], "ram": v[1]}
+                    for k, v in symbols.items()],
+    }
+
+
+def _by_size(items):
+    return sorted(items, key=lambda kv: (kv[1]["flash"] + kv[1]["ram"]), reverse=True)
+
+
+def _delta(now, before):
+    if before is None:
+        return ""
+    d = now - before
+    return "%+d" % d if d else "="
+
+
+def print_report(env_name, summary, baseline, flash_budget, ram_budget, tolerance):
+    """Prints the report and returns a list of budget/growth problems."""
+    problems = []
+    total = summary["total"]
+    base_total = baseline["total"] if baseline else None
+    base_libs = baseline["libraries"] if baseline else {}
+
+    print("")
+    print("=== Size report: %s ===" % env_name)
+    for label, key, budget in (("Flash", "flash", flash_budget), ("RAM", "ram", ram_budget)):
+        used = total[key]
+        line = "%-6s %7d bytes" % (label + ":", used)
+        if budget:
+            line += " of %d (%.1f%%)" % (budget, 100.0 * used / budget)
+            if used > budget:
+                problems.append("%s over budget by %d bytes" % (label, used - budget))
+        if base_total:
+            line += "  baseline %s" % _delta(used, base_total[key])
+            if used - base_total[key] > tolerance:
+                problems.append("%s grew by %d bytes" % (label, used - base_total[key]))
+        print(line)
+
+    print("")
+    print("%-24s %8s %8s %8s %8s" % ("library", "flash", "ram", "d.flash", "d.ram"))
+    for name, row in _by_size(summary["libraries"].items()):
+        before = base_libs.get(name)
+        print("%-24s %8d %8d %8s %8s" % (
+            name, row["flash"], row["ram"],
+            _delta(row["flash"], before["flash"] if before else (0 if baseline else None)),
+            _delta(row["ram"], before["ram"] if before else (0 if baseline else None))))
+        if baseline:
+            grew = row["flash"] - (before["flash"] if before else 0)
+            if grew > tolerance:
+                problems.append("%s flash grew by %d bytes" % (name, grew))
+
+    print("")
+    print("%-48s %8s %8s" % ("object", "flash", "ram"))
+    for name, row in _by_size(summary["objects"].items())[:TOP_OBJECTS]:
+        print("%-48s %8d %8d" % (name[:48], row["flash"], row["ram"]))
+
+    symbols = sorted(summary["symbols"], key=lambda s: s["flash"] + s["ram"], reverse=True)
+    symbols = symbols[:TOP_SYMBOLS]
+    names = demangle(s["symbol"] for s in symbols)
+    print("")
+    print("%-10s %-46s %8s %8s" % ("library", "symbol", "flash", "ram"))
+    for s in symbols:
+        print("%-10s %-46s %8d %8d" % (s["library"][:10], names[s["symbol"]][:46],
+                                       s["flash"], s["ram"]))
+
+    if baseline is None:
+        print("\nNo baseline stored for %s (pio run -e %s -t size_baseline)." % (env_name, env_name))
+    for problem in problems:
+        print("SIZE WARNING: %s" % problem)
+    print("")
+    return problems
+
+
+def baseline_path(project_dir, env_name):
+    return os.path.join(project_dir, BASELINE_DIR, env_name + ".json")
+
+
+def load_baseline(path):
+    if not os.path.isfile(path):
+        return None
+    with open(path, "r") as f:
+        return json.load(f)
+
+
+def save_baseline(path, summary):
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    stored = {"total": summary["total"], "libraries": summary["libraries"],
+              "objects": summary["objects"]}
+    with open(path, "w") as f:
+        json.dump(stored, f, indent=2, sort_keys=True)
+        f.write("\n")
+    print("Stored size baseline in %s" % path)
+
+
+def run(map_path, env_name, project_dir, flash_budget, ram_budget, tolerance,
+        update_baseline=False, report_path=None):
+    """Runs the report; returns the list of problems found."""
+    summary = summarize(parse_map(map_path))
+    path = baseline_path(project_dir, env_name)
+    if update_baseline:
+        save_baseline(path, summary)
+    problems = print_report(env_name, summary, load_baseline(path),
+                            flash_budget, ram_budget, tolerance)
+    if report_path:
+        with open(report_path, "w") as f:
+            json.dump(summary, f, indent=2, sort_keys=True)
+    return problems
+
+
+# --- PLATFORMIO INTEGRATION ---
+def _setup_platformio(env):
+    build_dir = env.subst("$BUILD_DIR")
+    map_path = os.path.join(build_dir, "firmware.map")
+    project_dir = env.subst("$PROJECT_DIR")
+    env_name = env.subst("$PIOENV")
+    env.Append(LINKFLAGS=["-Wl,-Map," + map_path])
+
+    def option(name, default):
+        return env.GetProjectOption(name, default)
+
+    def board_size(key, default):
+        try:
+            return int(env.BoardConfig().get(key, default))
+        except (TypeError, ValueError):
+            return default
+
+    flash_budget = int(option("custom_flash_budget", board_size("upload.maximum_size", 0)))
+    ram_budget = int(option("custom_ram_budget", board_size("upload.maximum_ram_size", 0)))
+    tolerance = int(option("custom_size_growth_tolerance", 0))
+    strict = str(option("custom_size_strict", "no")).lower() in ("1", "yes", "true")
+
+    def report(update_baseline):
+        problems = run(map_path, env_name, project_dir, flash_budget, ram_budget,
+                       tolerance, update_baseline,
+                       os.path.join(build_dir, "size_report.json"))
+        if problems and strict and not update_baseline:
+            sys.stderr.write("Size check failed for %s\n" % env_name)
+            env.Exit(1)
+
+    program = "$BUILD_DIR/${PROGNAME}$PROGSUFFIX"
+    env.AddPostAction(program, lambda *args, **kwargs: report(False))
+    env.AddCustomTarget(
+        name="size_baseline",
+        dependencies=program,
+        actions=[lambda *args, **kwargs: report(True)],
+        title="Size baseline",
+        description="Store the current flash/RAM breakdown as the size baseline")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flash/RAM footprint report from a linker map")
+    parser.add_argument("--map", required=True, help="linker map file")
+    parser.add_argument("--env", required=True, help="build environment name")
+    parser.add_argument("--project-dir", default=".", help="project root (for the baseline)")
+    parser.add_argument("--flash-budget", type=int, default=0)
+    parser.add_argument("--ram-budget", type=int, default=0)
+    parser.add_argument("--tolerance", type=int, default=0,
+                        help="bytes of growth allowed before flagging")
+    parser.add_argument("--update-baseline", action="store_true")
+    parser.add_argument("--json", help="write the full breakdown to this file")
+    parser.add_argument("--strict", action="store_true",
+                        help="exit with an error on budget overrun or growth")
+    args = parser.parse_args()
+
+    problems = run(args.map, args.env, args.project_dir, args.flash_budget, args.ram_budget,
+                   args.tolerance, args.update_baseline, args.json)
+    return 1 if (problems and args.strict) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
+else:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    _setup_platformio(env)  # noqa: F821
@@ -0,0 +1,1207 @@
+// Append-only, tamper-evident audit log for the backend's CSV loggers.
+//
+// backend/app.py and backend/uart_reader.py pipe their CSV rows into
+// "append", which writes them to the log unchanged and keeps a Merkle tree
+// over the rows next to it.  The tree is the one from RFC 9162 (Certificate
+// Transparency v2), hashed with BLAKE2s (default) or SHA-256:
+//
+//   leaf  = H(0x00 || row)           row without its "\n" or "\r\n"
+//   node  = H(0x01 || left || right)
+//   empty = H()
+//
+// A log LOG is made of three files:
+//
+//   LOG        the rows, one per line, readable by every existing consumer
+//              of the CSV logs (rtc_replay, spreadsheets).
+//   LOG.tree   16-byte header, then the 32-byte root of every complete
+//              subtree in post-order.  Appending a row appends its leaf and
+//              the parents it completes, so the file is never rewritten,
+//              and any subtree root is one read away.
+//   LOG.sth    one checkpoint per commit: "<size> <root> [<mac>]", with the
+//              MAC (HMAC-SHA256 or keyed BLAKE2s, --key-file) over the size
+//              and root.  Publishing or MACing checkpoints is what makes
+//              rewriting the rows together with the tree detectable.
+//
+// Rows are group-committed: they are collected until --batch rows are
+// pending or the oldest has waited --interval milliseconds, then written
+// with one write per file (and one fsync per file with --sync), instead of
+// a flush per row.  The rows go to disk before their tree nodes, so a crash
+// leaves rows the tree does not cover yet; the next "append" indexes them.
+// An existing CSV log is indexed the same way the first time it is opened.
+//
+// Inclusion proofs need O(log n) node reads: every sibling on the path is
+// a stored subtree root except the one right of the first left turn, which
+// is folded from the O(log n) stored roots of the tree's right edge.
+//
+// Build and run with:
+//   pio run -e native_auditlog
+//   python uart_reader.py                  (pipes into the tool, see backend/audit_log.py)
+//   .pio/build/native_auditlog/program verify attiny_log.csv
+//   .pio/build/native_auditlog/program prove attiny_log.csv 1234 > proof.txt
+//   .pio/build/native_auditlog/program check-proof --root <root> < proof.txt
+
+#include <Crypto.h>
+#include <BLAKE2s.h>
+#include <SHA256.h>
+#include <HMAC.h>
+#include <BLAKE2sMAC.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/types.h>
+#define AUDIT_HAVE_POSIX 1
+#else
+#include <io.h>
+#define fseeko      _fseeki64
+#define ftello      _ftelli64
+#define ftruncate   _chsize_s
+#define fileno      _fileno
+#define AUDIT_HAVE_POSIX 0
+#endif
+
+typedef std::chrono::steady_clock SteadyClock;
+
+// --- DEFAULTS ---
+#define NODE_SIZE           32
+#define TREE_HEADER_SIZE    16
+#define MAX_KEY_SIZE        64
+#define MAX_TREE_DEPTH      64
+static const char treeMagic[8] = {'F', 'O', 'B', 'A', 'U', 'D', 'T', '1'};
+static const unsigned defaultBatch = 64;
+static const unsigned defaultIntervalMs = 1000;
+#define COALESCE_MS         2
+
+enum HashId {
+    HashBLAKE2s = 1,
+    HashSHA256  = 2
+};
+
+struct Node {
+    uint8_t h[NODE_SIZE];
+};
+
+// --- OPTIONS ---
+struct AuditOptions {
+    int hashId;                 // 0 = from the tree file, else BLAKE2s.
+    unsigned batch;
+    unsigned intervalMs;
+    bool sync;
+    bool quiet;
+    const char *keyFile;
+    const char *trustedRoot;
+    uint8_t key[MAX_KEY_SIZE];
+    size_t keyLen;
+};
+
+// --- HEX HELPERS ---
+static std::string toHex(const uint8_t *data, size_t len)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (size_t i = 0; i < len; ++i) {
+        out += digits[data[i] >> 4];
+        out += digits[data[i] & 0x0F];
+    }
+    return out;
+}
+
+static bool fromHex(const std::string &s, uint8_t *out, size_t len)
+{
+    if (s.size() != len * 2)
+        return false;
+    for (size_t i = 0; i < len * 2; ++i) {
+        char c = s[i];
+        int v;
+        if (c >= '0' && c <= '9')
+            v = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            v = c - 'A' + 10;
+        else
+            return false;
+        if (i & 1)
+            out[i / 2] |= (uint8_t)v;
+        else
+            out[i / 2] = (uint8_t)(v << 4);
+    }
+    return true;
+}
+
+static const char *hashName(int hashId)
+{
+    return hashId == HashSHA256 ? "sha256" : "blake2s";
+}
+
+static int parseHashName(const char *name)
+{
+    if (!strcmp(name, "blake2s"))
+        return HashBLAKE2s;
+    if (!strcmp(name, "sha256"))
+        return HashSHA256;
+    return 0;
+}
+
+// --- TREE HASHING ---
+class TreeHasher {
+public:
+    explicit TreeHasher(int hashId)
+        : hash(hashId == HashSHA256 ? (Hash *)&sha256 : (Hash *)&blake2s) {}
+
+    void leaf(Node &out, const char *row, size_t len)
+    {
+        // Prefix and row in one update, as for node().
+        input.assign(1, '\0');
+        input.append(row, len);
+        hash->reset();
+        hash->update(input.data(), input.size());
+        hash->finalize(out.h, NODE_SIZE);
+    }
+
+    void node(Node &out, const Node &left, const Node &right)
+    {
+        // One update, so the first block is compressed in place.
+        uint8_t input[1 + 2 * NODE_SIZE];
+        input[0] = 0x01;
+        memcpy(input + 1, left.h, NODE_SIZE);
+        memcpy(input + 1 + NODE_SIZE, right.h, NODE_SIZE);
+        hash->reset();
+        hash->update(input, sizeof(input));
+        hash->finalize(out.h, NODE_SIZE);
+    }
+
+    void empty(Node &out)
+    {
+        hash->reset();
+        hash->finalize(out.h, NODE_SIZE);
+    }
+
+private:
+    BLAKE2s blake2s;
+    SHA256 sha256;
+    Hash *hash;
+    std::string input;
+};
+
+// MAC over a checkpoint: the tree size as 8 big-endian bytes, then the root.
+static std::string checkpointMac(int hashId, const AuditOptions &options,
+                                 uint64_t size, const Node &root)
+{
+    uint8_t message[8 + NODE_SIZE];
+    uint8_t mac[NODE_SIZE];
+    for (int i = 0; i < 8; ++i)
+        message[i] = (uint8_t)(size >> (56 - 8 * i));
+    memcpy(message + 8, root.h, NODE_SIZE);
+    if (hashId == HashSHA256) {
+        HMAC<SHA256> hmac;
+        hmac.setKey(options.key, options.keyLen);
+        hmac.compute(mac, sizeof(mac), message, sizeof(message));
+    } else {
+        // BLAKE2s takes at most 32 key bytes; longer keys are hashed first
+        // as HMAC does with keys longer than a block.
+        uint8_t shortKey[BLAKE2s::HASH_SIZE];
+        const uint8_t *key = options.key;
+        size_t keyLen = options.keyLen;
+        if (keyLen > sizeof(shortKey)) {
+            BLAKE2s longKey;
+            longKey.update(options.key, options.keyLen);
+            longKey.finalize(shortKey, sizeof(shortKey));
+            key = shortKey;
+            keyLen = sizeof(shortKey);
+        }
+        BLAKE2sMAC keyed;
+        keyed.setKey(key, keyLen);
+        keyed.compute(mac, sizeof(mac), message, sizeof(message));
+        clean(shortKey, sizeof(shortKey));
+    }
+    std::string hex = toHex(mac, sizeof(mac));
+    clean(mac, sizeof(mac));
+    return hex;
+}
+
+// --- TREE LAYOUT ---
+// Post-order positions: leaf i is preceded by the 2i - popcount(i) nodes of
+// the leaves before it, and a complete subtree is stored right after its
+// last leaf's completed parents.
+static unsigned popCount(uint64_t x)
+{
+    unsigned n = 0;
+    for (; x; x &= x - 1)
+        ++n;
+    return n;
+}
+
+static uint64_t treeNodes(uint64_t leaves)
+{
+    return 2 * leaves - popCount(leaves);
+}
+
+// Position of the root of the 2^level leaves starting at the aligned leaf
+// "first".
+static uint64_t nodePosition(uint64_t first, unsigned level)
+{
+    uint64_t last = first + ((uint64_t)1 << level) - 1;
+    return treeNodes(last) + level;
+}
+
+// Largest power of two strictly less than n (n >= 2).
+static uint64_t splitPoint(uint64_t n)
+{
+    uint64_t k = 1;
+    while (k * 2 < n)
+        k *= 2;
+    return k;
+}
+
+static unsigned levelOf(uint64_t powerOfTwo)
+{
+    unsigned level = 0;
+    while (((uint64_t)1 << level) < powerOfTwo)
+        ++level;
+    return level;
+}
+
+// --- LOG ---
+struct AuditLog {
+    std::string path;
+    FILE *rows;
+    FILE *tree;
+    FILE *sth;
+    int hashId;
+    TreeHasher *hasher;
+    uint64_t size;              // Rows covered by LOG.tree.
+    uint64_t rowCount;          // Complete rows in LOG.
+    uint64_t tornBytes;         // Bytes of an interrupted node write.
+    std::vector<Node> peaks;    // Roots of the right edge, largest first.
+
+    // Commit buffers.
+    std::string pendingRows;
+    std::vector<Node> pendingNodes;
+    uint64_t pendingCount;
+};
+
+static void initLog(AuditLog &log)
+{
+    log.rows = 0;
+    log.tree = 0;
+    log.sth = 0;
+    log.hashId = HashBLAKE2s;
+    log.hasher = 0;
+    log.size = 0;
+    log.rowCount = 0;
+    log.tornBytes = 0;
+    log.pendingCount = 0;
+}
+
+static void closeLog(AuditLog &log)
+{
+    if (log.rows)
+        fclose(log.rows);
+    if (log.tree)
+        fclose(log.tree);
+    if (log.sth)
+        fclose(log.sth);
+    delete log.hasher;
+    initLog(log);
+}
+
+// Reads the next row without its line ending.  Returns false at the end of
+// the file; "complete" is false for a last line with no newline.
+static bool readRow(FILE *file, std::string &row, bool &complete)
+{
+    row.clear();
+    int c;
+    while ((c = getc(file)) != EOF) {
+        if (c == '\n') {
+            if (!row.empty() && row[row.size() - 1] == '\r')
+                row.erase(row.size() - 1);
+            complete = true;
+            return true;
+        }
+        row += (char)c;
+    }
+    complete = false;
+    return !row.empty();
+}
+
+static bool readNode(AuditLog &log, uint64_t position, Node &node)
+{
+    if (fseeko(log.tree, (long long)(TREE_HEADER_SIZE + position * NODE_SIZE), SEEK_SET) != 0)
+        return false;
+    return fread(node.h, NODE_SIZE, 1, log.tree) == 1;
+}
+
+// Root of leaves [first, end), which starts on a subtree boundary as every
+// range in the RFC 9162 recursion does.
+static bool rangeRoot(AuditLog &log, uint64_t first, uint64_t end, Node &out)
+{
+    uint64_t n = end - first;
+    if ((n & (n - 1)) == 0)
+        return readNode(log, nodePosition(first, levelOf(n)), out);
+    uint64_t k = splitPoint(n);
+    Node left, right;
+    if (!readNode(log, nodePosition(first, levelOf(k)), left) ||
+            !rangeRoot(log, first + k, end, right))
+        return false;
+    log.hasher->node(out, left, right);
+    return true;
+}
+
+static void treeRoot(AuditLog &log, Node &out)
+{
+    if (log.peaks.empty()) {
+        log.hasher->empty(out);
+        return;
+    }
+    out = log.peaks.back();
+    for (size_t i = log.peaks.size() - 1; i-- > 0; )
+        log.hasher->node(out, log.peaks[i], out);
+}
+
+// Adds a leaf and the parents it completes to the tree.  "emit" receives
+// the new nodes in post-order.
+static void pushLeaf(std::vector<Node> &peaks, uint64_t &size, TreeHasher &hasher,
+                     const Node &leaf, std::vector<Node> &emit)
+{
+    Node current = leaf;
+    emit.push_back(current);
+    for (uint64_t index = size; index & 1; index >>= 1) {
+        hasher.node(current, peaks.back(), current);
+        peaks.pop_back();
+        emit.push_back(current);
+    }
+    peaks.push_back(current);
+    ++size;
+}
+
+static bool writeTreeHeader(AuditLog &log)
+{
+    uint8_t header[TREE_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, treeMagic, sizeof(treeMagic));
+    header[8] = (uint8_t)log.hashId;
+    return fwrite(header, sizeof(header), 1, log.tree) == 1 && fflush(log.tree) == 0;
+}
+
+// Opens LOG and its tree.  A writable open creates missing files and drops
+// a torn node at the end of the tree; a read-only open leaves the files
+// alone and ignores it.
+static bool openLog(AuditLog &log, const char *path, const AuditOptions &options, bool writable)
+{
+    initLog(log);
+    log.path = path;
+    std::string treePath = log.path + ".tree";
+    std::string sthPath = log.path + ".sth";
+
+    log.rows = fopen(path, writable ? "a+b" : "rb");
+    if (!log.rows) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+    log.tree = fopen(treePath.c_str(), writable ? "r+b" : "rb");
+    if (!log.tree && writable)
+        log.tree = fopen(treePath.c_str(), "w+b");
+    if (!log.tree) {
+        fprintf(stderr, "%s: cannot open\n", treePath.c_str());
+        return false;
+    }
+
+    // Header, or a new tree with the requested hash.
+    uint8_t header[TREE_HEADER_SIZE];
+    fseeko(log.tree, 0, SEEK_END);
+    long long treeBytes = ftello(log.tree);
+    if (treeBytes < TREE_HEADER_SIZE) {
+        if (!writable) {
+            fprintf(stderr, "%s: no tree header\n", treePath.c_str());
+            return false;
+        }
+        log.hashId = options.hashId ? options.hashId : HashBLAKE2s;
+        if (ftruncate(fileno(log.tree), 0) != 0 || fseeko(log.tree, 0, SEEK_SET) != 0 ||
+                !writeTreeHeader(log)) {
+            fprintf(stderr, "%s: cannot write\n", treePath.c_str());
+            return false;
+        }
+        treeBytes = TREE_HEADER_SIZE;
+    } else {
+        fseeko(log.tree, 0, SEEK_SET);
+        if (fread(header, sizeof(header), 1, log.tree) != 1 ||
+                memcmp(header, treeMagic, sizeof(treeMagic)) != 0 ||
+                (header[8] != HashBLAKE2s && header[8] != HashSHA256)) {
+            fprintf(stderr, "%s: not an audit log tree\n", treePath.c_str());
+            return false;
+        }
+        log.hashId = header[8];
+        if (options.hashId && options.hashId != log.hashId) {
+            fprintf(stderr, "%s: tree uses %s\n", treePath.c_str(), hashName(log.hashId));
+            return false;
+        }
+    }
+    log.hasher = new TreeHasher(log.hashId);
+
+    // Leaves in the tree; anything past the last complete leaf is torn.
+    uint64_t nodes = (uint64_t)(treeBytes - TREE_HEADER_SIZE) / NODE_SIZE;
+    uint64_t leaves = nodes / 2;
+    while (treeNodes(leaves + 1) <= nodes)
+        ++leaves;
+    while (leaves > 0 && treeNodes(leaves) > nodes)
+        --leaves;
+    log.tornBytes = (uint64_t)treeBytes - (TREE_HEADER_SIZE + treeNodes(leaves) * NODE_SIZE);
+    if (writable && log.tornBytes) {
+        fflush(log.tree);
+        if (ftruncate(fileno(log.tree), (long long)(TREE_HEADER_SIZE + treeNodes(leaves) * NODE_SIZE)) != 0) {
+            fprintf(stderr, "%s: cannot truncate\n", treePath.c_str());
+            return false;
+        }
+    }
+    log.size = leaves;
+
+    // Right edge of the tree.
+    uint64_t first = 0;
+    for (int level = MAX_TREE_DEPTH - 1; level >= 0; --level) {
+        if (!(leaves & ((uint64_t)1 << level)))
+            continue;
+        Node peak;
+        if (!readNode(log, nodePosition(first, (unsigned)level), peak)) {
+            fprintf(stderr, "%s: read error\n", treePath.c_str());
+            return false;
+        }
+        log.peaks.push_back(peak);
+        first += (uint64_t)1 << level;
+    }
+
+    log.sth = fopen(sthPath.c_str(), writable ? "ab" : "rb");
+    if (!log.sth && writable) {
+        fprintf(stderr, "%s: cannot open\n", sthPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// --- COMMIT ---
+static void syncFile(FILE *file)
+{
+#if AUDIT_HAVE_POSIX
+    fsync(fileno(file));
+#else
+    (void)file;
+#endif
+}
+
+static void addRow(AuditLog &log, const std::string &row)
+{
+    Node leaf;
+    log.hasher->leaf(leaf, row.data(), row.size());
+    log.pendingRows += row;
+    log.pendingRows += '\n';
+    pushLeaf(log.peaks, log.size, *log.hasher, leaf, log.pendingNodes);
+    ++log.pendingCount;
+}
+
+// Rows first, then the nodes that cover them, then the checkpoint.
+static bool commit(AuditLog &log, const AuditOptions &options)
+{
+    if (!log.pendingCount && log.pendingNodes.empty())
+        return true;
+    if (!log.pendingRows.empty()) {
+        if (fwrite(log.pendingRows.data(), 1, log.pendingRows.size(), log.rows) != log.pendingRows.size() ||
+                fflush(log.rows) != 0) {
+            fprintf(stderr, "%s: write error\n", log.path.c_str());
+            return false;
+        }
+        if (options.sync)
+            syncFile(log.rows);
+    }
+    fseeko(log.tree, 0, SEEK_END);
+    if (fwrite(log.pendingNodes.data(), NODE_SIZE, log.pendingNodes.size(), log.tree) != log.pendingNodes.size() ||
+            fflush(log.tree) != 0) {
+        fprintf(stderr, "%s.tree: write error\n", log.path.c_str());
+        return false;
+    }
+    if (options.sync)
+        syncFile(log.tree);
+
+    Node root;
+    treeRoot(log, root);
+    std::string line = std::to_string((unsigned long long)log.size) + " " + toHex(root.h, NODE_SIZE);
+    if (options.keyLen)
+        line += " " + checkpointMac(log.hashId, options, log.size, root);
+    line += "\n";
+    if (fputs(line.c_str(), log.sth) == EOF || fflush(log.sth) != 0) {
+        fprintf(stderr, "%s.sth: write error\n", log.path.c_str());
+        return false;
+    }
+    if (options.sync)
+        syncFile(log.sth);
+
+    log.rowCount += log.pendingCount;
+    log.pendingRows.clear();
+    log.pendingNodes.clear();
+    log.pendingCount = 0;
+    return true;
+}
+
+// Brings the tree up to date with rows it does not cover yet: rows written
+// before a crash, or a CSV log that was never indexed.
+static bool indexExisting(AuditLog &log, const AuditOptions &options)
+{
+    fseeko(log.rows, 0, SEEK_SET);
+    std::string row;
+    bool complete;
+    bool lastComplete = true;
+    uint64_t count = 0;
+    uint64_t indexed = 0;
+    while (readRow(log.rows, row, complete)) {
+        lastComplete = complete;
+        if (count++ < log.size)
+            continue;
+        Node leaf;
+        log.hasher->leaf(leaf, row.data(), row.size());
+        pushLeaf(log.peaks, log.size, *log.hasher, leaf, log.pendingNodes);
+        ++indexed;
+    }
+    if (count < log.size) {
+        fprintf(stderr, "%s: tree covers %llu rows but the log has %llu; refusing to append\n",
+                log.path.c_str(), (unsigned long long)log.size, (unsigned long long)count);
+        return false;
+    }
+    log.rowCount = count;
+
+    // A torn last row stays a row; end it so the next one starts cleanly.
+    if (!lastComplete) {
+        fseeko(log.rows, 0, SEEK_END);
+        if (fputc('\n', log.rows) == EOF || fflush(log.rows) != 0)
+            return false;
+    }
+    if (indexed && !options.quiet)
+        fprintf(stderr, "%s: indexed %llu existing rows\n",
+                log.path.c_str(), (unsigned long long)indexed);
+    return commit(log, options);
+}
+
+// --- APPEND ---
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int)
+{
+    stopRequested = 1;
+}
+
+static int runAppend(const char *path, const AuditOptions &options)
+{
+    AuditLog log;
+    if (!openLog(log, path, options, true) || !indexExisting(log, options)) {
+        closeLog(log);
+        return 1;
+    }
+
+#if AUDIT_HAVE_POSIX
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onSignal;
+    sigaction(SIGINT, &action, 0);
+    sigaction(SIGTERM, &action, 0);
+#else
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+#endif
+
+    uint64_t appended = 0;
+    unsigned long commits = 0;
+    std::string row;
+    SteadyClock::time_point oldest = SteadyClock::now();
+    bool ok = true;
+    bool eof = false;
+
+#if AUDIT_HAVE_POSIX
+    char buffer[65536];
+    bool receiving = false;
+    while (ok && !eof && !stopRequested) {
+        // Wait for input, but no longer than the oldest pending row may.
+        int timeout = -1;
+        if (log.pendingCount) {
+            long waited = (long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                SteadyClock::now() - oldest).count();
+            timeout = waited >= (long)options.intervalMs ? 0 : (int)(options.intervalMs - waited);
+
+            // While rows are arriving, let them collect in the pipe for a
+            // moment rather than waking up for each one.
+            if (receiving && timeout > 0) {
+                usleep((timeout < COALESCE_MS ? timeout : COALESCE_MS) * 1000);
+                receiving = false;
+                continue;
+            }
+        }
+        receiving = false;
+        struct pollfd fd;
+        fd.fd = 0;
+        fd.events = POLLIN;
+        fd.revents = 0;
+        int ready = poll(&fd, 1, timeout);
+        if (ready < 0 && errno != EINTR) {
+            ok = false;
+            break;
+        }
+        if (ready > 0) {
+            ssize_t n = read(0, buffer, sizeof(buffer));
+            if (n < 0 && errno != EINTR) {
+                ok = false;
+                break;
+            }
+            if (n == 0)
+                eof = true;
+            receiving = n > 0;
+            const char *next = buffer;
+            const char *end = buffer + (n > 0 ? n : 0);
+            while (next < end) {
+                const char *newline = (const char *)memchr(next, '\n', end - next);
+                if (!newline) {
+                    row.append(next, end - next);
+                    break;
+                }
+                row.append(next, newline - next);
+                next = newline + 1;
+                if (!row.empty() && row[row.size() - 1] == '\r')
+                    row.erase(row.size() - 1);
+                if (!log.pendingCount)
+                    oldest = SteadyClock::now();
+                addRow(log, row);
+                row.clear();
+                ++appended;
+                if (log.pendingCount >= options.batch) {
+                    ok = commit(log, options);
+                    ++commits;
+                    if (!ok)
+                        break;
+                }
+            }
+        }
+        if (ok && log.pendingCount &&
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    SteadyClock::now() - oldest).count() >= (long)options.intervalMs) {
+            ok = commit(log, options);
+            ++commits;
+        }
+    }
+#else
+    // No poll() on stdin: commit on batch size and at the end only.
+    bool complete;
+    while (ok && !stopRequested && readRow(stdin, row, complete)) {
+        addRow(log, row);
+        ++appended;
+        if (log.pendingCount >= options.batch) {
+            ok = commit(log, options);
+            ++commits;
+        }
+    }
+    row.clear();
+    eof = true;
+#endif
+
+    // A last row without a newline still counts at the end of the input.
+    if (ok && eof && !row.empty()) {
+        addRow(log, row);
+        ++appended;
+    }
+    if (ok && log.pendingCount) {
+        ok = commit(log, options);
+        ++commits;
+    }
+
+    if (!options.quiet) {
+        Node root;
+        treeRoot(log, root);
+        fprintf(stderr, "%s: appended %llu rows in %lu commits; size %llu root %s\n",
+                path, (unsigned long long)appended, commits,
+                (unsigned long long)log.size, toHex(root.h, NODE_SIZE).c_str());
+    }
+    closeLog(log);
+    return ok ? 0 : 1;
+}
+
+// --- ROOT ---
+static int runRoot(const char *path, const AuditOptions &options)
+{
+    AuditLog log;
+    if (!openLog(log, path, options, false)) {
+        closeLog(log);
+        return 1;
+    }
+    Node root;
+    treeRoot(log, root);
+    printf("%s %llu %s\n", hashName(log.hashId), (unsigned long long)log.size,
+           toHex(root.h, NODE_SIZE).c_str());
+    closeLog(log);
+    return 0;
+}
+
+// --- PROVE ---
+// RFC 9162 PATH(index, D[first:end]), deepest sibling first.
+static bool inclusionPath(AuditLog &log, uint64_t index, uint64_t first, uint64_t end,
+                          std::vector<Node> &path)
+{
+    uint64_t n = end - first;
+    if (n <= 1)
+        return true;
+    uint64_t k = splitPoint(n);
+    Node sibling;
+    if (index < first + k) {
+        if (!inclusionPath(log, index, first, first + k, path) ||
+                !rangeRoot(log, first + k, end, sibling))
+            return false;
+    } else {
+        if (!inclusionPath(log, index, first + k, end, path) ||
+                !readNode(log, nodePosition(first, levelOf(k)), sibling))
+            return false;
+    }
+    path.push_back(sibling);
+    return true;
+}
+
+static int runProve(const char *path, const char *indexArg, const AuditOptions &options)
+{
+    AuditLog log;
+    if (!openLog(log, path, options, false)) {
+        closeLog(log);
+        return 1;
+    }
+    char *end;
+    unsigned long long index = strtoull(indexArg, &end, 10);
+    if (*end != '\0' || index >= log.size) {
+        fprintf(stderr, "%s: no row %s in a tree of %llu rows\n",
+                path, indexArg, (unsigned long long)log.size);
+        closeLog(log);
+        return 1;
+    }
+
+    std::string row;
+    bool complete;
+    for (uint64_t i = 0; i <= index; ++i) {
+        if (!readRow(log.rows, row, complete)) {
+            fprintf(stderr, "%s: row %llu missing\n", path, (unsigned long long)i);
+            closeLog(log);
+            return 1;
+        }
+    }
+
+    std::vector<Node> proof;
+    if (!inclusionPath(log, index, 0, log.size, proof)) {
+        fprintf(stderr, "%s.tree: read error\n", path);
+        closeLog(log);
+        return 1;
+    }
+    Node root;
+    treeRoot(log, root);
+    printf("hash %s\n", hashName(log.hashId));
+    printf("size %llu\n", (unsigned long long)log.size);
+    printf("root %s\n", toHex(root.h, NODE_SIZE).c_str());
+    printf("index %llu\n", index);
+    printf("row %s\n", row.c_str());
+    for (size_t i = 0; i < proof.size(); ++i)
+        printf("path %s\n", toHex(proof[i].h, NODE_SIZE).c_str());
+    closeLog(log);
+    return 0;
+}
+
+// --- CHECK-PROOF ---
+// RFC 9162 section 2.1.3.2.
+static bool verifyInclusion(TreeHasher &hasher, uint64_t index, uint64_t size,
+                            const Node &leaf, const std::vector<Node> &path,
+                            const Node &root)
+{
+    if (index >= size)
+        return false;
+    uint64_t fn = index;
+    uint64_t sn = size - 1;
+    Node r = leaf;
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (sn == 0)
+            return false;
+        if ((fn & 1) || fn == sn) {
+            hasher.node(r, path[i], r);
+            if (!(fn & 1)) {
+                while (!(fn & 1) && fn != 0) {
+                    fn >>= 1;
+                    sn >>= 1;
+                }
+            }
+        } else {
+            hasher.node(r, r, path[i]);
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+    return sn == 0 && !memcmp(r.h, root.h, NODE_SIZE);
+}
+
+static int runCheckProof(const char *proofPath, const AuditOptions &options)
+{
+    FILE *file = proofPath ? fopen(proofPath, "rb") : stdin;
+    if (!file) {
+        fprintf(stderr, "%s: cannot open\n", proofPath);
+        return 1;
+    }
+    int hashId = HashBLAKE2s;
+    unsigned long long size = 0, index = 0;
+    bool haveSize = false, haveIndex = false, haveRoot = false, haveRow = false;
+    Node root;
+    std::string row, line;
+    std::vector<Node> path;
+    bool complete;
+    bool ok = true;
+    while (ok && readRow(file, line, complete)) {
+        size_t space = line.find(' ');
+        std::string name = line.substr(0, space);
+        std::string value = space == std::string::npos ? std::string() : line.substr(space + 1);
+        if (name == "hash") {
+            hashId = parseHashName(value.c_str());
+            ok = hashId != 0;
+        } else if (name == "size") {
+            size = strtoull(value.c_str(), 0, 10);
+            haveSize = true;
+        } else if (name == "index") {
+            index = strtoull(value.c_str(), 0, 10);
+            haveIndex = true;
+        } else if (name == "root") {
+            ok = haveRoot = fromHex(value, root.h, NODE_SIZE);
+        } else if (name == "row") {
+            row = value;
+            haveRow = true;
+        } else if (name == "path") {
+            Node node;
+            ok = fromHex(value, node.h, NODE_SIZE);
+            path.push_back(node);
+        }
+    }
+    if (proofPath)
+        fclose(file);
+    if (!ok || !haveSize || !haveIndex || !haveRoot || !haveRow) {
+        fprintf(stderr, "malformed proof\n");
+        return 1;
+    }
+
+    // The root in the proof is only as good as where it came from.
+    if (options.trustedRoot) {
+        Node trusted;
+        if (!fromHex(options.trustedRoot, trusted.h, NODE_SIZE)) {
+            fprintf(stderr, "--root: expected %d hex digits\n", NODE_SIZE * 2);
+            return 1;
+        }
+        if (memcmp(trusted.h, root.h, NODE_SIZE) != 0) {
+            printf("FAIL: proof is for root %s, not the trusted root\n",
+                   toHex(root.h, NODE_SIZE).c_str());
+            return 1;
+        }
+    }
+
+    TreeHasher hasher(hashId);
+    Node leaf;
+    hasher.leaf(leaf, row.data(), row.size());
+    if (!verifyInclusion(hasher, index, size, leaf, path, root)) {
+        printf("FAIL: row %llu is not in the tree of size %llu with root %s\n",
+               index, size, toHex(root.h, NODE_SIZE).c_str());
+        return 1;
+    }
+    printf("ok: row %llu is in the tree of size %llu with root %s%s\n",
+           index, size, toHex(root.h, NODE_SIZE).c_str(),
+           options.trustedRoot ? "" : " (root not checked, see --root)");
+    return 0;
+}
+
+// --- VERIFY ---
+struct Checkpoint {
+    uint64_t size;
+    Node root;
+    std::string mac;
+    unsigned long line;
+};
+
+// Rehashes every row, compares the result with every stored node and
+// checks each checkpoint against the tree at its size.
+static int runVerify(const char *path, const AuditOptions &options)
+{
+    AuditLog log;
+    if (!openLog(log, path, options, false)) {
+        closeLog(log);
+        return 1;
+    }
+    unsigned long failures = 0;
+    unsigned long warnings = 0;
+    if (log.tornBytes) {
+        printf("%s.tree: %llu bytes of an interrupted commit after the last leaf\n",
+               path, (unsigned long long)log.tornBytes);
+        ++warnings;
+    }
+
+    std::vector<Checkpoint> checkpoints;
+    if (log.sth) {
+        std::string line;
+        bool complete;
+        unsigned long number = 0;
+        while (readRow(log.sth, line, complete)) {
+            ++number;
+            char root[NODE_SIZE * 2 + 1];
+            char mac[NODE_SIZE * 2 + 1];
+            unsigned long long size;
+            int fields = sscanf(line.c_str(), "%llu %64s %64s", &size, root, mac);
+            Checkpoint cp;
+            cp.size = size;
+            cp.line = number;
+            if (fields < 2 || !fromHex(root, cp.root.h, NODE_SIZE)) {
+                printf("%s.sth:%lu: malformed checkpoint\n", path, number);
+                ++failures;
+                continue;
+            }
+            if (fields == 3)
+                cp.mac = mac;
+            if (!checkpoints.empty() && cp.size < checkpoints.back().size) {
+                printf("%s.sth:%lu: tree shrank from %llu to %llu rows\n", path, number,
+                       (unsigned long long)checkpoints.back().size, size);
+                ++failures;
+            }
+            checkpoints.push_back(cp);
+        }
+    } else {
+        printf("%s.sth: missing, no checkpoints to check\n", path);
+        ++warnings;
+    }
+
+    // Rebuild the tree from the rows and compare it node by node.
+    std::vector<Node> peaks;
+    std::vector<Node> nodes;
+    uint64_t size = 0;
+    uint64_t position = 0;
+    uint64_t firstBadRow = ~(uint64_t)0;
+    size_t nextCheckpoint = 0;
+    unsigned long macsChecked = 0;
+    std::string row;
+    bool complete;
+    fseeko(log.tree, TREE_HEADER_SIZE, SEEK_SET);
+    for (;;) {
+        // Checkpoints at the current size.
+        while (nextCheckpoint < checkpoints.size() && checkpoints[nextCheckpoint].size <= size) {
+            const Checkpoint &cp = checkpoints[nextCheckpoint++];
+            if (cp.size < size)
+                continue;   // Already reported as a shrinking tree.
+            Node root;
+            if (peaks.empty()) {
+                log.hasher->empty(root);
+            } else {
+                root = peaks.back();
+                for (size_t i = peaks.size() - 1; i-- > 0; )
+                    log.hasher->node(root, peaks[i], root);
+            }
+            if (memcmp(root.h, cp.root.h, NODE_SIZE) != 0) {
+                printf("%s.sth:%lu: root for %llu rows does not match the rows\n",
+                       path, cp.line, (unsigned long long)cp.size);
+                ++failures;
+            }
+            if (options.keyLen) {
+                if (cp.mac.empty() || cp.mac != checkpointMac(log.hashId, options, cp.size, cp.root)) {
+                    printf("%s.sth:%lu: %s\n", path, cp.line,
+                           cp.mac.empty() ? "checkpoint has no MAC" : "bad checkpoint MAC");
+                    ++failures;
+                } else {
+                    ++macsChecked;
+                }
+            }
+        }
+        if (size >= log.size || !readRow(log.rows, row, complete))
+            break;
+
+        Node leaf;
+        log.hasher->leaf(leaf, row.data(), row.size());
+        nodes.clear();
+        pushLeaf(peaks, size, *log.hasher, leaf, nodes);
+        for (size_t i = 0; i < nodes.size(); ++i, ++position) {
+            Node stored;
+            if (fread(stored.h, NODE_SIZE, 1, log.tree) != 1 ||
+                    memcmp(stored.h, nodes[i].h, NODE_SIZE) != 0) {
+                if (firstBadRow == ~(uint64_t)0)
+                    firstBadRow = size - 1;
+                ++failures;
+                // Keep comparing against what is stored from here on.
+                fseeko(log.tree, (long long)(TREE_HEADER_SIZE + (position + 1) * NODE_SIZE), SEEK_SET);
+            }
+        }
+    }
+    if (firstBadRow != ~(uint64_t)0)
+        printf("%s: row %llu (line %llu) or a later one does not match the tree\n",
+               path, (unsigned long long)firstBadRow, (unsigned long long)firstBadRow + 1);
+    if (size < log.size) {
+        printf("%s: tree covers %llu rows but the log has only %llu\n",
+               path, (unsigned long long)log.size, (unsigned long long)size);
+        ++failures;
+    } else {
+        uint64_t extra = 0;
+        while (readRow(log.rows, row, complete))
+            ++extra;
+        if (extra) {
+            printf("%s: %llu rows after the last commit are not covered yet\n",
+                   path, (unsigned long long)extra);
+            ++warnings;
+        }
+    }
+    for (; nextCheckpoint < checkpoints.size(); ++nextCheckpoint) {
+        printf("%s.sth:%lu: checkpoint for %llu rows is past the end of the tree\n",
+               path, checkpoints[nextCheckpoint].line,
+               (unsigned long long)checkpoints[nextCheckpoint].size);
+        ++failures;
+    }
+    if (!options.keyLen && !checkpoints.empty() && !checkpoints.back().mac.empty()) {
+        printf("%s.sth: checkpoint MACs not checked (no --key-file)\n", path);
+        ++warnings;
+    }
+
+    Node root;
+    treeRoot(log, root);
+    printf("%s: %s, %llu rows, %lu checkpoints (%lu MACs checked), root %s: %s\n",
+           path, hashName(log.hashId), (unsigned long long)log.size,
+           (unsigned long)checkpoints.size(), macsChecked,
+           toHex(root.h, NODE_SIZE).c_str(),
+           failures ? "FAILED" : (warnings ? "ok with warnings" : "ok"));
+    closeLog(log);
+    return failures ? 1 : 0;
+}
+
+// --- MAIN ---
+// A key file written by echo ends in "\n" or "\r\n"; that is dropped only
+// when the rest of the file is printable text, so binary keys are kept as
+// they are.
+static size_t textKeyLength(const uint8_t *data, size_t len)
+{
+    size_t keyLen = len;
+    if (keyLen > 0 && data[keyLen - 1] == '\n') {
+        --keyLen;
+        if (keyLen > 0 && data[keyLen - 1] == '\r')
+            --keyLen;
+    }
+    for (size_t posn = 0; posn < keyLen; ++posn) {
+        if (data[posn] < 0x20 || data[posn] > 0x7E)
+            return len;
+    }
+    return keyLen;
+}
+
+static bool loadKey(AuditOptions &options)
+{
+    FILE *file = fopen(options.keyFile, "rb");
+    if (!file) {
+        fprintf(stderr, "%s: cannot open\n", options.keyFile);
+        return false;
+    }
+    // Room for a full-size text key and its line ending, plus one byte to
+    // tell that the file is longer than that.
+    uint8_t data[MAX_KEY_SIZE + 3];
+    size_t len = fread(data, 1, sizeof(data), file);
+    fclose(file);
+    size_t keyLen = textKeyLength(data, len);
+    bool ok = false;
+    if (!keyLen)
+        fprintf(stderr, "%s: empty key\n", options.keyFile);
+    else if (keyLen > MAX_KEY_SIZE)
+        fprintf(stderr, "%s: key is longer than %d bytes\n", options.keyFile, MAX_KEY_SIZE);
+    else
+        ok = true;
+    if (ok) {
+        memcpy(options.key, data, keyLen);
+        options.keyLen = keyLen;
+    }
+    clean(data, sizeof(data));
+    return ok;
+}
+
+static void usage(const char *progname)
+{
+    fprintf(stderr, "Usage: %s append [options] LOG     append rows read from stdin\n", progname);
+    fprintf(stderr, "       %s root LOG                 print the hash, size and root\n", progname);
+    fprintf(stderr, "       %s prove LOG INDEX          print an inclusion proof for row INDEX\n", progname);
+    fprintf(stderr, "       %s check-proof [options] [PROOF]\n", progname);
+    fprintf(stderr, "       %s verify [options] LOG\n", progname);
+    fprintf(stderr, "  --hash blake2s|sha256   tree hash for a new log (default blake2s)\n");
+    fprintf(stderr, "  --batch N               rows per commit (default %u)\n", defaultBatch);
+    fprintf(stderr, "  --interval MS           longest a row waits for its commit (default %u)\n",
+            defaultIntervalMs);
+    fprintf(stderr, "  --sync                  fsync every commit\n");
+    fprintf(stderr, "  --key-file FILE         MAC key for checkpoints (append, verify)\n");
+    fprintf(stderr, "  --root HEX              trusted root to check the proof against\n");
+    fprintf(stderr, "  --quiet                 no summary on stderr\n");
+}
+
+int main(int argc, char **argv)
+{
+    AuditOptions options;
+    options.hashId = 0;
+    options.batch = defaultBatch;
+    options.intervalMs = defaultIntervalMs;
+    options.sync = false;
+    options.quiet = false;
+    options.keyFile = 0;
+    options.trustedRoot = 0;
+    options.keyLen = 0;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *command = argv[1];
+    std::vector<const char *> args;
+    for (int i = 2; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(arg, "--hash") && hasValue) {
+            options.hashId = parseHashName(argv[++i]);
+            if (!options.hashId) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(arg, "--batch") && hasValue) {
+            options.batch = (unsigned)strtoul(argv[++i], 0, 10);
+        } else if (!strcmp(arg, "--interval") && hasValue) {
+            options.intervalMs = (unsigned)strtoul(argv[++i], 0, 10);
+        } else if (!strcmp(arg, "--sync")) {
+            options.sync = true;
+        } else if (!strcmp(arg, "--key-file") && hasValue) {
+            options.keyFile = argv[++i];
+        } else if (!strcmp(arg, "--root") && hasValue) {
+            options.trustedRoot = argv[++i];
+        } else if (!strcmp(arg, "--quiet")) {
+            options.quiet = true;
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (options.batch == 0)
+        options.batch = 1;
+    if (options.keyFile && !loadKey(options))
+        return 1;
+
+    int result;
+    if (!strcmp(command, "append") && args.size() == 1) {
+        result = runAppend(args[0], options);
+    } else if (!strcmp(command, "root") && args.size() == 1) {
+        result = runRoot(args[0], options);
+    } else if (!strcmp(command, "prove") && args.size() == 2) {
+        result = runProve(args[0], args[1], options);
+    } else if (!strcmp(command, "check-proof") && args.size() <= 1) {
+        result = runCheckProof(args.empty() ? 0 : args[0], options);
+    } else if (!strcmp(command, "verify") && args.size() == 1) {
+        result = runVerify(args[0], options);
+    } else {
+        usage(argv[0]);
+        result = 1;
+    }
+    clean(options.key, sizeof(options.key));
+    return result;
+}
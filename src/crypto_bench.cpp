@@ -0,0 +1,242 @@
+// Benchmark of the lib/Crypto implementation variants that
+// scripts/crypto_select.py chooses between.
+//
+// Runs on the target (Arduino framework, results over Serial) or on the
+// host (native platform, results on stdout).  Each result is one line:
+//
+//   BENCH <component> <variant> <microseconds per operation>
+//
+// All three AES-128 variants are measured in one run.  The Keccak, GF128
+// and big-number variants are fixed per build, so the build flags decide
+// which of their variants is measured (see the *_bench environments in
+// platformio.ini).  Feed the output to:
+//
+//   python scripts/crypto_select.py --merge bench.txt
+//       --size-report .pio/build/<env>/size_report.json
+//       --out bench/<target>.json
+//
+// The "mac" lines compare the per-frame cost of the MACs for the fob to
+// backend channel.  They are for reading, not for crypto_select.py, which
+// skips them.  Both sets do not fit in the ATtiny1616's flash, so on AVR
+// the MAC lines replace the variant lines when built with
+// -DCRYPTO_BENCH_MAC=1 (the attiny1616_bench_mac environment).
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <stdio.h>
+#include <time.h>
+#endif
+#include <Crypto.h>
+#include <AES.h>
+#include <SHA3.h>
+#include <GHASH.h>
+#include <Poly1305.h>
+#include <SHA1.h>
+#include <SHA256.h>
+#include <HMAC.h>
+#include <BLAKE2s.h>
+#include <BLAKE2sMAC.h>
+#include <string.h>
+
+// --- VARIANT NAMES ---
+// Mirrors the defaults in KeccakCore.cpp, GF128.cpp and BigNumberUtil.h.
+#if defined(CRYPTO_KECCAK_AVR_ASM)
+#define KECCAK_ASM CRYPTO_KECCAK_AVR_ASM
+#elif defined(__AVR__)
+#define KECCAK_ASM 1
+#else
+#define KECCAK_ASM 0
+#endif
+
+#if defined(CRYPTO_GF128_AVR_ASM)
+#define GF128_ASM CRYPTO_GF128_AVR_ASM
+#elif defined(__AVR__)
+#define GF128_ASM 1
+#else
+#define GF128_ASM 0
+#endif
+
+#if BIGNUMBER_LIMB_8BIT
+#define LIMB_NAME "8"
+#elif BIGNUMBER_LIMB_16BIT
+#define LIMB_NAME "16"
+#elif BIGNUMBER_LIMB_32BIT
+#define LIMB_NAME "32"
+#else
+#define LIMB_NAME "64"
+#endif
+
+#if !defined(CRYPTO_BENCH_MAC)
+#if defined(__AVR__)
+#define CRYPTO_BENCH_MAC 0
+#else
+#define CRYPTO_BENCH_MAC 1
+#endif
+#endif
+
+// --- TIMING ---
+#if defined(ARDUINO)
+#define BENCH_ITERATIONS 200
+static unsigned long nowMicros() { return micros(); }
+#else
+#define BENCH_ITERATIONS 200000
+static unsigned long nowMicros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)(ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+}
+#endif
+
+static void report(const char *component, const char *variant, unsigned long elapsed)
+{
+    double perOp = (double)elapsed / BENCH_ITERATIONS;
+#if defined(ARDUINO)
+    Serial.print("BENCH ");
+    Serial.print(component);
+    Serial.print(' ');
+    Serial.print(variant);
+    Serial.print(' ');
+    Serial.println(perOp, 3);
+#else
+    printf("BENCH %s %s %.3f\n", component, variant, perOp);
+#endif
+}
+
+static uint8_t buffer[64];
+
+// One block encryption after the key schedule, as used by CTR/GCM.
+static void benchAES(BlockCipher *cipher, const char *variant)
+{
+    static const uint8_t key[16] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+    };
+    cipher->setKey(key, sizeof(key));
+    unsigned long start = nowMicros();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; ++i)
+        cipher->encryptBlock(buffer, buffer);
+    report("aes128", variant, nowMicros() - start);
+}
+
+// One SHA3-256 rate block of 136 bytes, absorbed from the 64-byte buffer
+// as 64 + 64 + 8, i.e. one Keccak-p permutation.
+static void benchKeccak()
+{
+    SHA3_256 sha3;
+    unsigned long start = nowMicros();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; ++i) {
+        sha3.update(buffer, 64);
+        sha3.update(buffer, 64);
+        sha3.update(buffer, 8);
+    }
+    report("keccak", KECCAK_ASM ? "asm" : "c", nowMicros() - start);
+}
+
+// One 16-byte GHASH block, i.e. one GF(2^128) multiplication.
+static void benchGF128()
+{
+    GHASH ghash;
+    ghash.reset(buffer);
+    unsigned long start = nowMicros();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; ++i)
+        ghash.update(buffer, 16);
+    report("gf128", GF128_ASM ? "asm" : "c", nowMicros() - start);
+}
+
+// One 16-byte Poly1305 block, which is big-number arithmetic on limb_t.
+static void benchBigNumber()
+{
+    Poly1305 poly;
+    poly.reset(buffer);
+    unsigned long start = nowMicros();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; ++i)
+        poly.update(buffer, 16);
+    report("bignumber", LIMB_NAME, nowMicros() - start);
+}
+
+#if CRYPTO_BENCH_MAC
+// One 32-byte frame under a 16-byte key.  The HMACs start from their
+// cached midstates, keyed BLAKE2s from BLAKE2s::reset() with the key.
+#define BENCH_FRAME_SIZE 32
+
+template <typename T>
+static void benchHMAC(const char *variant)
+{
+    HMAC<T> mac(buffer, 16);
+    unsigned long start = nowMicros();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; ++i)
+        mac.compute(buffer, mac.macSize(), buffer, BENCH_FRAME_SIZE);
+    report("mac", variant, nowMicros() - start);
+}
+
+static void benchMAC()
+{
+    benchHMAC<SHA1>("hmac-sha1");
+    benchHMAC<SHA256>("hmac-sha256");
+    {
+        BLAKE2s blake;
+        uint8_t key[16];
+        memcpy(key, buffer, sizeof(key));
+        unsigned long start = nowMicros();
+        for (unsigned long i = 0; i < BENCH_ITERATIONS; ++i) {
+            blake.reset(key, sizeof(key), 16);
+            blake.update(buffer, BENCH_FRAME_SIZE);
+            blake.finalize(buffer, 16);
+        }
+        report("mac", "blake2s-keyed", nowMicros() - start);
+    }
+    {
+        BLAKE2sMAC mac(buffer, 16, 16);
+        unsigned long start = nowMicros();
+        for (unsigned long i = 0; i < BENCH_ITERATIONS; ++i)
+            mac.compute(buffer, 16, buffer, BENCH_FRAME_SIZE);
+        report("mac", "blake2s-mac", nowMicros() - start);
+    }
+}
+#endif
+
+static void runBenchmarks()
+{
+    memset(buffer, 0xA5, sizeof(buffer));
+#if !defined(__AVR__) || !CRYPTO_BENCH_MAC
+    {
+        AES128 aes;
+        benchAES(&aes, "full");
+    }
+    {
+        AESSmall128 aes;
+        benchAES(&aes, "small");
+    }
+    {
+        AESTiny128 aes;
+        benchAES(&aes, "tiny");
+    }
+    benchKeccak();
+    benchGF128();
+    benchBigNumber();
+#endif
+#if CRYPTO_BENCH_MAC
+    benchMAC();
+#endif
+}
+
+#if defined(ARDUINO)
+void setup()
+{
+    Serial.begin(9600);
+    runBenchmarks();
+    Serial.println("BENCH done");
+}
+
+void loop()
+{
+}
+#else
+int main()
+{
+    runBenchmarks();
+    return 0;
+}
+#endif
@@ -0,0 +1,596 @@
+// Fob fleet simulator for backend load testing.
+//
+// Models a fleet of fobs, each with its own secret, RTC drift, time since
+// provisioning and press rate, and turns their button presses into code
+// checks at a fixed request rate.  Codes are produced by the firmware's own
+// timebase and TOTP engine (lib/FobTOTP on lib/Crypto SHA1).  Checks go
+// either to an in-process model of the backend's check (default) or to a
+// running backend's POST /api/devices/<id>/totp/check endpoint (--url),
+// which first has the fleet registered through POST /api/register.
+//
+// Requests are sent open-loop: arrivals follow a Poisson process at --rate
+// and latency is measured from the scheduled arrival time, so a backend
+// that falls behind shows up as queueing delay rather than as a lower
+// request rate.  --rate 0 sends back-to-back from every worker instead and
+// measures peak throughput.
+//
+// Build and run with:
+//   pio run -e native_fleet
+//   .pio/build/native_fleet/program --fobs 5000 --rate 500 --duration 30
+//   .pio/build/native_fleet/program --url http://127.0.0.1:5000 --fobs 200 --rate 50
+
+#include <FobTOTP.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#define FLEET_HAVE_HTTP 1
+#else
+#define FLEET_HAVE_HTTP 0
+#endif
+
+typedef std::chrono::steady_clock SteadyClock;
+
+// --- DEFAULTS ---
+#define SECRET_LENGTH    20      // generate_random_secret() in backend/server.py
+#define MAX_WINDOW       10
+#define MAX_OFFSET_BINS  (2 * MAX_WINDOW + 1)
+
+// --- RANDOM ---
+// Same xorshift64* generator as the soak test.  Only used under fleetLock
+// or before the workers start.
+static uint64_t rngState = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t rngNext()
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 0x2545F4914F6CDD1DULL;
+}
+
+static double rngUniform()
+{
+    return (rngNext() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double rngNormal()
+{
+    double u1 = 1.0 - rngUniform();
+    double u2 = rngUniform();
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+// --- FLEET ---
+struct FleetOptions {
+    uint32_t fobs;
+    double rate;
+    double duration;
+    uint64_t requests;
+    uint32_t threads;
+    double driftSigmaPpm;
+    double maxAgeDays;
+    double pressesPerDay;
+    double typoRate;
+    int window;
+    const char *url;
+};
+
+struct SimFob {
+    uint32_t deviceId;
+    char secret[SECRET_LENGTH + 1];
+    int64_t syncTime;           // Backend time the fob was provisioned at.
+    double driftPpm;            // RTC error, positive = fob runs fast.
+    double pressesPerDay;
+};
+
+static std::vector<SimFob> fleet;
+static std::vector<double> pressWeights;    // Cumulative presses per day.
+
+static void makeSecret(char *out)
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    for (int i = 0; i < SECRET_LENGTH; ++i)
+        out[i] = alphabet[rngNext() % (sizeof(alphabet) - 1)];
+    out[SECRET_LENGTH] = '\0';
+}
+
+static void buildFleet(const FleetOptions &options, int64_t now)
+{
+    fleet.resize(options.fobs);
+    pressWeights.resize(options.fobs);
+    double total = 0;
+    for (uint32_t i = 0; i < options.fobs; ++i) {
+        SimFob &fob = fleet[i];
+        fob.deviceId = i + 1;
+        makeSecret(fob.secret);
+        fob.syncTime = now - (int64_t)(rngUniform() * options.maxAgeDays * 86400.0);
+        fob.driftPpm = rngNormal() * options.driftSigmaPpm;
+        // Log-normal spread of usage with the requested mean.
+        fob.pressesPerDay = options.pressesPerDay * exp(rngNormal() - 0.5);
+        total += fob.pressesPerDay;
+        pressWeights[i] = total;
+    }
+}
+
+// Picks the fob behind the next press, in proportion to each fob's usage.
+static uint32_t pickFob()
+{
+    double target = rngUniform() * pressWeights.back();
+    return (uint32_t)(std::upper_bound(pressWeights.begin(), pressWeights.end(), target) -
+                      pressWeights.begin()) % (uint32_t)fleet.size();
+}
+
+// Wall clock in seconds, as the backend's get_rtc_timestamp() sees it.
+static double wallSeconds()
+{
+    using namespace std::chrono;
+    return duration_cast<duration<double> >(system_clock::now().time_since_epoch()).count();
+}
+
+// Code on the fob's display at backend wall time 'now'.  The fob's RTC has
+// run (now - syncTime) seconds at its own rate since provisioning; the
+// timebase and TOTP are then exactly the firmware's.
+static uint32_t fobCode(FobTOTP &totp, const SimFob &fob, double now)
+{
+    double elapsed = now - (double)fob.syncTime;
+    if (elapsed < 0)
+        elapsed = 0;
+    uint64_t ticks = (uint64_t)(elapsed * FOB_RTC_TICKS_PER_SECOND * (1.0 + fob.driftPpm * 1e-6));
+    uint32_t totalSeconds = (uint32_t)((ticks >> 16) * FOB_RTC_OVERFLOW_SECONDS);
+    totp.setKey(fob.secret, SECRET_LENGTH);
+    return totp.generate(fobRTCSeconds(totalSeconds, (uint16_t)(ticks & 0xFFFF)));
+}
+
+// --- VERIFIERS ---
+enum CheckResult {
+    CheckAccepted,
+    CheckRejected,
+    CheckError
+};
+
+// Model of check_device_totp() in backend/server.py: whole-second elapsed
+// time since sync, steps tried nearest first within +/- window.
+static CheckResult nativeCheck(FobTOTP &totp, const SimFob &fob, uint32_t code,
+                               int window, int *offset)
+{
+    int64_t elapsed = (int64_t)wallSeconds() - fob.syncTime;
+    if (elapsed < 0)
+        elapsed = 0;
+    totp.setKey(fob.secret, SECRET_LENGTH);
+    for (int d = 0; d <= window; ++d) {
+        for (int sign = 1; sign >= -1; sign -= 2) {
+            if (d == 0 && sign < 0)
+                break;
+            int64_t stepTime = elapsed + sign * d * FOB_TOTP_TIMESTEP;
+            if (stepTime < 0)
+                continue;
+            if (totp.generateCounter((uint64_t)stepTime / FOB_TOTP_TIMESTEP) == code) {
+                *offset = sign * d;
+                return CheckAccepted;
+            }
+        }
+    }
+    return CheckRejected;
+}
+
+#if FLEET_HAVE_HTTP
+// Minimal HTTP/1.0 client: one connection per request, as the Flask
+// development server closes the connection after each response anyway.
+struct HttpTarget {
+    std::string host;
+    std::string port;
+    struct addrinfo *addr;
+};
+
+static HttpTarget httpTarget;
+
+static bool parseUrl(const char *url)
+{
+    const char *p = url;
+    if (!strncmp(p, "http://", 7))
+        p += 7;
+    std::string hostPort(p);
+    size_t slash = hostPort.find('/');
+    if (slash != std::string::npos)
+        hostPort.resize(slash);
+    size_t colon = hostPort.rfind(':');
+    if (colon != std::string::npos) {
+        httpTarget.host = hostPort.substr(0, colon);
+        httpTarget.port = hostPort.substr(colon + 1);
+    } else {
+        httpTarget.host = hostPort;
+        httpTarget.port = "80";
+    }
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(httpTarget.host.c_str(), httpTarget.port.c_str(), &hints,
+                    &httpTarget.addr) != 0) {
+        fprintf(stderr, "Cannot resolve %s\n", url);
+        return false;
+    }
+    return true;
+}
+
+// Sends a JSON POST and returns the HTTP status, or -1 on a socket error.
+static int httpPost(const char *path, const char *json, std::string &body)
+{
+    int fd = -1;
+    for (struct addrinfo *ai = httpTarget.addr; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            break;
+        close(fd);
+        fd = -1;
+    }
+    if (fd < 0)
+        return -1;
+
+    char header[256];
+    int headerLen = snprintf(header, sizeof(header),
+                             "POST %s HTTP/1.0\r\nHost: %s\r\n"
+                             "Content-Type: application/json\r\nContent-Length: %u\r\n\r\n",
+                             path, httpTarget.host.c_str(), (unsigned)strlen(json));
+    std::string request(header, headerLen);
+    request += json;
+    size_t sent = 0;
+    while (sent < request.size()) {
+        ssize_t n = send(fd, request.data() + sent, request.size() - sent, 0);
+        if (n <= 0) {
+            close(fd);
+            return -1;
+        }
+        sent += (size_t)n;
+    }
+
+    std::string response;
+    char buf[1024];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+        response.append(buf, (size_t)n);
+    close(fd);
+
+    int status = 0;
+    if (sscanf(response.c_str(), "HTTP/%*s %d", &status) != 1)
+        return -1;
+    size_t start = response.find("\r\n\r\n");
+    body = (start == std::string::npos) ? std::string() : response.substr(start + 4);
+    return status;
+}
+
+// Value of "name": in a flat JSON object, or 0 if it is missing.
+static const char *jsonField(const std::string &body, const char *name)
+{
+    std::string key = std::string("\"") + name + "\"";
+    size_t pos = body.find(key);
+    if (pos == std::string::npos)
+        return 0;
+    pos = body.find(':', pos + key.size());
+    if (pos == std::string::npos)
+        return 0;
+    const char *p = body.c_str() + pos + 1;
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        ++p;
+    return p;
+}
+
+// Registers the fleet with the backend, which chooses the secrets and sync
+// times.  Fobs therefore start freshly provisioned; drift still applies.
+static bool registerFleet()
+{
+    for (size_t i = 0; i < fleet.size(); ++i) {
+        SimFob &fob = fleet[i];
+        char json[64];
+        snprintf(json, sizeof(json), "{\"name\": \"fleet-sim-%u\"}", (unsigned)(i + 1));
+        std::string body;
+        int status = httpPost("/api/register", json, body);
+        const char *id = jsonField(body, "id");
+        const char *secret = jsonField(body, "secret_key");
+        const char *sync = jsonField(body, "sync_time");
+        if (status != 201 || !id || !secret || !sync || *secret != '"') {
+            fprintf(stderr, "Registering fob %u failed (HTTP %d)\n", (unsigned)(i + 1), status);
+            return false;
+        }
+        fob.deviceId = (uint32_t)strtoul(id, 0, 10);
+        size_t len = strcspn(secret + 1, "\"");
+        if (len != SECRET_LENGTH) {
+            fprintf(stderr, "Unexpected secret length %u from backend\n", (unsigned)len);
+            return false;
+        }
+        memcpy(fob.secret, secret + 1, len);
+        fob.secret[len] = '\0';
+        fob.syncTime = strtoll(sync, 0, 10);
+    }
+    return true;
+}
+
+static CheckResult httpCheck(const SimFob &fob, uint32_t code, int *offset)
+{
+    char path[64], json[32];
+    snprintf(path, sizeof(path), "/api/devices/%u/totp/check", (unsigned)fob.deviceId);
+    snprintf(json, sizeof(json), "{\"code\": \"%06lu\"}", (unsigned long)code);
+    std::string body;
+    if (httpPost(path, json, body) != 200)
+        return CheckError;
+    const char *valid = jsonField(body, "valid");
+    if (!valid)
+        return CheckError;
+    if (strncmp(valid, "true", 4) != 0)
+        return CheckRejected;
+    const char *off = jsonField(body, "offset");
+    *offset = off ? atoi(off) : 0;
+    return CheckAccepted;
+}
+#endif
+
+// --- LOAD GENERATOR ---
+struct WorkerStats {
+    std::vector<float> latencyUs;
+    uint64_t accepted;
+    uint64_t rejected;
+    uint64_t typosSent;
+    uint64_t typosAccepted;
+    uint64_t errors;
+    uint64_t offsets[MAX_OFFSET_BINS];
+};
+
+static std::mutex fleetLock;
+static uint64_t issued = 0;
+static double nextArrival = 0;      // Seconds after the run start.
+
+// Claims the next request: its scheduled time, fob and whether the user
+// mistypes the code.  Returns false once the run is over.
+static bool nextRequest(const FleetOptions &options, double *when, uint32_t *fobIndex,
+                        bool *typo)
+{
+    std::lock_guard<std::mutex> guard(fleetLock);
+    if (options.requests && issued >= options.requests)
+        return false;
+    if (options.rate > 0) {
+        nextArrival += -log(1.0 - rngUniform()) / options.rate;
+        if (!options.requests && nextArrival > options.duration)
+            return false;
+    }
+    *when = nextArrival;
+    *fobIndex = pickFob();
+    *typo = rngUniform() < options.typoRate;
+    ++issued;
+    return true;
+}
+
+static void worker(const FleetOptions &options, SteadyClock::time_point start,
+                   WorkerStats *stats)
+{
+    FobTOTP fobTotp;
+    FobTOTP backendTotp;
+    double when;
+    uint32_t index;
+    bool typo;
+    while (nextRequest(options, &when, &index, &typo)) {
+        SteadyClock::time_point scheduled;
+        if (options.rate > 0) {
+            scheduled = start + std::chrono::duration_cast<SteadyClock::duration>(
+                                    std::chrono::duration<double>(when));
+            std::this_thread::sleep_until(scheduled);
+        } else {
+            scheduled = SteadyClock::now();
+            if (!options.requests &&
+                std::chrono::duration<double>(scheduled - start).count() > options.duration)
+                break;
+        }
+
+        const SimFob &fob = fleet[index];
+        uint32_t code = fobCode(fobTotp, fob, wallSeconds());
+        if (typo) {
+            // One wrong digit, as when a code is misread off the display.
+            static const uint32_t place[6] = {1, 10, 100, 1000, 10000, 100000};
+            uint32_t p = place[index % 6];
+            uint32_t digit = (code / p) % 10;
+            code += (((digit + 1 + index % 9) % 10) - digit) * p;
+            ++stats->typosSent;
+        }
+
+        int offset = 0;
+        CheckResult result;
+#if FLEET_HAVE_HTTP
+        if (options.url)
+            result = httpCheck(fob, code, &offset);
+        else
+#endif
+            result = nativeCheck(backendTotp, fob, code, options.window, &offset);
+
+        SteadyClock::time_point done = SteadyClock::now();
+        stats->latencyUs.push_back(
+            (float)std::chrono::duration<double, std::micro>(done - scheduled).count());
+        if (result == CheckAccepted) {
+            ++stats->accepted;
+            if (typo)
+                ++stats->typosAccepted;
+            if (offset >= -MAX_WINDOW && offset <= MAX_WINDOW)
+                ++stats->offsets[offset + MAX_WINDOW];
+        } else if (result == CheckRejected) {
+            ++stats->rejected;
+        } else {
+            ++stats->errors;
+        }
+    }
+}
+
+static double percentile(const std::vector<float> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t i = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+static void usage(const char *progname)
+{
+    fprintf(stderr, "Usage: %s [options]\n", progname);
+    fprintf(stderr, "  --fobs N              fleet size (default 5000)\n");
+    fprintf(stderr, "  --rate R              checks per second, 0 = as fast as possible (default 200)\n");
+    fprintf(stderr, "  --duration S          run time in seconds (default 10)\n");
+    fprintf(stderr, "  --requests N          stop after N checks instead\n");
+    fprintf(stderr, "  --threads N           concurrent workers (default 8)\n");
+    fprintf(stderr, "  --drift-sigma PPM     spread of fob RTC error (default 20)\n");
+    fprintf(stderr, "  --max-age DAYS        fobs provisioned up to DAYS ago (default 30)\n");
+    fprintf(stderr, "  --presses-per-day N   mean presses per fob per day (default 4)\n");
+    fprintf(stderr, "  --typo-rate F         fraction of codes entered with a wrong digit (default 0)\n");
+    fprintf(stderr, "  --window N            native check window in timesteps (default 1)\n");
+    fprintf(stderr, "  --url URL             check against a running backend instead\n");
+    fprintf(stderr, "  --seed N              random seed\n");
+}
+
+int main(int argc, char **argv)
+{
+    FleetOptions options;
+    options.fobs = 5000;
+    options.rate = 200;
+    options.duration = 10;
+    options.requests = 0;
+    options.threads = 8;
+    options.driftSigmaPpm = 20;
+    options.maxAgeDays = 30;
+    options.pressesPerDay = 4;
+    options.typoRate = 0;
+    options.window = 1;
+    options.url = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(arg, "--fobs") && hasValue) {
+            options.fobs = (uint32_t)strtoul(argv[++i], 0, 10);
+        } else if (!strcmp(arg, "--rate") && hasValue) {
+            options.rate = atof(argv[++i]);
+        } else if (!strcmp(arg, "--duration") && hasValue) {
+            options.duration = atof(argv[++i]);
+        } else if (!strcmp(arg, "--requests") && hasValue) {
+            options.requests = strtoull(argv[++i], 0, 10);
+        } else if (!strcmp(arg, "--threads") && hasValue) {
+            options.threads = (uint32_t)strtoul(argv[++i], 0, 10);
+        } else if (!strcmp(arg, "--drift-sigma") && hasValue) {
+            options.driftSigmaPpm = atof(argv[++i]);
+        } else if (!strcmp(arg, "--max-age") && hasValue) {
+            options.maxAgeDays = atof(argv[++i]);
+        } else if (!strcmp(arg, "--presses-per-day") && hasValue) {
+            options.pressesPerDay = atof(argv[++i]);
+        } else if (!strcmp(arg, "--typo-rate") && hasValue) {
+            options.typoRate = atof(argv[++i]);
+        } else if (!strcmp(arg, "--window") && hasValue) {
+            options.window = atoi(argv[++i]);
+        } else if (!strcmp(arg, "--url") && hasValue) {
+            options.url = argv[++i];
+        } else if (!strcmp(arg, "--seed") && hasValue) {
+            rngState = strtoull(argv[++i], 0, 10) | 1;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.fobs == 0 || options.threads == 0 || options.pressesPerDay <= 0 ||
+            options.window < 0 || options.window > MAX_WINDOW ||
+            (options.rate <= 0 && !options.requests && options.duration <= 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    buildFleet(options, (int64_t)wallSeconds());
+    if (options.url) {
+#if FLEET_HAVE_HTTP
+        if (!parseUrl(options.url))
+            return 1;
+        printf("Registering %u fobs with %s...\n", (unsigned)options.fobs, options.url);
+        if (!registerFleet())
+            return 1;
+#else
+        fprintf(stderr, "--url needs a POSIX host; use the native check on Windows\n");
+        return 1;
+#endif
+    }
+
+    double fleetRate = pressWeights.back() / 86400.0;
+    printf("fleet:        %u fobs, %.1f presses/day each, drift sigma %.1f ppm, "
+           "provisioned up to %.0f days ago\n",
+           (unsigned)options.fobs, options.pressesPerDay, options.driftSigmaPpm,
+           options.url ? 0.0 : options.maxAgeDays);
+    printf("load:         natural rate %.3f checks/s", fleetRate);
+    if (options.rate > 0)
+        printf(", running at %.1f/s (%.0f fobs' worth)",
+               options.rate, options.rate / fleetRate * options.fobs);
+    else
+        printf(", running closed-loop with %u workers", (unsigned)options.threads);
+    printf("\ntarget:       %s\n", options.url ? options.url : "native check model");
+
+    std::vector<WorkerStats> stats(options.threads);
+    std::vector<std::thread> workers;
+    SteadyClock::time_point start = SteadyClock::now();
+    for (uint32_t t = 0; t < options.threads; ++t) {
+        WorkerStats &s = stats[t];
+        s.accepted = s.rejected = s.typosSent = s.typosAccepted = s.errors = 0;
+        memset(s.offsets, 0, sizeof(s.offsets));
+        workers.push_back(std::thread(worker, std::cref(options), start, &s));
+    }
+    for (size_t t = 0; t < workers.size(); ++t)
+        workers[t].join();
+    double wall = std::chrono::duration<double>(SteadyClock::now() - start).count();
+
+    WorkerStats total;
+    total.accepted = total.rejected = total.typosSent = total.typosAccepted = total.errors = 0;
+    memset(total.offsets, 0, sizeof(total.offsets));
+    for (size_t t = 0; t < stats.size(); ++t) {
+        const WorkerStats &s = stats[t];
+        total.latencyUs.insert(total.latencyUs.end(), s.latencyUs.begin(), s.latencyUs.end());
+        total.accepted += s.accepted;
+        total.rejected += s.rejected;
+        total.typosSent += s.typosSent;
+        total.typosAccepted += s.typosAccepted;
+        total.errors += s.errors;
+        for (int b = 0; b < MAX_OFFSET_BINS; ++b)
+            total.offsets[b] += s.offsets[b];
+    }
+    std::sort(total.latencyUs.begin(), total.latencyUs.end());
+    uint64_t done = total.latencyUs.size();
+    uint64_t genuine = done - total.typosSent;
+    uint64_t genuineAccepted = total.accepted - total.typosAccepted;
+
+    printf("requests:     %llu in %.2f s, %.1f/s\n",
+           (unsigned long long)done, wall, wall > 0 ? done / wall : 0);
+    printf("latency us:   p50 %.0f  p90 %.0f  p99 %.0f  p99.9 %.0f  max %.0f\n",
+           percentile(total.latencyUs, 50), percentile(total.latencyUs, 90),
+           percentile(total.latencyUs, 99), percentile(total.latencyUs, 99.9),
+           total.latencyUs.empty() ? 0.0 : (double)total.latencyUs.back());
+    printf("results:      %llu of %llu genuine codes accepted (%.2f%%), "
+           "%llu of %llu typos accepted, %llu errors\n",
+           (unsigned long long)genuineAccepted, (unsigned long long)genuine,
+           genuine ? 100.0 * genuineAccepted / genuine : 0.0,
+           (unsigned long long)total.typosAccepted, (unsigned long long)total.typosSent,
+           (unsigned long long)total.errors);
+    printf("step offsets:");
+    for (int b = 0; b < MAX_OFFSET_BINS; ++b) {
+        if (total.offsets[b])
+            printf("  %+d: %llu", b - MAX_WINDOW, (unsigned long long)total.offsets[b]);
+    }
+    printf("\n");
+
+    return total.errors ? 2 : 0;
+}
@@ -0,0 +1,438 @@
+// Host-side soak test of the fob firmware timebase and TOTP path.
+//
+// Runs the firmware's button/display/sleep loop (src/main.cpp) against a
+// simulated RTC (lib/FobTOTP/FobSimRTC.h) at accelerated time: millions of
+// button presses separated by random standby periods, with every 64-second
+// counter overflow taken through the same totalSeconds += 64 ISR path.  Each
+// displayed code is checked against an independent HMAC-SHA1 TOTP reference
+// (below, not lib/Crypto) computed from the true 64-bit tick count, so
+// timebase wraparound and torn-read bugs show up as mismatches in minutes
+// rather than after years in the field.
+//
+// Build and run with:
+//   pio run -e native_soak
+//   .pio/build/native_soak/program --presses 1000000 --mean-idle 3600
+
+#include <FobTOTP.h>
+#include <FobSimRTC.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+// --- DEFAULTS ---
+static const char *defaultKey = "12345678901234567890";
+
+// Firmware behaviour (see loop() in src/main.cpp).
+#define DISPLAY_SECONDS  30      // Code stays on screen for 30 RTC seconds.
+#define REFRESH_MS       1000    // delay(1000) between refreshes.
+#define F_CPU_HZ         20000000UL
+
+// --- REFERENCE SHA-1 / HMAC / TOTP ---
+// Straightforward FIPS 180-4 / RFC 2104 / RFC 6238 implementation written
+// independently of lib/Crypto so that both sides of the check do not share
+// a bug.
+struct RefSHA1 {
+    uint32_t h[5];
+    uint8_t block[64];
+    uint32_t used;
+    uint64_t length;
+};
+
+static uint32_t refRotl(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+static void refSHA1Block(RefSHA1 &s)
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = ((uint32_t)s.block[i * 4] << 24) | ((uint32_t)s.block[i * 4 + 1] << 16) |
+               ((uint32_t)s.block[i * 4 + 2] << 8) | (uint32_t)s.block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; ++i)
+        w[i] = refRotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = s.h[0], b = s.h[1], c = s.h[2], d = s.h[3], e = s.h[4];
+    for (int i = 0; i < 80; ++i) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = refRotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = refRotl(b, 30);
+        b = a;
+        a = t;
+    }
+    s.h[0] += a;
+    s.h[1] += b;
+    s.h[2] += c;
+    s.h[3] += d;
+    s.h[4] += e;
+}
+
+static void refSHA1Init(RefSHA1 &s)
+{
+    s.h[0] = 0x67452301;
+    s.h[1] = 0xEFCDAB89;
+    s.h[2] = 0x98BADCFE;
+    s.h[3] = 0x10325476;
+    s.h[4] = 0xC3D2E1F0;
+    s.used = 0;
+    s.length = 0;
+}
+
+static void refSHA1Update(RefSHA1 &s, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        s.block[s.used++] = data[i];
+        if (s.used == 64) {
+            refSHA1Block(s);
+            s.used = 0;
+        }
+    }
+    s.length += len;
+}
+
+static void refSHA1Final(RefSHA1 &s, uint8_t out[20])
+{
+    uint64_t bits = s.length * 8;
+    uint8_t pad = 0x80;
+    refSHA1Update(s, &pad, 1);
+    pad = 0;
+    while (s.used != 56)
+        refSHA1Update(s, &pad, 1);
+    uint8_t len[8];
+    for (int i = 0; i < 8; ++i)
+        len[i] = (uint8_t)(bits >> (56 - 8 * i));
+    refSHA1Update(s, len, 8);
+    for (int i = 0; i < 20; ++i)
+        out[i] = (uint8_t)(s.h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+static void refHMACSHA1(const uint8_t *key, size_t keyLen,
+                        const uint8_t *msg, size_t msgLen, uint8_t out[20])
+{
+    uint8_t k[64];
+    memset(k, 0, sizeof(k));
+    if (keyLen > 64) {
+        RefSHA1 s;
+        refSHA1Init(s);
+        refSHA1Update(s, key, keyLen);
+        refSHA1Final(s, k);
+    } else {
+        memcpy(k, key, keyLen);
+    }
+
+    uint8_t pad[64];
+    uint8_t inner[20];
+    RefSHA1 s;
+    for (int i = 0; i < 64; ++i)
+        pad[i] = k[i] ^ 0x36;
+    refSHA1Init(s);
+    refSHA1Update(s, pad, 64);
+    refSHA1Update(s, msg, msgLen);
+    refSHA1Final(s, inner);
+    for (int i = 0; i < 64; ++i)
+        pad[i] = k[i] ^ 0x5C;
+    refSHA1Init(s);
+    refSHA1Update(s, pad, 64);
+    refSHA1Update(s, inner, 20);
+    refSHA1Final(s, out);
+}
+
+// 64-bit time, so a wrap of the fob's 32-bit seconds cannot hide here.
+static uint32_t refTOTP(const uint8_t *key, size_t keyLen, uint64_t seconds,
+                        uint32_t timestep, uint32_t modulus)
+{
+    uint64_t counter = seconds / timestep;
+    uint8_t msg[8];
+    for (int i = 0; i < 8; ++i)
+        msg[i] = (uint8_t)(counter >> (56 - 8 * i));
+    uint8_t mac[20];
+    refHMACSHA1(key, keyLen, msg, sizeof(msg), mac);
+    int offset = mac[19] & 0x0F;
+    uint32_t binary = ((uint32_t)(mac[offset] & 0x7F) << 24) |
+                      ((uint32_t)mac[offset + 1] << 16) |
+                      ((uint32_t)mac[offset + 2] << 8) |
+                      (uint32_t)mac[offset + 3];
+    return binary % modulus;
+}
+
+// RFC 6238 Appendix B (SHA-1 rows), reduced to 6 digits.
+static bool checkReferenceVectors()
+{
+    static const struct {
+        uint64_t time;
+        uint32_t code;
+    } vectors[] = {
+        {59ULL, 287082},
+        {1111111109ULL, 81804},
+        {1111111111ULL, 50471},
+        {1234567890ULL, 5924},
+        {2000000000ULL, 279037},
+        {20000000000ULL, 353130},
+    };
+    const uint8_t *key = (const uint8_t *)"12345678901234567890";
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); ++i) {
+        if (refTOTP(key, 20, vectors[i].time, 30, 1000000) != vectors[i].code) {
+            fprintf(stderr, "reference TOTP failed RFC 6238 vector t=%llu\n",
+                    (unsigned long long)vectors[i].time);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// --- RANDOM ---
+// xorshift64*, seeded from the command line for reproducible runs.
+static uint64_t rngState = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t rngNext()
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 0x2545F4914F6CDD1DULL;
+}
+
+static double rngUniform()
+{
+    return (rngNext() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// --- SIMULATED FOB ---
+struct SoakOptions {
+    const char *key;
+    uint64_t presses;
+    double meanIdle;
+    double driftPpm;
+    uint32_t startSeconds;
+    double raceWindowCycles;
+    double displayMs;
+    uint32_t reportEvery;
+};
+
+struct SoakStats {
+    uint64_t presses;
+    uint64_t refreshes;
+    uint64_t mismatches;
+    uint64_t backwards;
+    uint64_t tornReads;
+    uint64_t shortPresses;
+    uint64_t firstMismatchPress;
+    double awakeSeconds;
+};
+
+class SoakFob
+{
+public:
+    SoakFob(const SoakOptions &opts)
+        : options(opts), realSeconds(0), ticks(0), phase(0), lastRead(0)
+    {
+        totp.setKey(opts.key, strlen(opts.key));
+        tickRate = FOB_RTC_TICKS_PER_SECOND * (1.0 + opts.driftPpm * 1e-6);
+        raceTicks = opts.raceWindowCycles * FOB_RTC_TICKS_PER_SECOND / F_CPU_HZ;
+
+        // Start the timebase at the requested point, as if the fob had
+        // already been running that long.
+        rtc.totalSeconds = opts.startSeconds - (opts.startSeconds % FOB_RTC_OVERFLOW_SECONDS);
+        ticks = (uint64_t)rtc.totalSeconds * FOB_RTC_TICKS_PER_SECOND;
+        lastRead = rtc.totalSeconds;
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    // Standby sleep: the RTC keeps counting and overflowing.
+    void sleep(double seconds) { advance(seconds); }
+
+    // One button press through the firmware's display loop.
+    void press()
+    {
+        ++stats.presses;
+        uint32_t startLoopTime = getRTCSeconds();
+        uint32_t refreshes = 0;
+        while ((uint32_t)(getRTCSeconds() - startLoopTime) < DISPLAY_SECONDS) {
+            uint32_t currentSeconds = getRTCSeconds();
+            uint32_t code = totp.generate(currentSeconds);
+            uint64_t trueSeconds = trueRTCSeconds();
+            uint32_t expected = refTOTP((const uint8_t *)options.key, strlen(options.key),
+                                        trueSeconds, FOB_TOTP_TIMESTEP, FOB_TOTP_MODULUS);
+            if (code != expected) {
+                if (!stats.mismatches)
+                    stats.firstMismatchPress = stats.presses;
+                ++stats.mismatches;
+            }
+            ++refreshes;
+            ++stats.refreshes;
+            advance((REFRESH_MS + options.displayMs) / 1000.0);
+        }
+        // A code that vanishes early means the loop saw the time jump.
+        double expected = DISPLAY_SECONDS * 1000.0 / (REFRESH_MS + options.displayMs);
+        if (refreshes + 2 < expected)
+            ++stats.shortPresses;
+        stats.awakeSeconds += refreshes * (REFRESH_MS + options.displayMs) / 1000.0;
+    }
+
+    // 64-bit seconds from the true tick count; what an atomic, non-wrapping
+    // timebase would read.
+    uint64_t trueRTCSeconds() const
+    {
+        return ticks / FOB_RTC_TICKS_PER_SECOND;
+    }
+
+    const SoakStats &getStats() const { return stats; }
+    const FobSimRTC &getRTC() const { return rtc; }
+    double getRealSeconds() const { return realSeconds; }
+
+private:
+    const SoakOptions &options;
+    FobTOTP totp;
+    FobSimRTC rtc;
+    SoakStats stats;
+    double realSeconds;
+    double tickRate;
+    double raceTicks;
+    uint64_t ticks;
+    double phase;
+    uint32_t lastRead;
+
+    void advance(double seconds)
+    {
+        realSeconds += seconds;
+        double exact = phase + seconds * tickRate;
+        uint64_t whole = (uint64_t)exact;
+        phase = exact - whole;
+        ticks += whole;
+        rtc.advance(whole);
+    }
+
+    // getRTCSeconds() reads RTC.CNT, then totalSeconds.  If the counter is
+    // about to wrap, the overflow ISR can run between the two reads.
+    uint32_t getRTCSeconds()
+    {
+        uint16_t currentCount = rtc.count;
+        uint32_t total = rtc.totalSeconds;
+        if (currentCount == 0xFFFF && phase >= 1.0 - raceTicks) {
+            total += FOB_RTC_OVERFLOW_SECONDS;
+            ++stats.tornReads;
+        }
+        uint32_t seconds = fobRTCSeconds(total, currentCount);
+
+        // The timebase must never run backwards.
+        if ((int32_t)(seconds - lastRead) < 0)
+            ++stats.backwards;
+        lastRead = seconds;
+        return seconds;
+    }
+};
+
+static void usage(const char *progname)
+{
+    fprintf(stderr, "Usage: %s [options]\n", progname);
+    fprintf(stderr, "  --presses N            button presses to simulate (default 1000000)\n");
+    fprintf(stderr, "  --mean-idle S          mean standby time between presses (default 3600)\n");
+    fprintf(stderr, "  --drift-ppm PPM        RTC oscillator error (default 0)\n");
+    fprintf(stderr, "  --start-seconds N      initial timebase value, e.g. 4294900000 to cross the 32-bit wrap\n");
+    fprintf(stderr, "  --race-window CYCLES   CPU cycles between the RTC.CNT and totalSeconds reads (default 0)\n");
+    fprintf(stderr, "  --display-ms MS        time to redraw the display per refresh (default 0)\n");
+    fprintf(stderr, "  --key ASCII            TOTP secret (default %s)\n", defaultKey);
+    fprintf(stderr, "  --seed N               random seed\n");
+    fprintf(stderr, "  --report-every N       progress line every N presses (default 0 = off)\n");
+}
+
+int main(int argc, char **argv)
+{
+    SoakOptions options;
+    options.key = defaultKey;
+    options.presses = 1000000;
+    options.meanIdle = 3600;
+    options.driftPpm = 0;
+    options.startSeconds = 0;
+    options.raceWindowCycles = 0;
+    options.displayMs = 0;
+    options.reportEvery = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(arg, "--presses") && hasValue) {
+            options.presses = strtoull(argv[++i], 0, 10);
+        } else if (!strcmp(arg, "--mean-idle") && hasValue) {
+            options.meanIdle = atof(argv[++i]);
+        } else if (!strcmp(arg, "--drift-ppm") && hasValue) {
+            options.driftPpm = atof(argv[++i]);
+        } else if (!strcmp(arg, "--start-seconds") && hasValue) {
+            options.startSeconds = (uint32_t)strtoul(argv[++i], 0, 10);
+        } else if (!strcmp(arg, "--race-window") && hasValue) {
+            options.raceWindowCycles = atof(argv[++i]);
+        } else if (!strcmp(arg, "--display-ms") && hasValue) {
+            options.displayMs = atof(argv[++i]);
+        } else if (!strcmp(arg, "--key") && hasValue) {
+            options.key = argv[++i];
+        } else if (!strcmp(arg, "--seed") && hasValue) {
+            rngState = strtoull(argv[++i], 0, 10) | 1;
+        } else if (!strcmp(arg, "--report-every") && hasValue) {
+            options.reportEvery = (uint32_t)strtoul(argv[++i], 0, 10);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!checkReferenceVectors())
+        return 1;
+
+    SoakFob fob(options);
+    clock_t start = clock();
+    for (uint64_t p = 0; p < options.presses; ++p) {
+        // Exponentially distributed standby time between presses.
+        fob.sleep(-log(1.0 - rngUniform()) * options.meanIdle);
+        fob.press();
+        if (options.reportEvery && (p + 1) % options.reportEvery == 0) {
+            const SoakStats &s = fob.getStats();
+            printf("%llu presses, %.2f years, %llu mismatches\n",
+                   (unsigned long long)(p + 1), fob.getRealSeconds() / 31557600.0,
+                   (unsigned long long)s.mismatches);
+        }
+    }
+    double wall = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    const SoakStats &s = fob.getStats();
+    const FobSimRTC &rtc = fob.getRTC();
+    double years = fob.getRealSeconds() / 31557600.0;
+    double perPress = s.presses ? (double)s.refreshes / s.presses : 0;
+    printf("simulated:    %.2f years, %llu presses, %llu RTC overflows\n",
+           years, (unsigned long long)s.presses, (unsigned long long)rtc.overflows);
+    printf("timebase:     fob %lu s, true %llu s\n",
+           (unsigned long)rtc.seconds(), (unsigned long long)fob.trueRTCSeconds());
+    printf("codes:        %llu displayed, %llu mismatches vs reference",
+           (unsigned long long)s.refreshes, (unsigned long long)s.mismatches);
+    if (s.mismatches)
+        printf(" (first at press %llu)", (unsigned long long)s.firstMismatchPress);
+    printf("\n");
+    printf("timebase:     %llu backwards steps, %llu torn overflow reads, %llu presses cut short\n",
+           (unsigned long long)s.backwards, (unsigned long long)s.tornReads,
+           (unsigned long long)s.shortPresses);
+    printf("per press:    %.2f refreshes, %.2f TOTP computations, %.2f SHA-1 blocks, %.2f s awake\n",
+           perPress, perPress, perPress * 2, s.presses ? s.awakeSeconds / s.presses : 0);
+    printf("host cost:    %.3f s wall, %.0f ns per press, %.0fx real time\n",
+           wall, s.presses ? wall * 1e9 / s.presses : 0,
+           wall > 0 ? fob.getRealSeconds() / wall : 0);
+
+    return (s.mismatches || s.backwards || s.shortPresses) ? 2 : 0;
+}
@@ -3,6 +3,7 @@
 #include <SPI.h>
 #include <Crypto.h>
 #include <SHA1.h>
+#include <FobTOTP.h>
 #include <string.h>
 #include <avr/sleep.h>
 #include <avr/interrupt.h>
@@ -26,12 +27,9 @@ U8G2_ST7305_200X200_1_4W_SW_SPI u8g2(U8G2_R0, PIN_CLK, PIN_MOSI, PIN_CS, PIN_DC,
 
 // --- TOTP CONFIG ---
 const uint8_t secretKey[] = "12345678901234567890";
-const uint32_t timestep = 30;
 
 // --- GLOBALS ---
-SHA1 hash;
-uint8_t i_key_pad[64];
-uint8_t o_key_pad[64];
+FobTOTP totp;
 volatile bool buttonPressed = false;
 
 // --- TIME TRACKING ---
@@ -39,7 +37,7 @@ volatile uint32_t totalSeconds = 0;
 
 // --- RTC OVERFLOW INTERRUPT ---
 ISR(RTC_CNT_vect) {
-  totalSeconds += 64;
+  totalSeconds += FOB_RTC_OVERFLOW_SECONDS;
   RTC.INTFLAGS = RTC_OVF_bm; // Clear overflow flag
 }
 
@@ -67,51 +65,12 @@ uint32_t getRTCSeconds() {
   uint16_t currentCount = RTC.CNT;
   
   // Current seconds = total overflow seconds + current count
-  return totalSeconds + (currentCount / 1024);
-}
-
-// --- HMAC PREPARATION ---
-void prepareHMACPads() {
-  memset(i_key_pad, 0x36, 64);
-  memset(o_key_pad, 0x5C, 64);
-
-  for (int i = 0; i < sizeof(secretKey) - 1; i++) {
-    i_key_pad[i] ^= secretKey[i];
-    o_key_pad[i] ^= secretKey[i];
-  }
+  return fobRTCSeconds(totalSeconds, currentCount);
 }
 
 // --- TOTP GENERATION ---
 uint32_t generateTOTP(uint32_t time) {
-  uint64_t counter = time / timestep;
-
-  uint8_t counterBytes[8];
-  for (int i = 7; i >= 0; --i) {
-    counterBytes[i] = counter & 0xFF;
-    counter >>= 8;
-  }
-
-  uint8_t tempHash[20];
-  hash.reset();
-  hash.update(i_key_pad, 64);
-  hash.update(counterBytes, 8);
-  hash.finalize(tempHash, sizeof(tempHash));
-
-  uint8_t finalHash[20];
-  hash.reset();
-  hash.update(o_key_pad, 64);
-  hash.update(tempHash, sizeof(tempHash));
-  hash.finalize(finalHash, sizeof(finalHash));
-
-  int offset = finalHash[19] & 0x0F;
-
-  uint32_t binary =
-      ((uint32_t)(finalHash[offset] & 0x7F) << 24) |
-      ((uint32_t)(finalHash[offset + 1] & 0xFF) << 16) |
-      ((uint32_t)(finalHash[offset + 2] & 0xFF) << 8) |
-      ((uint32_t)(finalHash[offset + 3] & 0xFF));
-
-  return binary % 1000000;
+  return totp.generate(time);
 }
 
 // --- DISPLAY TOTP CODE ---
@@ -170,7 +129,7 @@ void setup() {
   u8g2.setContrast(0x90);
   
   // TOTP setup
-  prepareHMACPads();
+  totp.setKey(secretKey, sizeof(secretKey) - 1);
 
   // Clear display initially
   clearDisplay();
@@ -0,0 +1,465 @@
+// Host-side replay of recorded RTC drift logs through the fob timebase.
+//
+// Reads the CSV logs written by backend/app.py (totp_log.csv),
+// backend/uart_reader.py (attiny_log.csv) and the copies kept under
+// rtc_test_files/, and replays them through the same getRTCSeconds() and
+// generateTOTP() logic the firmware runs (lib/FobTOTP).  For each log it
+// reports:
+//
+//   - how many logged codes the firmware logic re-derives from the logged
+//     elapsed seconds (a sanity check of the log against the firmware),
+//   - the drift curve of the logged clock against the reference timestamps,
+//   - the code mismatch rate against the reference clock for one or more
+//     candidate RTC calibrations (--trim-ppm), using a simulated RTC that
+//     counts ticks and takes overflow interrupts exactly like the hardware.
+//
+// Build and run with:
+//   pio run -e native_replay
+//   .pio/build/native_replay/program rtc_test_files/20260303_2/attiny_log.csv
+
+#include <FobTOTP.h>
+#include <FobSimRTC.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+// --- DEFAULTS ---
+static const char *defaultKey = "12345678901234567890";
+static const double defaultCurveInterval = 600.0;
+
+// --- LOG ROW ---
+struct ReplayRow {
+    double refTime;        // Reference seconds since the first row.
+    uint32_t elapsed;      // Logged clock seconds.
+    uint32_t code;         // Logged TOTP code.
+};
+
+struct ReplayLog {
+    std::string path;
+    std::vector<ReplayRow> rows;
+    unsigned long malformed;
+    unsigned long dropped;
+    unsigned long runs;
+};
+
+// --- OPTIONS ---
+struct ReplayOptions {
+    std::string key;
+    uint32_t timestep;
+    uint32_t window;
+    double curveInterval;
+    const char *curveCsv;
+    std::vector<double> trims;
+    bool autoTrim;
+};
+
+// --- CSV HELPERS ---
+static void splitCSV(const char *line, std::vector<std::string> &fields)
+{
+    fields.clear();
+    std::string field;
+    for (const char *p = line; *p != '\0' && *p != '\n' && *p != '\r'; ++p) {
+        if (*p == ',') {
+            fields.push_back(field);
+            field.clear();
+        } else if (*p != '"') {
+            field += *p;
+        }
+    }
+    fields.push_back(field);
+}
+
+static std::string upper(const std::string &s)
+{
+    std::string out(s);
+    for (size_t i = 0; i < out.size(); ++i) {
+        if (out[i] >= 'a' && out[i] <= 'z')
+            out[i] -= 'a' - 'A';
+    }
+    return out;
+}
+
+static bool parseUnsigned(const std::string &s, uint32_t &value)
+{
+    if (s.empty())
+        return false;
+    char *end;
+    unsigned long v = strtoul(s.c_str(), &end, 10);
+    if (*end != '\0')
+        return false;
+    value = (uint32_t)v;
+    return true;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date.
+static long daysFromCivil(long y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long)doe - 719468;
+}
+
+// Parses "YYYY-MM-DD HH:MM:SS.fff", "HH:MM:SS.fff" or the "MM:SS.f" form
+// that spreadsheet round-trips leave behind.  "period" is set to the
+// interval after which the timestamp wraps, or zero if it does not.
+static bool parseTimestamp(const std::string &s, double &seconds, double &period)
+{
+    long y;
+    unsigned mo, d, h, mi;
+    double sec;
+    int used = 0;
+    if (sscanf(s.c_str(), "%ld-%u-%u %u:%u:%lf%n", &y, &mo, &d, &h, &mi, &sec, &used) == 6
+            && used == (int)s.size()) {
+        seconds = daysFromCivil(y, mo, d) * 86400.0 + h * 3600.0 + mi * 60.0 + sec;
+        period = 0;
+        return true;
+    }
+    if (sscanf(s.c_str(), "%u:%u:%lf%n", &h, &mi, &sec, &used) == 3 && used == (int)s.size()) {
+        seconds = h * 3600.0 + mi * 60.0 + sec;
+        period = 86400.0;
+        return true;
+    }
+    if (sscanf(s.c_str(), "%u:%lf%n", &mi, &sec, &used) == 2 && used == (int)s.size()) {
+        seconds = mi * 60.0 + sec;
+        period = 3600.0;
+        return true;
+    }
+    return false;
+}
+
+// --- LOG LOADING ---
+static bool loadLog(const char *path, ReplayLog &log)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+
+    log.path = path;
+    log.rows.clear();
+    log.malformed = 0;
+    log.dropped = 0;
+    log.runs = 0;
+
+    int codeCol = -1;
+    int elapsedCol = -1;
+    bool haveFirst = false;
+    double prev = 0, unwrap = 0;
+    char line[1024];
+    std::vector<std::string> fields;
+    std::vector<ReplayRow> run;
+    unsigned long usable = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        splitCSV(line, fields);
+
+        // Header rows name the columns; several loggers write one per run.
+        bool header = false;
+        for (size_t i = 0; i < fields.size(); ++i) {
+            std::string name = upper(fields[i]);
+            if (name.find("TOTP") != std::string::npos) {
+                codeCol = (int)i;
+                header = true;
+            } else if (name == "ELAPSED (S)") {
+                elapsedCol = (int)i;
+                header = true;
+            }
+        }
+        if (header || codeCol < 0 || elapsedCol < 0)
+            continue;
+
+        ReplayRow row;
+        double stamp, period;
+        if ((int)fields.size() <= codeCol || (int)fields.size() <= elapsedCol ||
+                !parseTimestamp(fields[0], stamp, period) ||
+                !parseUnsigned(fields[codeCol], row.code) ||
+                !parseUnsigned(fields[elapsedCol], row.elapsed)) {
+            ++log.malformed;
+            continue;
+        }
+
+        // Undo the wrap of time-of-day timestamps.
+        if (haveFirst && period > 0 && stamp + unwrap < prev - period / 2)
+            unwrap += period;
+        stamp += unwrap;
+
+        haveFirst = true;
+        prev = stamp;
+        ++usable;
+        row.refTime = stamp;
+
+        // A device reset or serial garbage shows up as an elapsed value
+        // that does not follow the reference clock.  That ends the current
+        // run; the longest consistent run in the file is replayed.
+        if (!run.empty()) {
+            const ReplayRow &last = run.back();
+            double step = stamp - last.refTime;
+            if (row.elapsed < last.elapsed ||
+                    (double)(row.elapsed - last.elapsed) > step * 1.5 + 2.0) {
+                if (run.size() > log.rows.size())
+                    log.rows.swap(run);
+                run.clear();
+                ++log.runs;
+            }
+        }
+        run.push_back(row);
+    }
+    if (!run.empty()) {
+        if (run.size() > log.rows.size())
+            log.rows.swap(run);
+        ++log.runs;
+    }
+    fclose(file);
+
+    if (log.rows.size() < 2) {
+        fprintf(stderr, "%s: not enough usable rows\n", path);
+        return false;
+    }
+
+    // Reference time is measured from the start of the replayed run.
+    double first = log.rows[0].refTime;
+    for (size_t i = 0; i < log.rows.size(); ++i)
+        log.rows[i].refTime -= first;
+    log.dropped = usable - log.rows.size();
+    return true;
+}
+
+// --- DRIFT FIT ---
+// Least-squares fit of logged seconds against reference seconds.
+static void fitDrift(const ReplayLog &log, double &intercept, double &slope)
+{
+    double n = (double)log.rows.size();
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    double base = log.rows[0].elapsed;
+    for (size_t i = 0; i < log.rows.size(); ++i) {
+        double x = log.rows[i].refTime;
+        double y = log.rows[i].elapsed - base;
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    double denom = n * sxx - sx * sx;
+    slope = denom != 0 ? (n * sxy - sx * sy) / denom : 1.0;
+    intercept = base + (sy - slope * sx) / n;
+}
+
+// --- REPLAY ---
+struct ReplayResult {
+    unsigned long presses;
+    unsigned long mismatches;
+    unsigned long rejected;
+    long finalOffset;
+    uint64_t overflows;
+};
+
+// Drives a simulated RTC along the fitted clock model, optionally trimmed,
+// and checks each code against the reference clock.
+static ReplayResult replayTimebase(const ReplayLog &log, FobTOTP &totp,
+                                   double intercept, double slope,
+                                   double trimPpm, uint32_t window)
+{
+    ReplayResult result;
+    memset(&result, 0, sizeof(result));
+
+    FobSimRTC rtc;
+    double start = intercept > 0 ? intercept * FOB_RTC_TICKS_PER_SECOND : 0;
+    double rate = slope * (1.0 + trimPpm * 1e-6) * FOB_RTC_TICKS_PER_SECOND;
+    uint64_t ticks = (uint64_t)llround(start);
+    rtc.advance(ticks);
+
+    uint32_t refBase = log.rows[0].elapsed;
+    for (size_t i = 0; i < log.rows.size(); ++i) {
+        double t = log.rows[i].refTime;
+        double modelled = start + t * rate;
+        uint64_t target = modelled > 0 ? (uint64_t)llround(modelled) : 0;
+        if (target > ticks) {
+            rtc.advance(target - ticks);
+            ticks = target;
+        }
+
+        uint32_t fobSeconds = rtc.seconds();
+        uint32_t refSeconds = refBase + (uint32_t)floor(t);
+        uint32_t fobCode = totp.generate(fobSeconds);
+        ++result.presses;
+        if (fobCode != totp.generate(refSeconds)) {
+            ++result.mismatches;
+
+            // Would the verifier still have accepted it within the window?
+            uint64_t refStep = refSeconds / totp.getTimestep();
+            bool accepted = false;
+            for (uint32_t w = 1; w <= window && !accepted; ++w) {
+                if (totp.generateCounter(refStep + w) == fobCode ||
+                        (refStep >= w && totp.generateCounter(refStep - w) == fobCode))
+                    accepted = true;
+            }
+            if (!accepted)
+                ++result.rejected;
+        }
+        result.finalOffset = (long)fobSeconds - (long)refSeconds;
+    }
+    result.overflows = rtc.overflows;
+    return result;
+}
+
+// --- REPORTING ---
+static void reportLog(const ReplayLog &log, const ReplayOptions &options, FILE *curve)
+{
+    FobTOTP totp;
+    totp.setKey(options.key.data(), options.key.size());
+    totp.setTimestep(options.timestep);
+
+    const ReplayRow &last = log.rows.back();
+    printf("== %s\n", log.path.c_str());
+    printf("rows: %lu  (malformed %lu; longest of %lu runs, %lu other rows dropped)\n",
+           (unsigned long)log.rows.size(), log.malformed, log.runs, log.dropped);
+    printf("span: %.1f s reference, %lu s logged\n",
+           last.refTime, (unsigned long)(last.elapsed - log.rows[0].elapsed));
+
+    // Re-derive every logged code from its logged elapsed seconds.
+    unsigned long rederived = 0;
+    for (size_t i = 0; i < log.rows.size(); ++i) {
+        if (totp.generate(log.rows[i].elapsed) == log.rows[i].code)
+            ++rederived;
+    }
+    printf("firmware re-derivation: %lu/%lu logged codes match (%.3f%% mismatch)\n",
+           rederived, (unsigned long)log.rows.size(),
+           100.0 * (log.rows.size() - rederived) / log.rows.size());
+
+    // Drift curve: logged clock minus reference clock.
+    double intercept, slope;
+    fitDrift(log, intercept, slope);
+    double ppm = (slope - 1.0) * 1e6;
+    printf("fitted drift: %+.1f ppm  (%+.2f s/day)\n", ppm, ppm * 0.0864);
+    printf("drift curve:\n");
+    printf("  %10s %10s %10s %10s\n", "ref (s)", "logged", "drift (s)", "ppm");
+    double nextPoint = 0;
+    for (size_t i = 0; i < log.rows.size(); ++i) {
+        const ReplayRow &row = log.rows[i];
+        double drift = (double)(row.elapsed - log.rows[0].elapsed) - row.refTime;
+        if (curve) {
+            fprintf(curve, "%s,%.3f,%lu,%.3f\n", log.path.c_str(),
+                    row.refTime, (unsigned long)row.elapsed, drift);
+        }
+        if (row.refTime >= nextPoint || i == log.rows.size() - 1) {
+            printf("  %10.1f %10lu %+10.1f %+10.0f\n", row.refTime,
+                   (unsigned long)row.elapsed, drift,
+                   row.refTime > 0 ? drift / row.refTime * 1e6 : 0.0);
+            nextPoint = row.refTime + options.curveInterval;
+        }
+    }
+
+    // Timebase replay for each candidate calibration.
+    std::vector<double> trims(options.trims);
+    if (options.autoTrim && slope > 0)
+        trims.push_back(-ppm / (1.0 + ppm * 1e-6));
+    printf("timebase replay against reference (window +/-%lu steps):\n",
+           (unsigned long)options.window);
+    printf("  %12s %10s %10s %10s %12s %10s\n",
+           "trim (ppm)", "codes", "mismatch", "rejected", "final off s", "overflows");
+    for (size_t i = 0; i < trims.size(); ++i) {
+        ReplayResult r = replayTimebase(log, totp, intercept, slope,
+                                        trims[i], options.window);
+        printf("  %+12.1f %10lu %9.3f%% %9.3f%% %+12ld %10llu\n",
+               trims[i], r.presses,
+               100.0 * r.mismatches / r.presses,
+               100.0 * r.rejected / r.presses,
+               r.finalOffset, (unsigned long long)r.overflows);
+    }
+}
+
+static void usage(const char *progname)
+{
+    fprintf(stderr, "Usage: %s [options] log.csv [log.csv ...]\n", progname);
+    fprintf(stderr, "  --key ASCII          TOTP secret (default %s)\n", defaultKey);
+    fprintf(stderr, "  --timestep N         TOTP timestep in seconds (default %d)\n", FOB_TOTP_TIMESTEP);
+    fprintf(stderr, "  --trim-ppm PPM       candidate RTC calibration, repeatable (default 0)\n");
+    fprintf(stderr, "  --auto-trim          also replay with the trim that cancels the fitted drift\n");
+    fprintf(stderr, "  --window N           verifier acceptance window in steps (default 0)\n");
+    fprintf(stderr, "  --curve-interval S   spacing of printed drift curve points (default %.0f)\n",
+            defaultCurveInterval);
+    fprintf(stderr, "  --curve-csv FILE     write the full drift curve as CSV\n");
+}
+
+int main(int argc, char **argv)
+{
+    ReplayOptions options;
+    options.key = defaultKey;
+    options.timestep = FOB_TOTP_TIMESTEP;
+    options.window = 0;
+    options.curveInterval = defaultCurveInterval;
+    options.curveCsv = 0;
+    options.autoTrim = false;
+
+    std::vector<const char *> paths;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(arg, "--key") && hasValue) {
+            options.key = argv[++i];
+        } else if (!strcmp(arg, "--timestep") && hasValue) {
+            options.timestep = (uint32_t)strtoul(argv[++i], 0, 10);
+        } else if (!strcmp(arg, "--trim-ppm") && hasValue) {
+            options.trims.push_back(atof(argv[++i]));
+        } else if (!strcmp(arg, "--auto-trim")) {
+            options.autoTrim = true;
+        } else if (!strcmp(arg, "--window") && hasValue) {
+            options.window = (uint32_t)strtoul(argv[++i], 0, 10);
+        } else if (!strcmp(arg, "--curve-interval") && hasValue) {
+            options.curveInterval = atof(argv[++i]);
+        } else if (!strcmp(arg, "--curve-csv") && hasValue) {
+            options.curveCsv = argv[++i];
+        } else if (arg[0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty() || options.timestep == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (options.trims.empty())
+        options.trims.push_back(0.0);
+
+    FILE *curve = 0;
+    if (options.curveCsv) {
+        curve = fopen(options.curveCsv, "w");
+        if (!curve) {
+            fprintf(stderr, "%s: cannot create\n", options.curveCsv);
+            return 1;
+        }
+        fprintf(curve, "log,ref_s,logged_s,drift_s\n");
+    }
+
+    clock_t start = clock();
+    double simulated = 0;
+    int failures = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        ReplayLog log;
+        if (!loadLog(paths[i], log)) {
+            ++failures;
+            continue;
+        }
+        reportLog(log, options, curve);
+        simulated += log.rows.back().refTime * options.trims.size();
+        printf("\n");
+    }
+    double wall = (double)(clock() - start) / CLOCKS_PER_SEC;
+    if (wall > 0)
+        printf("replayed %.0f s of logs in %.3f s (%.0fx real time)\n",
+               simulated, wall, simulated / wall);
+
+    if (curve)
+        fclose(curve);
+    return failures ? 1 : 0;
+}